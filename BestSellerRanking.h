@@ -0,0 +1,327 @@
+﻿#ifndef BESTSELLERRANKING_H
+#define BESTSELLERRANKING_H
+
+#include <ctime>
+#include <deque>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "Order.h"
+#include "StringHash.h"
+#include "MemoryUsage.h"
+
+/**
+ * @brief 排行榜中的一项
+ */
+struct RankedProduct {
+    std::string productId;
+    long long unitsSold = 0;
+};
+
+/**
+ * @brief 对外展示的畅销商品
+ */
+struct BestSeller {
+    Product product;
+    long long unitsSold = 0;
+};
+
+/**
+ * @brief 带排序的销量计数器 - 每个商品一个计数，同时维护总榜和各类别的有序集合
+ *
+ * 修改一个商品的销量为 O(log n)（从有序集合中删除旧位置、插入新位置），
+ * 读取前 K 名为 O(K)。
+ */
+class RankedCounter {
+public:
+    /**
+     * @brief 调整商品销量
+     * @param delta 增加为正，减少为负；销量降到 0 时移出排行
+     */
+    void add(std::string_view productId, std::string_view category, long long delta) {
+        if (delta == 0) return;
+
+        auto it = counts.find(productId);
+        if (it == counts.end()) {
+            if (delta < 0) return;
+            it = counts.emplace(std::string(productId), Entry{ 0, std::string(category) }).first;
+        }
+
+        Entry& entry = it->second;
+        RankSet& categoryRank = byCategory[entry.category];
+        long long units = entry.units + delta;
+
+        if (entry.units > 0 && units > 0) {
+            // 取出节点改键后放回，不重新分配节点
+            reposition(overall, RankKey{ entry.units, it->first }, units);
+            reposition(categoryRank, RankKey{ entry.units, it->first }, units);
+        }
+        else if (entry.units > 0) {
+            overall.erase(RankKey{ entry.units, it->first });
+            categoryRank.erase(RankKey{ entry.units, it->first });
+        }
+        else if (units > 0) {
+            overall.insert(RankKey{ units, it->first });
+            categoryRank.insert(RankKey{ units, it->first });
+        }
+
+        entry.units = units;
+        if (units <= 0) {
+            if (categoryRank.empty()) byCategory.erase(entry.category);
+            counts.erase(it);
+        }
+    }
+
+    long long getUnits(std::string_view productId) const {
+        auto it = counts.find(productId);
+        return it == counts.end() ? 0 : it->second.units;
+    }
+
+    /**
+     * @brief 按销量从高到低遍历，visitor 返回 false 时停止
+     * @param category 为空表示总榜
+     */
+    template <typename Visitor>
+    void forEachRanked(std::string_view category, Visitor&& visitor) const {
+        const RankSet* rank = &overall;
+        if (!category.empty()) {
+            auto it = byCategory.find(category);
+            if (it == byCategory.end()) return;
+            rank = &it->second;
+        }
+        for (const RankKey& key : *rank) {
+            if (!visitor(key.productId, key.units)) return;
+        }
+    }
+
+    std::vector<RankedProduct> top(size_t limit, std::string_view category = "") const {
+        std::vector<RankedProduct> result;
+        result.reserve(limit);
+        forEachRanked(category, [&](const std::string& productId, long long units) {
+            if (result.size() >= limit) return false;
+            result.push_back(RankedProduct{ productId, units });
+            return true;
+        });
+        return result;
+    }
+
+    void clear() {
+        counts.clear();
+        overall.clear();
+        byCategory.clear();
+    }
+
+    MemoryUsage getMemoryUsage() const {
+        MemoryUsage usage{ MemoryAccounting::ofHashTable(counts) + rankBytes(overall) +
+            MemoryAccounting::ofHashTable(byCategory), counts.size() };
+        for (const auto& [productId, entry] : counts) {
+            usage.bytes += MemoryAccounting::ofString(productId) + MemoryAccounting::ofString(entry.category);
+        }
+        for (const auto& [category, rank] : byCategory) {
+            usage.bytes += MemoryAccounting::ofString(category) + rankBytes(rank);
+        }
+        return usage;
+    }
+
+private:
+    struct Entry {
+        long long units;
+        std::string category;
+    };
+
+    struct RankKey {
+        long long units;
+        std::string productId;
+
+        // 销量降序，销量相同按商品ID升序，保证排名稳定
+        bool operator<(const RankKey& other) const {
+            return units != other.units ? units > other.units : productId < other.productId;
+        }
+    };
+
+    using RankSet = std::set<RankKey>;
+
+    static void reposition(RankSet& rank, const RankKey& key, long long units) {
+        auto node = rank.extract(key);
+        if (node.empty()) return;
+        node.value().units = units;
+        rank.insert(std::move(node));
+    }
+
+    static size_t rankBytes(const RankSet& rank) {
+        size_t bytes = MemoryAccounting::ofTree(rank);
+        for (const RankKey& key : rank) {
+            bytes += MemoryAccounting::ofString(key.productId);
+        }
+        return bytes;
+    }
+
+    StringMap<Entry> counts;
+    RankSet overall;
+    StringMap<RankSet> byCategory;
+};
+
+/**
+ * @brief 畅销榜 - 下单和取消时增量维护，可选按天滑动的时间窗口榜（如"本周畅销"）
+ *
+ * 销量按订单项件数计，已取消的订单不计入。
+ * 窗口榜把最近 windowDays 天的销量按天分桶保存，跨天时把过期桶的销量从窗口榜中扣除，
+ * 每个过期商品 O(log n)。
+ */
+class BestSellerRanking {
+public:
+    explicit BestSellerRanking(int windowDays = 7) : windowDays(windowDays) {}
+
+    BestSellerRanking(const BestSellerRanking&) = delete;
+    BestSellerRanking& operator=(const BestSellerRanking&) = delete;
+
+    /**
+     * @brief 设置窗口天数，0 表示关闭窗口榜；修改后窗口榜从空开始累计
+     */
+    void setWindowDays(int days) {
+        windowDays = days > 0 ? days : 0;
+        window.clear();
+        buckets.clear();
+    }
+
+    int getWindowDays() const { return windowDays; }
+
+    /**
+     * @brief 记录一个订单的销量变化
+     * @param order 订单
+     * @param sign +1 表示计入（下单），-1 表示扣除（取消）
+     * @param categoryOf 商品ID -> 类别的查询函数
+     */
+    template <typename CategoryOf>
+    void recordOrder(const Order& order, int sign, CategoryOf&& categoryOf) {
+        long long day = order.getOrderDay();
+        DayBucket* bucket = nullptr;
+        if (windowDays > 0 && day >= 0) {
+            advanceTo(currentDay());
+            bucket = bucketFor(day);
+        }
+
+        for (const OrderItem& item : order.getItems()) {
+            std::string_view category = categoryOf(item.getProductId());
+            long long delta = static_cast<long long>(sign) * item.getQuantity();
+            allTime.add(item.getProductId(), category, delta);
+
+            if (bucket) {
+                window.add(item.getProductId(), category, delta);
+                auto it = bucket->sales.find(item.getProductId());
+                if (it == bucket->sales.end()) {
+                    it = bucket->sales.emplace(item.getProductId(), BucketSale{ std::string(category), 0 }).first;
+                }
+                it->second.units += delta;
+            }
+        }
+    }
+
+    /**
+     * @brief 前 K 名
+     * @param category 为空表示总榜
+     * @param inWindow true 表示窗口榜（最近 windowDays 天）
+     */
+    std::vector<RankedProduct> top(size_t limit, std::string_view category = "", bool inWindow = false) {
+        return ranking(inWindow).top(limit, category);
+    }
+
+    // 累计销量（不含已取消订单）
+    long long getUnitsSold(std::string_view productId) const {
+        return allTime.getUnits(productId);
+    }
+
+    template <typename Visitor>
+    void forEachRanked(std::string_view category, bool inWindow, Visitor&& visitor) {
+        ranking(inWindow).forEachRanked(category, std::forward<Visitor>(visitor));
+    }
+
+    void clear() {
+        allTime.clear();
+        window.clear();
+        buckets.clear();
+    }
+
+    // 全部时间和滑动窗口两份排名，加上窗口内按天的销量桶
+    MemoryUsage getMemoryUsage() const {
+        MemoryUsage usage = allTime.getMemoryUsage();
+        usage += window.getMemoryUsage();
+        usage.bytes += MemoryAccounting::ofDeque(buckets);
+        for (const auto& bucket : buckets) {
+            usage.bytes += MemoryAccounting::ofHashTable(bucket.sales);
+            for (const auto& [productId, sale] : bucket.sales) {
+                usage.bytes += MemoryAccounting::ofString(productId) + MemoryAccounting::ofString(sale.category);
+            }
+        }
+        return usage;
+    }
+
+private:
+    struct BucketSale {
+        std::string category;
+        long long units;
+    };
+
+    struct DayBucket {
+        long long day;
+        StringMap<BucketSale> sales;  ///< 商品ID -> 当天销量
+    };
+
+    int windowDays;
+    RankedCounter allTime;
+    RankedCounter window;
+    std::deque<DayBucket> buckets;  ///< 按天升序
+    long long cachedDay = -1;
+    std::time_t cachedAt = 0;
+
+    // 今天（本地日期）的天数编号，与 Order::getOrderDay 口径一致；
+    // localtime 较慢，结果缓存一分钟（跨零点时窗口最多晚一分钟滑动）
+    long long currentDay() {
+        std::time_t now = std::time(nullptr);
+        if (cachedDay >= 0 && now >= cachedAt && now - cachedAt < 60) return cachedDay;
+
+        std::tm localTime;
+        #ifdef _WIN32
+        localtime_s(&localTime, &now);
+        #else
+        localtime_r(&now, &localTime);
+        #endif
+        char text[11];
+        std::strftime(text, sizeof(text), "%Y-%m-%d", &localTime);
+        cachedDay = Order::toDayNumber(text);
+        cachedAt = now;
+        return cachedDay;
+    }
+
+    const RankedCounter& ranking(bool inWindow) {
+        if (inWindow && windowDays > 0) {
+            advanceTo(currentDay());
+            return window;
+        }
+        return allTime;
+    }
+
+    // 扣除已滑出窗口的天
+    void advanceTo(long long today) {
+        while (!buckets.empty() && buckets.front().day <= today - windowDays) {
+            for (const auto& sale : buckets.front().sales) {
+                window.add(sale.first, sale.second.category, -sale.second.units);
+            }
+            buckets.pop_front();
+        }
+    }
+
+    // 订单日期不在窗口内时返回 nullptr
+    DayBucket* bucketFor(long long day) {
+        if (day <= currentDay() - windowDays) return nullptr;
+
+        auto it = buckets.begin();
+        while (it != buckets.end() && it->day < day) ++it;
+        if (it != buckets.end() && it->day == day) return &*it;
+        return &*buckets.insert(it, DayBucket{ day, {} });
+    }
+};
+
+#endif // BESTSELLERRANKING_H
@@ -0,0 +1,347 @@
+﻿#ifndef CARTSTORE_H
+#define CARTSTORE_H
+
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "Order.h"
+#include "StringHash.h"
+#include "MemoryUsage.h"
+#include "TextRecord.h"
+#include "DurableFile.h"
+
+/**
+ * @brief 单个用户的购物车 - 按商品ID哈希定位购物车行，合计金额增量维护
+ */
+class Cart {
+private:
+    std::vector<OrderItem> lines;
+    StringMap<size_t> lineIndex;  ///< 商品ID -> lines 中的位置
+    Money total;
+
+public:
+    Cart() {}
+
+    const std::vector<OrderItem>& getItems() const { return lines; }
+    Money getTotal() const { return total; }
+    bool empty() const { return lines.empty(); }
+    size_t size() const { return lines.size(); }
+
+    const OrderItem* find(std::string_view productId) const {
+        auto it = lineIndex.find(productId);
+        return it == lineIndex.end() ? nullptr : &lines[it->second];
+    }
+
+    /**
+     * @brief 加入商品，已存在时累加数量（沿用已有行的单价）
+     */
+    void add(OrderItem item) {
+        auto it = lineIndex.find(item.getProductId());
+        if (it != lineIndex.end()) {
+            OrderItem& line = lines[it->second];
+            line.setQuantity(line.getQuantity() + item.getQuantity());
+            total += line.getPrice() * item.getQuantity();
+            return;
+        }
+        total += item.getTotalPrice();
+        lineIndex.emplace(item.getProductId(), lines.size());
+        lines.push_back(std::move(item));
+    }
+
+    /**
+     * @brief 修改数量，数量为 0 时移除该行
+     */
+    bool setQuantity(std::string_view productId, int quantity) {
+        auto it = lineIndex.find(productId);
+        if (it == lineIndex.end() || quantity < 0) return false;
+        if (quantity == 0) return remove(productId);
+
+        OrderItem& line = lines[it->second];
+        total += line.getPrice() * (quantity - line.getQuantity());
+        line.setQuantity(quantity);
+        return true;
+    }
+
+    /**
+     * @brief 移除一行，用末尾行填补空位，O(1)
+     */
+    bool remove(std::string_view productId) {
+        auto it = lineIndex.find(productId);
+        if (it == lineIndex.end()) return false;
+
+        size_t position = it->second;
+        total -= lines[position].getTotalPrice();
+        lineIndex.erase(it);
+
+        if (position != lines.size() - 1) {
+            lines[position] = std::move(lines.back());
+            lineIndex[lines[position].getProductId()] = position;
+        }
+        lines.pop_back();
+        return true;
+    }
+
+    void clear() {
+        lines.clear();
+        lineIndex.clear();
+        total = Money();
+    }
+
+    // 购物车行和行索引占用的堆内存（不含对象本身）
+    size_t getHeapBytes() const {
+        size_t bytes = MemoryAccounting::ofVector(lines) + MemoryAccounting::ofHashTable(lineIndex);
+        for (const auto& line : lines) {
+            bytes += line.getHeapBytes();
+        }
+        for (const auto& [productId, position] : lineIndex) {
+            bytes += MemoryAccounting::ofString(productId);
+        }
+        return bytes;
+    }
+
+    /**
+     * @brief 取走全部购物车行并清空（下单时使用）
+     */
+    std::vector<OrderItem> takeItems() {
+        std::vector<OrderItem> items = std::move(lines);
+        clear();
+        return items;
+    }
+};
+
+/**
+ * @brief 购物车存储 - 按用户名保存购物车，退出登录后保留
+ *
+ * 设置了日志文件时，每次修改追加一条记录（A 加入 / Q 改数量 / C 清空），字段经 TextRecord 转义；
+ * 启动时重放日志恢复购物车，格式无效的记录和中断时写了一半的最后一行跳过并报告，不影响启动。
+ * 日志中的无效记录过多时重写为快照。购物车清空后即从表中移除，getCartCount 只计非空的购物车。
+ * 各方法自带锁（下单不取引擎锁），读取返回副本。
+ */
+class CartStore {
+private:
+    mutable std::mutex mutex;
+    StringMap<Cart> carts;
+    std::string logPath;
+    std::ofstream log;
+    size_t logRecords;
+
+    static constexpr size_t COMPACT_MIN_RECORDS = 4096;
+
+public:
+    CartStore() : logRecords(0) {}
+
+    CartStore(const CartStore&) = delete;
+    CartStore& operator=(const CartStore&) = delete;
+
+    /**
+     * @brief 打开日志文件：重放已有记录，之后的修改追加写入
+     * @param path 日志路径，为空表示只保存在内存中
+     */
+    void open(const std::string& path) {
+        std::lock_guard<std::mutex> guard(mutex);
+        log.close();
+        carts.clear();
+        logRecords = 0;
+        logPath = path;
+        if (logPath.empty()) return;
+
+        replay();
+        compact();
+    }
+
+    // 没有购物车（或购物车为空）时返回 false
+    bool copyCart(std::string_view username, Cart& result) const {
+        std::lock_guard<std::mutex> guard(mutex);
+        auto it = carts.find(username);
+        if (it == carts.end()) return false;
+        result = it->second;
+        return true;
+    }
+
+    bool contains(std::string_view username, std::string_view productId) const {
+        std::lock_guard<std::mutex> guard(mutex);
+        auto it = carts.find(username);
+        return it != carts.end() && it->second.find(productId);
+    }
+
+    void addItem(std::string_view username, OrderItem item) {
+        std::lock_guard<std::mutex> guard(mutex);
+        if (log.is_open()) {
+            log << formatRecord('A', username, item.toString()) << '\n';
+        }
+        cartFor(username).add(std::move(item));
+        afterWrite();
+    }
+
+    bool setQuantity(std::string_view username, std::string_view productId, int quantity) {
+        std::lock_guard<std::mutex> guard(mutex);
+        auto it = carts.find(username);
+        if (it == carts.end() || !it->second.setQuantity(productId, quantity)) return false;
+        if (it->second.empty()) carts.erase(it);
+
+        if (log.is_open()) {
+            log << formatRecord('Q', username, TextRecord::escape(productId) + "|" + std::to_string(quantity)) << '\n';
+        }
+        afterWrite();
+        return true;
+    }
+
+    bool removeItem(std::string_view username, std::string_view productId) {
+        return setQuantity(username, productId, 0);
+    }
+
+    void clear(std::string_view username) {
+        std::lock_guard<std::mutex> guard(mutex);
+        auto it = carts.find(username);
+        if (it == carts.end()) return;
+
+        carts.erase(it);
+        if (log.is_open()) {
+            log << formatRecord('C', username, std::string_view()) << '\n';
+        }
+        afterWrite();
+    }
+
+    std::vector<OrderItem> takeItems(std::string_view username) {
+        std::lock_guard<std::mutex> guard(mutex);
+        auto it = carts.find(username);
+        if (it == carts.end()) return std::vector<OrderItem>();
+
+        std::vector<OrderItem> items = it->second.takeItems();
+        carts.erase(it);
+        if (log.is_open()) {
+            log << formatRecord('C', username, std::string_view()) << '\n';
+        }
+        afterWrite();
+        return items;
+    }
+
+    size_t getCartCount() const {
+        std::lock_guard<std::mutex> guard(mutex);
+        return carts.size();
+    }
+
+    MemoryUsage getMemoryUsage() const {
+        std::lock_guard<std::mutex> guard(mutex);
+        MemoryUsage usage{ MemoryAccounting::ofHashTable(carts), carts.size() };
+        for (const auto& [username, cart] : carts) {
+            usage.bytes += MemoryAccounting::ofString(username) + cart.getHeapBytes();
+        }
+        return usage;
+    }
+
+private:
+    Cart& cartFor(std::string_view username) {
+        auto it = carts.find(username);
+        if (it == carts.end()) {
+            it = carts.emplace(std::string(username), Cart()).first;
+        }
+        return it->second;
+    }
+
+    size_t liveLineCount() const {
+        size_t count = 0;
+        for (const auto& entry : carts) {
+            count += entry.second.size();
+        }
+        return count;
+    }
+
+    void afterWrite() {
+        if (!log.is_open()) return;
+        log.flush();
+        ++logRecords;
+        if (logRecords > COMPACT_MIN_RECORDS && logRecords > 2 * liveLineCount()) {
+            compact();
+        }
+    }
+
+    // 记录格式：类型|用户名[|内容]，内容中的字段由调用方转义
+    static std::string formatRecord(char type, std::string_view username, std::string_view payload) {
+        std::string record(1, type);
+        record += '|';
+        TextRecord::appendField(record, username);
+        if (!payload.empty()) {
+            record += '|';
+            record += payload;
+        }
+        return record;
+    }
+
+    void replay() {
+        std::ifstream in(logPath);
+        std::string line;
+        size_t lineNumber = 0;
+        size_t skipped = 0;
+        while (std::getline(in, line)) {
+            ++lineNumber;
+            // 没有换行结尾的最后一行是写到一半时中断留下的
+            if (in.eof() || !applyRecord(line)) {
+                ++skipped;
+                std::cerr << "购物车日志 " << logPath << " 第 " << lineNumber << " 行无效，已跳过" << std::endl;
+                continue;
+            }
+            ++logRecords;
+        }
+        if (skipped > 0) {
+            std::cerr << "购物车日志共跳过 " << skipped << " 条无效记录" << std::endl;
+        }
+    }
+
+    // 重放一条记录，格式无效时返回 false 且不做任何修改
+    bool applyRecord(std::string_view line) {
+        if (line.size() < 3 || line[1] != '|') return false;
+        char type = line[0];
+        std::vector<std::string_view> fields = TextRecord::split(line.substr(2), '|', type == 'A' ? 2 : SIZE_MAX);
+        std::string username = TextRecord::unescape(fields[0]);
+        if (username.empty()) return false;
+
+        switch (type) {
+        case 'A': {
+            OrderItem item;
+            if (fields.size() != 2 || !OrderItem::tryParse(fields[1], item)) return false;
+            cartFor(username).add(std::move(item));
+            return true;
+        }
+        case 'Q': {
+            int quantity = 0;
+            if (fields.size() != 3 || !TextRecord::parseInt(fields[2], quantity) || quantity < 0) return false;
+            auto it = carts.find(username);
+            if (it != carts.end() && it->second.setQuantity(TextRecord::unescape(fields[1]), quantity) &&
+                it->second.empty()) {
+                carts.erase(it);
+            }
+            return true;
+        }
+        case 'C': {
+            if (fields.size() != 1) return false;
+            carts.erase(username);
+            return true;
+        }
+        default:
+            return false;
+        }
+    }
+
+    // 把当前所有购物车写成快照，同步后改名替换原日志；替换失败时保留原日志，下次再压缩
+    void compact() {
+        log.close();
+        std::string content;
+        for (const auto& entry : carts) {
+            for (const auto& item : entry.second.getItems()) {
+                content += formatRecord('A', entry.first, item.toString());
+                content += '\n';
+            }
+        }
+        if (DurableFile::replace(logPath, content)) {
+            logRecords = liveLineCount();
+        }
+        log.open(logPath, std::ios::app);
+    }
+};
+
+#endif // CARTSTORE_H
@@ -0,0 +1,122 @@
+﻿#ifndef CATALOGSNAPSHOT_H
+#define CATALOGSNAPSHOT_H
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "CompactProduct.h"
+#include "Product.h"
+#include "ProductStore.h"
+#include "QueryResultCache.h"
+#include "SnapshotCell.h"
+
+/**
+ * @brief 商品表的只读快照 - 与商品表按块共享
+ *
+ * 发布时直接引用商品表当前的各块和共用去重池（见 ProductStore::share），不复制任何商品；
+ * 商品表之后修改某块时先复制一份，快照仍读原来的块，因此快照创建后不再变化。
+ * 快照同时带上发布时的查询版本号，读者据此判断查询缓存中的结果是否属于同一版本。
+ * 快照中商品的位置与 DatabaseManager 商品表中的位置一致。读者经 ProductView 访问商品，需要 Product 对象时再还原。
+ */
+class CatalogSnapshot {
+public:
+    static constexpr size_t CHUNK_SIZE = ProductStore::CHUNK_SIZE;
+    using Chunk = ProductStore::Chunk;
+
+    CatalogSnapshot() = default;
+
+    /**
+     * @brief 由当前商品表构建新版本，O(总块数)
+     */
+    static std::unique_ptr<CatalogSnapshot> build(ProductStore& products, QueryStamps stamps, uint64_t version) {
+        auto snapshot = std::make_unique<CatalogSnapshot>();
+        snapshot->stamps = std::move(stamps);
+        snapshot->version = version;
+        products.share(snapshot->chunks, snapshot->productCount, snapshot->shared);
+        return snapshot;
+    }
+
+    size_t size() const { return productCount; }
+
+    ProductView operator[](size_t position) const {
+        const Chunk& chunk = *chunks[position / CHUNK_SIZE];
+        return ProductView(chunk.records[position % CHUNK_SIZE], chunk.strings, *shared);
+    }
+
+    /**
+     * @brief 按位置顺序访问每个商品，visitor(position, ProductView)
+     */
+    template <typename Visitor>
+    void forEach(Visitor&& visitor) const {
+        size_t position = 0;
+        for (const auto& chunk : chunks) {
+            for (const CompactProduct& record : chunk->records) {
+                visitor(position++, ProductView(record, chunk->strings, *shared));
+            }
+        }
+    }
+
+    const QueryStamps& getStamps() const { return stamps; }
+    uint64_t getVersion() const { return version; }
+
+    // 只计已与商品表分开的块和去重池，仍共用的部分已计入商品表
+    MemoryUsage getMemoryUsage(const ProductStore& live) const {
+        MemoryUsage usage{ MemoryAccounting::ofVector(chunks), 0 };
+        if (!live.holds(shared.get())) usage.bytes += shared->getMemoryBytes();
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            if (!live.holds(i, chunks[i].get())) usage += ProductStore::chunkUsage(*chunks[i]);
+        }
+        return usage;
+    }
+
+private:
+    std::vector<std::shared_ptr<const Chunk>> chunks;
+    std::shared_ptr<const InternedStringPool> shared = std::make_shared<const InternedStringPool>();
+    size_t productCount = 0;
+    QueryStamps stamps;
+    uint64_t version = 0;
+};
+
+/**
+ * @brief 目录查询的结果 - 持有所读的快照和命中商品的位置，经 ProductView 读取，不还原 Product
+ *
+ * 位置表与查询缓存共用，缓存命中时不复制任何商品。持有期间占用一个快照读槽，旧快照也不能回收，
+ * 应在读完后立即释放，不要跨越等待用户输入；需要保存结果时用 toProducts() 还原。
+ */
+class ProductListing {
+public:
+    ProductListing(SnapshotCell<CatalogSnapshot>::ReadGuard snapshot, QueryResultCache::Positions positions)
+        : snapshot(std::move(snapshot)), positions(std::move(positions)) {
+    }
+
+    size_t size() const { return positions->size(); }
+    bool empty() const { return positions->empty(); }
+
+    ProductView operator[](size_t index) const { return (*snapshot)[(*positions)[index]]; }
+
+    /**
+     * @brief 按结果顺序访问每个商品，visitor(ProductView)
+     */
+    template <typename Visitor>
+    void forEach(Visitor&& visitor) const {
+        for (uint32_t position : *positions) {
+            visitor((*snapshot)[position]);
+        }
+    }
+
+    std::vector<Product> toProducts() const {
+        std::vector<Product> result;
+        result.reserve(positions->size());
+        for (uint32_t position : *positions) {
+            (*snapshot)[position].copyTo(result.emplace_back());
+        }
+        return result;
+    }
+
+private:
+    SnapshotCell<CatalogSnapshot>::ReadGuard snapshot;
+    QueryResultCache::Positions positions;
+};
+
+#endif // CATALOGSNAPSHOT_H
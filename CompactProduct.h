@@ -0,0 +1,199 @@
+﻿#ifndef COMPACTPRODUCT_H
+#define COMPACTPRODUCT_H
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "MemoryUsage.h"
+#include "Money.h"
+#include "Product.h"
+#include "StringHash.h"
+
+/**
+ * @brief 字符串池 - 字符串首尾相接存放在一块连续内存中，按 32 位偏移引用
+ *
+ * 每个字符串以 '\0' 结尾，长度在读取时计算，引用方只需保存偏移；偏移 0 固定为空串。
+ * 字符串只追加不修改，已发出的偏移一直有效。商品字段来自按行、按 '|' 分隔的文本，不含 '\0'；
+ * 含 '\0' 的字符串读回时截断在第一个 '\0' 处。
+ */
+class StringPool {
+public:
+    StringPool() : bytes(1, '\0') {}
+
+    uint32_t append(std::string_view text) {
+        if (text.empty()) return 0;
+        if (bytes.size() + text.size() + 1 > UINT32_MAX) throw std::length_error("StringPool::append");
+        uint32_t offset = static_cast<uint32_t>(bytes.size());
+        bytes.insert(bytes.end(), text.begin(), text.end());
+        bytes.push_back('\0');
+        return offset;
+    }
+
+    /**
+     * @brief 尾部共用：host 处的字符串以 text 结尾时直接引用其尾部，否则追加
+     */
+    uint32_t appendSuffixOf(uint32_t host, std::string_view text) {
+        std::string_view hostText = view(host);
+        if (!text.empty() && hostText.size() >= text.size() &&
+            hostText.compare(hostText.size() - text.size(), text.size(), text) == 0) {
+            return host + static_cast<uint32_t>(hostText.size() - text.size());
+        }
+        return append(text);
+    }
+
+    std::string_view view(uint32_t offset) const {
+        const char* text = bytes.data() + offset;
+        return std::string_view(text, std::strlen(text));
+    }
+
+    void reserve(size_t size) { bytes.reserve(size); }
+    void shrinkToFit() { bytes.shrink_to_fit(); }
+
+    size_t size() const { return bytes.size(); }
+    size_t getMemoryBytes() const { return MemoryAccounting::ofVector(bytes); }
+
+private:
+    std::vector<char> bytes;
+};
+
+/**
+ * @brief 去重字符串池 - 相同的字符串只存一份，用于分类、卖家这类取值很少的字段
+ *
+ * 只追加：复制一份再追加新字符串后，原来发出的偏移在副本中仍然有效。
+ */
+class InternedStringPool {
+public:
+    // 已有时返回原偏移；没有时返回 false，由调用方决定是否复制一份后再 intern
+    bool find(std::string_view text, uint32_t& offset) const {
+        if (text.empty()) {
+            offset = 0;
+            return true;
+        }
+        auto it = offsets.find(text);
+        if (it == offsets.end()) return false;
+        offset = it->second;
+        return true;
+    }
+
+    uint32_t intern(std::string_view text) {
+        uint32_t offset;
+        if (find(text, offset)) return offset;
+        offset = pool.append(text);
+        offsets.emplace(std::string(text), offset);
+        return offset;
+    }
+
+    std::string_view view(uint32_t offset) const { return pool.view(offset); }
+
+    size_t size() const { return pool.size(); }
+    size_t getCount() const { return offsets.size(); }
+
+    size_t getMemoryBytes() const {
+        size_t bytes = pool.getMemoryBytes() + MemoryAccounting::ofHashTable(offsets);
+        for (const auto& entry : offsets) bytes += MemoryAccounting::ofString(entry.first);
+        return bytes;
+    }
+
+private:
+    StringPool pool;
+    StringMap<uint32_t> offsets;
+};
+
+/**
+ * @brief 紧凑商品记录 - 定长，数值字段连续存放，字符串字段只存 32 位偏移
+ *
+ * 编号、名称和描述几乎各不相同，放在记录所属块的字符串池里（名称是描述的结尾时共用描述的尾部）；
+ * 分类、卖家用户名和卖家手机号取值很少，放在整个目录共用的去重字符串池里。
+ * 一条记录 40 字节，Product 对象本身约 200 字节，另有超出短字符串缓冲区的字段各占一次堆分配。
+ */
+struct CompactProduct {
+    int64_t priceCents;
+    int32_t stock;
+    uint32_t id;              ///< 块字符串池中的偏移
+    uint32_t name;
+    uint32_t description;
+    uint32_t category;        ///< 共用去重池中的偏移
+    uint32_t sellerUsername;
+    uint32_t sellerPhone;
+    bool isActive;
+
+    /**
+     * @brief 编码一个商品（Product 或 ProductView）
+     * @param intern 把分类和卖家字段放入共用去重池并返回偏移，intern(string_view) -> uint32_t
+     */
+    template <typename Source, typename Intern>
+    static CompactProduct encode(const Source& product, StringPool& strings, Intern&& intern) {
+        CompactProduct record{};
+        record.priceCents = product.getPrice().getCents();
+        record.stock = product.getStock();
+        record.isActive = product.getIsActive();
+        record.id = strings.append(product.getId());
+        record.description = strings.append(product.getDescription());
+        record.name = strings.appendSuffixOf(record.description, product.getName());
+        record.category = intern(product.getCategory());
+        record.sellerUsername = intern(product.getSellerUsername());
+        record.sellerPhone = intern(product.getSellerPhone());
+        return record;
+    }
+};
+
+static_assert(sizeof(CompactProduct) <= 40, "CompactProduct 应保持 40 字节以内");
+
+/**
+ * @brief 紧凑商品的只读外观 - 与 Product 的读取接口同名，字符串字段以 string_view 返回
+ *
+ * 视图不拥有数据，读快照时在快照存活期间有效，读商品表时在下一次写之前有效；
+ * 需要长期保存或修改时用 toProduct() 还原为 Product。
+ */
+class ProductView {
+public:
+    ProductView(const CompactProduct& record, const StringPool& strings, const InternedStringPool& shared)
+        : record(&record), strings(&strings), shared(&shared) {
+    }
+
+    std::string_view getId() const { return strings->view(record->id); }
+    std::string_view getName() const { return strings->view(record->name); }
+    std::string_view getCategory() const { return shared->view(record->category); }
+    Money getPrice() const { return Money::fromCents(record->priceCents); }
+    int getStock() const { return record->stock; }
+    std::string_view getDescription() const { return strings->view(record->description); }
+    bool getIsActive() const { return record->isActive; }
+    std::string_view getSellerUsername() const { return shared->view(record->sellerUsername); }
+    std::string_view getSellerPhone() const { return shared->view(record->sellerPhone); }
+
+    bool isAvailable() const { return record->isActive && record->stock > 0; }
+    bool isInStock() const { return record->stock > 0; }
+
+    void displayInfo() const {
+        printProductInfo(*this);
+    }
+
+    Product toProduct() const {
+        Product product;
+        copyTo(product);
+        return product;
+    }
+
+    // 就地写入各字段，批量还原时配合 emplace_back 使用，省去临时字符串和 Product 的移动
+    void copyTo(Product& product) const {
+        product.id.assign(getId());
+        product.name.assign(getName());
+        product.category.assign(getCategory());
+        product.price = getPrice();
+        product.stock = getStock();
+        product.description.assign(getDescription());
+        product.isActive = getIsActive();
+        product.sellerUsername.assign(getSellerUsername());
+        product.sellerPhone.assign(getSellerPhone());
+    }
+
+private:
+    const CompactProduct* record;
+    const StringPool* strings;
+    const InternedStringPool* shared;
+};
+
+#endif // COMPACTPRODUCT_H
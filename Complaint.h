@@ -7,6 +7,9 @@
 #include <sstream>
 #include <vector>
 #include <iomanip>
+#include <atomic>
+#include <utility>
+#include "MemoryUsage.h"
 
 /**
  * @brief 商品投诉类 - 管理用户对商品的投诉信息
@@ -42,33 +45,34 @@ public:
      * @param title 投诉标题
      * @param content 投诉内容
      */
-    Complaint(const std::string& productId, const std::string& productName,
-        const std::string& complainant, const std::string& complaintType,
-        const std::string& title, const std::string& content);
+    Complaint(std::string productId, std::string productName,
+        std::string complainant, std::string complaintType,
+        std::string title, std::string content);
 
     // ==================== Getter 方法 ====================
-
-    std::string getComplaintId() const { return complaintId; }
-    std::string getProductId() const { return productId; }
-    std::string getProductName() const { return productName; }
-    std::string getComplainant() const { return complainant; }
-    std::string getComplaintType() const { return complaintType; }
-    std::string getTitle() const { return title; }
-    std::string getContent() const { return content; }
-    std::string getComplaintTime() const { return complaintTime; }
-    std::string getStatus() const { return status; }
-    std::string getResponse() const { return response; }
-    std::string getResponseTime() const { return responseTime; }
-    std::string getAdminUser() const { return adminUser; }
+    // 均返回常量引用，调用方需要副本时自行拷贝
+
+    const std::string& getComplaintId() const { return complaintId; }
+    const std::string& getProductId() const { return productId; }
+    const std::string& getProductName() const { return productName; }
+    const std::string& getComplainant() const { return complainant; }
+    const std::string& getComplaintType() const { return complaintType; }
+    const std::string& getTitle() const { return title; }
+    const std::string& getContent() const { return content; }
+    const std::string& getComplaintTime() const { return complaintTime; }
+    const std::string& getStatus() const { return status; }
+    const std::string& getResponse() const { return response; }
+    const std::string& getResponseTime() const { return responseTime; }
+    const std::string& getAdminUser() const { return adminUser; }
 
     // ==================== Setter 方法 ====================
 
-    void setComplaintType(const std::string& newType) { complaintType = newType; }
-    void setTitle(const std::string& newTitle) { title = newTitle; }
-    void setContent(const std::string& newContent) { content = newContent; }
-    void setStatus(const std::string& newStatus) { status = newStatus; }
-    void setResponse(const std::string& newResponse) { response = newResponse; }
-    void setAdminUser(const std::string& admin) { adminUser = admin; }
+    void setComplaintType(std::string newType) { complaintType = std::move(newType); }
+    void setTitle(std::string newTitle) { title = std::move(newTitle); }
+    void setContent(std::string newContent) { content = std::move(newContent); }
+    void setStatus(std::string newStatus) { status = std::move(newStatus); }
+    void setResponse(std::string newResponse) { response = std::move(newResponse); }
+    void setAdminUser(std::string admin) { adminUser = std::move(admin); }
 
     // ==================== 业务逻辑方法 ====================
 
@@ -102,7 +106,7 @@ public:
      * @param responseContent 回复内容
      * @param adminUsername 处理投诉的管理员用户名
      */
-    void processComplaint(const std::string& responseContent, const std::string& adminUsername);
+    void processComplaint(std::string responseContent, std::string adminUsername);
 
     /**
      * @brief 获取状态文本
@@ -116,26 +120,47 @@ public:
      */
     bool isProcessed() const;
 
+    // 字符串占用的堆内存（不含对象本身）
+    size_t getHeapBytes() const {
+        size_t bytes = 0;
+        for (const std::string* field : { &complaintId, &productId, &productName, &complainant, &complaintType, &title,
+            &content, &complaintTime, &status, &response, &responseTime, &adminUser }) {
+            bytes += MemoryAccounting::ofString(*field);
+        }
+        return bytes;
+    }
+
     // ==================== 数据持久化方法 ====================
 
     std::string toString() const;
     static Complaint fromString(const std::string& data);
+
+private:
+    /**
+     * @brief 进程内递增序号，保证同一秒内提交的投诉ID不重复
+     */
+    static unsigned long long nextSequence();
 };
 
 // ==================== 成员函数实现 ====================
 
-inline Complaint::Complaint(const std::string& productId, const std::string& productName,
-    const std::string& complainant, const std::string& complaintType,
-    const std::string& title, const std::string& content)
-    : productId(productId), productName(productName), complainant(complainant),
-    complaintType(complaintType), title(title), content(content), status("pending") {
+inline Complaint::Complaint(std::string productId, std::string productName,
+    std::string complainant, std::string complaintType,
+    std::string title, std::string content)
+    : productId(std::move(productId)), productName(std::move(productName)), complainant(std::move(complainant)),
+    complaintType(std::move(complaintType)), title(std::move(title)), content(std::move(content)), status("pending") {
     generateComplaintId();
     setCurrentTime();
 }
 
+inline unsigned long long Complaint::nextSequence() {
+    static std::atomic<unsigned long long> sequence{ 0 };
+    return ++sequence;
+}
+
 inline void Complaint::generateComplaintId() {
     std::ostringstream oss;
-    oss << "CMP" << std::time(nullptr) << std::rand() % 1000;
+    oss << "CMP" << std::time(nullptr) << nextSequence();
     complaintId = oss.str();
 }
 
@@ -181,9 +206,9 @@ inline void Complaint::displayBriefInfo() const {
         << " | " << getStatusText() << " | " << complaintTime << std::endl;
 }
 
-inline void Complaint::processComplaint(const std::string& responseContent, const std::string& adminUsername) {
-    response = responseContent;
-    adminUser = adminUsername;
+inline void Complaint::processComplaint(std::string responseContent, std::string adminUsername) {
+    response = std::move(responseContent);
+    adminUser = std::move(adminUsername);
     status = "resolved";
     setResponseTime();
 }
@@ -220,24 +245,24 @@ inline Complaint Complaint::fromString(const std::string& data) {
 
     if (tokens.size() >= 9) {
         Complaint complaint;
-        complaint.complaintId = tokens[0];
-        complaint.productId = tokens[1];
-        complaint.productName = tokens[2];
-        complaint.complainant = tokens[3];
-        complaint.complaintType = tokens[4];
-        complaint.title = tokens[5];
-        complaint.content = tokens[6];
-        complaint.complaintTime = tokens[7];
-        complaint.status = tokens[8];
+        complaint.complaintId = std::move(tokens[0]);
+        complaint.productId = std::move(tokens[1]);
+        complaint.productName = std::move(tokens[2]);
+        complaint.complainant = std::move(tokens[3]);
+        complaint.complaintType = std::move(tokens[4]);
+        complaint.title = std::move(tokens[5]);
+        complaint.content = std::move(tokens[6]);
+        complaint.complaintTime = std::move(tokens[7]);
+        complaint.status = std::move(tokens[8]);
 
         if (tokens.size() > 9) {
-            complaint.response = tokens[9];
+            complaint.response = std::move(tokens[9]);
         }
         if (tokens.size() > 10) {
-            complaint.responseTime = tokens[10];
+            complaint.responseTime = std::move(tokens[10]);
         }
         if (tokens.size() > 11) {
-            complaint.adminUser = tokens[11];
+            complaint.adminUser = std::move(tokens[11]);
         }
         return complaint;
     }
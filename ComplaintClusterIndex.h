@@ -0,0 +1,210 @@
+﻿#ifndef COMPLAINTCLUSTERINDEX_H
+#define COMPLAINTCLUSTERINDEX_H
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Utf8Text.h"
+#include "MemoryUsage.h"
+
+/**
+ * @brief 相似投诉聚类 - 字符 shingle 的 MinHash 签名 + LSH 分桶
+ *
+ * 文本按 Unicode 字符切成长度为 SHINGLE_SIZE 的片段（先按 Utf8Text 归一化），
+ * 用 SIGNATURE_SIZE 个哈希函数取最小值得到签名。签名分成 BAND_COUNT 段，每段连同商品ID
+ * 哈希成一个桶键，只有同一商品、至少一段完全相同的投诉才成为候选，
+ * 候选的签名相似度（估计 Jaccard）达到阈值即归入同一组（并查集合并）。
+ * 16 段 x 4 行时，Jaccard 0.5 左右的文本约有一半概率成为候选，0.7 以上几乎必定成为候选。
+ * 同一组的投诉大多连续到达，大桶只比较最近 MAX_BUCKET_SCAN 条，单次插入为常数时间。
+ * 投诉以其在投诉表中的位置标识。
+ */
+class ComplaintClusterIndex {
+public:
+    static constexpr size_t SHINGLE_SIZE = 3;
+    static constexpr size_t BAND_COUNT = 16;
+    static constexpr size_t ROWS_PER_BAND = 4;
+    static constexpr size_t SIGNATURE_SIZE = BAND_COUNT * ROWS_PER_BAND;
+    /// 每个桶只和最近登记的若干条比较，避免模板化投诉堆积的大桶让插入退化为线性
+    static constexpr size_t MAX_BUCKET_SCAN = 32;
+
+    explicit ComplaintClusterIndex(double similarityThreshold = 0.5)
+        : similarityThreshold(similarityThreshold) {
+    }
+
+    /**
+     * @brief 登记一条投诉并归组
+     * @param position 投诉位置（须按 0, 1, 2... 依次登记）
+     * @param productId 商品ID，只在同一商品的投诉之间归组
+     * @param title 标题
+     * @param content 内容
+     * @return 所在组的大小
+     */
+    size_t add(size_t position, std::string_view productId, std::string_view title, std::string_view content) {
+        if (position >= entries.size()) entries.resize(position + 1);
+        Entry& entry = entries[position];
+        entry.parent = position;
+        entry.members.assign(1, position);
+        computeSignature(title, content, entry.signature);
+
+        uint64_t productHash = hashBytes(productId);
+        for (size_t band = 0; band < BAND_COUNT; ++band) {
+            // 桶是按登记顺序倒序串起来的链表，桶表只记链表头
+            auto [head, inserted] = bucketHeads.try_emplace(bandKey(entry.signature, band, productHash), position);
+            entry.nextInBucket[band] = inserted ? NO_POSITION : head->second;
+            head->second = position;
+
+            size_t candidate = entry.nextInBucket[band];
+            for (size_t scanned = 0; candidate != NO_POSITION && scanned < MAX_BUCKET_SCAN; ++scanned) {
+                if (find(candidate) != find(position) &&
+                    similarity(entries[candidate].signature, entry.signature) >= similarityThreshold) {
+                    unite(candidate, position);
+                }
+                candidate = entries[candidate].nextInBucket[band];
+            }
+        }
+        return entries[find(position)].members.size();
+    }
+
+    /**
+     * @brief 与该投诉同组的全部投诉位置（包括自身）
+     */
+    const std::vector<size_t>& getCluster(size_t position) {
+        static const std::vector<size_t> empty;
+        if (position >= entries.size()) return empty;
+        return entries[find(position)].members;
+    }
+
+    /**
+     * @brief 两条投诉的估计 Jaccard 相似度
+     */
+    double estimateSimilarity(size_t first, size_t second) const {
+        if (first >= entries.size() || second >= entries.size()) return 0.0;
+        return similarity(entries[first].signature, entries[second].signature);
+    }
+
+    void clear() {
+        entries.clear();
+        bucketHeads.clear();
+    }
+
+    MemoryUsage getMemoryUsage() const {
+        MemoryUsage usage{ MemoryAccounting::ofVector(entries) + MemoryAccounting::ofHashTable(bucketHeads), entries.size() };
+        for (const auto& entry : entries) {
+            usage.bytes += MemoryAccounting::ofVector(entry.members);
+        }
+        return usage;
+    }
+
+private:
+    using Signature = std::array<uint64_t, SIGNATURE_SIZE>;
+
+    static constexpr size_t NO_POSITION = static_cast<size_t>(-1);
+
+    struct Entry {
+        Signature signature{};
+        std::array<size_t, BAND_COUNT> nextInBucket{};  ///< 每段所在桶中的上一条投诉
+        size_t parent = 0;
+        std::vector<size_t> members;  ///< 仅组代表（根）上有效
+    };
+
+    double similarityThreshold;
+    std::vector<Entry> entries;
+    std::unordered_map<uint64_t, size_t> bucketHeads;  ///< 桶键 -> 最近登记的投诉位置
+
+    static uint64_t mix(uint64_t value) {
+        // splitmix64 终结函数
+        value += 0x9E3779B97F4A7C15ull;
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+        return value ^ (value >> 31);
+    }
+
+    static uint64_t hashBytes(std::string_view text) {
+        uint64_t hash = 1469598103934665603ull;  // FNV-1a
+        for (unsigned char c : text) {
+            hash = (hash ^ c) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // 各哈希函数的种子（xorshift 序列）
+    static constexpr std::array<uint64_t, SIGNATURE_SIZE> makeSeeds() {
+        std::array<uint64_t, SIGNATURE_SIZE> seeds{};
+        uint64_t state = 0x2545F4914F6CDD1Dull;
+        for (auto& seed : seeds) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            seed = state;
+        }
+        return seeds;
+    }
+
+    static void computeSignature(std::string_view title, std::string_view content, Signature& signature) {
+        thread_local std::vector<uint32_t> codePoints;
+        codePoints.clear();
+        Utf8Text::appendNormalized(title, codePoints);
+        Utf8Text::appendNormalized(content, codePoints);
+
+        signature.fill(UINT64_MAX);
+        if (codePoints.empty()) return;
+
+        static constexpr std::array<uint64_t, SIGNATURE_SIZE> seeds = makeSeeds();
+
+        size_t shingleCount = codePoints.size() >= SHINGLE_SIZE ? codePoints.size() - SHINGLE_SIZE + 1 : 1;
+        for (size_t start = 0; start < shingleCount; ++start) {
+            uint64_t shingle = 0;
+            for (size_t k = start; k < start + SHINGLE_SIZE && k < codePoints.size(); ++k) {
+                shingle = shingle * 0x100000001B3ull + codePoints[k];
+            }
+            shingle = mix(shingle);
+
+            // 片段哈希已充分混合，第 i 个哈希函数只需异或种子再乘一个奇数（双射），内层循环可向量化
+            for (size_t i = 0; i < SIGNATURE_SIZE; ++i) {
+                uint64_t value = (shingle ^ seeds[i]) * 0x9E3779B97F4A7C15ull;
+                if (value < signature[i]) signature[i] = value;
+            }
+        }
+    }
+
+    static uint64_t bandKey(const Signature& signature, size_t band, uint64_t productHash) {
+        uint64_t key = mix(productHash ^ band);
+        for (size_t row = 0; row < ROWS_PER_BAND; ++row) {
+            key = mix(key ^ signature[band * ROWS_PER_BAND + row]);
+        }
+        return key;
+    }
+
+    static double similarity(const Signature& first, const Signature& second) {
+        size_t equal = 0;
+        for (size_t i = 0; i < SIGNATURE_SIZE; ++i) {
+            equal += first[i] == second[i];
+        }
+        return static_cast<double>(equal) / SIGNATURE_SIZE;
+    }
+
+    // 并查集：路径减半
+    size_t find(size_t position) {
+        while (entries[position].parent != position) {
+            entries[position].parent = entries[entries[position].parent].parent;
+            position = entries[position].parent;
+        }
+        return position;
+    }
+
+    // 按组大小合并，成员列表并入较大的组
+    void unite(size_t first, size_t second) {
+        size_t a = find(first);
+        size_t b = find(second);
+        if (a == b) return;
+        if (entries[a].members.size() < entries[b].members.size()) std::swap(a, b);
+        entries[b].parent = a;
+        entries[a].members.insert(entries[a].members.end(), entries[b].members.begin(), entries[b].members.end());
+        entries[b].members.clear();
+        entries[b].members.shrink_to_fit();
+    }
+};
+
+#endif // COMPLAINTCLUSTERINDEX_H
@@ -0,0 +1,225 @@
+﻿#ifndef COMPLAINTQUEUE_H
+#define COMPLAINTQUEUE_H
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <set>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "MemoryUsage.h"
+
+/**
+ * @brief 待处理投诉的优先队列，支持管理员领取（带租约）
+ *
+ * 队列只保存投诉在投诉表中的位置，投诉对象的状态由 DatabaseManager 同步修改。
+ * 优先级分数 = 投诉时间（秒）- 类型加权，分数越小越先处理：
+ * 越早的投诉越靠前，质量问题等严重类型相当于提前若干小时提交。
+ * 分数在入队时确定，入队、领取、归还、完成均为 O(log n)。
+ * 领取后进入租约集合，租约到期未处理的投诉在下次领取时自动回到队列。
+ */
+class ComplaintQueue {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit ComplaintQueue(std::chrono::seconds leaseDuration = std::chrono::minutes(15))
+        : leaseDuration(leaseDuration), nextSequence(0) {
+    }
+
+    void setLeaseDuration(std::chrono::seconds duration) { leaseDuration = duration; }
+    std::chrono::seconds getLeaseDuration() const { return leaseDuration; }
+
+    /**
+     * @brief 加入待处理队列（已在队列或已领取时忽略）
+     * @param position 投诉在投诉表中的位置
+     * @param complaintTime 投诉时间 "YYYY-MM-DD HH:MM:SS"，无法解析时按当前时间
+     * @param complaintType 投诉类型，决定加权
+     */
+    void enqueue(size_t position, std::string_view complaintTime, std::string_view complaintType) {
+        Slot& slot = slotFor(position);
+        if (slot.state != SlotState::None) return;
+
+        long long arrival = parseSeconds(complaintTime);
+        if (arrival < 0) arrival = static_cast<long long>(std::time(nullptr));
+        slot.key = PendingKey{ arrival - typeCredit(complaintType), nextSequence++, position };
+        slot.state = SlotState::Pending;
+        pending.insert(slot.key);
+    }
+
+    /**
+     * @brief 领取优先级最高的投诉，先回收已过期的租约
+     * @param expired 输出：本次回收（回到待处理）的投诉位置，调用方据此重置投诉状态
+     * @return 队列为空时返回 false
+     */
+    bool claim(size_t& position, std::vector<size_t>& expired, Clock::time_point now = Clock::now()) {
+        expireLeases(now, expired);
+        if (pending.empty()) return false;
+
+        PendingKey key = *pending.begin();
+        pending.erase(pending.begin());
+
+        Slot& slot = slots[key.position];
+        slot.state = SlotState::Leased;
+        slot.leaseExpiry = now + leaseDuration;
+        leases.insert(LeaseKey{ slot.leaseExpiry, key.position });
+        position = key.position;
+        return true;
+    }
+
+    /**
+     * @brief 归还已领取的投诉，按原优先级回到队列
+     */
+    bool release(size_t position) {
+        if (!isLeased(position)) return false;
+        Slot& slot = slots[position];
+        leases.erase(LeaseKey{ slot.leaseExpiry, position });
+        slot.state = SlotState::Pending;
+        pending.insert(slot.key);
+        return true;
+    }
+
+    /**
+     * @brief 投诉已处理完毕，移出队列或租约集合
+     */
+    bool remove(size_t position) {
+        if (position >= slots.size()) return false;
+        Slot& slot = slots[position];
+        if (slot.state == SlotState::Pending) {
+            pending.erase(slot.key);
+        }
+        else if (slot.state == SlotState::Leased) {
+            leases.erase(LeaseKey{ slot.leaseExpiry, position });
+        }
+        else {
+            return false;
+        }
+        slot.state = SlotState::None;
+        return true;
+    }
+
+    /**
+     * @brief 把已过期的租约放回队列
+     * @param expired 输出：回到队列的投诉位置
+     */
+    void expireLeases(Clock::time_point now, std::vector<size_t>& expired) {
+        while (!leases.empty() && leases.begin()->expiry <= now) {
+            size_t position = leases.begin()->position;
+            leases.erase(leases.begin());
+            Slot& slot = slots[position];
+            slot.state = SlotState::Pending;
+            pending.insert(slot.key);
+            expired.push_back(position);
+        }
+    }
+
+    bool isPending(size_t position) const {
+        return position < slots.size() && slots[position].state == SlotState::Pending;
+    }
+
+    // 已领取且租约未过期
+    bool isLeased(size_t position, Clock::time_point now = Clock::now()) const {
+        return position < slots.size() && slots[position].state == SlotState::Leased &&
+            slots[position].leaseExpiry > now;
+    }
+
+    /**
+     * @brief 按优先级顺序遍历待处理投诉的位置，visitor 返回 false 时停止
+     */
+    template <typename Visitor>
+    void forEachPending(Visitor&& visitor) const {
+        for (const PendingKey& key : pending) {
+            if (!visitor(key.position)) return;
+        }
+    }
+
+    size_t getPendingCount() const { return pending.size(); }
+    size_t getLeasedCount() const { return leases.size(); }
+
+    void clear() {
+        slots.clear();
+        pending.clear();
+        leases.clear();
+    }
+
+    MemoryUsage getMemoryUsage() const {
+        return MemoryUsage{ MemoryAccounting::ofVector(slots) + MemoryAccounting::ofTree(pending) +
+            MemoryAccounting::ofTree(leases), pending.size() + leases.size() };
+    }
+
+    /**
+     * @brief 类型加权（秒）：相当于提前这么久提交
+     */
+    static long long typeCredit(std::string_view complaintType) {
+        if (complaintType == "质量问题") return 24 * 3600;
+        if (complaintType == "虚假宣传") return 12 * 3600;
+        if (complaintType == "服务问题") return 4 * 3600;
+        return 0;
+    }
+
+private:
+    enum class SlotState : uint8_t { None, Pending, Leased };
+
+    struct PendingKey {
+        long long score;
+        uint64_t sequence;  ///< 分数相同时按入队顺序
+        size_t position;
+
+        bool operator<(const PendingKey& other) const {
+            return score != other.score ? score < other.score : sequence < other.sequence;
+        }
+    };
+
+    struct LeaseKey {
+        Clock::time_point expiry;
+        size_t position;
+
+        bool operator<(const LeaseKey& other) const {
+            return expiry != other.expiry ? expiry < other.expiry : position < other.position;
+        }
+    };
+
+    struct Slot {
+        SlotState state = SlotState::None;
+        PendingKey key{};
+        Clock::time_point leaseExpiry{};
+    };
+
+    std::chrono::seconds leaseDuration;
+    uint64_t nextSequence;
+    std::vector<Slot> slots;      ///< 按投诉位置索引
+    std::set<PendingKey> pending;
+    std::set<LeaseKey> leases;    ///< 按到期时间排序
+
+    Slot& slotFor(size_t position) {
+        if (position >= slots.size()) slots.resize(position + 1);
+        return slots[position];
+    }
+
+    // "YYYY-MM-DD HH:MM:SS" 转为秒（按 UTC 计算，只用于相互比较），无法解析时返回 -1
+    static long long parseSeconds(std::string_view text) {
+        if (text.size() < 19 || text[4] != '-' || text[7] != '-' || text[10] != ' ' ||
+            text[13] != ':' || text[16] != ':') {
+            return -1;
+        }
+        auto digits = [&](size_t begin, size_t count) {
+            int value = 0;
+            for (size_t i = begin; i < begin + count; ++i) {
+                if (text[i] < '0' || text[i] > '9') return -1;
+                value = value * 10 + (text[i] - '0');
+            }
+            return value;
+        };
+        int year = digits(0, 4), month = digits(5, 2), day = digits(8, 2);
+        int hour = digits(11, 2), minute = digits(14, 2), second = digits(17, 2);
+        if (year < 0 || month < 0 || day < 0 || hour < 0 || minute < 0 || second < 0) return -1;
+
+        std::chrono::year_month_day date{ std::chrono::year(year),
+            std::chrono::month(static_cast<unsigned>(month)), std::chrono::day(static_cast<unsigned>(day)) };
+        if (!date.ok()) return -1;
+        long long days = std::chrono::sys_days(date).time_since_epoch().count();
+        return days * 86400 + hour * 3600 + minute * 60 + second;
+    }
+};
+
+#endif // COMPLAINTQUEUE_H
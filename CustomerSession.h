@@ -0,0 +1,491 @@
+﻿#ifndef CUSTOMERSESSION_H
+#define CUSTOMERSESSION_H
+
+#include <cstdlib>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include "InputSource.h"
+#include "SessionTask.h"
+#include "ShopSystem.h"
+
+/**
+ * @brief 普通用户会话流程的协程版本
+ *
+ * 登录、浏览、搜索、商品详情与加购、购物车、下单、订单和热销榜各流程在等待输入时挂起，
+ * 一个线程可以同时推进成千上万个会话。控制台菜单也使用这些流程：控制台输入源从不挂起，
+ * 流程直接用 runToCompletion 同步执行。菜单文字写到 out，业务层自身的提示信息仍输出到 std::cout。
+ */
+class CustomerSession {
+public:
+    static constexpr size_t BEST_SELLER_COUNT = 100;  // 热销榜显示的商品数
+    static constexpr size_t SEARCH_PAGE_SIZE = 10;    // 搜索结果每页条数
+
+    /**
+     * @param clearScreens 每个页面开始时是否清屏（只有控制台需要）
+     */
+    CustomerSession(ShopSystem& shop, InputSource& input, std::ostream& out, bool clearScreens = false)
+        : shop(shop), input(input), out(out), clearScreens(clearScreens) {
+    }
+
+    CustomerSession(const CustomerSession&) = delete;
+    CustomerSession& operator=(const CustomerSession&) = delete;
+
+    /**
+     * @brief 会话主循环：未登录时显示主菜单，登录后显示用户菜单，直到输入结束或选择退出
+     */
+    SessionTask<> run() {
+        while (!disconnected && !exited) {
+            if (!shop.isUserLoggedIn()) {
+                co_await showMainMenu();
+            }
+            else if (shop.getCurrentUser().isAdmin()) {
+                out << "会话模式只提供用户菜单，管理员请使用控制台！" << std::endl;
+                shop.logout();
+            }
+            else {
+                co_await showCustomerMenu();
+            }
+        }
+    }
+
+    // ==================== 主菜单 ====================
+    SessionTask<> showMainMenu() {
+        beginScreen("商城管理系统");
+        out << "1. 用户登录" << std::endl;
+        out << "2. 用户注册" << std::endl;
+        out << "3. 退出系统" << std::endl;
+        out << "请选择操作: ";
+
+        idle = true;
+        int choice = co_await getInt("");
+        idle = false;
+        if (disconnected) co_return;
+
+        switch (choice) {
+        case 1:
+            co_await showLoginMenu();
+            break;
+        case 2:
+            co_await showRegisterMenu();
+            break;
+        case 3:
+            out << "感谢使用商城管理系统，再见！" << std::endl;
+            exited = true;
+            break;
+        default:
+            out << "无效选择，请重新输入！" << std::endl;
+            co_await pause();
+        }
+    }
+
+    SessionTask<> showLoginMenu() {
+        beginScreen("用户登录");
+
+        const int maxAttempts = 3;
+        for (int attempts = 1; attempts <= maxAttempts; ++attempts) {
+            std::string username = co_await getString("用户名: ");
+            std::string password = co_await getString("密码: ");
+            if (disconnected) co_return;
+
+            if (shop.login(username, password)) {
+                co_return;
+            }
+
+            if (attempts < maxAttempts) {
+                out << "登录失败，还有 " << (maxAttempts - attempts) << " 次尝试机会" << std::endl;
+            }
+            else {
+                out << "登录失败次数过多，返回主菜单" << std::endl;
+                co_await pause();
+            }
+        }
+    }
+
+    SessionTask<> showRegisterMenu() {
+        beginScreen("用户注册");
+
+        std::string username = co_await getString("用户名: ");
+        std::string password = co_await getString("密码: ");
+        std::string confirmPassword = co_await getString("确认密码: ");
+        if (disconnected) co_return;
+
+        if (password != confirmPassword) {
+            out << "两次输入的密码不一致！" << std::endl;
+            co_await pause();
+            co_return;
+        }
+
+        std::string email = co_await getString("邮箱(可选): ");
+        std::string phone = co_await getString("手机号(必填): ");
+        if (disconnected) co_return;
+
+        if (shop.registerUser(username, password, "customer", email, phone)) {
+            out << "注册成功！是否立即登录？(y/n): ";
+            std::string choice = co_await getString("");
+            if (choice == "y" || choice == "Y") {
+                if (shop.login(username, password)) {
+                    out << "自动登录成功！" << std::endl;
+                }
+            }
+        }
+        co_await pause();
+    }
+
+    // ==================== 用户菜单 ====================
+    SessionTask<> showCustomerMenu() {
+        beginScreen("用户菜单 - " + shop.getLoginStatus());
+        out << "1. 浏览商品" << std::endl;
+        out << "2. 搜索商品" << std::endl;
+        out << "3. 查看商品详情" << std::endl;
+        out << "4. 购物车管理" << std::endl;
+        out << "5. 我的订单" << std::endl;
+        out << "6. 我的商品管理" << std::endl;
+        out << "7. 投诉管理" << std::endl;
+        out << "8. 热销排行" << std::endl;
+        out << "9. 退出登录" << std::endl;
+        out << "请选择操作: ";
+
+        idle = true;
+        int choice = co_await getInt("");
+        idle = false;
+        if (disconnected) co_return;
+
+        switch (choice) {
+        case 1:
+            co_await browseProducts();
+            break;
+        case 2:
+            co_await searchProducts();
+            break;
+        case 3:
+            co_await viewProductDetails();
+            break;
+        case 4:
+            co_await showCartMenu();
+            break;
+        case 5:
+            co_await showOrderMenu();
+            break;
+        case 6:
+        case 7:
+            out << "会话模式暂不支持此功能，请使用控制台！" << std::endl;
+            co_await pause();
+            break;
+        case 8:
+            co_await showBestSellers();
+            break;
+        case 9:
+            shop.logout();
+            co_await pause();
+            break;
+        default:
+            out << "无效选择！" << std::endl;
+            co_await pause();
+        }
+    }
+
+    // 商品浏览功能
+    SessionTask<> browseProducts() {
+        beginScreen("浏览商品");
+
+        {
+            // 列表持有目录快照，显示完即释放，不跨越等待输入
+            ProductListing products = shop.browseProducts();
+            if (products.empty()) {
+                out << "暂无商品！" << std::endl;
+            }
+            else {
+                products.forEach([](const ProductView& product) { product.displayInfo(); });
+            }
+        }
+        co_await pause();
+    }
+
+    SessionTask<> showBestSellers() {
+        beginScreen("热销排行");
+
+        int windowDays = shop.getBestSellerWindowDays();
+        out << "1. 总榜" << std::endl;
+        if (windowDays > 0) {
+            out << "2. 近 " << windowDays << " 天" << std::endl;
+        }
+        int choice = co_await getInt("请选择榜单: ");
+        if (disconnected) co_return;
+        if (choice != 1 && (choice != 2 || windowDays == 0)) {
+            out << "无效选择！" << std::endl;
+            co_await pause();
+            co_return;
+        }
+        std::string category = co_await getString("商品类别（直接回车表示全部）: ");
+        if (disconnected) co_return;
+
+        auto bestSellers = shop.getBestSellers(BEST_SELLER_COUNT, category, choice == 2);
+        if (bestSellers.empty()) {
+            out << "暂无销售数据！" << std::endl;
+        }
+        for (size_t i = 0; i < bestSellers.size(); ++i) {
+            out << std::setw(3) << i + 1 << ". 已售 " << std::setw(6) << bestSellers[i].unitsSold << " 件 | ";
+            bestSellers[i].product.displayBriefInfo();
+        }
+        co_await pause();
+    }
+
+    SessionTask<> searchProducts() {
+        beginScreen("搜索商品");
+
+        std::string keyword = co_await getString("请输入搜索关键词: ");
+        if (disconnected) co_return;
+        size_t page = 0;
+        while (true) {
+            SearchPage result = shop.searchProductsRanked(keyword, page, SEARCH_PAGE_SIZE);
+            if (result.totalHits == 0) {
+                // 没有命中时按名称容错搜索
+                auto similarProducts = shop.fuzzySearchProducts(keyword);
+                if (similarProducts.empty()) {
+                    out << "未找到相关商品！" << std::endl;
+                }
+                else {
+                    out << "未找到完全匹配的商品，您是不是要找:" << std::endl;
+                    for (const auto& product : similarProducts) {
+                        product.displayBriefInfo();
+                    }
+                }
+                break;
+            }
+
+            out << "找到 " << result.totalHits << " 个相关商品（第 " << page + 1 << "/"
+                << result.getPageCount() << " 页，按相关度排序）:" << std::endl;
+            for (const auto& product : result.products) {
+                product.displayBriefInfo();
+            }
+            if (result.getPageCount() <= 1) break;
+
+            std::string choice = co_await getString("n 下一页, p 上一页, 直接回车返回: ");
+            if (disconnected) co_return;
+            if (choice == "n" && page + 1 < result.getPageCount()) ++page;
+            else if (choice == "p" && page > 0) --page;
+            else if (choice != "n" && choice != "p") break;
+        }
+        co_await pause();
+    }
+
+    SessionTask<> viewProductDetails() {
+        beginScreen("商品详情");
+
+        std::string productId = co_await getString("请输入商品ID: ");
+        if (disconnected) co_return;
+        auto product = shop.getProduct(productId);
+
+        if (product) {
+            product->displayInfo();
+
+            out << "\n1. 加入购物车" << std::endl;
+            out << "2. 返回" << std::endl;
+            out << "请选择操作: ";
+
+            int choice = co_await getInt("");
+            if (choice == 1) {
+                int quantity = co_await getInt("请输入数量: ");
+                if (disconnected) co_return;
+                shop.addToCart(productId, quantity);
+            }
+        }
+        else {
+            out << "商品不存在！" << std::endl;
+        }
+        co_await pause();
+    }
+
+    // 购物车菜单
+    SessionTask<> showCartMenu() {
+        beginScreen("购物车管理");
+
+        shop.displayCart();
+
+        if (!shop.hasCartItems()) {
+            co_await pause();
+            co_return;
+        }
+
+        out << "\n1. 继续购物" << std::endl;
+        out << "2. 生成订单" << std::endl;
+        out << "3. 清空购物车" << std::endl;
+        out << "4. 修改商品数量" << std::endl;
+        out << "5. 移除商品" << std::endl;
+        out << "6. 返回" << std::endl;
+        out << "请选择操作: ";
+
+        int choice = co_await getInt("");
+        if (disconnected) co_return;
+        switch (choice) {
+        case 1:
+            // 继续购物，直接返回
+            break;
+        case 2:
+            co_await createOrder();
+            break;
+        case 3:
+            shop.clearCart();
+            co_await pause();
+            break;
+        case 4: {
+            std::string productId = co_await getString("请输入商品ID: ");
+            int quantity = co_await getInt("请输入新的数量(0 表示移除): ");
+            if (disconnected) co_return;
+            shop.updateCartQuantity(productId, quantity);
+            co_await pause();
+            break;
+        }
+        case 5: {
+            std::string productId = co_await getString("请输入要移除的商品ID: ");
+            if (disconnected) co_return;
+            shop.removeFromCart(productId);
+            co_await pause();
+            break;
+        }
+        case 6:
+            break;
+        default:
+            out << "无效选择！" << std::endl;
+            co_await pause();
+        }
+    }
+
+    SessionTask<> createOrder() {
+        beginScreen("生成订单");
+
+        std::string address = co_await getString("请输入配送地址: ");
+        std::string payment = co_await getString("请输入支付方式: ");
+        if (disconnected) co_return;
+
+        Order order = shop.createOrder(address, payment);
+        if (order.getOrderId() != "") {
+            out << "\n订单详情:" << std::endl;
+            order.displayOrderDetails();
+        }
+        co_await pause();
+    }
+
+    // 订单菜单
+    SessionTask<> showOrderMenu() {
+        beginScreen("我的订单");
+
+        auto orders = shop.getUserOrders();
+        if (orders.empty()) {
+            out << "您没有进行中的订单！" << std::endl;
+        }
+        else {
+            for (const auto& order : orders) {
+                order.displayBriefInfo();
+            }
+        }
+
+        out << "\n1. 查看订单详情" << std::endl;
+        out << "2. 取消订单" << std::endl;
+        out << "3. 查看历史订单" << std::endl;
+        out << "4. 返回" << std::endl;
+        out << "请选择操作: ";
+
+        int choice = co_await getInt("");
+        if (disconnected) co_return;
+        switch (choice) {
+        case 1: {
+            std::string orderId = co_await getString("请输入订单ID: ");
+            if (disconnected) co_return;
+            Order order;
+            if (shop.getOrderDetails(orderId, order)) {
+                order.displayOrderDetails();
+            }
+            break;
+        }
+        case 2: {
+            std::string orderId = co_await getString("请输入要取消的订单ID: ");
+            if (disconnected) co_return;
+            shop.cancelOrder(orderId);
+            break;
+        }
+        case 3: {
+            auto archived = shop.getArchivedOrders();
+            if (archived.empty()) {
+                out << "没有已归档的历史订单！" << std::endl;
+            }
+            for (const auto& order : archived) {
+                order.displayBriefInfo();
+            }
+            break;
+        }
+        case 4:
+            co_return;
+        default:
+            out << "无效选择！" << std::endl;
+        }
+        co_await pause();
+    }
+
+    // 输入已结束（脚本关闭或控制台 EOF），流程提前返回
+    bool isDisconnected() const { return disconnected; }
+    bool hasExited() const { return exited; }
+
+    // 正停在主菜单或用户菜单等待选择，驱动方据此判断一个流程已走完
+    bool isIdle() const { return idle && input.isWaiting(); }
+
+private:
+    ShopSystem& shop;
+    InputSource& input;
+    std::ostream& out;
+    bool clearScreens;
+    bool disconnected = false;
+    bool exited = false;
+    bool idle = false;
+
+    // ==================== 输入辅助 ====================
+    // 输入结束后不再读取，返回空值并置 disconnected，调用方在下一个检查点退出
+    SessionTask<std::string> getString(std::string prompt) {
+        out << prompt;
+        if (disconnected) co_return std::string();
+        auto line = co_await input.readLine();
+        if (!line) {
+            disconnected = true;
+            co_return std::string();
+        }
+        co_return std::move(*line);
+    }
+
+    SessionTask<int> getInt(std::string prompt) {
+        out << prompt;
+        while (!disconnected) {
+            auto line = co_await input.readLine();
+            if (!line) {
+                disconnected = true;
+                break;
+            }
+            int value;
+            if (InputSource::parseInt(*line, value)) co_return value;
+            out << "输入无效，请输入数字: ";
+        }
+        co_return 0;
+    }
+
+    SessionTask<> pause() {
+        out << "按回车键继续...";
+        if (disconnected) co_return;
+        auto line = co_await input.readLine();
+        if (!line) disconnected = true;
+    }
+
+    void beginScreen(const std::string& title) {
+        if (clearScreens) {
+#ifdef _WIN32
+            system("cls");
+#else
+            system("clear");
+#endif
+        }
+        out << "==========================================" << std::endl;
+        out << "          " << title << std::endl;
+        out << "==========================================" << std::endl;
+    }
+};
+
+#endif // CUSTOMERSESSION_H
@@ -3,41 +3,234 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
 #include <algorithm>
+#include <utility>
+#include <variant>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <cmath>
+#include <optional>
 #include "User.h"
 #include "Product.h"
+#include "ProductStore.h"
 #include "Order.h"
 #include"Complaint.h"
+#include "SessionManager.h"
+#include "CartStore.h"
+#include "UserStore.h"
+#include "UserImport.h"
+#include "OrderStore.h"
+#include "OrderArchive.h"
+#include "GroupCommitLog.h"
+#include "SalesAnalytics.h"
+#include "BestSellerRanking.h"
+#include "SellerIndex.h"
+#include "ComplaintClusterIndex.h"
+#include "FuzzyNameIndex.h"
+#include "ProductSearchIndex.h"
+#include "QueryResultCache.h"
+#include "CatalogSnapshot.h"
+#include "SnapshotCell.h"
+#include "ComplaintQueue.h"
+#include "StringHash.h"
+#include "TextRecord.h"
+#include "ExistenceFilter.h"
+#include "MemoryUsage.h"
 /**
  * @brief 数据库管理类 - 内存数据库
+ *
+ * 下单和取消订单（Transaction、addOrder、cancelOrder、updateOrder）不取引擎锁，只锁涉及的商品块和订单分片，
+ * 其余业务操作由调用方持有引擎锁。需要同时持有多把锁时按以下顺序获取：
+ * 引擎锁 -> 订单写锁 -> 目录锁 -> 商品表结构锁 -> 商品块锁 -> 订单分片锁 -> 销量锁 -> 订单日志内部锁。
+ * 购物车、用户表和会话表的锁只在各自内部使用，不与其他锁嵌套。
  */
 class DatabaseManager {
 private:
-    std::vector<User> users;
-    std::vector<Product> products;
-    std::vector<Order> orders;
+    // 订单中各商品的类别，在加锁前查好，持销量锁时不再访问商品表
+    using CategoryMap = StringMap<std::string>;
+
+    UserStore users;                  // 按用户名分片，注册和登录不取引擎锁
+    ProductStore products;            // 紧凑记录，按块与目录快照共享
+    OrderStore orders;                // 热数据：未结束或刚结束的订单，按下单用户分片
+    OrderArchive orderArchive;        // 冷数据：超过归档期限的已结束订单
+    GroupCommitLog orderJournal;      // 热订单的修改日志（组提交），重启时重放
+    uint64_t journalSequence;         // 持引擎锁的线程写入的最后一条日志序号，释放锁后等待其落盘
+    std::chrono::seconds orderArchiveAge;
+    std::atomic<size_t> ordersSinceArchive;
+    BestSellerRanking bestSellers;    // 下单、取消时增量维护，包含已归档的订单（销量锁保护）
     std::vector<Complaint> complaints;
+    StringMap<size_t> complaintIndex;  // 投诉ID -> complaints 中的位置（投诉不会被删除）
+    ComplaintQueue complaintQueue;     // 待处理投诉的优先队列
+    ComplaintClusterIndex complaintClusters;  // 相似投诉分组
+    CartStore carts;                 // 自带锁
+    SellerIndex sellerIndex;         // 卖家 -> 商品位置，以及卖家看板汇总（销量锁保护）
+    FuzzyNameIndex fuzzyNames;       // 商品名称二元组倒排，用于容错搜索
+    ProductSearchIndex searchIndex;  // 名称和描述的倒排，用于相关度搜索
+    QueryResultCache queryCache;     // 浏览、类别和关键词搜索的结果缓存（自带锁）
+    QueryStamps queryStamps;         // 查询结果集合的版本号，随目录快照发布
+    std::string dataDirectory;
+    MemoryLimits memoryLimits;
+    MemoryPressureStats memoryPressure;
+    std::chrono::steady_clock::time_point lastMemoryCheck;  // 上一次按总上限生成完整报告的时间
+
+    // 引擎锁：除下单、取消等订单写入外，DatabaseManager 自身的方法不加锁，由调用方（ShopSystem）
+    // 在一次完整业务操作期间持有，保证返回的指针在操作内有效
+    std::mutex engineMutex;
+    std::atomic<std::thread::id> engineOwner;  // 持有引擎锁的线程
+
+    // 订单写锁：写订单和订单日志的事务持共享模式，可以并发；归档、检查点等遍历全部热订单
+    // 或改写日志的维护操作持独占模式，期间没有订单写入
+    mutable std::shared_mutex orderWriteMutex;
+    // 销量锁：保护畅销榜和卖家索引，持有期间不再获取其他数据库锁（订单日志除外）
+    mutable std::mutex salesMutex;
+
+    // 目录快照：浏览和关键词搜索读已发布的快照，不取引擎锁。
+    // 写操作修改 products 后发布新版本：引擎锁内的修改在释放锁时发布，其余写操作改完即发布
+    SnapshotCell<CatalogSnapshot> catalog;
+    std::atomic<bool> catalogChanged;     // 是否有未发布的修改
+    // 发布快照和修改查询版本号时持有；增删改商品连同版本号在锁内完成，快照中不会只有其中一半
+    std::mutex catalogMutex;
+    uint64_t catalogVersion;
+
+    // 会话表自带分片锁，不受引擎锁保护
+    SessionManager sessions;
 public:
-    DatabaseManager() {
+    /**
+     * @brief 构造数据库
+     * @param dataDirectory 持久化数据目录（购物车日志、订单日志和归档），为空表示纯内存运行
+     * @param shardCount 用户表和热订单表的分片数
+     */
+    explicit DatabaseManager(std::string dataDirectory = "shop_data",
+        size_t shardCount = OrderStore::DEFAULT_SHARD_COUNT)
+        : users(shardCount), orders(shardCount), journalSequence(0), orderArchiveAge(std::chrono::hours(24 * 30)),
+        ordersSinceArchive(0), dataDirectory(std::move(dataDirectory)), catalog(std::make_unique<CatalogSnapshot>()), catalogChanged(false),
+        catalogVersion(0) {
         initializeSampleData();
+        rebuildProductIndex();
+        publishCatalog(true);
+
+        std::string cartLogPath;
+        std::string orderArchivePath;
+        std::string orderJournalPath;
+        if (!this->dataDirectory.empty()) {
+            std::error_code error;
+            std::filesystem::create_directories(this->dataDirectory, error);
+            cartLogPath = (std::filesystem::path(this->dataDirectory) / "carts.log").string();
+            orderArchivePath = (std::filesystem::path(this->dataDirectory) / "orders.archive").string();
+            orderJournalPath = (std::filesystem::path(this->dataDirectory) / "orders.journal").string();
+        }
+        carts.open(cartLogPath);
+        orderArchive.open(orderArchivePath);
+
+        // 畅销榜和卖家汇总的历史部分从归档中恢复；恢复出的订单ID都登记，新订单的序号排在其后
+        for (const auto& segment : orderArchive.loadAllSegments()) {
+            for (const auto& order : segment) {
+                Order::reserveOrderId(order.getOrderId());
+                CategoryMap categories;
+                lookupCategories(order, categories);
+                std::lock_guard<std::mutex> sales(salesMutex);
+                applyOrderChange(nullptr, order, categories);
+            }
+        }
+        // 热订单由日志重放（日志打开前的修改不会再写入日志），之后写成检查点
+        if (!orderJournalPath.empty()) {
+            replayOrderJournal(GroupCommitLog::readRecords(orderJournalPath));
+            std::unique_lock<std::shared_mutex> writers(orderWriteMutex);
+            orders.forEach([](const Order& order) { Order::reserveOrderId(order.getOrderId()); });
+            orderJournal.open(orderJournalPath);
+            checkpointOrderJournal();
+        }
+        for (size_t i = 0; i < complaints.size(); ++i) {
+            recordComplaint(complaints[i]);
+            indexComplaint(i);
+            clusterComplaint(i);
+        }
+    }
+
+    const std::string& getDataDirectory() const { return dataDirectory; }
+
+    /**
+     * @brief 引擎锁的持有者，释放前发布本次操作对商品表的修改
+     *
+     * 操作写了订单日志时，先释放锁再等待日志落盘（提前释放锁）：等待期间其他会话的写操作
+     * 可以取锁并加入同一批，多个会话的下单共用一次同步；调用方在析构返回后才算写入完成。
+     */
+    class EngineLock {
+    public:
+        explicit EngineLock(DatabaseManager& db) : db(db), guard(db.engineMutex) {
+            db.engineOwner.store(std::this_thread::get_id());
+        }
+
+        ~EngineLock() {
+            release();
+        }
+
+        /**
+         * @brief 提前释放引擎锁，并等待本次操作写入的订单日志落盘
+         * @return 日志写入或同步失败时返回 false；未写日志时返回 true，重复调用返回第一次的结果
+         *
+         * 写订单日志的操作（下单、取消）应显式调用：此时内存中的修改已生效，返回 false 只表示未能持久化；
+         * 析构时同样会释放并等待，但落盘结果无人可见。
+         */
+        bool release() {
+            if (!guard.owns_lock()) return durable;
+            if (db.catalogChanged.load()) db.publishCatalog(false);
+            uint64_t sequence = std::exchange(db.journalSequence, 0);
+            db.engineOwner.store(std::thread::id());
+            guard.unlock();
+            durable = db.orderJournal.waitDurable(sequence);
+            return durable;
+        }
+
+        EngineLock(const EngineLock&) = delete;
+        EngineLock& operator=(const EngineLock&) = delete;
+
+    private:
+        DatabaseManager& db;
+        std::unique_lock<std::mutex> guard;
+        bool durable = true;
+    };
+
+    /**
+     * @brief 获取引擎锁，多个会话共享同一个 DatabaseManager 时使用
+     */
+    EngineLock lock() {
+        return EngineLock(*this);
+    }
+
+    /**
+     * @brief 读取已发布的目录快照，不取引擎锁；持有期间快照不会被回收
+     *
+     * 写者改完即自行发布，读者不等待正在进行的发布，读到的是最近发布完成的版本；
+     * 持有引擎锁的线程读取时先发布自己尚未发布的修改，保证读到本次操作写入的内容。
+     */
+    SnapshotCell<CatalogSnapshot>::ReadGuard readCatalog() {
+        if (catalogChanged.load() && engineOwner.load() == std::this_thread::get_id()) publishCatalog(false);
+        return catalog.read();
     }
 
     void initializeSampleData() {
         // 初始化用户
-        users.push_back(User("admin", "admin123", "admin", "admin@shop.com", "13800138000"));
-        users.push_back(User("user1", "123456", "customer", "user1@email.com", "13900139000"));
-        users.push_back(User("user2", "123456", "customer", "user2@email.com", "13900139001"));
+        users.add(User("admin", "admin123", "admin", "admin@shop.com", "13800138000"));
+        users.add(User("user1", "123456", "customer", "user1@email.com", "13900139000"));
+        users.add(User("user2", "123456", "customer", "user2@email.com", "13900139001"));
 
         // 初始化商品，现在包含卖家信息
-        products.push_back(Product("P001", "iPhone 15", "电子产品", 5999.00, 50,
+        products.add(Product("P001", "iPhone 15", "电子产品", Money::fromCents(599900), 50,
             "最新款苹果手机", true, "user1", "13900139000"));
-        products.push_back(Product("P002", "华为Mate 60", "电子产品", 4999.00, 30,
+        products.add(Product("P002", "华为Mate 60", "电子产品", Money::fromCents(499900), 30,
             "华为旗舰手机", true, "user2", "13900139001"));
-        products.push_back(Product("P003", "牛奶", "食品", 5.50, 200,
+        products.add(Product("P003", "牛奶", "食品", Money::fromCents(550), 200,
             "纯牛奶250ml", true, "user1", "13900139000"));
-        products.push_back(Product("P004", "面包", "食品", 8.00, 150,
+        products.add(Product("P004", "面包", "食品", Money::fromCents(800), 150,
             "新鲜烘焙面包", false, "user2", "13900139001"));
-        products.push_back(Product("P005", "T恤", "服装", 59.00, 100,
+        products.add(Product("P005", "T恤", "服装", Money::fromCents(5900), 100,
             "纯棉短袖T恤", true, "user1", "13900139000"));
 
         // 初始化投诉数据
@@ -46,61 +239,93 @@ public:
         complaints.push_back(Complaint("P003", "牛奶", "user2", "虚假宣传",
             "牛奶过期", "牛奶生产日期已过保质期"));
     }
-    // 用户管理（原有方法保持不变）
-    bool addUser(const User& user) {
-        if (getUser(user.getUsername()) != nullptr) {
-            return false;
-        }
-        users.push_back(user);
-        return true;
+    // 用户管理：用户表自带分片锁，addUser / findUserId / copyUser / copyUserById 不需要引擎锁
+    // 写入方法按值接收记录，调用方可移动传入；用户名已存在时返回 false
+    bool addUser(User user) {
+        return users.add(std::move(user));
     }
 
-    User* getUser(const std::string& username) {
-        for (auto& user : users) {
-            if (user.getUsername() == username) {
-                return &user;
-            }
-        }
-        return nullptr;
+    // 返回表内指针，调用方须持有引擎锁
+    // 查询方法接收 string_view，传字面量或子串时不构造临时字符串
+    User* getUser(std::string_view username) {
+        return users.find(username);
+    }
+
+    // 用户不会被删除，编号保持稳定
+    int findUserId(std::string_view username) const {
+        return users.findId(username);
+    }
+
+    User* getUserById(uint32_t userId) {
+        return users.findById(userId);
+    }
+
+    bool copyUser(std::string_view username, User& result) const {
+        return users.copy(username, result);
+    }
+
+    bool copyUserById(uint32_t userId, User& result) const {
+        return users.copyById(userId, result);
     }
 
     std::vector<User> getAllUsers() {
-        return users;
+        return users.getAll();
+    }
+
+    /**
+     * @brief 批量导入用户（不需要引擎锁），导入成功的记录从 users 中移走
+     */
+    UserImportReport importUsers(std::vector<User>& users, unsigned threadCount = 0) {
+        return UserImporter::run(this->users, users, threadCount);
+    }
+
+    bool userExists(std::string_view username) {
+        return users.findId(username) >= 0;
     }
 
-    bool userExists(const std::string& username) {
-        return getUser(username) != nullptr;
+    // 返回 false 表示用户名一定不存在（只查过滤器，不取锁）
+    bool userMayExist(std::string_view username) const {
+        return users.mayContain(username);
     }
 
     bool updateUser(const User& user) {
-        User* existingUser = getUser(user.getUsername());
-        if (existingUser) {
-            *existingUser = user;
-            return true;
-        }
-        return false;
+        return users.update(user);
     }
 
     // 商品管理 - 新增状态相关方法
-    bool addProduct(const Product& product) {
-        if (getProduct(product.getId()) != nullptr) {
-            return false;
+    // 增删商品和修改商品资料须持有引擎锁；库存和商品读取不需要
+    bool addProduct(Product product) {
+        size_t position = products.size();
+        {
+            std::lock_guard<std::mutex> guard(catalogMutex);
+            if (!products.add(product)) return false;
+            if (product.getIsActive()) queryStamps.bumpCategory(product.getCategory());
+        }
+        {
+            std::lock_guard<std::mutex> sales(salesMutex);
+            sellerIndex.addProduct(product.getSellerUsername(), position);
         }
-        products.push_back(product);
+        fuzzyNames.add(position, product.getName());
+        searchIndex.add(position, product.getName(), product.getDescription());
+        markCatalogChanged();
         return true;
     }
 
-    Product* getProduct(const std::string& productId) {
-        for (auto& product : products) {
-            if (product.getId() == productId) {
-                return &product;
-            }
-        }
-        return nullptr;
+    // 由紧凑记录还原的副本；修改商品经 updateProduct、reduceStock 等方法写回
+    std::optional<Product> getProduct(std::string_view productId) const {
+        return products.get(productId);
+    }
+
+    bool productExists(std::string_view productId) const {
+        size_t position;
+        return products.find(productId, position);
     }
     // ==================== 投诉管理 ====================
-    bool addComplaint(const Complaint& complaint) {
-        complaints.push_back(complaint);
+    bool addComplaint(Complaint complaint) {
+        recordComplaint(complaint);
+        complaints.push_back(std::move(complaint));
+        indexComplaint(complaints.size() - 1);
+        clusterComplaint(complaints.size() - 1);
         return true;
     }
 
@@ -108,7 +333,7 @@ public:
         return complaints;
     }
 
-    std::vector<Complaint> getComplaintsByUser(const std::string& username) {
+    std::vector<Complaint> getComplaintsByUser(std::string_view username) {
         std::vector<Complaint> result;
         for (const auto& complaint : complaints) {
             if (complaint.getComplainant() == username) {
@@ -118,7 +343,7 @@ public:
         return result;
     }
 
-    std::vector<Complaint> getComplaintsByProduct(const std::string& productId) {
+    std::vector<Complaint> getComplaintsByProduct(std::string_view productId) {
         std::vector<Complaint> result;
         for (const auto& complaint : complaints) {
             if (complaint.getProductId() == productId) {
@@ -128,196 +353,1184 @@ public:
         return result;
     }
 
+    // 按处理优先级返回待处理投诉，只访问队列中的投诉
     std::vector<Complaint> getPendingComplaints() {
+        reclaimExpiredComplaints();
         std::vector<Complaint> result;
-        for (const auto& complaint : complaints) {
-            if (complaint.getStatus() == "pending") {
-                result.push_back(complaint);
-            }
-        }
+        result.reserve(complaintQueue.getPendingCount());
+        complaintQueue.forEachPending([&](size_t position) {
+            result.push_back(complaints[position]);
+            return true;
+        });
         return result;
     }
 
+    // 状态变为已解决/已关闭时移出队列，重新变为待处理时放回队列
     bool updateComplaint(const Complaint& complaint) {
-        for (auto& comp : complaints) {
-            if (comp.getComplaintId() == complaint.getComplaintId()) {
-                comp = complaint;
-                return true;
-            }
+        auto it = complaintIndex.find(complaint.getComplaintId());
+        if (it == complaintIndex.end()) return false;
+
+        size_t position = it->second;
+        complaints[position] = complaint;
+        const std::string& status = complaints[position].getStatus();
+        if (status == "pending" && !complaintQueue.isPending(position)) {
+            complaintQueue.remove(position);
+            indexComplaint(position);
         }
-        return false;
+        else if (status != "pending" && status != "processing") {
+            complaintQueue.remove(position);
+        }
+        return true;
     }
 
-    Complaint* getComplaint(const std::string& complaintId) {
-        for (auto& complaint : complaints) {
-            if (complaint.getComplaintId() == complaintId) {
-                return &complaint;
+    Complaint* getComplaint(std::string_view complaintId) {
+        auto it = complaintIndex.find(complaintId);
+        return it == complaintIndex.end() ? nullptr : &complaints[it->second];
+    }
+
+    /**
+     * @brief 领取优先级最高的待处理投诉，状态改为"处理中"并开始租约
+     * @param adminUsername 领取的管理员
+     * @return 队列为空时返回 nullptr
+     */
+    Complaint* claimNextComplaint(std::string_view adminUsername) {
+        std::vector<size_t> expired;
+        size_t position;
+        bool claimed = complaintQueue.claim(position, expired);
+        resetExpiredClaims(expired);
+        if (!claimed) return nullptr;
+
+        Complaint& complaint = complaints[position];
+        complaint.setStatus("processing");
+        complaint.setAdminUser(std::string(adminUsername));
+        return &complaint;
+    }
+
+    /**
+     * @brief 归还自己领取的投诉，按原优先级回到队列
+     */
+    bool releaseComplaint(std::string_view complaintId, std::string_view adminUsername) {
+        auto it = complaintIndex.find(complaintId);
+        if (it == complaintIndex.end()) return false;
+
+        Complaint& complaint = complaints[it->second];
+        if (complaint.getAdminUser() != adminUsername || !complaintQueue.release(it->second)) return false;
+        complaint.setStatus("pending");
+        complaint.setAdminUser("");
+        return true;
+    }
+
+    // 投诉是否被某位管理员领取且租约未过期
+    bool isComplaintClaimed(std::string_view complaintId) const {
+        auto it = complaintIndex.find(complaintId);
+        return it != complaintIndex.end() && complaintQueue.isLeased(it->second);
+    }
+
+    /**
+     * @brief 与该投诉相似（同一商品、内容相近）且尚未处理完的投诉，包括自身，按提交顺序排列
+     * @return 投诉不存在时返回空列表
+     */
+    std::vector<Complaint*> getOpenComplaintCluster(std::string_view complaintId) {
+        std::vector<Complaint*> result;
+        auto it = complaintIndex.find(complaintId);
+        if (it == complaintIndex.end()) return result;
+
+        reclaimExpiredComplaints();
+        std::vector<size_t> members = complaintClusters.getCluster(it->second);
+        std::sort(members.begin(), members.end());
+        for (size_t position : members) {
+            if (!complaints[position].isProcessed()) {
+                result.push_back(&complaints[position]);
             }
         }
-        return nullptr;
+        return result;
     }
 
+    ComplaintQueue& getComplaintQueue() { return complaintQueue; }
+
     int getTotalComplaintCount() const {
         return complaints.size();
     }
 
     int getPendingComplaintCount() const {
-        int count = 0;
-        for (const auto& complaint : complaints) {
-            if (complaint.getStatus() == "pending") {
-                count++;
-            }
-        }
-        return count;
+        return static_cast<int>(complaintQueue.getPendingCount());
+    }
+
+    int getClaimedComplaintCount() const {
+        return static_cast<int>(complaintQueue.getLeasedCount());
     }
     // 获取所有商品（包括下架的）
     std::vector<Product> getAllProducts() {
-        return products;
+        std::vector<Product> result;
+        result.reserve(products.size());
+        products.forEach([&](size_t, const ProductView& product) { product.copyTo(result.emplace_back()); });
+        return result;
+    }
+
+    /**
+     * @brief 上架商品列表，经 ProductView 读取，缓存命中时不复制商品（浏览用）
+     *
+     * 本方法和 getActiveProducts、getProductsByCategory、searchProducts 读目录快照，无需持有引擎锁
+     */
+    ProductListing listActiveProducts() {
+        return cachedQuery(QueryResultCache::Kind::ActiveProducts, "",
+            [](const ProductView& product) { return product.getIsActive(); });
     }
 
-    // 只获取上架的商品
+    // 只获取上架的商品，还原为 Product
     std::vector<Product> getActiveProducts() {
-        std::vector<Product> result;
-        for (const auto& product : products) {
-            if (product.getIsActive()) {
-                result.push_back(product);
-            }
-        }
-        return result;
+        return listActiveProducts().toProducts();
     }
 
     // 获取下架的商品
     std::vector<Product> getInactiveProducts() {
         std::vector<Product> result;
-        for (const auto& product : products) {
+        products.forEach([&](size_t, const ProductView& product) {
             if (!product.getIsActive()) {
-                result.push_back(product);
+                product.copyTo(result.emplace_back());
             }
-        }
+        });
         return result;
     }
 
-    std::vector<Product> getProductsByCategory(const std::string& category) {
+    // 经卖家索引只访问该卖家的商品，O(该卖家的商品数)
+    std::vector<Product> getProductsBySeller(std::string_view sellerUsername) {
+        std::vector<size_t> positions;
+        {
+            std::lock_guard<std::mutex> sales(salesMutex);
+            positions = sellerIndex.getProductPositions(sellerUsername);
+        }
         std::vector<Product> result;
-        for (const auto& product : products) {
-            if (product.getCategory() == category && product.getIsActive()) {
-                result.push_back(product);
-            }
+        result.reserve(positions.size());
+        for (size_t position : positions) {
+            result.push_back(products.get(position));
         }
         return result;
     }
 
-    std::vector<Product> searchProducts(const std::string& keyword) {
+    SellerStats getSellerStats(std::string_view sellerUsername) const {
+        std::lock_guard<std::mutex> sales(salesMutex);
+        return sellerIndex.getStats(sellerUsername);
+    }
+
+    std::vector<Product> getProductsByCategory(std::string_view category) {
+        return cachedQuery(QueryResultCache::Kind::Category, category, [&](const ProductView& product) {
+            return product.getCategory() == category && product.getIsActive();
+        }).toProducts();
+    }
+
+    std::vector<Product> searchProducts(std::string_view keyword) {
+        return cachedQuery(QueryResultCache::Kind::Search, keyword, [&](const ProductView& product) {
+            return product.getIsActive() &&
+                (product.getName().find(keyword) != std::string_view::npos ||
+                    product.getDescription().find(keyword) != std::string_view::npos);
+        }).toProducts();
+    }
+
+    QueryCacheStats getQueryCacheStats() const { return queryCache.getStats(); }
+
+    // 尚未回收的旧目录快照数（有读者长时间持有快照时增加）
+    size_t getRetiredCatalogCount() const { return catalog.getRetiredCount(); }
+
+    // 查询缓存容量（字节），0 表示禁用
+    void setQueryCacheCapacity(size_t capacityBytes) { queryCache.setCapacity(capacityBytes); }
+
+    /**
+     * @brief 用户名和商品ID存在性过滤器的目标误判率，立即按现有数据重建，0 表示禁用
+     *
+     * 两个过滤器都在各自的表内加锁重建，不需要引擎锁。
+     */
+    void setExistenceFilterRate(double falsePositiveRate) {
+        users.setFilterFalsePositiveRate(falsePositiveRate);
+        products.setFilterRate(falsePositiveRate);
+    }
+
+    ExistenceFilter::Stats getUserFilterStats() const { return users.getFilterStats(); }
+    ExistenceFilter::Stats getProductFilterStats() const { return products.getFilterStats(); }
+
+    /**
+     * @brief 容错搜索：按名称模糊匹配上架商品，允许关键词有少量错字、漏字、多字
+     * @param maxDistance 编辑距离上限，负数表示按关键词长度自动选择
+     * @param limit 最多返回的条数
+     * @return 按相似度排序，越相近越靠前
+     */
+    std::vector<Product> fuzzySearchProducts(std::string_view keyword, int maxDistance = -1, size_t limit = 50) {
+        auto snapshot = readCatalog();
+        std::vector<FuzzyMatch> matches = fuzzyNames.search(keyword, maxDistance, limit,
+            [&](size_t position) { return position < snapshot->size() && (*snapshot)[position].getIsActive(); });
+
         std::vector<Product> result;
-        for (const auto& product : products) {
-            if (product.getIsActive() &&
-                (product.getName().find(keyword) != std::string::npos ||
-                    product.getDescription().find(keyword) != std::string::npos)) {
-                result.push_back(product);
+        result.reserve(matches.size());
+        for (const FuzzyMatch& match : matches) {
+            result.push_back(products.get(match.position));
+        }
+        return result;
+    }
+
+    /**
+     * @brief 相关度搜索：按 BM25 对名称和描述打分，名称命中权重更高，只返回请求的一页
+     * @param page 页码，从 0 开始
+     * @param pageSize 每页条数
+     * @param useSignals 是否叠加有货和销量加分
+     */
+    SearchPage searchProductsRanked(std::string_view keyword, size_t page, size_t pageSize, bool useSignals = true) {
+        SearchPage result;
+        result.page = page;
+        result.pageSize = pageSize;
+
+        // 上架状态和库存读目录快照（本线程的修改已在 readCatalog 中发布），候选商品不逐个加块锁
+        auto snapshot = readCatalog();
+        auto bonus = [&](size_t position) {
+            ProductView product = (*snapshot)[position];
+            bool inStock = product.getStock() > 0;
+            long long units;
+            {
+                std::lock_guard<std::mutex> sales(salesMutex);
+                units = bestSellers.getUnitsSold(product.getId());
             }
+            double sales = std::log1p(static_cast<double>(units));
+            return (inStock ? SEARCH_IN_STOCK_BONUS : 0.0) +
+                SEARCH_SALES_BONUS * std::min(1.0, sales / std::log1p(SEARCH_SALES_SATURATION));
+        };
+        std::vector<SearchHit> hits = searchIndex.search(keyword, page * pageSize, pageSize,
+            [&](size_t position) { return position < snapshot->size() && (*snapshot)[position].getIsActive(); },
+            [&](size_t position) { return useSignals ? bonus(position) : 0.0; },
+            useSignals ? SEARCH_IN_STOCK_BONUS + SEARCH_SALES_BONUS : 0.0, result.totalHits);
+
+        result.products.reserve(hits.size());
+        result.scores.reserve(hits.size());
+        for (const SearchHit& hit : hits) {
+            result.products.push_back(products.get(hit.position));
+            result.scores.push_back(hit.score);
         }
         return result;
     }
 
     bool updateProduct(const Product& product) {
-        Product* existingProduct = getProduct(product.getId());
-        if (existingProduct) {
-            *existingProduct = product;
-            return true;
+        size_t position;
+        if (!products.find(product.getId(), position)) return false;
+
+        Product existing = products.get(position);
+        bool sellerChanged = existing.getSellerUsername() != product.getSellerUsername();
+        bool nameChanged = existing.getName() != product.getName();
+        bool textChanged = nameChanged || existing.getDescription() != product.getDescription();
+        if (textChanged && !sellerChanged) {
+            searchIndex.remove(position, existing.getName(), existing.getDescription());
         }
-        return false;
+        {
+            std::lock_guard<std::mutex> guard(catalogMutex);
+            if (textChanged || existing.getIsActive() != product.getIsActive() ||
+                existing.getCategory() != product.getCategory()) {
+                queryStamps.bumpCategory(existing.getCategory());
+                queryStamps.bumpCategory(product.getCategory());
+            }
+            products.assign(position, product);
+        }
+        markCatalogChanged();
+        if (sellerChanged) {
+            rebuildProductIndex();
+        }
+        else if (textChanged) {
+            if (nameChanged) fuzzyNames.update(position, product.getName());
+            searchIndex.add(position, product.getName(), product.getDescription());
+        }
+        return true;
     }
 
     // 上架商品
-    bool activateProduct(const std::string& productId) {
-        Product* product = getProduct(productId);
-        if (product) {
-            product->activate();
-            return true;
-        }
-        return false;
+    bool activateProduct(std::string_view productId) {
+        return setProductActive(productId, true);
     }
 
     // 下架商品
-    bool deactivateProduct(const std::string& productId) {
-        Product* product = getProduct(productId);
-        if (product) {
-            product->deactivate();
-            return true;
-        }
-        return false;
+    bool deactivateProduct(std::string_view productId) {
+        return setProductActive(productId, false);
     }
 
-    bool deleteProduct(const std::string& productId) {
-        auto it = std::remove_if(products.begin(), products.end(),
-            [&](const Product& p) { return p.getId() == productId; });
+    // 库存变化不影响查询的结果集合，只需在快照中更新所在的块；只锁商品所在的块，不需要引擎锁
+    bool reduceStock(std::string_view productId, int quantity) {
+        if (!products.reduceStock(productId, quantity)) return false;
+        markCatalogChanged();
+        return true;
+    }
 
-        if (it != products.end()) {
-            products.erase(it, products.end());
-            return true;
-        }
-        return false;
+    bool increaseStock(std::string_view productId, int quantity) {
+        if (!products.increaseStock(productId, quantity)) return false;
+        markCatalogChanged();
+        return true;
     }
 
-    // 订单管理（原有方法保持不变）
-    bool addOrder(const Order& order) {
-        orders.push_back(order);
+    bool deleteProduct(std::string_view productId) {
+        {
+            std::lock_guard<std::mutex> guard(catalogMutex);
+            if (!products.erase(productId)) return false;
+            queryStamps.bumpAll();
+        }
+        rebuildProductIndex();  // 删除后位置整体前移，重建索引
+        markCatalogChanged();
         return true;
     }
 
-    std::vector<Order> getOrdersByUser(const std::string& username) {
-        std::vector<Order> result;
-        for (const auto& order : orders) {
-            if (order.getUsername() == username) {
-                result.push_back(order);
+    // ==================== 事务 ====================
+    /**
+     * @brief 跨商品、订单、投诉的轻量事务，由 beginTransaction 开始
+     *
+     * 写操作先记入写集合，commit 时按锁顺序锁住涉及的商品块和订单分片（不取引擎锁），依次执行
+     * 可能失败的写（取消订单、修改库存），每执行一步记入撤销日志；任一步失败即在锁内按撤销日志逆序恢复，
+     * 数据库回到事务开始前的状态，订单日志中不留任何记录。全部成功后更新畅销榜和卖家汇总、追加新订单，
+     * 再把缓存的日志记录一并追加到订单日志，之后才释放锁，其他事务看不到中间状态。
+     * 日志记录只进入组提交缓冲区，落盘用 waitDurable 等待；在引擎锁内提交时释放引擎锁也会等待。
+     * 修改投诉仍须持有引擎锁，未持有时事务失败。未提交的事务不产生任何修改。
+     */
+    class Transaction {
+    public:
+        explicit Transaction(DatabaseManager& db) : db(db) {}
+
+        Transaction(const Transaction&) = delete;
+        Transaction& operator=(const Transaction&) = delete;
+
+        void reduceStock(std::string_view productId, int quantity) {
+            stockChanges.push_back(StockChange{ std::string(productId), -quantity });
+        }
+
+        void increaseStock(std::string_view productId, int quantity) {
+            stockChanges.push_back(StockChange{ std::string(productId), quantity });
+        }
+
+        // 取消订单并扣除其销量；订单不存在或当前状态不能取消时事务失败
+        void cancelOrder(std::string_view orderId) {
+            cancelledOrders.emplace_back(orderId);
+        }
+
+        void addOrder(Order order) {
+            newOrders.push_back(std::move(order));
+        }
+
+        void updateComplaint(Complaint complaint) {
+            updatedComplaints.push_back(std::move(complaint));
+        }
+
+        void addComplaint(Complaint complaint) {
+            newComplaints.push_back(std::move(complaint));
+        }
+
+        /**
+         * @brief 提交写集合
+         * @return 任一步失败时全部撤销并返回 false，原因见 getError
+         */
+        bool commit() {
+            undoLog.clear();
+            error.clear();
+            journalSequence = 0;
+            if (!checkComplaints()) {
+                clear();
+                return false;
+            }
+
+            // 加锁前确定要锁的商品和订单分片，并查好订单中商品的类别（持锁期间不再访问商品表的其他块）
+            std::vector<std::string_view> productIds;
+            productIds.reserve(stockChanges.size());
+            for (const StockChange& change : stockChanges) productIds.push_back(change.productId);
+            std::vector<size_t> shardIds;
+            CategoryMap categories;
+            for (const std::string& orderId : cancelledOrders) {
+                Order order;
+                if (db.orders.copy(orderId, order)) {
+                    shardIds.push_back(db.orders.shardOfUser(order.getUsername()));
+                    db.lookupCategories(order, categories);
+                }
+            }
+            for (const Order& order : newOrders) {
+                shardIds.push_back(db.orders.shardOfUser(order.getUsername()));
+                db.lookupCategories(order, categories);
+            }
+
+            size_t addedOrders = newOrders.size();
+            bool writesOrders = !cancelledOrders.empty() || addedOrders > 0;
+            {
+                std::shared_lock<std::shared_mutex> writers(db.orderWriteMutex, std::defer_lock);
+                if (writesOrders) writers.lock();
+                ProductStore::Batch stock = db.products.lock(productIds);
+                OrderStore::ShardLocks locked = db.orders.lockShards(std::move(shardIds));
+                if (!applyFallibleWrites(stock, locked)) {
+                    rollback(stock, locked);
+                    clear();
+                    return false;
+                }
+                applyOrders(locked, categories);
+            }
+
+            for (const Complaint& complaint : updatedComplaints) {
+                db.updateComplaint(complaint);
+            }
+            for (Complaint& complaint : newComplaints) {
+                db.addComplaint(std::move(complaint));
             }
+            if (!stockChanges.empty()) db.markCatalogChanged();
+            clear();
+            if (addedOrders > 0) db.afterOrdersAdded(addedOrders);
+            return true;
         }
-        return result;
+
+        /**
+         * @brief 等待上一次提交写入的订单日志落盘
+         * @return 日志写入或同步失败时返回 false；未写日志时返回 true
+         */
+        bool waitDurable() {
+            return db.orderJournal.waitDurable(journalSequence);
+        }
+
+        // 上一次提交写入的最后一条日志序号，0 表示未写日志；交给其他线程时用 waitOrderJournal 等待落盘
+        uint64_t getJournalSequence() const { return journalSequence; }
+
+        const std::string& getError() const { return error; }
+
+    private:
+        struct StockChange {
+            std::string productId;
+            int delta;
+        };
+
+        struct OrderStatus {
+            std::string orderId;
+            std::string status;
+        };
+
+        // 撤销记录：库存变化的反向量，或订单取消前的状态
+        using UndoRecord = std::variant<StockChange, OrderStatus>;
+
+        DatabaseManager& db;
+        std::vector<StockChange> stockChanges;
+        std::vector<std::string> cancelledOrders;
+        std::vector<Order> newOrders;
+        std::vector<Complaint> updatedComplaints;
+        std::vector<Complaint> newComplaints;
+        std::vector<Order> cancelledBefore;  // 被取消的订单取消前的副本，用于调整畅销榜和卖家汇总
+        std::vector<UndoRecord> undoLog;
+        std::string error;
+        uint64_t journalSequence = 0;        // 上一次提交写入的最后一条日志序号
+
+        bool checkComplaints() {
+            if (updatedComplaints.empty() && newComplaints.empty()) return true;
+            if (db.engineOwner.load() != std::this_thread::get_id()) {
+                error = "修改投诉须持有引擎锁";
+                return false;
+            }
+            for (const Complaint& complaint : updatedComplaints) {
+                if (!db.getComplaint(complaint.getComplaintId())) {
+                    error = "投诉 " + complaint.getComplaintId() + " 不存在";
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool applyFallibleWrites(ProductStore::Batch& stock, OrderStore::ShardLocks& locked) {
+            for (const std::string& orderId : cancelledOrders) {
+                const Order* order = locked.find(orderId);
+                if (!order || !order->canCancel()) {
+                    error = "订单 " + orderId + " 无法取消";
+                    return false;
+                }
+                cancelledBefore.push_back(*order);
+                undoLog.emplace_back(OrderStatus{ orderId, order->getStatus() });
+                locked.update(orderId, [](Order& target) {
+                    target.cancel();
+                    return true;
+                });
+            }
+
+            for (const StockChange& change : stockChanges) {
+                size_t position;
+                if (!stock.find(change.productId, position)) {
+                    error = "商品 " + change.productId + " 不存在";
+                    return false;
+                }
+                if (change.delta < 0 && !stock.reduceStock(position, -change.delta)) {
+                    error = "商品 " + change.productId + " 库存不足";
+                    return false;
+                }
+                if (change.delta > 0) stock.increaseStock(position, change.delta);
+                undoLog.emplace_back(StockChange{ change.productId, -change.delta });
+            }
+            return true;
+        }
+
+        // 按撤销日志逆序恢复；撤销的每一步都是已成功的写的逆操作，不会失败。此时尚未写日志、未改畅销榜
+        void rollback(ProductStore::Batch& stock, OrderStore::ShardLocks& locked) {
+            for (auto it = undoLog.rbegin(); it != undoLog.rend(); ++it) {
+                if (auto* change = std::get_if<StockChange>(&*it)) {
+                    size_t position = 0;
+                    stock.find(change->productId, position);
+                    if (change->delta < 0) stock.reduceStock(position, -change->delta);
+                    else stock.increaseStock(position, change->delta);
+                }
+                else {
+                    const OrderStatus& before = std::get<OrderStatus>(*it);
+                    locked.update(before.orderId, [&](Order& target) {
+                        target.setStatus(before.status);
+                        return true;
+                    });
+                }
+            }
+        }
+
+        // 提交点之后：更新畅销榜和卖家汇总、追加新订单，日志记录在释放分片锁前追加，
+        // 同一订单的日志记录顺序与内存中的修改顺序一致
+        void applyOrders(OrderStore::ShardLocks& locked, const CategoryMap& categories) {
+            std::vector<std::string> records;
+            records.reserve(cancelledBefore.size() + newOrders.size());
+            {
+                std::lock_guard<std::mutex> sales(db.salesMutex);
+                for (const Order& before : cancelledBefore) {
+                    db.applyOrderChange(&before, *locked.find(before.getOrderId()), categories);
+                }
+                for (const Order& order : newOrders) {
+                    db.applyOrderChange(nullptr, order, categories);
+                }
+            }
+            for (const Order& before : cancelledBefore) {
+                records.push_back(journalRecord('X', TextRecord::escape(before.getOrderId())));
+            }
+            for (Order& order : newOrders) {
+                records.push_back(journalRecord('O', order.toString()));
+                locked.add(std::move(order));
+            }
+            for (const std::string& record : records) {
+                if (uint64_t sequence = db.appendJournal(record)) journalSequence = sequence;
+            }
+        }
+
+        void clear() {
+            stockChanges.clear();
+            cancelledOrders.clear();
+            newOrders.clear();
+            updatedComplaints.clear();
+            newComplaints.clear();
+            cancelledBefore.clear();
+            undoLog.clear();
+        }
+    };
+
+    /**
+     * @brief 开始一个事务，不需要引擎锁（含投诉修改时除外）
+     */
+    Transaction beginTransaction() {
+        return Transaction(*this);
+    }
+
+    /**
+     * @brief 等待序号不超过 sequence 的订单日志落盘，序号由 Transaction::getJournalSequence 取得
+     * @return 日志写入或同步失败时返回 false；sequence 为 0 时立即返回 true
+     */
+    bool waitOrderJournal(uint64_t sequence) {
+        return orderJournal.waitDurable(sequence);
+    }
+
+    // 订单管理：下单、改单、取消不取引擎锁，只锁订单所在的分片（见 Transaction）
+    // 每新增 ARCHIVE_CHECK_INTERVAL 个订单检查一次归档和订单日志的长度，均摊到下单操作上
+    bool addOrder(Order order) {
+        Transaction transaction(*this);
+        transaction.addOrder(std::move(order));
+        return transaction.commit();
+    }
+
+    // 以下三个读取方法只持分片锁，不需要引擎锁
+    std::vector<Order> getOrdersByUser(std::string_view username) {
+        return orders.getByUser(username);
     }
 
     std::vector<Order> getAllOrders() {
-        return orders;
+        return orders.getAll();
     }
 
-    Order* getOrder(const std::string& orderId) {
-        for (auto& order : orders) {
-            if (order.getOrderId() == orderId) {
-                return &order;
-            }
-        }
-        return nullptr;
+    bool copyOrder(std::string_view orderId, Order& result) const {
+        return orders.copy(orderId, result);
     }
 
+    // 订单在"已取消"和其他状态之间变化时同步调整畅销榜（不能修改订单ID和下单用户）
     bool updateOrder(const Order& order) {
-        for (auto& ord : orders) {
-            if (ord.getOrderId() == order.getOrderId()) {
-                ord = order;
-                return true;
+        Order previous;
+        if (!orders.copy(order.getOrderId(), previous)) return false;
+        CategoryMap categories;
+        lookupCategories(previous, categories);
+        lookupCategories(order, categories);
+
+        std::shared_lock<std::shared_mutex> writers(orderWriteMutex);
+        return orders.update(order.getOrderId(), [&](Order& target) {
+            {
+                std::lock_guard<std::mutex> sales(salesMutex);
+                applyOrderChange(&target, order, categories);
+            }
+            target = order;
+            appendJournal(journalRecord('U', order.toString()));
+            return true;
+        });
+    }
+
+    /**
+     * @brief 取消订单并扣除其销量（单条事务）
+     * @return 订单不存在或当前状态不能取消时返回 false
+     */
+    bool cancelOrder(std::string_view orderId) {
+        Transaction transaction(*this);
+        transaction.cancelOrder(orderId);
+        return transaction.commit();
+    }
+
+    // ==================== 畅销榜 ====================
+    /**
+     * @brief 按名次依次访问畅销商品，visitor(productId, units) 返回 false 时停止
+     *
+     * 名次在销量锁内按批复制，回调在锁外执行，可以读取商品；批次之间有新订单时名次可能略有变动。
+     */
+    template <typename Visitor>
+    void forEachBestSeller(std::string_view category, bool recentOnly, Visitor&& visitor) {
+        size_t skipped = 0;
+        size_t batch = BEST_SELLER_BATCH;
+        while (true) {
+            std::vector<std::pair<std::string, long long>> ranked;
+            {
+                std::lock_guard<std::mutex> sales(salesMutex);
+                size_t index = 0;
+                bestSellers.forEachRanked(category, recentOnly, [&](const std::string& productId, long long units) {
+                    if (index++ < skipped) return true;
+                    ranked.emplace_back(productId, units);
+                    return ranked.size() < batch;
+                });
+            }
+            for (const auto& [productId, units] : ranked) {
+                if (!visitor(productId, units)) return;
             }
+            if (ranked.size() < batch) return;
+            skipped += batch;
+            batch *= 2;
         }
-        return false;
     }
 
+    int getBestSellerWindowDays() const {
+        std::lock_guard<std::mutex> sales(salesMutex);
+        return bestSellers.getWindowDays();
+    }
+
+    // ==================== 订单归档 ====================
+    // copyOrder / getOrdersByUser / getAllOrders 只查热数据，归档订单通过下面的方法按需查询
+    void setOrderArchiveAge(std::chrono::seconds age) { orderArchiveAge = age; }
+    std::chrono::seconds getOrderArchiveAge() const { return orderArchiveAge; }
+
+    /**
+     * @brief 把下单时间早于归档期限的已结束订单移入归档，调用方须持有引擎锁
+     * @param now 当前时间（默认取系统时间）
+     * @return 归档的订单数
+     */
+    size_t archiveFinishedOrders(std::time_t now = std::time(nullptr)) {
+        std::unique_lock<std::shared_mutex> writers(orderWriteMutex);
+        return archiveExpiredOrders(now);
+    }
+
+    bool findArchivedOrder(std::string_view orderId, Order& result) {
+        return orderArchive.findOrder(orderId, result);
+    }
+
+    std::vector<Order> getArchivedOrdersByUser(std::string_view username) {
+        return orderArchive.getOrdersByUser(username);
+    }
+
+    const OrderArchive& getOrderArchive() const { return orderArchive; }
+
+    // ==================== 内存统计与上限 ====================
+    /**
+     * @brief 各表和各索引的内存占用（估算），调用方须持有引擎锁
+     *
+     * 遍历全部记录，耗时与数据量成正比；用户表、订单表和会话表逐个分片加锁统计。
+     */
+    MemoryReport getMemoryReport() {
+        MemoryReport report;
+        auto table = [&](const char* name, MemoryUsage usage) { report.entries.push_back({ name, false, usage }); };
+        auto index = [&](const char* name, MemoryUsage usage) { report.entries.push_back({ name, true, usage }); };
+        auto filter = [](const ExistenceFilter::Stats& stats) { return MemoryUsage{ stats.memoryBytes, stats.keys }; };
+
+        MemoryUsage complaintUsage{ MemoryAccounting::ofVector(complaints), complaints.size() };
+        for (const auto& complaint : complaints) complaintUsage.bytes += complaint.getHeapBytes();
+        MemoryUsage complaintIndexUsage{ MemoryAccounting::ofHashTable(complaintIndex), complaintIndex.size() };
+        for (const auto& [complaintId, position] : complaintIndex) {
+            complaintIndexUsage.bytes += MemoryAccounting::ofString(complaintId);
+        }
+        QueryCacheStats cache = queryCache.getStats();
+        MemoryUsage sellerIndexUsage;
+        MemoryUsage bestSellerUsage;
+        {
+            std::lock_guard<std::mutex> sales(salesMutex);
+            sellerIndexUsage = sellerIndex.getMemoryUsage();
+            bestSellerUsage = bestSellers.getMemoryUsage();
+        }
+
+        table("用户", users.getMemoryUsage());
+        table("商品", products.getMemoryUsage());
+        table("热订单", orders.getMemoryUsage());
+        table("归档订单", orderArchive.getMemoryUsage());
+        table("投诉", complaintUsage);
+        table("购物车", carts.getMemoryUsage());
+        table("会话", sessions.getMemoryUsage());
+        index("用户名索引", users.getIndexMemoryUsage());
+        index("用户名过滤器", filter(users.getFilterStats()));
+        index("商品ID索引", products.getIndexMemoryUsage());
+        index("商品ID过滤器", filter(products.getFilterStats()));
+        index("卖家索引", sellerIndexUsage);
+        index("容错搜索索引", fuzzyNames.getMemoryUsage());
+        index("相关度搜索索引", searchIndex.getMemoryUsage());
+        index("目录快照", readCatalog()->getMemoryUsage(products));
+        index("查询缓存", MemoryUsage{ cache.memoryBytes, cache.entryCount });
+        index("订单索引", orders.getIndexMemoryUsage());
+        index("畅销榜", bestSellerUsage);
+        index("投诉ID索引", complaintIndexUsage);
+        index("投诉队列", complaintQueue.getMemoryUsage());
+        index("相似投诉分组", complaintClusters.getMemoryUsage());
+        return report;
+    }
+
+    /**
+     * @brief 设置内存软上限，调用方须持有引擎锁或在启动时调用
+     *
+     * 热订单上限在每次归档检查时（每 ARCHIVE_CHECK_INTERVAL 个新订单）按增量统计比较，开销很小；
+     * 总上限需要生成完整报告，最多每 MEMORY_CHECK_PERIOD 检查一次。
+     */
+    void setMemoryLimits(const MemoryLimits& limits) {
+        memoryLimits = limits;
+        lastMemoryCheck = std::chrono::steady_clock::time_point();
+    }
+
+    const MemoryLimits& getMemoryLimits() const { return memoryLimits; }
+    const MemoryPressureStats& getMemoryPressureStats() const { return memoryPressure; }
+    size_t getHotOrderBytes() const { return orders.getLiveBytes(); }
+
+    /**
+     * @brief 立即按上限检查并回收：提前归档最早的已结束订单，仍超总上限时淘汰查询缓存
+     *
+     * 超限时回收到上限的 (100 - MEMORY_HEADROOM_PERCENT)%，留出余量，避免每次检查都刚好触发。
+     * 调用方须持有引擎锁。
+     */
+    const MemoryPressureStats& enforceMemoryLimits() {
+        std::unique_lock<std::shared_mutex> writers(orderWriteMutex);
+        return enforceMemoryLimitsExclusive();
+    }
+
+    // ==================== 订单日志 ====================
+    // 下单、改单、取消各写一条日志记录，等待落盘见 Transaction::waitDurable 和 EngineLock::release
+    void setOrderJournalOptions(GroupCommitOptions options) { orderJournal.setOptions(options); }
+    GroupCommitStats getOrderJournalStats() const { return orderJournal.getStats(); }
+
+    // ==================== 购物车 ====================
+    // 购物车按用户名保存，退出登录和重启后仍保留；自带锁，下单时不需要引擎锁
+    CartStore& getCarts() { return carts; }
+
+    // ==================== 会话管理 ====================
+    SessionManager& getSessions() { return sessions; }
+
     // 统计信息
-    int getTotalUserCount() const { return users.size(); }
+    int getTotalUserCount() const { return static_cast<int>(users.size()); }
     int getTotalProductCount() const { return products.size(); }
     int getActiveProductCount() const {
         int count = 0;
-        for (const auto& product : products) {
+        products.forEach([&](size_t, const ProductView& product) {
             if (product.getIsActive()) count++;
-        }
+        });
         return count;
     }
-    int getTotalOrderCount() const { return orders.size(); }
+    // 订单总数与销售额包含已归档的订单
+    int getTotalOrderCount() const { return static_cast<int>(orders.size() + orderArchive.getOrderCount()); }
+    int getActiveOrderCount() const { return static_cast<int>(orders.size()); }
+
+    int getCartCount() const { return static_cast<int>(carts.getCartCount()); }
+
+    /**
+     * @brief 按卖家、类别、商品、日期统计销售额（包含已归档的订单），调用方须持有引擎锁
+     * @param threadCount 线程数，0 表示使用硬件线程数
+     *
+     * 类别取自目录快照；统计期间持订单写锁的独占模式，下单和取消等待统计结束。
+     */
+    SalesReport computeSalesReport(unsigned threadCount = 0) {
+        auto snapshot = readCatalog();
+        SalesAnalytics::CategoryLookup categories;
+        categories.reserve(snapshot->size());
+        snapshot->forEach([&](size_t, const ProductView& product) {
+            categories.emplace(product.getId(), product.getCategory());
+        });
+
+        std::unique_lock<std::shared_mutex> writers(orderWriteMutex);
+        std::vector<std::vector<Order>> archived = orderArchive.loadAllSegments();
+        std::vector<std::span<const Order>> sources;
+        sources.reserve(archived.size() + orders.getShardCount());
+        orders.forEachShard([&](const std::vector<Order>& shard) { sources.emplace_back(shard); });
+        for (const auto& segment : archived) {
+            sources.emplace_back(segment);
+        }
+        return SalesAnalytics::compute(sources, categories, threadCount);
+    }
+
+    // 热订单部分对各分片的销售额列做向量化整数求和，不逐个访问订单
+    Money getTotalSales() const {
+        return orderArchive.getSales() + orders.sumSales();
+    }
+
+private:
+    static constexpr size_t ARCHIVE_CHECK_INTERVAL = 1024;
+    static constexpr size_t BEST_SELLER_BATCH = 64;
+    static constexpr size_t MEMORY_HEADROOM_PERCENT = 10;
+    static constexpr std::chrono::seconds MEMORY_CHECK_PERIOD{ 10 };
+
+    static size_t withHeadroom(size_t limit) {
+        return limit / 100 * (100 - MEMORY_HEADROOM_PERCENT);
+    }
+
+    // 调用方持有引擎锁和订单写锁的独占模式
+    const MemoryPressureStats& enforceMemoryLimitsExclusive() {
+        lastMemoryCheck = std::chrono::steady_clock::now();
+        bool over = enforceHotOrderLimit();
+        bool stillOver = memoryLimits.hotOrderBytes > 0 && orders.getLiveBytes() > memoryLimits.hotOrderBytes;
+
+        if (memoryLimits.totalBytes > 0) {
+            ++memoryPressure.checks;
+            size_t total = getMemoryReport().getTotalBytes();
+            if (total > memoryLimits.totalBytes) {
+                over = true;
+                size_t excess = total - withHeadroom(memoryLimits.totalBytes);
+                size_t freed = shedHotOrders(excess);
+                if (freed < excess) {
+                    size_t cached = queryCache.getStats().memoryBytes;
+                    size_t remaining = excess - freed;
+                    memoryPressure.cacheBytesTrimmed += queryCache.trim(cached > remaining ? cached - remaining : 0);
+                }
+                total = getMemoryReport().getTotalBytes();
+            }
+            memoryPressure.lastTotalBytes = total;
+            stillOver = stillOver || total > memoryLimits.totalBytes;
+        }
+
+        if (over) ++memoryPressure.overLimitEvents;
+        memoryPressure.overLimit = stillOver;
+        return memoryPressure;
+    }
+
+    // 每次归档检查时调用：热订单上限只比较增量统计值，总上限按周期生成完整报告
+    void checkMemoryLimits() {
+        if (memoryLimits.totalBytes > 0 && std::chrono::steady_clock::now() - lastMemoryCheck >= MEMORY_CHECK_PERIOD) {
+            enforceMemoryLimitsExclusive();
+        }
+        else if (enforceHotOrderLimit()) {
+            ++memoryPressure.overLimitEvents;
+            memoryPressure.overLimit = orders.getLiveBytes() > memoryLimits.hotOrderBytes;
+        }
+    }
+
+    // 热订单超过上限时提前归档，返回检查时是否超限
+    bool enforceHotOrderLimit() {
+        if (memoryLimits.hotOrderBytes == 0 || orders.getLiveBytes() <= memoryLimits.hotOrderBytes) return false;
+        shedHotOrders(orders.getLiveBytes() - withHeadroom(memoryLimits.hotOrderBytes));
+        return true;
+    }
+
+    /**
+     * @brief 按下单时间从早到晚选取已结束的订单，累计到 bytesToFree 为止，提前移入归档
+     * @return 热订单减少的字节数
+     */
+    size_t shedHotOrders(size_t bytesToFree) {
+        std::vector<std::pair<std::time_t, size_t>> finished;
+        orders.forEach([&](const Order& order) {
+            std::time_t placedAt = order.getOrderTimestamp();
+            if (order.isFinished() && placedAt != -1) finished.emplace_back(placedAt, OrderStore::bytesOf(order));
+        });
+        if (finished.empty()) return 0;
+
+        std::sort(finished.begin(), finished.end());
+        std::time_t cutoff = finished.front().first;
+        size_t selected = 0;
+        for (const auto& [placedAt, bytes] : finished) {
+            cutoff = placedAt;
+            selected += bytes;
+            if (selected >= bytesToFree) break;
+        }
+
+        size_t before = orders.getLiveBytes();
+        memoryPressure.ordersArchived += archiveFinishedOrdersPlacedBy(cutoff);
+        return before - orders.getLiveBytes();
+    }
+
+    // 调用方持有订单写锁的独占模式
+    size_t archiveExpiredOrders(std::time_t now) {
+        ordersSinceArchive.store(0);
+        return archiveFinishedOrdersPlacedBy(now - static_cast<std::time_t>(orderArchiveAge.count()));
+    }
+
+    /**
+     * @brief 事务追加订单后调用：累计满 ARCHIVE_CHECK_INTERVAL 个时归档、写检查点并检查内存上限
+     *
+     * 未持有引擎锁时先取引擎锁，再取订单写锁的独占模式，等进行中的事务结束后执行。
+     */
+    void afterOrdersAdded(size_t added) {
+        if (ordersSinceArchive.fetch_add(added) + added < ARCHIVE_CHECK_INTERVAL) return;
+        std::optional<EngineLock> engine;
+        if (engineOwner.load() != std::this_thread::get_id()) engine.emplace(*this);
+        std::unique_lock<std::shared_mutex> writers(orderWriteMutex);
+        if (ordersSinceArchive.load() < ARCHIVE_CHECK_INTERVAL) return;  // 其他线程已经执行过
+
+        if (archiveExpiredOrders(std::time(nullptr)) == 0 &&
+            orderJournal.getFileRecords() > 2 * orders.size() + ARCHIVE_CHECK_INTERVAL) {
+            checkpointOrderJournal();
+        }
+        checkMemoryLimits();
+    }
+
+    // 把下单时间不晚于 cutoff 的已结束订单移入归档，调用方持有订单写锁的独占模式
+    size_t archiveFinishedOrdersPlacedBy(std::time_t cutoff) {
+        auto isCold = [cutoff](const Order& order) {
+            if (!order.isFinished()) return false;
+            std::time_t placedAt = order.getOrderTimestamp();
+            return placedAt != -1 && placedAt <= cutoff;
+        };
+
+        // 热订单在各分片内保持原有顺序，冷订单移出后整体写入归档
+        std::vector<Order> cold = orders.extractIf(isCold);
+        if (cold.empty()) return 0;
+
+        // 归档段已同步到磁盘后才写检查点把这些订单移出订单日志；写入失败的订单放回热数据，仍由日志保存
+        size_t archived = orderArchive.append(cold);
+        for (size_t i = archived; i < cold.size(); ++i) {
+            orders.add(std::move(cold[i]));
+        }
+        if (archived > 0) checkpointOrderJournal();
+        return archived;
+    }
+
+    // 相关度搜索的加分：有货加 0.5，销量按对数加分、1000 件封顶加 1.0（文本得分通常为 1~20）
+    static constexpr double SEARCH_IN_STOCK_BONUS = 0.5;
+    static constexpr double SEARCH_SALES_BONUS = 1.0;
+    static constexpr double SEARCH_SALES_SATURATION = 1000.0;
+
+    /**
+     * @brief 经查询缓存执行一次全表筛选：命中时直接共用缓存的位置表，未命中时扫描并写入缓存
+     *
+     * 筛选条件读紧凑记录的视图；结果与所读的快照一起返回，由调用方决定是否还原为 Product。
+     */
+    template <typename Predicate>
+    ProductListing cachedQuery(QueryResultCache::Kind kind, std::string_view argument, Predicate&& matches) {
+        auto snapshot = readCatalog();
+        uint64_t stamp = snapshot->getStamps().get(kind, argument);
+
+        QueryResultCache::Positions positions = queryCache.find(kind, argument, stamp);
+        if (!positions) {
+            std::vector<uint32_t> found;
+            snapshot->forEach([&](size_t position, const ProductView& product) {
+                if (matches(product)) found.push_back(static_cast<uint32_t>(position));
+            });
+            found.shrink_to_fit();
+            positions = queryCache.store(kind, argument, stamp, std::move(found));
+        }
+        return ProductListing(std::move(snapshot), std::move(positions));
+    }
+
+    /**
+     * @brief 标记商品表已修改；不在引擎锁内的写操作（下单、取消、单独改库存）随即自行发布
+     *
+     * 由写者承担发布，读者通常不必在读路径上构建快照；持有引擎锁时推迟到释放锁时统一发布。
+     */
+    void markCatalogChanged() {
+        catalogChanged.store(true);
+        if (engineOwner.load() != std::this_thread::get_id()) publishCatalog(false);
+    }
+
+    /**
+     * @brief 由当前商品表发布新的目录快照，与商品表共享各块
+     * @param force 为 false 时取得目录锁后若已无未发布的修改（其他线程刚发布过）则不再发布
+     *
+     * 先清标志再构建：构建期间的修改（库存写入不取目录锁）会重新置位，由下一次发布带上。
+     */
+    void publishCatalog(bool force) {
+        std::lock_guard<std::mutex> guard(catalogMutex);
+        if (!catalogChanged.exchange(false) && !force) return;
+        catalog.publish(CatalogSnapshot::build(products, queryStamps, ++catalogVersion));
+    }
+
+    bool setProductActive(std::string_view productId, bool active) {
+        size_t position = 0;
+        bool wasActive = false;
+        std::string category;
+        if (!products.read(productId, [&](size_t found, const ProductView& product) {
+            position = found;
+            wasActive = product.getIsActive();
+            category = product.getCategory();
+        })) {
+            return false;
+        }
+        {
+            std::lock_guard<std::mutex> guard(catalogMutex);
+            if (wasActive != active) queryStamps.bumpCategory(category);
+            products.setActive(position, active);
+        }
+        markCatalogChanged();
+        return true;
+    }
 
-    double getTotalSales() const {
-        double total = 0.0;
-        for (const auto& order : orders) {
-            if (order.getStatus() == "completed" || order.getStatus() == "shipped") {
-                total += order.getTotalAmount();
+    void lookupCategories(const Order& order, CategoryMap& categories) const {
+        for (const OrderItem& item : order.getItems()) {
+            if (categories.find(item.getProductId()) != categories.end()) continue;
+            std::string category = "未分类";
+            products.read(item.getProductId(), [&](size_t, const ProductView& product) { category = product.getCategory(); });
+            categories.emplace(item.getProductId(), std::move(category));
+        }
+    }
+
+    /**
+     * @brief 订单新增（before 为空）或由 before 变为 after 时调整畅销榜和卖家汇总，调用方持有销量锁
+     *
+     * 已取消的订单不计销量，畅销榜只在"已取消"和其他状态之间变化时调整。
+     */
+    void applyOrderChange(const Order* before, const Order& after, const CategoryMap& categories) {
+        auto categoryOf = [&](std::string_view productId) -> std::string_view {
+            auto it = categories.find(productId);
+            return it == categories.end() ? std::string_view("未分类") : std::string_view(it->second);
+        };
+        bool wasCancelled = before && before->getStatus() == "cancelled";
+        bool isCancelled = after.getStatus() == "cancelled";
+        if (before && !wasCancelled && isCancelled) bestSellers.recordOrder(*before, -1, categoryOf);
+        if ((!before || wasCancelled) && !isCancelled) bestSellers.recordOrder(after, +1, categoryOf);
+        if (before) sellerIndex.applyOrder(*before, -1);
+        sellerIndex.applyOrder(after, +1);
+    }
+
+    // 订单日志记录：类型|内容（O 新订单 / U 整单更新 / X 取消）
+    static std::string journalRecord(char type, std::string_view payload) {
+        std::string record;
+        record.reserve(payload.size() + 2);
+        record.push_back(type);
+        record.push_back('|');
+        record.append(payload);
+        return record;
+    }
+
+    // 追加一条订单日志记录，返回序号；当前线程持有引擎锁时释放锁后等待其落盘
+    uint64_t appendJournal(std::string_view record) {
+        uint64_t sequence = orderJournal.append(record);
+        if (sequence && engineOwner.load() == std::this_thread::get_id()) journalSequence = sequence;
+        return sequence;
+    }
+
+    // 启动时重放订单日志；已在归档中的订单（归档后、写检查点前崩溃）跳过
+    void replayOrderJournal(const std::vector<std::string>& records) {
+        size_t skipped = 0;
+        for (size_t i = 0; i < records.size(); ++i) {
+            if (!applyOrderRecord(records[i])) {
+                std::cerr << "订单日志第 " << (i + 1) << " 条记录无效，已跳过" << std::endl;
+                ++skipped;
             }
         }
-        return total;
+        if (skipped > 0) {
+            std::cerr << "订单日志共跳过 " << skipped << " 条无效记录" << std::endl;
+        }
+    }
+
+    // 重放一条订单日志记录；格式不对时返回 false，不修改任何数据
+    bool applyOrderRecord(std::string_view record) {
+        if (record.size() < 3 || record[1] != '|') return false;
+        std::string_view payload = record.substr(2);
+        switch (record[0]) {
+        case 'O':
+        case 'U': {
+            Order order;
+            if (!Order::tryParse(payload, order)) return false;
+            if (record[0] == 'U') updateOrder(order);
+            else if (!orderArchive.contains(order.getOrderId())) addOrder(std::move(order));
+            return true;
+        }
+        case 'X':
+            if (payload.empty()) return false;
+            cancelOrder(TextRecord::unescape(payload));
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    /**
+     * @brief 把订单日志改写为当前热订单的检查点，调用方持有订单写锁的独占模式（期间没有日志追加）
+     *
+     * 归档移走冷订单后执行；日志中的更新和取消记录累计过多时也会执行。
+     * 替换失败时原日志不变（已归档订单的记录重放时跳过），照常追加；
+     * 替换后无法重新打开时日志停止写入，之后的下单、取消均报告未能落盘（见 EngineLock::release）。
+     */
+    bool checkpointOrderJournal() {
+        if (!orderJournal.isOpen()) return false;
+        std::vector<std::string> records;
+        records.reserve(orders.size());
+        orders.forEach([&](const Order& order) { records.push_back("O|" + order.toString()); });
+        if (orderJournal.rewrite(records)) return true;
+
+        if (orderJournal.isOpen()) {
+            std::cerr << "订单日志检查点写入失败，保留原日志继续追加" << std::endl;
+        }
+        else {
+            std::cerr << "订单日志检查点后无法重新打开日志，订单日志已停止写入" << std::endl;
+        }
+        return false;
+    }
+
+    // 商品ID索引和过滤器由商品表自己维护；卖家索引在销量锁内整体替换商品位置
+    void rebuildProductIndex() {
+        std::vector<std::string> sellers;
+        sellers.reserve(products.size());
+        fuzzyNames.clear();
+        searchIndex.clear();
+        products.forEach([&](size_t i, const ProductView& product) {
+            sellers.emplace_back(product.getSellerUsername());
+            fuzzyNames.add(i, product.getName());
+            searchIndex.add(i, product.getName(), product.getDescription());
+        });
+
+        std::lock_guard<std::mutex> sales(salesMutex);
+        sellerIndex.clearProducts();
+        for (size_t i = 0; i < sellers.size(); ++i) {
+            sellerIndex.addProduct(sellers[i], i);
+        }
+    }
+
+    // 登记投诉ID，待处理的投诉进入队列
+    void indexComplaint(size_t position) {
+        const Complaint& complaint = complaints[position];
+        complaintIndex[complaint.getComplaintId()] = position;
+        if (complaint.getStatus() == "pending") {
+            complaintQueue.enqueue(position, complaint.getComplaintTime(), complaint.getComplaintType());
+        }
+    }
+
+    // 按商品、标题和内容归入相似投诉组
+    void clusterComplaint(size_t position) {
+        const Complaint& complaint = complaints[position];
+        complaintClusters.add(position, complaint.getProductId(), complaint.getTitle(), complaint.getContent());
+    }
+
+    // 租约过期的投诉已回到队列，恢复为待处理
+    void resetExpiredClaims(const std::vector<size_t>& expired) {
+        for (size_t position : expired) {
+            complaints[position].setStatus("pending");
+            complaints[position].setAdminUser("");
+        }
+    }
+
+    void reclaimExpiredComplaints() {
+        std::vector<size_t> expired;
+        complaintQueue.expireLeases(ComplaintQueue::Clock::now(), expired);
+        resetExpiredClaims(expired);
+    }
+
+    // 投诉计入被投诉商品的卖家
+    void recordComplaint(const Complaint& complaint) {
+        std::string seller;
+        if (products.read(complaint.getProductId(), [&](size_t, const ProductView& product) {
+            seller = product.getSellerUsername();
+        })) {
+            std::lock_guard<std::mutex> sales(salesMutex);
+            sellerIndex.addComplaint(seller);
+        }
     }
 };
 
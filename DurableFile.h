@@ -0,0 +1,127 @@
+﻿#ifndef DURABLEFILE_H
+#define DURABLEFILE_H
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#include <share.h>
+#else
+#include <unistd.h>
+#endif
+
+/**
+ * @brief 持久化文件操作 - 按文件描述符写入并同步到磁盘，供各日志和归档共用
+ *
+ * 写入后须 sync 才算落盘；新建或改名替换文件后还须同步所在目录，目录项本身才持久化。
+ */
+struct DurableFile {
+    static std::string read(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    // 只写打开，不存在时创建；truncate 为 false 时追加写入。失败返回 -1
+    static int open(const std::string& path, bool truncate = false) {
+        #ifdef _WIN32
+        int file = -1;
+        int flags = _O_WRONLY | _O_CREAT | _O_BINARY | (truncate ? _O_TRUNC : _O_APPEND);
+        _sopen_s(&file, path.c_str(), flags, _SH_DENYNO, _S_IREAD | _S_IWRITE);
+        return file;
+        #else
+        int flags = O_WRONLY | O_CREAT | (truncate ? O_TRUNC : O_APPEND);
+        return ::open(path.c_str(), flags, 0644);
+        #endif
+    }
+
+    static bool writeAll(int file, const char* data, size_t size) {
+        while (size > 0) {
+            #ifdef _WIN32
+            int written = _write(file, data, static_cast<unsigned>(std::min<size_t>(size, 1u << 30)));
+            #else
+            ssize_t written = ::write(file, data, size);
+            #endif
+            if (written <= 0) return false;
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    static bool sync(int file) {
+        #ifdef _WIN32
+        return _commit(file) == 0;
+        #elif defined(__APPLE__)
+        return ::fsync(file) == 0;
+        #else
+        return ::fdatasync(file) == 0;
+        #endif
+    }
+
+    static void close(int file) {
+        #ifdef _WIN32
+        _close(file);
+        #else
+        ::close(file);
+        #endif
+    }
+
+    // 同步文件所在目录，保证新建、改名本身持久化（Windows 无需此步）
+    static void syncDirectory(const std::string& path) {
+        #ifndef _WIN32
+        std::string directory = std::filesystem::path(path).parent_path().string();
+        int dir = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+        if (dir < 0) return;
+        ::fsync(dir);
+        ::close(dir);
+        #endif
+    }
+
+    /**
+     * @brief 追加数据并同步；文件由本次调用新建时同时同步目录
+     * @return 写入或同步失败时返回 false，已写入的部分可能留在文件尾部，由读取方按格式截掉
+     */
+    static bool append(const std::string& path, std::string_view data) {
+        std::error_code error;
+        bool created = !std::filesystem::exists(path, error);
+        int file = open(path);
+        if (file < 0) return false;
+        bool ok = writeAll(file, data.data(), data.size()) && sync(file);
+        close(file);
+        if (ok && created) syncDirectory(path);
+        return ok;
+    }
+
+    /**
+     * @brief 整体替换文件内容：先写临时文件并同步，再改名覆盖原文件并同步目录
+     *
+     * 任何时刻磁盘上都有一份完整的旧文件或新文件。std::filesystem::rename 覆盖已存在的目标
+     * （POSIX 上是原子的 rename，MSVC 上是带 MOVEFILE_REPLACE_EXISTING 的 MoveFileExW），
+     * 不需要先删除原文件。失败时原文件保持不变。
+     */
+    static bool replace(const std::string& path, std::string_view content) {
+        std::string tempPath = path + ".tmp";
+        int file = open(tempPath, true);
+        if (file < 0) return false;
+        bool written = writeAll(file, content.data(), content.size()) && sync(file);
+        close(file);
+
+        std::error_code error;
+        if (written) std::filesystem::rename(tempPath, path, error);
+        if (!written || error) {
+            std::remove(tempPath.c_str());
+            return false;
+        }
+        syncDirectory(path);
+        return true;
+    }
+};
+
+#endif // DURABLEFILE_H
@@ -0,0 +1,286 @@
+﻿#ifndef EXISTENCEFILTER_H
+#define EXISTENCEFILTER_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include "SnapshotCell.h"
+#include "StringHash.h"
+
+/**
+ * @brief 存在性过滤器 - 可扩展的分块布隆过滤器，无锁回答"一定不存在"
+ *
+ * 查询返回 false 时键一定不在表中，调用方可以不访问主索引（也就不取分片锁）；返回 true 时再查主索引。
+ * 每个键只落在一个 64 字节的块内，一次查询最多一次缓存未命中；置位用原子或，查询和插入都不加锁。
+ *
+ * 容量用完时追加一个容量加倍的新阶段，各阶段误判率依次减半，总误判率不超过目标值。
+ * 阶段数达到 REBUILD_STAGES 时 needsRebuild() 为真，由调用方在排除插入的情况下调用 rebuild，
+ * 按当前键数重建为单个阶段并经 SnapshotCell 发布，进行中的查询仍读旧版本。
+ * 过滤器不支持删除，删除键后的旧位只会增加误判，由调用方在适当时机重建。
+ */
+class ExistenceFilter {
+public:
+    static constexpr double DEFAULT_FALSE_POSITIVE_RATE = 0.01;
+    static constexpr size_t MIN_CAPACITY = 1024;
+    static constexpr unsigned REBUILD_STAGES = 3;  ///< 阶段数达到该值时建议重建
+
+    /**
+     * @param falsePositiveRate 目标误判率，0 表示禁用（查询总是返回"可能存在"）
+     * @param expectedKeys 预计键数，决定第一个阶段的容量
+     */
+    explicit ExistenceFilter(double falsePositiveRate = DEFAULT_FALSE_POSITIVE_RATE, size_t expectedKeys = 0)
+        : generation(std::make_unique<Generation>(clampRate(falsePositiveRate), expectedKeys)),
+        rebuildCount(0) {
+    }
+
+    ExistenceFilter(const ExistenceFilter&) = delete;
+    ExistenceFilter& operator=(const ExistenceFilter&) = delete;
+
+    void add(std::string_view key) {
+        auto current = generation.read();
+        current->add(hashKey(key));
+    }
+
+    // 返回 false 表示一定不存在
+    bool mayContain(std::string_view key) const {
+        auto current = generation.read();
+        return current->mayContain(hashKey(key));
+    }
+
+    bool needsRebuild() const {
+        auto current = generation.read();
+        return current->getStageCount() >= REBUILD_STAGES;
+    }
+
+    /**
+     * @brief 按全部键重建为单个阶段，容量为键数的两倍
+     * @param forEachKey 以回调 void(std::string_view) 为参数，依次给出全部键
+     * @param falsePositiveRate 新的目标误判率，负数表示沿用当前值
+     *
+     * 调用方须保证重建期间没有 add，且对 rebuild 自身串行化；查询可以并发进行。
+     */
+    template <typename ForEachKey>
+    void rebuild(size_t keyCount, ForEachKey&& forEachKey, double falsePositiveRate = -1.0) {
+        double rate = falsePositiveRate < 0.0 ? generation.read()->getTargetRate() : clampRate(falsePositiveRate);
+        auto next = std::make_unique<Generation>(rate, keyCount * 2);
+        forEachKey([&](std::string_view key) { next->add(hashKey(key)); });
+        generation.publish(std::move(next));
+        rebuildCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // ==================== 统计 ====================
+    struct Stats {
+        size_t keys = 0;            ///< 插入次数（重建后为重建时的键数加之后的插入）
+        size_t capacity = 0;        ///< 各阶段容量之和
+        size_t memoryBytes = 0;
+        unsigned stages = 0;
+        unsigned hashCount = 0;     ///< 第一个阶段每个键置位的个数
+        size_t rebuilds = 0;
+        double targetRate = 0.0;    ///< 0 表示禁用
+        double estimatedRate = 0.0; ///< 按各阶段置位比例估算的当前误判率
+    };
+
+    Stats getStats() const {
+        auto current = generation.read();
+        Stats stats = current->getStats();
+        stats.rebuilds = rebuildCount.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    struct Hash {
+        uint32_t block;  ///< 选块用
+        uint32_t first;  ///< 块内位置：first + i * step
+        uint32_t step;
+    };
+
+    struct alignas(64) Block {
+        std::atomic<uint64_t> words[8];
+    };
+
+    /**
+     * @brief 一个阶段：固定容量的分块布隆过滤器
+     */
+    class Stage {
+    public:
+        Stage(size_t capacity, double rate)
+            : capacity(capacity), inserted(0) {
+            // 分块过滤器的位分布不如标准布隆过滤器均匀，按标准公式多给约 20% 的位
+            double bitsPerKey = -std::log(rate) / (std::log(2.0) * std::log(2.0)) * 1.2;
+            hashCount = static_cast<unsigned>(std::clamp(std::lround(bitsPerKey / 1.2 * std::log(2.0)), 1L, 16L));
+            size_t bits = static_cast<size_t>(std::ceil(bitsPerKey * static_cast<double>(capacity)));
+            blockCount = std::max<size_t>(1, (bits + 511) / 512);
+            blocks = std::make_unique<Block[]>(blockCount);
+        }
+
+        // 返回 false 表示本阶段已满，调用方应追加新阶段
+        bool tryAdd(const Hash& hash) {
+            if (inserted.fetch_add(1, std::memory_order_relaxed) >= capacity) return false;
+            set(hash);
+            return true;
+        }
+
+        // 最后一个阶段不再追加时越过容量继续置位，误判率随之升高
+        void set(const Hash& hash) {
+            Block& block = blocks[blockOf(hash)];
+            uint32_t position = hash.first;
+            for (unsigned i = 0; i < hashCount; ++i, position += hash.step) {
+                std::atomic<uint64_t>& word = block.words[(position >> 6) & 7];
+                uint64_t mask = 1ull << (position & 63);
+                // 已置位时不写，避免热块在核间来回失效
+                if (!(word.load(std::memory_order_relaxed) & mask)) {
+                    word.fetch_or(mask, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        bool test(const Hash& hash) const {
+            const Block& block = blocks[blockOf(hash)];
+            uint32_t position = hash.first;
+            for (unsigned i = 0; i < hashCount; ++i, position += hash.step) {
+                uint64_t mask = 1ull << (position & 63);
+                if (!(block.words[(position >> 6) & 7].load(std::memory_order_relaxed) & mask)) return false;
+            }
+            return true;
+        }
+
+        size_t getCapacity() const { return capacity; }
+        size_t getInserted() const { return std::min(inserted.load(std::memory_order_relaxed), capacity); }
+        unsigned getHashCount() const { return hashCount; }
+        size_t getMemoryBytes() const { return blockCount * sizeof(Block); }
+
+        // 未插入的键落在某块后 k 位全部已置位的概率，按各块的置位比例分别计算再平均
+        double estimateRate() const {
+            double total = 0.0;
+            for (size_t i = 0; i < blockCount; ++i) {
+                int setBits = 0;
+                for (const auto& word : blocks[i].words) {
+                    setBits += std::popcount(word.load(std::memory_order_relaxed));
+                }
+                total += std::pow(setBits / 512.0, static_cast<double>(hashCount));
+            }
+            return total / static_cast<double>(blockCount);
+        }
+
+    private:
+        size_t capacity;
+        std::atomic<size_t> inserted;
+        unsigned hashCount;
+        size_t blockCount;
+        std::unique_ptr<Block[]> blocks;
+
+        size_t blockOf(const Hash& hash) const {
+            return static_cast<size_t>((static_cast<uint64_t>(hash.block) * blockCount) >> 32);
+        }
+    };
+
+    /**
+     * @brief 一个版本：按顺序追加的若干阶段，查询时逐个检查
+     *
+     * 快照单元只给出 const 引用，而阶段要在版本内并发追加，阶段表因此声明为 mutable；
+     * 追加只发生在末尾，用 CAS 安装，先装入阶段再增加阶段数，读者按阶段数读取总能看到完整的阶段。
+     */
+    class Generation {
+    public:
+        static constexpr unsigned MAX_STAGES = 32;
+
+        Generation(double rate, size_t expectedKeys)
+            : targetRate(rate), stageCount(0) {
+            if (rate <= 0.0) return;
+            // 阶段 i 的误判率为 rate / 2^(i+1)，各阶段之和小于 rate
+            stages[0].store(new Stage(std::max(expectedKeys, MIN_CAPACITY), rate / 2), std::memory_order_relaxed);
+            stageCount.store(1, std::memory_order_release);
+        }
+
+        ~Generation() {
+            for (auto& stage : stages) delete stage.load(std::memory_order_relaxed);
+        }
+
+        void add(const Hash& hash) const {
+            if (targetRate <= 0.0) return;
+            while (true) {
+                unsigned count = stageCount.load(std::memory_order_acquire);
+                Stage* last = stages[count - 1].load(std::memory_order_acquire);
+                if (count == MAX_STAGES) {
+                    last->set(hash);
+                    return;
+                }
+                if (last->tryAdd(hash)) return;
+                grow(count, *last);
+            }
+        }
+
+        bool mayContain(const Hash& hash) const {
+            if (targetRate <= 0.0) return true;
+            unsigned count = stageCount.load(std::memory_order_acquire);
+            for (unsigned i = 0; i < count; ++i) {
+                if (stages[i].load(std::memory_order_acquire)->test(hash)) return true;
+            }
+            return false;
+        }
+
+        unsigned getStageCount() const { return stageCount.load(std::memory_order_acquire); }
+        double getTargetRate() const { return targetRate; }
+
+        Stats getStats() const {
+            Stats stats;
+            stats.targetRate = targetRate;
+            stats.stages = getStageCount();
+            double passRate = 1.0;  // 未插入的键通过所有阶段（均判为不存在）的概率
+            for (unsigned i = 0; i < stats.stages; ++i) {
+                const Stage* stage = stages[i].load(std::memory_order_acquire);
+                stats.keys += stage->getInserted();
+                stats.capacity += stage->getCapacity();
+                stats.memoryBytes += stage->getMemoryBytes();
+                if (i == 0) stats.hashCount = stage->getHashCount();
+                passRate *= 1.0 - stage->estimateRate();
+            }
+            stats.estimatedRate = targetRate <= 0.0 ? 1.0 : 1.0 - passRate;
+            return stats;
+        }
+
+    private:
+        double targetRate;
+        mutable std::atomic<Stage*> stages[MAX_STAGES] = {};
+        mutable std::atomic<unsigned> stageCount;
+
+        // 第 count 个阶段已满：安装下一个阶段（多个线程同时发现时只有一个安装成功），再推进阶段数
+        void grow(unsigned count, const Stage& last) const {
+            if (!stages[count].load(std::memory_order_acquire)) {
+                Stage* next = new Stage(last.getCapacity() * 2, targetRate / std::ldexp(2.0, static_cast<int>(count) + 1));
+                Stage* expected = nullptr;
+                if (!stages[count].compare_exchange_strong(expected, next, std::memory_order_acq_rel)) {
+                    delete next;
+                }
+            }
+            unsigned expectedCount = count;
+            stageCount.compare_exchange_strong(expectedCount, count + 1, std::memory_order_acq_rel);
+        }
+    };
+
+    SnapshotCell<Generation> generation;
+    std::atomic<size_t> rebuildCount;
+
+    static double clampRate(double rate) {
+        return rate <= 0.0 ? 0.0 : std::min(rate, 0.5);
+    }
+
+    // 在标准库字符串哈希上再做一次 64 位终混，块号和块内位置取自不同的位
+    static Hash hashKey(std::string_view key) {
+        uint64_t h = static_cast<uint64_t>(StringHash{}(key));
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDull;
+        h ^= h >> 33;
+        h *= 0xC4CEB9FE1A85EC53ull;
+        h ^= h >> 33;
+        uint64_t probe = h * 0x9E3779B97F4A7C15ull;
+        return Hash{ static_cast<uint32_t>(h >> 32), static_cast<uint32_t>(probe >> 32),
+            static_cast<uint32_t>(probe) | 1u };
+    }
+};
+
+#endif // EXISTENCEFILTER_H
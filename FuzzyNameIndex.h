@@ -0,0 +1,435 @@
+﻿#ifndef FUZZYNAMEINDEX_H
+#define FUZZYNAMEINDEX_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Utf8Text.h"
+#include "MemoryUsage.h"
+
+/**
+ * @brief 模糊匹配结果
+ */
+struct FuzzyMatch {
+    size_t position;   ///< 商品位置
+    int distance;      ///< 关键词与名称中最相近片段的编辑距离
+};
+
+/**
+ * @brief 商品名称模糊搜索索引 - 码点二元组倒排 + Myers 位并行编辑距离
+ *
+ * 名称按 Utf8Text 归一化为码点序列，每个不同的相邻码点对（二元组）记一条倒排，倒排按商品位置升序。
+ * 查询分两步：
+ * 1. 候选：每处编辑最多破坏 2 个二元组，关键词有 g 个不同二元组时，
+ *    与名称某个片段编辑距离不超过 k 的名称至少含其中 g - 2k 个。
+ *    先求距离 0 的候选（门槛 g，即各倒排的交集），用 MergeSkip 多路归并，常见二元组的长倒排大部分被跳过；
+ *    结果已够 limit 条时不再放宽。否则按预算的门槛做一次计数扫描（ScanCount）求出全部候选：
+ *    门槛低于 g 时 MergeSkip 每步只能跳过少数倒排，堆操作的开销超过直接扫描。
+ *    计数扫描的候选按共有二元组数从多到少校验：共有 c 个的名称距离至少为 ceil((g - c) / 2)，
+ *    已有 limit 条结果的距离小于该下界时提前结束；每次查询最多校验 MAX_VERIFIED 个候选，
+ *    超出时返回已校验候选中最好的结果。
+ *    门槛不大于 0 时无法过滤，退化为扫描全部名称（只在显式给出较大预算时发生，不受校验上限约束）。
+ * 2. 校验：Myers 位并行算法计算关键词与名称任意片段的最小编辑距离，一个 64 位字即一列 DP，
+ *    每个名称码点 O(1)。关键词超过 MAX_PATTERN 个码点时只取前 MAX_PATTERN 个。
+ * 结果按距离、名称长度与关键词长度之差、位置排序。
+ */
+class FuzzyNameIndex {
+public:
+    static constexpr size_t MAX_PATTERN = 64;
+    static constexpr size_t MAX_VERIFIED = 2048;  ///< 计数扫描阶段每次查询最多校验的候选数
+
+    /**
+     * @brief 按关键词长度给出默认的编辑距离预算：3 个码点以内不容错，8 个以内容 1 处，更长容 2 处
+     *
+     * 预算越大二元组门槛越低、候选越多；关键词有重复二元组时 search 还会再收紧预算
+     */
+    static int defaultBudget(size_t patternLength) {
+        if (patternLength <= 3) return 0;
+        if (patternLength <= 8) return 1;
+        return 2;
+    }
+
+    /**
+     * @brief 登记名称；position 已登记时等同于 update
+     */
+    void add(size_t position, std::string_view name) {
+        if (position < names.size()) {
+            update(position, name);
+            return;
+        }
+        names.resize(position + 1, NameSlot{ 0, 0 });
+        store(position, name);
+        forEachGram(position, [&](uint64_t gram) {
+            std::vector<uint32_t>& posting = postings[gram];
+            if (posting.empty() || posting.back() < position) {
+                posting.push_back(static_cast<uint32_t>(position));
+            }
+            else {
+                insertSorted(posting, position);
+            }
+        });
+    }
+
+    /**
+     * @brief 名称变化时更新倒排（从旧二元组的倒排中删除，加入新二元组的倒排）
+     */
+    void update(size_t position, std::string_view name) {
+        if (position >= names.size()) {
+            add(position, name);
+            return;
+        }
+        forEachGram(position, [&](uint64_t gram) {
+            auto it = postings.find(gram);
+            if (it == postings.end()) return;
+            auto entry = std::lower_bound(it->second.begin(), it->second.end(), static_cast<uint32_t>(position));
+            if (entry != it->second.end() && *entry == position) it->second.erase(entry);
+            if (it->second.empty()) postings.erase(it);
+        });
+        store(position, name);
+        forEachGram(position, [&](uint64_t gram) {
+            insertSorted(postings[gram], position);
+        });
+    }
+
+    void clear() {
+        names.clear();
+        codePointPool.clear();
+        postings.clear();
+    }
+
+    MemoryUsage getMemoryUsage() const {
+        MemoryUsage usage{ MemoryAccounting::ofVector(names) + MemoryAccounting::ofVector(codePointPool) +
+            MemoryAccounting::ofHashTable(postings), postings.size() };
+        for (const auto& [gram, posting] : postings) {
+            usage.bytes += MemoryAccounting::ofVector(posting);
+        }
+        return usage;
+    }
+
+    /**
+     * @brief 模糊搜索
+     * @param query 关键词
+     * @param maxDistance 编辑距离上限，负数表示按关键词长度取 defaultBudget
+     * @param limit 最多返回的条数
+     * @param accept 位置过滤（如只要上架商品），返回 false 的位置不参与校验
+     */
+    template <typename Accept>
+    std::vector<FuzzyMatch> search(std::string_view query, int maxDistance, size_t limit, Accept&& accept) {
+        std::vector<FuzzyMatch> matches;
+        std::vector<uint32_t> pattern;
+        Utf8Text::appendNormalized(query, pattern);
+        if (pattern.size() > MAX_PATTERN) pattern.resize(MAX_PATTERN);
+        if (pattern.empty() || limit == 0) return matches;
+
+        int budget = maxDistance < 0 ? defaultBudget(pattern.size()) : maxDistance;
+        int tierBudget = budget;
+        PatternMasks masks(pattern);
+
+        // 返回该位置是否实际做了校验（被 accept 过滤的不算）
+        auto verify = [&](size_t position) {
+            if (!accept(position)) return false;
+            const NameSlot& slot = names[position];
+            int distance = masks.bestSubstringDistance(codePointPool.data() + slot.offset, slot.length);
+            if (distance <= tierBudget) {
+                matches.push_back(FuzzyMatch{ position, distance });
+            }
+            return true;
+        };
+
+        std::vector<uint64_t> grams;
+        for (size_t i = 1; i < pattern.size(); ++i) {
+            grams.push_back(gramKey(pattern[i - 1], pattern[i]));
+        }
+        std::sort(grams.begin(), grams.end());
+        grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+
+        // 默认预算保证门槛大于 0，只有单个码点的关键词才会全表扫描
+        if (maxDistance < 0) {
+            budget = std::min(budget, static_cast<int>(grams.size() > 0 ? (grams.size() - 1) / 2 : 0));
+        }
+
+        // 距离 0：门槛等于 g，结果已够 limit 条时更远的结果不会进入前 limit 名
+        if (!grams.empty()) {
+            tierBudget = 0;
+            collectCandidates(grams, grams.size(), verify);
+        }
+        // 放宽：距离不超过 d 的名称都达到门槛 g - 2d，一次计数扫描求出，各级距离共用。
+        // 预算使门槛不大于 0 时，先用仍能过滤的最大距离试一次，结果不够 limit 条才扫描全部名称
+        int filteredBudget = std::min(budget, grams.empty() ? 0 : static_cast<int>((grams.size() - 1) / 2));
+        if (filteredBudget > 0 && matches.size() < limit) {
+            matches.clear();
+            tierBudget = filteredBudget;
+            std::vector<size_t> matchesAt(static_cast<size_t>(filteredBudget) + 1, 0);  // 各距离的结果数
+            size_t verified = 0;
+            countCandidates(grams, grams.size() - 2 * static_cast<size_t>(filteredBudget),
+                [&](size_t position, size_t overlap) {
+                    size_t lowerBound = (grams.size() - overlap + 1) / 2;
+                    size_t closer = 0;
+                    for (size_t d = 0; d < lowerBound && d < matchesAt.size(); ++d) closer += matchesAt[d];
+                    if (closer >= limit || verified >= MAX_VERIFIED) return false;
+
+                    size_t before = matches.size();
+                    if (verify(position)) ++verified;
+                    if (matches.size() > before) ++matchesAt[static_cast<size_t>(matches.back().distance)];
+                    return true;
+                });
+        }
+        if (grams.empty() || (filteredBudget < budget && matches.size() < limit)) {
+            matches.clear();
+            tierBudget = budget;
+            for (size_t position = 0; position < names.size(); ++position) verify(position);
+        }
+
+        auto better = [&](const FuzzyMatch& a, const FuzzyMatch& b) {
+            if (a.distance != b.distance) return a.distance < b.distance;
+            size_t extraA = lengthGap(names[a.position].length, pattern.size());
+            size_t extraB = lengthGap(names[b.position].length, pattern.size());
+            return extraA != extraB ? extraA < extraB : a.position < b.position;
+        };
+        if (matches.size() > limit) {
+            std::partial_sort(matches.begin(), matches.begin() + limit, matches.end(), better);
+            matches.resize(limit);
+        }
+        else {
+            std::sort(matches.begin(), matches.end(), better);
+        }
+        return matches;
+    }
+
+    size_t getNameCount() const { return names.size(); }
+    size_t getGramCount() const { return postings.size(); }
+
+private:
+    struct NameSlot {
+        uint32_t offset;  ///< 在 codePointPool 中的起始下标
+        uint32_t length;  ///< 码点数
+    };
+
+    /**
+     * @brief 关键词的位掩码表：第 i 位为 1 表示关键词第 i 个码点等于该字符
+     */
+    class PatternMasks {
+    public:
+        explicit PatternMasks(const std::vector<uint32_t>& pattern)
+            : length(pattern.size()), highBit(uint64_t(1) << (pattern.size() - 1)) {
+            ascii.fill(0);
+            for (size_t i = 0; i < pattern.size(); ++i) {
+                uint64_t bit = uint64_t(1) << i;
+                if (pattern[i] < 128) {
+                    ascii[pattern[i]] |= bit;
+                    continue;
+                }
+                auto it = std::find_if(other.begin(), other.end(),
+                    [&](const std::pair<uint32_t, uint64_t>& entry) { return entry.first == pattern[i]; });
+                if (it == other.end()) other.emplace_back(pattern[i], bit);
+                else it->second |= bit;
+            }
+        }
+
+        /**
+         * @brief Myers (1999) 位并行近似匹配：文本起点不计代价，返回所有结束位置中的最小距离
+         */
+        int bestSubstringDistance(const uint32_t* text, size_t textLength) const {
+            uint64_t positiveVertical = ~uint64_t(0);
+            uint64_t negativeVertical = 0;
+            int score = static_cast<int>(length);
+            int best = score;
+
+            for (size_t j = 0; j < textLength && best > 0; ++j) {
+                uint64_t equal = maskOf(text[j]);
+                uint64_t xVertical = equal | negativeVertical;
+                uint64_t xHorizontal = (((equal & positiveVertical) + positiveVertical) ^ positiveVertical) | equal;
+                uint64_t positiveHorizontal = negativeVertical | ~(xHorizontal | positiveVertical);
+                uint64_t negativeHorizontal = positiveVertical & xHorizontal;
+
+                if (positiveHorizontal & highBit) ++score;
+                else if (negativeHorizontal & highBit) --score;
+
+                positiveHorizontal <<= 1;
+                negativeHorizontal <<= 1;
+                positiveVertical = negativeHorizontal | ~(xVertical | positiveHorizontal);
+                negativeVertical = positiveHorizontal & xVertical;
+                best = std::min(best, score);
+            }
+            return best;
+        }
+
+    private:
+        size_t length;
+        uint64_t highBit;
+        std::array<uint64_t, 128> ascii;
+        std::vector<std::pair<uint32_t, uint64_t>> other;  ///< 非 ASCII 码点，关键词很短，线性查找即可
+
+        uint64_t maskOf(uint32_t codePoint) const {
+            if (codePoint < 128) return ascii[codePoint];
+            for (const auto& entry : other) {
+                if (entry.first == codePoint) return entry.second;
+            }
+            return 0;
+        }
+    };
+
+    std::vector<NameSlot> names;          ///< 按商品位置索引
+    std::vector<uint32_t> codePointPool;  ///< 所有名称的码点连续存放，名称修改后旧片段留到 clear 时回收
+    std::unordered_map<uint64_t, std::vector<uint32_t>> postings;  ///< 二元组 -> 商品位置（升序）
+
+    static uint64_t gramKey(uint32_t first, uint32_t second) {
+        return (static_cast<uint64_t>(first) << 32) | second;
+    }
+
+    static size_t lengthGap(size_t nameLength, size_t patternLength) {
+        return nameLength > patternLength ? nameLength - patternLength : patternLength - nameLength;
+    }
+
+    static void insertSorted(std::vector<uint32_t>& posting, size_t position) {
+        auto it = std::lower_bound(posting.begin(), posting.end(), static_cast<uint32_t>(position));
+        if (it == posting.end() || *it != position) posting.insert(it, static_cast<uint32_t>(position));
+    }
+
+    void store(size_t position, std::string_view name) {
+        size_t offset = codePointPool.size();
+        Utf8Text::appendNormalized(name, codePointPool);
+        names[position] = NameSlot{ static_cast<uint32_t>(offset), static_cast<uint32_t>(codePointPool.size() - offset) };
+    }
+
+    // 对名称中每个不同的二元组调用一次 visitor
+    template <typename Visitor>
+    void forEachGram(size_t position, Visitor&& visitor) const {
+        const NameSlot& slot = names[position];
+        const uint32_t* points = codePointPool.data() + slot.offset;
+        thread_local std::vector<uint64_t> grams;
+        grams.clear();
+        for (size_t i = 1; i < slot.length; ++i) {
+            grams.push_back(gramKey(points[i - 1], points[i]));
+        }
+        std::sort(grams.begin(), grams.end());
+        grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+        for (uint64_t gram : grams) visitor(gram);
+    }
+
+    /**
+     * @brief 找出至少出现在 threshold 条二元组倒排中的位置（升序），逐个交给 visit
+     *
+     * MergeSkip：各倒排的当前元素放入小顶堆。堆顶元素出现次数不足 threshold 时，
+     * 取出最小的 threshold - 1 个元素，比它们小的位置不可能达到门槛，
+     * 这些倒排直接跳到新堆顶（倍增查找），常见二元组的长倒排大部分被跳过。
+     * @param grams 关键词中互不相同的二元组
+     */
+    template <typename Visit>
+    void collectCandidates(const std::vector<uint64_t>& grams, size_t threshold, Visit&& visit) const {
+        struct Cursor {
+            uint32_t value;  ///< *current 的副本，堆比较时不必解引用
+            const uint32_t* current;
+            const uint32_t* end;
+        };
+        std::vector<Cursor> cursors;
+        for (uint64_t gram : grams) {
+            auto it = postings.find(gram);
+            if (it != postings.end()) {
+                const std::vector<uint32_t>& posting = it->second;
+                cursors.push_back(Cursor{ posting.front(), posting.data(), posting.data() + posting.size() });
+            }
+        }
+
+        auto later = [](const Cursor& a, const Cursor& b) { return a.value > b.value; };
+        std::vector<Cursor> heap = cursors;
+        std::make_heap(heap.begin(), heap.end(), later);
+        std::vector<Cursor> popped;
+
+        auto popTop = [&] {
+            std::pop_heap(heap.begin(), heap.end(), later);
+            popped.push_back(heap.back());
+            heap.pop_back();
+        };
+        auto pushBack = [&](Cursor cursor) {
+            if (cursor.current == cursor.end) return;
+            cursor.value = *cursor.current;
+            heap.push_back(cursor);
+            std::push_heap(heap.begin(), heap.end(), later);
+        };
+
+        while (heap.size() >= threshold) {
+            uint32_t top = heap.front().value;
+            popped.clear();
+            while (!heap.empty() && heap.front().value == top) popTop();
+
+            if (popped.size() >= threshold) {
+                visit(top);
+                for (Cursor cursor : popped) {
+                    ++cursor.current;
+                    pushBack(cursor);
+                }
+                continue;
+            }
+
+            while (popped.size() < threshold - 1 && !heap.empty()) popTop();
+            if (heap.empty()) break;
+            uint32_t target = heap.front().value;
+            for (Cursor cursor : popped) {
+                cursor.current = gallopTo(cursor.current, cursor.end, target);
+                pushBack(cursor);
+            }
+        }
+    }
+
+    /**
+     * @brief 找出至少出现在 threshold 条二元组倒排中的位置，按出现次数从多到少交给 visit(position, overlap)
+     *
+     * ScanCount：逐条扫描倒排，为每个位置累加出现次数，恰好达到门槛时记为候选；
+     * 扫描完后按最终次数做计数排序（次数相同的保持达到门槛的先后），visit 返回 false 时停止。
+     * 计数数组按线程复用（每个名称一字节），扫描后沿原倒排清零，不必每次清空整个数组。
+     * 关键词最多 MAX_PATTERN - 1 个二元组，次数不会超出 uint8_t。
+     */
+    template <typename Visit>
+    void countCandidates(const std::vector<uint64_t>& grams, size_t threshold, Visit&& visit) const {
+        thread_local std::vector<uint8_t> counts;
+        if (counts.size() < names.size()) counts.resize(names.size());
+
+        std::vector<const std::vector<uint32_t>*> lists;
+        for (uint64_t gram : grams) {
+            auto it = postings.find(gram);
+            if (it != postings.end()) lists.push_back(&it->second);
+        }
+        std::vector<uint32_t> candidates;
+        for (const std::vector<uint32_t>* posting : lists) {
+            for (uint32_t position : *posting) {
+                if (++counts[position] == threshold) candidates.push_back(position);
+            }
+        }
+
+        // bucketStart[k] 为共有 lists.size() - k 个二元组的候选在 ordered 中的起点
+        std::vector<size_t> bucketStart(lists.size() + 2, 0);
+        for (uint32_t position : candidates) ++bucketStart[lists.size() - counts[position] + 1];
+        for (size_t k = 1; k < bucketStart.size(); ++k) bucketStart[k] += bucketStart[k - 1];
+        std::vector<uint32_t> ordered(candidates.size());
+        for (uint32_t position : candidates) ordered[bucketStart[lists.size() - counts[position]]++] = position;
+
+        std::vector<uint8_t> overlaps(ordered.size());
+        for (size_t i = 0; i < ordered.size(); ++i) overlaps[i] = counts[ordered[i]];
+        for (const std::vector<uint32_t>* posting : lists) {
+            for (uint32_t position : *posting) counts[position] = 0;
+        }
+
+        for (size_t i = 0; i < ordered.size(); ++i) {
+            if (!visit(ordered[i], overlaps[i])) break;
+        }
+    }
+
+    // 从 first 开始倍增步长找到第一个不小于 target 的元素
+    static const uint32_t* gallopTo(const uint32_t* first, const uint32_t* last, uint32_t target) {
+        size_t step = 1;
+        const uint32_t* low = first;
+        while (first + step < last && first[step] < target) {
+            low = first + step;
+            step *= 2;
+        }
+        const uint32_t* high = first + step < last ? first + step + 1 : last;
+        return std::lower_bound(low, high, target);
+    }
+};
+
+#endif // FUZZYNAMEINDEX_H
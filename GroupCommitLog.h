@@ -0,0 +1,276 @@
+﻿#ifndef GROUPCOMMITLOG_H
+#define GROUPCOMMITLOG_H
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "DurableFile.h"
+
+/**
+ * @brief 组提交的批量参数
+ */
+struct GroupCommitOptions {
+    size_t maxBatchRecords = 256;          ///< 一批最多的记录数，攒满立即落盘
+    std::chrono::microseconds maxWait{ 0 };  ///< 一批中第一条记录最多等待多久再落盘，0 表示落盘线程空闲即写
+    bool syncToDisk = true;                ///< false 时只写入不同步到磁盘（仅用于对比测试）
+};
+
+/**
+ * @brief 组提交的统计信息
+ */
+struct GroupCommitStats {
+    uint64_t records = 0;        ///< 已落盘的记录数
+    uint64_t batches = 0;        ///< 落盘次数（每批一次写入和一次同步）
+    uint64_t bytes = 0;
+    uint64_t failedBatches = 0;  ///< 写入或同步失败的批数
+
+    double getAverageBatch() const {
+        return batches == 0 ? 0.0 : static_cast<double>(records) / batches;
+    }
+};
+
+/**
+ * @brief 组提交日志 - 并发写入的记录攒成一批，一次 write + fdatasync 落盘
+ *
+ * append 只把记录追加到内存缓冲区并返回序号，由独立的落盘线程取走整批缓冲区写入文件并同步，
+ * 之后唤醒等待的调用方；落盘期间新到的记录进入下一批，写入方越多每批越大，同步次数不随写入方增加。
+ * 调用方应在释放自己的锁之后再 waitDurable，这样持锁的下一个写入方可以加入同一批。
+ * 每条记录占一行（记录内不能含换行）；打开时截掉崩溃留下的不完整的最后一行。
+ * 一批写入或同步失败后，文件尾部可能留有该批的一部分，同步失败后页缓存的状态也不再可信，
+ * 日志就此停止写入：该批及之后的所有记录 waitDurable 均返回 false，直到重新 open。
+ */
+class GroupCommitLog {
+public:
+    GroupCommitLog() = default;
+
+    GroupCommitLog(const GroupCommitLog&) = delete;
+    GroupCommitLog& operator=(const GroupCommitLog&) = delete;
+
+    ~GroupCommitLog() {
+        close();
+    }
+
+    /**
+     * @brief 读出日志中的完整记录（用于启动时重放），不完整的最后一行不返回
+     */
+    static std::vector<std::string> readRecords(const std::string& path) {
+        std::vector<std::string> records;
+        std::string content = DurableFile::read(path);
+        size_t begin = 0;
+        for (size_t end = content.find('\n'); end != std::string::npos; end = content.find('\n', begin)) {
+            if (end > begin) records.emplace_back(content, begin, end - begin);
+            begin = end + 1;
+        }
+        return records;
+    }
+
+    /**
+     * @brief 打开日志文件追加写入，并启动落盘线程
+     * @param path 日志路径，为空表示不落盘（append 返回 0）
+     */
+    bool open(const std::string& path, GroupCommitOptions newOptions = GroupCommitOptions()) {
+        close();
+        if (path.empty()) return false;
+
+        // 截掉不完整的最后一行，并统计已有记录数
+        std::string content = DurableFile::read(path);
+        size_t complete = content.rfind('\n');
+        complete = complete == std::string::npos ? 0 : complete + 1;
+        if (complete < content.size()) {
+            std::error_code error;
+            std::filesystem::resize_file(path, complete, error);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        fd = DurableFile::open(path);
+        if (fd < 0) return false;
+        filePath = path;
+        options = newOptions;
+        fileRecords = static_cast<size_t>(std::count(content.begin(), content.begin() + complete, '\n'));
+        stopping = false;
+        running = true;
+        firstFailedSequence = 0;
+        flusher = std::thread([this] { flushLoop(); });
+        return true;
+    }
+
+    /**
+     * @brief 落盘剩余记录后关闭文件；日志已停止写入（文件可能已关闭）时同样结束落盘线程
+     */
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!flusher.joinable()) return;
+            stopping = true;
+        }
+        flushNeeded.notify_one();
+        flusher.join();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (fd >= 0) DurableFile::close(fd);
+        fd = -1;
+        running = false;
+        durable.notify_all();
+    }
+
+    // 已打开且仍在写入
+    bool isOpen() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return fd >= 0 && firstFailedSequence == 0;
+    }
+
+    /**
+     * @brief 追加一条记录（不等待落盘）
+     * @return 记录序号，交给 waitDurable；日志未打开时返回 0。日志已停止写入时照常返回序号，
+     *         该序号立即记为失败，waitDurable 返回 false
+     */
+    uint64_t append(std::string_view record) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) return 0;
+        if (firstFailedSequence != 0) {
+            durableSequence = ++appendedSequence;
+            return appendedSequence;
+        }
+        if (pending.empty()) batchStart = std::chrono::steady_clock::now();
+        pending.append(record);
+        pending.push_back('\n');
+        ++pendingRecords;
+        // 批中第一条唤醒落盘线程开始计时，攒满时让它立即写
+        if (pendingRecords == 1 || pendingRecords == options.maxBatchRecords) flushNeeded.notify_one();
+        return ++appendedSequence;
+    }
+
+    /**
+     * @brief 等待序号不大于 sequence 的记录全部落盘
+     * @return 落盘失败时返回 false（记录可能未持久化）
+     */
+    bool waitDurable(uint64_t sequence) {
+        if (sequence == 0) return true;
+        std::unique_lock<std::mutex> lock(mutex);
+        durable.wait(lock, [&] { return durableSequence >= sequence || !running; });
+        return durableSequence >= sequence && (firstFailedSequence == 0 || sequence < firstFailedSequence);
+    }
+
+    /**
+     * @brief 用一组记录替换日志内容（检查点），先写临时文件并同步，再替换原文件
+     *
+     * 调用方须保证 records 已包含此前所有记录的效果；替换期间 append 会等待。
+     * 替换失败时原文件不变，继续追加；替换后重新打开失败时日志停止写入，之后的记录均记为失败。
+     */
+    bool rewrite(const std::vector<std::string>& records) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (fd < 0 || firstFailedSequence != 0) return false;
+        durable.wait(lock, [&] { return durableSequence == appendedSequence; });
+
+        std::string content;
+        for (const auto& record : records) {
+            content.append(record);
+            content.push_back('\n');
+        }
+
+        // Windows 上不能改名覆盖仍打开着的文件，先关闭；替换失败时原文件不变，重新打开继续追加
+        DurableFile::close(fd);
+        bool replaced = DurableFile::replace(filePath, content);
+        fd = DurableFile::open(filePath);
+        if (fd < 0) firstFailedSequence = appendedSequence + 1;
+        if (replaced) fileRecords = records.size();
+        return replaced && fd >= 0;
+    }
+
+    void setOptions(GroupCommitOptions newOptions) {
+        std::lock_guard<std::mutex> lock(mutex);
+        options = newOptions;
+    }
+
+    // 文件中的记录数（含打开前已有的），供调用方决定何时做检查点
+    size_t getFileRecords() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return fileRecords + pendingRecords;
+    }
+
+    GroupCommitStats getStats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
+    }
+
+private:
+    mutable std::mutex mutex;
+    std::condition_variable flushNeeded;  ///< 通知落盘线程：有新批次、批次已满或需要关闭
+    std::condition_variable durable;      ///< 通知等待方：一批已落盘
+    std::thread flusher;
+    GroupCommitOptions options;
+    std::string filePath;
+    int fd = -1;
+    bool stopping = false;
+    bool running = false;  ///< open 成功到 close 之间为 true（含停止写入之后）
+
+    std::string pending;   ///< 下一批的记录
+    std::string writing;   ///< 落盘线程正在写的批，与 pending 交换复用缓冲区
+    size_t pendingRecords = 0;
+    size_t fileRecords = 0;
+    std::chrono::steady_clock::time_point batchStart;
+    uint64_t appendedSequence = 0;
+    uint64_t durableSequence = 0;
+    uint64_t firstFailedSequence = 0;  ///< 停止写入后的第一个失败序号，0 表示正常
+    GroupCommitStats stats;
+
+    void flushLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            // 停止写入后 append 不再进入 pending，这里只等待关闭
+            flushNeeded.wait(lock, [&] { return stopping || pendingRecords > 0; });
+            if (pendingRecords == 0) break;
+
+            // 攒批：批满、等待超时或关闭时写出
+            flushNeeded.wait_until(lock, batchStart + options.maxWait,
+                [&] { return stopping || pendingRecords >= options.maxBatchRecords; });
+
+            // 超过批大小上限时只取前 maxBatchRecords 条，其余留给下一批
+            size_t records = std::min(pendingRecords, std::max<size_t>(1, options.maxBatchRecords));
+            if (records == pendingRecords) {
+                writing.swap(pending);
+            }
+            else {
+                size_t end = 0;
+                for (size_t i = 0; i < records; ++i) end = pending.find('\n', end) + 1;
+                writing.assign(pending, 0, end);
+                pending.erase(0, end);
+            }
+            uint64_t batchEnd = appendedSequence - (pendingRecords - records);
+            pendingRecords -= records;
+            bool sync = options.syncToDisk;
+            int file = fd;
+            lock.unlock();
+
+            bool ok = DurableFile::writeAll(file, writing.data(), writing.size()) && (!sync || DurableFile::sync(file));
+
+            lock.lock();
+            if (ok) {
+                stats.records += records;
+                stats.bytes += writing.size();
+                fileRecords += records;
+            }
+            else {
+                // 不再向可能带着半批数据的文件尾部追加：本批和尚未写出的记录一并记为失败
+                ++stats.failedBatches;
+                firstFailedSequence = batchEnd - records + 1;
+                batchEnd = appendedSequence;
+                pending.clear();
+                pendingRecords = 0;
+            }
+            ++stats.batches;
+            writing.clear();
+            durableSequence = batchEnd;
+            durable.notify_all();
+        }
+    }
+};
+
+#endif // GROUPCOMMITLOG_H
@@ -0,0 +1,143 @@
+﻿#ifndef INPUTSOURCE_H
+#define INPUTSOURCE_H
+
+#include <cctype>
+#include <charconv>
+#include <coroutine>
+#include <deque>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include "SessionTask.h"
+
+/**
+ * @brief 输入源 - 菜单流程按行读取用户输入的来源
+ *
+ * 协程流程用 co_await readLine() 读取一行：有可读内容时不挂起；暂时没有时挂起，
+ * 输入源收到新行或关闭后把协程交给调度器恢复。输入结束（关闭且读完）时得到空的 optional。
+ */
+class InputSource {
+public:
+    explicit InputSource(SessionScheduler* scheduler = nullptr) : scheduler(scheduler) {}
+    virtual ~InputSource() = default;
+
+    InputSource(const InputSource&) = delete;
+    InputSource& operator=(const InputSource&) = delete;
+
+    /**
+     * @brief 读取一行（不含换行）
+     * @return 暂无可读内容或输入已结束时返回 false
+     */
+    virtual bool tryReadLine(std::string& line) = 0;
+
+    // 输入已结束，之后不会再有新行
+    virtual bool isClosed() const = 0;
+
+    class LineAwaiter {
+    public:
+        explicit LineAwaiter(InputSource& source) : source(source) {}
+
+        bool await_ready() {
+            received = source.tryReadLine(line);
+            return received || source.isClosed();
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) {
+            source.waiter = handle;
+        }
+
+        std::optional<std::string> await_resume() {
+            if (!received) received = source.tryReadLine(line);
+            if (!received) return std::nullopt;
+            return std::move(line);
+        }
+
+    private:
+        InputSource& source;
+        std::string line;
+        bool received = false;
+    };
+
+    LineAwaiter readLine() { return LineAwaiter(*this); }
+
+    // 有协程挂起等待本输入源
+    bool isWaiting() const { return static_cast<bool>(waiter); }
+
+    // ==================== 输入解析 ====================
+    // 与 std::cin >> value 一致：跳过前导空白，按最长前缀解析，忽略其后的内容
+    static bool parseInt(std::string_view text, int& value) {
+        text = skipSpaces(text);
+        if (!text.empty() && text.front() == '+') text.remove_prefix(1);
+        return std::from_chars(text.data(), text.data() + text.size(), value).ec == std::errc();
+    }
+
+protected:
+    // 派生类在收到新行或关闭时调用，恢复挂起的协程
+    void wakeWaiter() {
+        if (waiter && scheduler) scheduler->schedule(std::exchange(waiter, nullptr));
+    }
+
+private:
+    SessionScheduler* scheduler;
+    std::coroutine_handle<> waiter;
+
+    static std::string_view skipSpaces(std::string_view text) {
+        while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front()))) text.remove_prefix(1);
+        return text;
+    }
+};
+
+/**
+ * @brief 控制台输入源 - 阻塞读取 std::cin，协程读取时从不挂起
+ */
+class ConsoleInputSource : public InputSource {
+public:
+    bool tryReadLine(std::string& line) override {
+        return static_cast<bool>(std::getline(std::cin, line));
+    }
+
+    bool isClosed() const override {
+        return std::cin.eof() || std::cin.bad();
+    }
+};
+
+/**
+ * @brief 脚本输入源 - 由驱动方逐行推送输入，用于在一个线程上模拟大量会话（压测，或将来的网络客户端）
+ */
+class ScriptedInputSource : public InputSource {
+public:
+    explicit ScriptedInputSource(SessionScheduler& scheduler) : InputSource(&scheduler) {}
+
+    bool tryReadLine(std::string& line) override {
+        if (lines.empty()) return false;
+        line = std::move(lines.front());
+        lines.pop_front();
+        return true;
+    }
+
+    bool isClosed() const override {
+        return closed && lines.empty();
+    }
+
+    void pushLine(std::string line) {
+        if (closed) return;
+        lines.push_back(std::move(line));
+        wakeWaiter();
+    }
+
+    // 结束输入，等待中的会话读到输入结束后退出
+    void close() {
+        closed = true;
+        wakeWaiter();
+    }
+
+    size_t getPendingLines() const { return lines.size(); }
+
+private:
+    std::deque<std::string> lines;
+    bool closed = false;
+};
+
+#endif // INPUTSOURCE_H
@@ -0,0 +1,1409 @@
+﻿#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <queue>
+#include <sstream>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <filesystem>
+#include <new>
+#include <span>
+
+// 按依赖顺序包含头文件
+#include "User.h"
+#include "Product.h"
+#include "Order.h"
+#include "DatabaseManager.h"
+#include "ShopSystem.h"
+#include "PartitionRuntime.h"
+#include "CustomerSession.h"
+
+// ==================== 分配计数 ====================
+
+// 每线程的堆分配次数，用于统计各操作的平均分配次数
+static thread_local unsigned long long allocationCount = 0;
+
+// 替换的 new/delete 禁止内联：GCC 把内联进调用方的 free 与调用方看到的 operator new 配对，
+// 会误报 -Wmismatched-new-delete；保持为独立调用后，调用方看到的始终是 new 与 delete 成对
+#if defined(_MSC_VER)
+#define LOADGEN_NOINLINE __declspec(noinline)
+#else
+#define LOADGEN_NOINLINE __attribute__((noinline))
+#endif
+
+LOADGEN_NOINLINE void* operator new(std::size_t size) {
+    ++allocationCount;
+    if (void* block = std::malloc(size ? size : 1)) {
+        return block;
+    }
+    throw std::bad_alloc();
+}
+
+LOADGEN_NOINLINE void operator delete(void* block) noexcept {
+    std::free(block);
+}
+
+LOADGEN_NOINLINE void operator delete(void* block, std::size_t) noexcept {
+    std::free(block);
+}
+
+/**
+ * @brief 压测操作类型
+ */
+enum OperationType {
+    OP_BROWSE,
+    OP_SEARCH,
+    OP_ADD_TO_CART,
+    OP_CHECKOUT,
+    OP_CANCEL,
+    OP_COMPLAINT,
+    OP_LOGIN,
+    OP_AUTHENTICATE,
+    OP_COUNT
+};
+
+static const char* const OPERATION_NAMES[OP_COUNT] = {
+    "browse", "search", "cart", "checkout", "cancel", "complain", "login", "auth"
+};
+
+// 商品名称词表，搜索关键词也从这里取
+static const char* const PRODUCT_WORDS[] = {
+    "手机", "耳机", "平板", "电脑", "键盘", "鼠标", "显示器", "音箱",
+    "牛奶", "面包", "咖啡", "茶叶", "T恤", "外套", "运动鞋", "背包"
+};
+static const char* const PRODUCT_CATEGORIES[] = { "电子产品", "食品", "服装", "日用品" };
+static const char* const COMPLAINT_TYPES[] = { "质量问题", "虚假宣传", "服务问题", "其他" };
+static const int PRODUCT_WORD_COUNT = sizeof(PRODUCT_WORDS) / sizeof(PRODUCT_WORDS[0]);
+
+/**
+ * @brief 压测配置
+ */
+struct LoadConfig {
+    int users = 1000;
+    int threads = 0;              ///< 0 表示使用硬件线程数
+    int durationSeconds = 30;
+    int catalogSize = 10000;
+    int sellerCount = 50;
+    int initialStock = 1000000;
+    double thinkTimeMs = 50.0;    ///< 平均思考时间（指数分布），0 表示不等待
+    unsigned int seed = 42;
+    std::string metricsJsonPath;  ///< 非空时导出引擎内部的操作延迟直方图
+    std::string dataDirectory;    ///< 非空时启用持久化（购物车日志等）
+    int archiveAgeSeconds = -1;   ///< 订单归档期限，-1 表示使用数据库默认值
+    int shards = 16;              ///< 用户表和热订单表的分片数
+    int queryCacheMb = -1;        ///< 查询缓存容量（MB），-1 表示使用默认值，0 表示禁用
+    long long analyticsLines = 0; ///< 大于 0 时改为运行销售分析扩展性基准，指定订单项行数
+    int fuzzyQueries = 0;         ///< 大于 0 时改为运行容错搜索基准，指定查询次数
+    int commitBenchSeconds = 0;   ///< 大于 0 时改为运行订单日志组提交基准，指定每组的时长
+    int batchRecords = -1;        ///< 组提交每批最多记录数，-1 表示使用默认值
+    int batchWaitUs = -1;         ///< 组提交每批最长等待，微秒，-1 表示使用默认值
+    int partitionBenchSeconds = 0;  ///< 大于 0 时改为运行分区运行时与加锁模式的下单对比基准，指定每组时长
+    int partitions = 0;           ///< 分区运行时的分区数，0 表示与 --threads 相同
+    bool pinPartitions = false;   ///< 分区线程是否绑核
+    bool partitionRuntime = false;  ///< 会话压测的下单、取消和库存查询是否经分区运行时
+    int soakSessions = 0;         ///< 大于 0 时改为在单线程上用协程会话流程做浸泡测试，指定会话数
+    int importRows = 0;           ///< 大于 0 时改为运行批量导入用户基准，指定导入行数
+    double filterRate = -1.0;     ///< 存在性过滤器的目标误判率，-1 表示使用默认值，0 表示禁用
+    int filterBenchUsers = 0;     ///< 大于 0 时改为运行存在性过滤器基准，指定用户数
+    int memoryLimitMb = 0;        ///< 内存总软上限（MB），0 表示不限制
+    int hotOrderLimitMb = 0;      ///< 热订单内存软上限（MB），0 表示不限制
+    int mix[OP_COUNT] = { 30, 25, 20, 10, 5, 5, 5, 0 };
+};
+
+/**
+ * @brief 单个模拟用户的会话状态
+ */
+struct SimulatedUser {
+    std::unique_ptr<ShopSystem> shop;
+    std::string username;
+    std::string password;
+    std::string phone;
+    std::string token;                    ///< 登录时签发的会话令牌
+    std::vector<std::string> openOrders;  ///< 尚可取消的订单
+    std::chrono::steady_clock::time_point due;
+};
+
+/**
+ * @brief 每个工作线程独立记录的延迟样本（纳秒），结束后统一合并
+ */
+struct LatencySamples {
+    std::vector<long long> samples[OP_COUNT];
+    unsigned long long allocations[OP_COUNT] = {};
+};
+
+// ==================== 参数解析 ====================
+
+static void printUsage() {
+    std::cout << "用法: ShopLoadGenerator [选项]" << std::endl;
+    std::cout << "  --users N        模拟用户数 (默认 1000)" << std::endl;
+    std::cout << "  --threads N      工作线程数 (默认 硬件线程数)" << std::endl;
+    std::cout << "  --duration S     压测时长，秒 (默认 30)" << std::endl;
+    std::cout << "  --catalog N      商品数量 (默认 10000)" << std::endl;
+    std::cout << "  --sellers N      卖家数量 (默认 50)" << std::endl;
+    std::cout << "  --stock N        每个商品初始库存 (默认 1000000)" << std::endl;
+    std::cout << "  --think-ms X     平均思考时间，毫秒 (默认 50)" << std::endl;
+    std::cout << "  --seed N         随机种子 (默认 42)" << std::endl;
+    std::cout << "  --mix LIST       操作比例，如 browse=30,search=25,cart=20,checkout=10,"
+        "cancel=5,complain=5,login=5,auth=0" << std::endl;
+    std::cout << "  --metrics-json F 将引擎内部操作延迟统计导出为 JSON 文件" << std::endl;
+    std::cout << "  --data-dir D     持久化数据目录 (默认 不持久化)" << std::endl;
+    std::cout << "  --archive-age S  已结束订单的归档期限，秒 (默认 30 天)" << std::endl;
+    std::cout << "  --shards N       用户表和热订单表的分片数 (默认 16)" << std::endl;
+    std::cout << "  --query-cache-mb N  浏览和搜索结果缓存的容量，MB (默认 16，0 表示禁用)" << std::endl;
+    std::cout << "  --analytics-bench N  不做会话压测，改为在 N 行订单项上测试销售分析在 1..--threads"
+        " 个线程下的扩展性 (每行约 150 字节内存)" << std::endl;
+    std::cout << "  --fuzzy-bench N  不做会话压测，改为在 --catalog 个商品上执行 N 次带一处错字的容错搜索"
+        "并统计延迟与命中率" << std::endl;
+    std::cout << "  --commit-bench S 不做会话压测，改为测试订单日志在 1..--threads 个写入线程下的下单吞吐，"
+        "每组 S 秒 (数据写入 --data-dir 或当前目录下的 commit_bench)" << std::endl;
+    std::cout << "  --partition-bench S  不做会话压测，改为在 1..--threads 个客户端线程下对比加锁模式与"
+        "分区运行时的下单吞吐，每组 S 秒 (指定 --data-dir 时两种模式的订单都写入订单日志)" << std::endl;
+    std::cout << "  --partitions N   分区运行时的分区数 (默认 与 --threads 相同)" << std::endl;
+    std::cout << "  --pin N          1 表示分区线程绑核 (默认 0)" << std::endl;
+    std::cout << "  --partition-runtime N  1 表示会话压测的下单、取消和库存查询经分区运行时 (默认 0)" << std::endl;
+    std::cout << "  --session-soak N 不做会话压测，改为在单个线程上用协程菜单流程同时推进 N 个脚本会话，"
+        "持续 --duration 秒 (--mix 中 cancel 对应我的订单, complain 对应热销榜, login 对应重新登录, 忽略 auth)"
+        << std::endl;
+    std::cout << "  --import-bench N 不做会话压测，改为测试 N 行用户批量导入在 1..--threads 个线程下的吞吐"
+        " (约 2% 手机号无效, 1% 文件内重名, 1% 与已有用户重名)" << std::endl;
+    std::cout << "  --filter-rate P  用户名和商品ID存在性过滤器的目标误判率 (默认 0.01，0 表示禁用)" << std::endl;
+    std::cout << "  --filter-bench N 不做会话压测，改为在 N 个用户上对比开启和关闭存在性过滤器时"
+        "按用户名查询的吞吐 (1..--threads 个线程)" << std::endl;
+    std::cout << "  --memory-limit-mb N     数据库内存总软上限，超过时提前归档已结束订单并淘汰查询缓存 (默认 不限)"
+        << std::endl;
+    std::cout << "  --hot-order-limit-mb N  热订单内存软上限，超过时提前归档最早的已结束订单 (默认 不限)" << std::endl;
+    std::cout << "  --batch N        订单日志组提交每批最多记录数 (默认 256)" << std::endl;
+    std::cout << "  --batch-wait-us N  订单日志每批最长等待，微秒 (默认 0，即落盘线程空闲即写)" << std::endl;
+}
+
+static MemoryLimits makeMemoryLimits(const LoadConfig& config) {
+    MemoryLimits limits;
+    limits.totalBytes = static_cast<size_t>(std::max(0, config.memoryLimitMb)) * 1024 * 1024;
+    limits.hotOrderBytes = static_cast<size_t>(std::max(0, config.hotOrderLimitMb)) * 1024 * 1024;
+    return limits;
+}
+
+static bool parseMix(const std::string& text, LoadConfig& config) {
+    for (int& weight : config.mix) weight = 0;
+
+    std::istringstream iss(text);
+    std::string entry;
+    while (std::getline(iss, entry, ',')) {
+        size_t pos = entry.find('=');
+        if (pos == std::string::npos) return false;
+        std::string name = entry.substr(0, pos);
+        int weight = std::atoi(entry.substr(pos + 1).c_str());
+        if (weight < 0) return false;
+
+        bool found = false;
+        for (int op = 0; op < OP_COUNT; ++op) {
+            if (name == OPERATION_NAMES[op]) {
+                config.mix[op] = weight;
+                found = true;
+                break;
+            }
+        }
+        if (!found) return false;
+    }
+
+    for (int weight : config.mix) {
+        if (weight > 0) return true;
+    }
+    return false;
+}
+
+static bool parseArguments(int argc, char* argv[], LoadConfig& config) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") return false;
+        if (i + 1 >= argc) return false;
+        std::string value = argv[++i];
+
+        if (arg == "--users") config.users = std::atoi(value.c_str());
+        else if (arg == "--threads") config.threads = std::atoi(value.c_str());
+        else if (arg == "--duration") config.durationSeconds = std::atoi(value.c_str());
+        else if (arg == "--catalog") config.catalogSize = std::atoi(value.c_str());
+        else if (arg == "--sellers") config.sellerCount = std::atoi(value.c_str());
+        else if (arg == "--stock") config.initialStock = std::atoi(value.c_str());
+        else if (arg == "--think-ms") config.thinkTimeMs = std::atof(value.c_str());
+        else if (arg == "--seed") config.seed = static_cast<unsigned int>(std::atoi(value.c_str()));
+        else if (arg == "--metrics-json") config.metricsJsonPath = value;
+        else if (arg == "--data-dir") config.dataDirectory = value;
+        else if (arg == "--archive-age") config.archiveAgeSeconds = std::atoi(value.c_str());
+        else if (arg == "--shards") config.shards = std::atoi(value.c_str());
+        else if (arg == "--query-cache-mb") config.queryCacheMb = std::atoi(value.c_str());
+        else if (arg == "--analytics-bench") config.analyticsLines = std::atoll(value.c_str());
+        else if (arg == "--fuzzy-bench") config.fuzzyQueries = std::atoi(value.c_str());
+        else if (arg == "--commit-bench") config.commitBenchSeconds = std::atoi(value.c_str());
+        else if (arg == "--partition-bench") config.partitionBenchSeconds = std::atoi(value.c_str());
+        else if (arg == "--partitions") config.partitions = std::atoi(value.c_str());
+        else if (arg == "--pin") config.pinPartitions = std::atoi(value.c_str()) != 0;
+        else if (arg == "--partition-runtime") config.partitionRuntime = std::atoi(value.c_str()) != 0;
+        else if (arg == "--session-soak") config.soakSessions = std::atoi(value.c_str());
+        else if (arg == "--import-bench") config.importRows = std::atoi(value.c_str());
+        else if (arg == "--filter-rate") config.filterRate = std::atof(value.c_str());
+        else if (arg == "--filter-bench") config.filterBenchUsers = std::atoi(value.c_str());
+        else if (arg == "--memory-limit-mb") config.memoryLimitMb = std::atoi(value.c_str());
+        else if (arg == "--hot-order-limit-mb") config.hotOrderLimitMb = std::atoi(value.c_str());
+        else if (arg == "--batch") config.batchRecords = std::atoi(value.c_str());
+        else if (arg == "--batch-wait-us") config.batchWaitUs = std::atoi(value.c_str());
+        else if (arg == "--mix") {
+            if (!parseMix(value, config)) return false;
+        }
+        else return false;
+    }
+
+    if (config.threads <= 0) {
+        config.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    return config.users > 0 && config.durationSeconds > 0 && config.catalogSize > 0 &&
+        config.sellerCount > 0 && config.thinkTimeMs >= 0.0;
+}
+
+// ==================== 数据准备 ====================
+
+static std::string makeProductId(int index) {
+    std::ostringstream oss;
+    oss << "LG" << std::setw(7) << std::setfill('0') << index;
+    return oss.str();
+}
+
+static std::string makePhone(int index) {
+    std::ostringstream oss;
+    oss << "13" << std::setw(9) << std::setfill('0') << index;
+    return oss.str();
+}
+
+static void seedCatalog(DatabaseManager& db, const LoadConfig& config) {
+    for (int s = 0; s < config.sellerCount; ++s) {
+        db.addUser(User("lg_seller_" + std::to_string(s), "seller123", "customer",
+            "", makePhone(900000000 + s)));
+    }
+
+    for (int i = 0; i < config.catalogSize; ++i) {
+        int seller = i % config.sellerCount;
+        std::string name = std::string(PRODUCT_WORDS[i % PRODUCT_WORD_COUNT]) + " " + std::to_string(i);
+        db.addProduct(Product(makeProductId(i), name, PRODUCT_CATEGORIES[i % 4],
+            Money::fromCents(100 * (1 + i % 500)), config.initialStock, "压测商品 " + name, true,
+            "lg_seller_" + std::to_string(seller), makePhone(900000000 + seller)));
+    }
+}
+
+// ==================== 工作线程 ====================
+
+class LoadWorker {
+private:
+    DatabaseManager& db;
+    const LoadConfig& config;
+    std::vector<SimulatedUser> users;
+    std::mt19937 rng;
+    std::discrete_distribution<int> operationPicker;
+    std::exponential_distribution<double> thinkTime;
+    LatencySamples latencies;
+    std::unique_ptr<PartitionRuntime::Client> partitionClient;  ///< 本线程所有用户共用
+
+public:
+    LoadWorker(DatabaseManager& db, const LoadConfig& config, int firstUser, int userCount, unsigned int seed)
+        : db(db), config(config), rng(seed),
+        operationPicker(std::begin(config.mix), std::end(config.mix)),
+        thinkTime(config.thinkTimeMs > 0.0 ? 1.0 / config.thinkTimeMs : 1.0) {
+        users.resize(userCount);
+        for (int i = 0; i < userCount; ++i) {
+            SimulatedUser& user = users[i];
+            user.shop = std::make_unique<ShopSystem>(db);
+            user.username = "lg_user_" + std::to_string(firstUser + i);
+            user.password = "password";
+            user.phone = makePhone(firstUser + i);
+        }
+    }
+
+    // 本线程的用户改经分区运行时下单、取消和查询库存
+    void usePartitionRuntime(PartitionRuntime& runtime) {
+        partitionClient = runtime.connect();
+        for (auto& user : users) {
+            user.shop->setPartitionClient(partitionClient.get());
+        }
+    }
+
+    // 注册并登录本线程负责的所有用户（不计入压测结果）
+    void prepare() {
+        for (auto& user : users) {
+            user.shop->registerUser(user.username, user.password, "customer", "", user.phone);
+            user.shop->login(user.username, user.password);
+            user.token = user.shop->getSessionToken().toString();
+        }
+    }
+
+    void run(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point deadline) {
+        using Clock = std::chrono::steady_clock;
+        using Entry = std::pair<Clock::time_point, size_t>;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> schedule;
+
+        for (size_t i = 0; i < users.size(); ++i) {
+            users[i].due = start + nextThinkTime();
+            schedule.push(Entry(users[i].due, i));
+        }
+
+        while (!schedule.empty()) {
+            Entry next = schedule.top();
+            if (next.first >= deadline) break;
+            schedule.pop();
+
+            if (next.first > Clock::now()) {
+                std::this_thread::sleep_until(next.first);
+            }
+
+            SimulatedUser& user = users[next.second];
+            execute(user, static_cast<OperationType>(operationPicker(rng)));
+
+            user.due = Clock::now() + nextThinkTime();
+            schedule.push(Entry(user.due, next.second));
+        }
+    }
+
+    const LatencySamples& getLatencies() const { return latencies; }
+
+private:
+    std::chrono::steady_clock::duration nextThinkTime() {
+        if (config.thinkTimeMs <= 0.0) return std::chrono::steady_clock::duration::zero();
+        return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double, std::milli>(thinkTime(rng)));
+    }
+
+    std::string randomProductId() {
+        return makeProductId(std::uniform_int_distribution<int>(0, config.catalogSize - 1)(rng));
+    }
+
+    template <typename Operation>
+    void timed(OperationType type, Operation operation) {
+        // 先预留样本空间，避免样本数组扩容被计入操作的分配次数
+        auto& samples = latencies.samples[type];
+        if (samples.size() == samples.capacity()) {
+            samples.reserve(samples.capacity() * 2 + 1024);
+        }
+
+        unsigned long long allocationsBefore = allocationCount;
+        auto begin = std::chrono::steady_clock::now();
+        operation();
+        auto end = std::chrono::steady_clock::now();
+        latencies.allocations[type] += allocationCount - allocationsBefore;
+        samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+    }
+
+    void execute(SimulatedUser& user, OperationType type) {
+        ShopSystem& shop = *user.shop;
+
+        switch (type) {
+        case OP_BROWSE:
+            timed(OP_BROWSE, [&] { shop.browseProducts(); });
+            break;
+        case OP_SEARCH: {
+            std::string keyword = PRODUCT_WORDS[std::uniform_int_distribution<int>(0, PRODUCT_WORD_COUNT - 1)(rng)];
+            timed(OP_SEARCH, [&] { shop.searchProductsRanked(keyword, 0, 20); });
+            break;
+        }
+        case OP_ADD_TO_CART: {
+            std::string productId = randomProductId();
+            int quantity = std::uniform_int_distribution<int>(1, 3)(rng);
+            timed(OP_ADD_TO_CART, [&] { shop.addToCart(productId, quantity); });
+            break;
+        }
+        case OP_CHECKOUT: {
+            // 购物车为空时先加购一件商品，加购本身按 cart 计时
+            if (!shop.hasCartItems()) {
+                std::string productId = randomProductId();
+                timed(OP_ADD_TO_CART, [&] { shop.addToCart(productId, 1); });
+            }
+            Order order;
+            timed(OP_CHECKOUT, [&] { order = shop.createOrder("压测地址", "余额"); });
+            if (!order.getOrderId().empty()) {
+                user.openOrders.push_back(order.getOrderId());
+            }
+            break;
+        }
+        case OP_CANCEL:
+            if (user.openOrders.empty()) {
+                // 没有可取消的订单时退化为浏览
+                timed(OP_BROWSE, [&] { shop.browseProducts(); });
+            }
+            else {
+                size_t index = std::uniform_int_distribution<size_t>(0, user.openOrders.size() - 1)(rng);
+                std::string orderId = user.openOrders[index];
+                user.openOrders[index] = user.openOrders.back();
+                user.openOrders.pop_back();
+                timed(OP_CANCEL, [&] { shop.cancelOrder(orderId); });
+            }
+            break;
+        case OP_COMPLAINT: {
+            std::string productId = randomProductId();
+            const char* complaintType = COMPLAINT_TYPES[std::uniform_int_distribution<int>(0, 3)(rng)];
+            timed(OP_COMPLAINT, [&] {
+                shop.addComplaint(productId, complaintType, "压测投诉", "模拟用户提交的投诉内容");
+                });
+            break;
+        }
+        case OP_LOGIN:
+            shop.logout();
+            timed(OP_LOGIN, [&] { shop.login(user.username, user.password); });
+            user.token = shop.getSessionToken().toString();
+            break;
+        case OP_AUTHENTICATE: {
+            // 模拟无状态前端：每个请求只凭令牌鉴权
+            SessionInfo info;
+            timed(OP_AUTHENTICATE, [&] { shop.authenticate(user.token, info); });
+            break;
+        }
+        default:
+            break;
+        }
+    }
+};
+
+// ==================== 报告 ====================
+
+static long long percentile(const std::vector<long long>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t rank = static_cast<size_t>(p * sorted.size());
+    if (rank >= sorted.size()) rank = sorted.size() - 1;
+    return sorted[rank];
+}
+
+static void printReport(const LoadConfig& config, const std::vector<std::unique_ptr<LoadWorker>>& workers,
+    double elapsedSeconds, DatabaseManager& db) {
+    std::cout << "==========================================" << std::endl;
+    std::cout << "          压测报告" << std::endl;
+    std::cout << "==========================================" << std::endl;
+    std::cout << "模拟用户: " << config.users << "  线程: " << config.threads
+        << "  时长: " << std::fixed << std::setprecision(1) << elapsedSeconds << "s"
+        << "  商品数: " << config.catalogSize
+        << "  平均思考时间: " << config.thinkTimeMs << "ms"
+        << "  分片: " << config.shards << std::endl;
+
+    std::cout << std::left << std::setw(10) << "操作"
+        << std::right << std::setw(10) << "次数"
+        << std::setw(14) << "吞吐(ops/s)"
+        << std::setw(12) << "p50(us)"
+        << std::setw(12) << "p90(us)"
+        << std::setw(12) << "p99(us)"
+        << std::setw(12) << "p99.9(us)"
+        << std::setw(12) << "max(us)"
+        << std::setw(14) << "分配次数/op" << std::endl;
+
+    size_t totalOperations = 0;
+    for (int op = 0; op < OP_COUNT; ++op) {
+        std::vector<long long> merged;
+        unsigned long long allocations = 0;
+        for (const auto& worker : workers) {
+            const auto& samples = worker->getLatencies().samples[op];
+            merged.insert(merged.end(), samples.begin(), samples.end());
+            allocations += worker->getLatencies().allocations[op];
+        }
+        std::sort(merged.begin(), merged.end());
+        totalOperations += merged.size();
+
+        std::cout << std::left << std::setw(10) << OPERATION_NAMES[op]
+            << std::right << std::setw(10) << merged.size()
+            << std::setw(14) << std::setprecision(1) << merged.size() / elapsedSeconds
+            << std::setw(12) << percentile(merged, 0.50) / 1000.0
+            << std::setw(12) << percentile(merged, 0.90) / 1000.0
+            << std::setw(12) << percentile(merged, 0.99) / 1000.0
+            << std::setw(12) << percentile(merged, 0.999) / 1000.0
+            << std::setw(12) << (merged.empty() ? 0.0 : merged.back() / 1000.0)
+            << std::setw(14) << (merged.empty() ? 0.0 : static_cast<double>(allocations) / merged.size())
+            << std::endl;
+    }
+
+    std::cout << "------------------------------------------" << std::endl;
+    std::cout << "总操作数: " << totalOperations
+        << "  总吞吐: " << std::setprecision(1) << totalOperations / elapsedSeconds << " ops/s" << std::endl;
+    std::cout << "订单总数: " << db.getTotalOrderCount()
+        << " (已归档 " << db.getOrderArchive().getOrderCount() << ")"
+        << "  投诉总数: " << db.getTotalComplaintCount() << std::endl;
+
+    QueryCacheStats cache = db.getQueryCacheStats();
+    std::cout << "查询缓存命中率: " << std::setprecision(1) << 100.0 * cache.getHitRate() << "%"
+        << " (命中 " << cache.hits << ", 未命中 " << cache.misses << ", 失效 " << cache.invalidations
+        << ", 淘汰 " << cache.evictions << ")  条目: " << cache.entryCount
+        << "  内存: " << cache.memoryBytes / 1024 << " / " << cache.capacityBytes / 1024 << " KB" << std::endl;
+
+    if (!config.dataDirectory.empty()) {
+        GroupCommitStats journal = db.getOrderJournalStats();
+        std::cout << "订单日志: 落盘 " << journal.records << " 条, " << journal.batches << " 批"
+            << " (平均每批 " << std::setprecision(1) << journal.getAverageBatch() << " 条)";
+        if (journal.failedBatches > 0) std::cout << "  失败 " << journal.failedBatches << " 批";
+        std::cout << std::endl;
+    }
+
+    auto guard = db.lock();
+    MemoryReport memory = db.getMemoryReport();
+    std::cout << "内存(估算): 合计 " << std::setprecision(1) << memory.getTotalBytes() / 1048576.0 << " MB, 索引 "
+        << memory.getIndexBytes() / 1048576.0 << " MB  (";
+    for (size_t i = 0; i < memory.entries.size(); ++i) {
+        std::cout << (i ? ", " : "") << memory.entries[i].name << " "
+            << memory.entries[i].usage.bytes / 1048576.0;
+    }
+    std::cout << ")" << std::endl;
+    const MemoryPressureStats& pressure = db.getMemoryPressureStats();
+    if (pressure.checks > 0 || pressure.overLimitEvents > 0) {
+        std::cout << "内存上限: 检查 " << pressure.checks << " 次, 超限 " << pressure.overLimitEvents
+            << " 次, 提前归档 " << pressure.ordersArchived << " 个订单, 淘汰缓存 "
+            << pressure.cacheBytesTrimmed / 1024 << " KB" << (pressure.overLimit ? ", 仍超限" : "") << std::endl;
+    }
+}
+
+// ==================== 销售分析基准 ====================
+
+/**
+ * @brief 生成合成订单（每单 5 行订单项，日期分布在一年内），多线程并行构造
+ */
+static std::vector<Order> generateAnalyticsOrders(const LoadConfig& config) {
+    static const int LINES_PER_ORDER = 5;
+    size_t orderCount = static_cast<size_t>((config.analyticsLines + LINES_PER_ORDER - 1) / LINES_PER_ORDER);
+    std::vector<Order> orders(orderCount);
+
+    std::vector<std::thread> threads;
+    size_t perThread = (orderCount + config.threads - 1) / config.threads;
+    for (int t = 0; t < config.threads; ++t) {
+        threads.emplace_back([&, t] {
+            std::mt19937 rng(config.seed + t);
+            size_t end = std::min(orderCount, (t + 1) * perThread);
+            for (size_t i = t * perThread; i < end; ++i) {
+                std::ostringstream line;
+                line << "BENCH" << i << "|buyer" << rng() % 100000 << "|0|2025-"
+                    << std::setw(2) << std::setfill('0') << 1 + rng() % 12 << "-"
+                    << std::setw(2) << 1 + rng() % 28 << " 12:00:00|"
+                    << (rng() % 10 == 0 ? "cancelled" : "completed") << "|地址|支付宝|13900000000|";
+                for (int k = 0; k < LINES_PER_ORDER; ++k) {
+                    int product = static_cast<int>(rng() % config.catalogSize);
+                    int seller = product % config.sellerCount;
+                    if (k > 0) line << ";";
+                    line << makeProductId(product) << "|商品|" << 1 + rng() % 3 << "|" << 1 + product % 500
+                        << "|lg_seller_" << seller << "|" << makePhone(900000000 + seller);
+                }
+                orders[i] = Order::fromString(line.str());
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    return orders;
+}
+
+static int runAnalyticsBenchmark(const LoadConfig& config) {
+    std::cout << "生成 " << config.analyticsLines << " 行订单项..." << std::endl;
+    std::vector<Order> orders = generateAnalyticsOrders(config);
+
+    std::vector<std::string> productIds;
+    productIds.reserve(config.catalogSize);
+    SalesAnalytics::CategoryLookup categories;
+    for (int i = 0; i < config.catalogSize; ++i) {
+        productIds.push_back(makeProductId(i));
+    }
+    for (int i = 0; i < config.catalogSize; ++i) {
+        categories.emplace(productIds[i], PRODUCT_CATEGORIES[i % 4]);
+    }
+
+    std::vector<std::span<const Order>> sources = { std::span<const Order>(orders) };
+    std::cout << std::left << std::setw(8) << "线程" << std::right << std::setw(12) << "耗时(ms)"
+        << std::setw(16) << "行/秒" << std::setw(10) << "加速比" << std::setw(10) << "效率" << std::endl;
+
+    double baseline = 0.0;
+    for (int threads = 1; ; threads = std::min(threads * 2, config.threads)) {
+        // 每种线程数跑 3 次取最快，排除首次缺页等干扰
+        SalesReport best;
+        for (int run = 0; run < 3; ++run) {
+            SalesReport report = SalesAnalytics::compute(sources, categories, threads);
+            if (run == 0 || report.elapsedMs < best.elapsedMs) best = std::move(report);
+        }
+        if (threads == 1) baseline = best.elapsedMs;
+
+        double speedup = baseline / best.elapsedMs;
+        std::cout << std::left << std::setw(8) << threads << std::right << std::fixed << std::setprecision(1)
+            << std::setw(12) << best.elapsedMs
+            << std::setw(16) << std::setprecision(0) << best.linesScanned / (best.elapsedMs / 1000.0)
+            << std::setw(10) << std::setprecision(2) << speedup
+            << std::setw(9) << std::setprecision(0) << 100.0 * speedup / threads << "%" << std::endl;
+
+        if (threads == config.threads) {
+            std::cout << "销售额 Y" << std::setprecision(2) << best.totalRevenue << ", 卖家 " << best.bySeller.size()
+                << ", 商品 " << best.byProduct.size() << ", 日期 " << best.byDay.size() << std::endl;
+            break;
+        }
+    }
+    return 0;
+}
+
+// ==================== 容错搜索基准 ====================
+
+/**
+ * @brief 随机取一个商品名称，随机替换、删除或插入一个字符作为查询，检查该商品是否在结果中
+ */
+static int runFuzzySearchBenchmark(const LoadConfig& config) {
+    DatabaseManager db("");
+    std::cout << "准备数据: " << config.catalogSize << " 个商品..." << std::endl;
+    std::cout.setstate(std::ios_base::badbit);
+    seedCatalog(db, config);
+    std::cout.clear();
+
+    static const char* const TYPO_CHARACTERS[] = { "机", "鸡", "耳", "x", "7", "0" };
+    std::mt19937 rng(config.seed);
+    std::vector<long long> latencies;
+    latencies.reserve(config.fuzzyQueries);
+    int found = 0;
+    size_t totalResults = 0;
+
+    for (int q = 0; q < config.fuzzyQueries; ++q) {
+        int target = std::uniform_int_distribution<int>(0, config.catalogSize - 1)(rng);
+        auto product = db.getProduct(makeProductId(target));
+        std::string name = product->getName();
+
+        // 按 UTF-8 字符边界切分后做一处修改
+        std::vector<std::string> characters;
+        for (size_t i = 0; i < name.size();) {
+            size_t next = i;
+            Utf8Text::decode(name, next);
+            characters.push_back(name.substr(i, next - i));
+            i = next;
+        }
+        size_t at = rng() % characters.size();
+        std::string typo = TYPO_CHARACTERS[rng() % (sizeof(TYPO_CHARACTERS) / sizeof(TYPO_CHARACTERS[0]))];
+        switch (rng() % 3) {
+        case 0: characters[at] = typo; break;
+        case 1: characters.erase(characters.begin() + at); break;
+        default: characters.insert(characters.begin() + at, typo); break;
+        }
+        std::string query;
+        for (const auto& character : characters) query += character;
+
+        auto begin = std::chrono::steady_clock::now();
+        std::vector<Product> results = db.fuzzySearchProducts(query);
+        auto end = std::chrono::steady_clock::now();
+        latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+
+        totalResults += results.size();
+        for (const auto& result : results) {
+            if (result.getId() == product->getId()) {
+                ++found;
+                break;
+            }
+        }
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) {
+        return latencies[std::min(latencies.size() - 1, static_cast<size_t>(p * latencies.size()))] / 1e6;
+    };
+    std::cout << std::fixed << std::setprecision(3)
+        << "查询 " << latencies.size() << " 次  p50 " << percentile(0.50) << " ms  p99 " << percentile(0.99)
+        << " ms  最大 " << latencies.back() / 1e6 << " ms" << std::endl;
+    std::cout << std::setprecision(1) << "目标商品命中率 " << 100.0 * found / latencies.size()
+        << "%  平均结果数 " << static_cast<double>(totalResults) / latencies.size() << std::endl;
+    return 0;
+}
+
+// ==================== 组提交基准 ====================
+
+static GroupCommitOptions makeJournalOptions(const LoadConfig& config) {
+    GroupCommitOptions options;
+    if (config.batchRecords > 0) options.maxBatchRecords = static_cast<size_t>(config.batchRecords);
+    if (config.batchWaitUs >= 0) options.maxWait = std::chrono::microseconds(config.batchWaitUs);
+    return options;
+}
+
+/**
+ * @brief 各写入线程在引擎锁内下单，释放锁后等待订单日志落盘，统计每秒持久化的订单数
+ */
+static GroupCommitStats runCommitRound(const LoadConfig& config, const std::string& directory,
+    GroupCommitOptions options, int threadCount, double& ordersPerSecond) {
+    std::error_code error;
+    std::filesystem::remove_all(directory, error);
+    DatabaseManager db(directory);
+    db.setOrderJournalOptions(options);
+
+    std::vector<OrderItem> items = {
+        OrderItem(makeProductId(0), "商品", 1, Money::fromCents(9900), "lg_seller_0", makePhone(900000000))
+    };
+    std::atomic<long long> completed{ 0 };
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(config.commitBenchSeconds);
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t] {
+            std::string username = "lg_writer_" + std::to_string(t);
+            long long count = 0;
+            while (std::chrono::steady_clock::now() < deadline) {
+                Order order(username, items, "地址", "支付宝", makePhone(t));
+                auto guard = db.lock();
+                db.addOrder(std::move(order));
+                ++count;  // guard 析构时释放锁并等待落盘，下一轮开始时本单已持久化
+            }
+            completed += count;
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ordersPerSecond = completed.load() / elapsed;
+    return db.getOrderJournalStats();
+}
+
+static int runCommitBenchmark(const LoadConfig& config) {
+    std::string directory = (std::filesystem::path(config.dataDirectory.empty() ? "." : config.dataDirectory)
+        / "commit_bench").string();
+    GroupCommitOptions grouped = makeJournalOptions(config);
+    GroupCommitOptions single = grouped;
+    single.maxBatchRecords = 1;
+    single.maxWait = std::chrono::microseconds(0);
+
+    std::cout << "组提交: 每批最多 " << grouped.maxBatchRecords << " 条, 最长等待 " << grouped.maxWait.count()
+        << " us, 每组 " << config.commitBenchSeconds << " s, 目录 " << directory << std::endl;
+    std::cout << std::left << std::setw(8) << "线程" << std::right << std::setw(16) << "逐条同步(单/秒)"
+        << std::setw(16) << "组提交(单/秒)" << std::setw(10) << "提升" << std::setw(12) << "平均批大小"
+        << std::setw(12) << "同步/秒" << std::endl;
+
+    for (int threads = 1; ; threads = std::min(threads * 2, config.threads)) {
+        double singleRate = 0.0;
+        double groupedRate = 0.0;
+        std::cout.setstate(std::ios_base::badbit);
+        runCommitRound(config, directory, single, threads, singleRate);
+        GroupCommitStats stats = runCommitRound(config, directory, grouped, threads, groupedRate);
+        std::cout.clear();
+
+        std::cout << std::left << std::setw(8) << threads << std::right << std::fixed << std::setprecision(0)
+            << std::setw(16) << singleRate << std::setw(16) << groupedRate
+            << std::setw(9) << std::setprecision(2) << groupedRate / std::max(singleRate, 1.0) << "x"
+            << std::setw(12) << std::setprecision(1) << stats.getAverageBatch()
+            << std::setw(12) << std::setprecision(0) << stats.batches / static_cast<double>(config.commitBenchSeconds)
+            << std::endl;
+        if (stats.failedBatches > 0) {
+            std::cout << "  警告: " << stats.failedBatches << " 批写入或同步失败" << std::endl;
+        }
+        if (threads == config.threads) break;
+    }
+
+    std::error_code error;
+    std::filesystem::remove_all(directory, error);
+    return 0;
+}
+
+// ==================== 分区运行时基准 ====================
+
+/**
+ * @brief 一次随机下单的内容：用户和 1~3 个不同的商品，每个 1 件
+ */
+struct BenchCheckout {
+    std::string username;
+    std::vector<CheckoutLine> lines;
+};
+
+static BenchCheckout makeBenchCheckout(const LoadConfig& config, std::mt19937& rng) {
+    static const int BENCH_USERS = 1000;
+    BenchCheckout checkout;
+    checkout.username = "lg_buyer_" + std::to_string(rng() % BENCH_USERS);
+    int lineCount = 1 + static_cast<int>(rng() % 3);
+    while (static_cast<int>(checkout.lines.size()) < lineCount) {
+        std::string productId = makeProductId(static_cast<int>(rng() % config.catalogSize));
+        bool duplicate = std::any_of(checkout.lines.begin(), checkout.lines.end(),
+            [&](const CheckoutLine& line) { return line.productId == productId; });
+        if (!duplicate) checkout.lines.push_back(CheckoutLine{ productId, 1 });
+    }
+    return checkout;
+}
+
+/**
+ * @brief 在 threadCount 个线程中并发执行 body(rng)，返回每秒完成的次数
+ */
+template <typename Body>
+static double measureThroughput(const LoadConfig& config, int threadCount, Body&& body) {
+    std::atomic<long long> completed{ 0 };
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::seconds(config.partitionBenchSeconds);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t] {
+            std::mt19937 rng(config.seed + t * 7919);
+            long long count = 0;
+            while (std::chrono::steady_clock::now() < deadline) {
+                if (body(t, rng)) ++count;
+            }
+            completed += count;
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return completed.load() / elapsed;
+}
+
+static int runPartitionBenchmark(const LoadConfig& config) {
+    DatabaseManager db(config.dataDirectory);
+    db.setOrderJournalOptions(makeJournalOptions(config));
+    std::cout << "准备数据: " << config.catalogSize << " 个商品..." << std::endl;
+    std::cout.setstate(std::ios_base::badbit);
+    seedCatalog(db, config);
+    std::cout.clear();
+    size_t partitionCount = static_cast<size_t>(config.partitions > 0 ? config.partitions : config.threads);
+
+    std::cout << "分区数: " << partitionCount << (config.pinPartitions ? " (绑核)" : "")
+        << ", 每组 " << config.partitionBenchSeconds << " s" << std::endl;
+    std::cout << std::left << std::setw(8) << "线程" << std::right << std::setw(16) << "加锁模式(单/秒)"
+        << std::setw(16) << "分区模式(单/秒)" << std::setw(10) << "提升" << std::setw(12) << "跨分区" << std::endl;
+
+    for (int threads = 1; ; threads = std::min(threads * 2, config.threads)) {
+        // 加锁模式：与 ShopSystem::createOrder 相同，以事务扣库存并追加订单，只锁涉及的商品块和订单分片
+        double lockedRate = measureThroughput(config, threads, [&](int, std::mt19937& rng) {
+            BenchCheckout checkout = makeBenchCheckout(config, rng);
+            auto transaction = db.beginTransaction();
+            std::vector<OrderItem> items;
+            for (const CheckoutLine& line : checkout.lines) {
+                auto product = db.getProduct(line.productId);
+                if (!product) return false;
+                items.emplace_back(product->getId(), product->getName(), line.quantity, product->getPrice(),
+                    product->getSellerUsername(), product->getSellerPhone());
+                transaction.reduceStock(line.productId, line.quantity);
+            }
+            transaction.addOrder(Order(checkout.username, std::move(items), "地址", "支付宝"));
+            return transaction.commit() && transaction.waitDurable();
+        });
+
+        // 分区模式：每个线程一个客户端，库存和订单写入同一个数据库
+        PartitionRuntime runtime(db, partitionCount, static_cast<size_t>(threads));
+        runtime.start(config.pinPartitions);
+        std::vector<std::unique_ptr<PartitionRuntime::Client>> clients;
+        for (int t = 0; t < threads; ++t) {
+            clients.push_back(runtime.connect());
+        }
+        double partitionedRate = measureThroughput(config, threads, [&](int t, std::mt19937& rng) {
+            BenchCheckout checkout = makeBenchCheckout(config, rng);
+            Order order;
+            std::string error;
+            return clients[t]->checkout(checkout.username, checkout.lines, "地址", "支付宝", "", order, error) &&
+                clients[t]->waitDurable();
+        });
+        runtime.stop();
+        PartitionStats stats = runtime.getStats();
+
+        std::cout << std::left << std::setw(8) << threads << std::right << std::fixed << std::setprecision(0)
+            << std::setw(16) << lockedRate << std::setw(16) << partitionedRate
+            << std::setw(9) << std::setprecision(2) << partitionedRate / std::max(lockedRate, 1.0) << "x"
+            << std::setw(11) << std::setprecision(1)
+            << 100.0 * stats.crossPartitionCheckouts / std::max<uint64_t>(1, stats.orders + stats.failedCheckouts)
+            << "%" << std::endl;
+        if (threads == config.threads) break;
+    }
+    return 0;
+}
+
+// ==================== 协程会话浸泡测试 ====================
+
+enum SoakFlow { FLOW_REGISTER, FLOW_BROWSE, FLOW_SEARCH, FLOW_CART, FLOW_CHECKOUT, FLOW_ORDERS, FLOW_TOP, FLOW_RELOGIN, FLOW_COUNT };
+
+static const char* const SOAK_FLOW_NAMES[FLOW_COUNT] = {
+    "register", "browse", "search", "cart", "checkout", "orders", "top", "relogin"
+};
+
+/**
+ * @brief 一个脚本驱动的会话：输入源、会话状态和协程菜单流程
+ */
+struct SoakSession {
+    ScriptedInputSource input;
+    ShopSystem shop;
+    CustomerSession flows;
+    std::string username;
+    std::string phone;
+
+    SoakSession(SessionScheduler& scheduler, DatabaseManager& db, std::ostream& out)
+        : input(scheduler), shop(db), flows(shop, input, out) {
+    }
+};
+
+class SoakDriver {
+private:
+    const LoadConfig& config;
+    SessionScheduler& scheduler;
+    std::mt19937 rng;
+    std::discrete_distribution<int> flowPicker;
+
+public:
+    std::vector<long long> samples[FLOW_COUNT];  ///< 每个流程从送出第一行到回到菜单的耗时（纳秒）
+    unsigned long long linesSent = 0;
+    unsigned long long desyncs = 0;  ///< 补足回车后仍未回到菜单的次数
+
+    SoakDriver(const LoadConfig& config, SessionScheduler& scheduler)
+        : config(config), scheduler(scheduler), rng(config.seed),
+        flowPicker({ 0.0, double(config.mix[OP_BROWSE]), double(config.mix[OP_SEARCH]),
+            double(config.mix[OP_ADD_TO_CART]), double(config.mix[OP_CHECKOUT]), double(config.mix[OP_CANCEL]),
+            double(config.mix[OP_COMPLAINT]), double(config.mix[OP_LOGIN]) }) {
+    }
+
+    SoakFlow pickFlow() {
+        return static_cast<SoakFlow>(flowPicker(rng));
+    }
+
+    /**
+     * @brief 向会话送出一个流程的输入并推进到它回到菜单，记录耗时
+     */
+    void drive(SoakSession& session, SoakFlow flow) {
+        std::vector<std::string> lines;
+        script(session, flow, lines);
+
+        auto begin = std::chrono::steady_clock::now();
+        for (auto& line : lines) {
+            session.input.pushLine(std::move(line));
+        }
+        linesSent += lines.size();
+        scheduler.runReady();
+
+        // 流程末尾的分页提示和"按回车键继续"都以回车结束
+        for (int i = 0; i < 8 && !session.flows.isIdle() && session.input.isWaiting(); ++i) {
+            session.input.pushLine("");
+            ++linesSent;
+            scheduler.runReady();
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        if (!session.flows.isIdle()) ++desyncs;
+        samples[flow].push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+    }
+
+private:
+    std::string randomProductId() {
+        return makeProductId(std::uniform_int_distribution<int>(0, config.catalogSize - 1)(rng));
+    }
+
+    void script(SoakSession& session, SoakFlow flow, std::vector<std::string>& lines) {
+        switch (flow) {
+        case FLOW_REGISTER:
+            lines = { "2", session.username, "password", "password", "", session.phone, "y" };
+            break;
+        case FLOW_BROWSE:
+            lines = { "1" };
+            break;
+        case FLOW_SEARCH:
+            lines = { "2", PRODUCT_WORDS[std::uniform_int_distribution<int>(0, PRODUCT_WORD_COUNT - 1)(rng)] };
+            break;
+        case FLOW_CART:
+            lines = { "3", randomProductId(), "1", std::to_string(std::uniform_int_distribution<int>(1, 3)(rng)) };
+            break;
+        case FLOW_CHECKOUT:
+            // 购物车为空时先加购一件商品
+            if (!session.shop.hasCartItems()) {
+                lines = { "3", randomProductId(), "1", "1", "" };
+            }
+            lines.insert(lines.end(), { "4", "2", "压测地址", "余额" });
+            break;
+        case FLOW_ORDERS: {
+            auto orders = session.shop.getUserOrders();
+            if (orders.empty()) {
+                lines = { "5", "4" };
+            }
+            else {
+                size_t index = std::uniform_int_distribution<size_t>(0, orders.size() - 1)(rng);
+                lines = { "5", "2", orders[index].getOrderId() };
+            }
+            break;
+        }
+        case FLOW_TOP:
+            lines = { "8", "1", "" };
+            break;
+        case FLOW_RELOGIN:
+            lines = { "9", "", "1", session.username, "password" };
+            break;
+        default:
+            break;
+        }
+    }
+};
+
+/**
+ * @brief 在单个线程上用协程菜单流程推进大量脚本会话
+ *
+ * 每个会话是一个挂起在菜单输入处的协程，到期时由驱动方送出一个流程的输入行，
+ * 会话执行到下一次等待输入再挂起。会话数只受内存限制，不受线程数限制。
+ */
+static int runSessionSoak(const LoadConfig& config) {
+    DatabaseManager db(config.dataDirectory, static_cast<size_t>(std::max(1, config.shards)));
+    if (config.archiveAgeSeconds >= 0) {
+        db.setOrderArchiveAge(std::chrono::seconds(config.archiveAgeSeconds));
+    }
+    if (config.queryCacheMb >= 0) {
+        db.setQueryCacheCapacity(static_cast<size_t>(config.queryCacheMb) * 1024 * 1024);
+    }
+    if (config.filterRate >= 0.0) {
+        db.setExistenceFilterRate(config.filterRate);
+    }
+    db.setMemoryLimits(makeMemoryLimits(config));
+    db.setOrderJournalOptions(makeJournalOptions(config));
+
+    std::cout << "准备数据: " << config.catalogSize << " 个商品, " << config.soakSessions << " 个协程会话..." << std::endl;
+    std::cout.setstate(std::ios_base::badbit);
+    seedCatalog(db, config);
+
+    // 菜单文字丢弃：没有缓冲区的输出流只设置错误位，不做格式化输出
+    std::ostream discard(nullptr);
+    SessionScheduler scheduler;
+    SoakDriver driver(config, scheduler);
+    std::vector<std::unique_ptr<SoakSession>> sessions;
+    sessions.reserve(config.soakSessions);
+
+    unsigned long long allocationsBefore = allocationCount;
+    for (int i = 0; i < config.soakSessions; ++i) {
+        auto session = std::make_unique<SoakSession>(scheduler, db, discard);
+        session->username = "lg_soak_" + std::to_string(i);
+        session->phone = makePhone(i);
+        scheduler.spawn(session->flows.run());
+        sessions.push_back(std::move(session));
+    }
+    scheduler.runReady();
+    unsigned long long sessionAllocations = allocationCount - allocationsBefore;
+
+    // 注册并自动登录（计入 register 流程）
+    for (auto& session : sessions) {
+        driver.drive(*session, FLOW_REGISTER);
+    }
+
+    using Clock = std::chrono::steady_clock;
+    std::exponential_distribution<double> thinkTime(config.thinkTimeMs > 0.0 ? 1.0 / config.thinkTimeMs : 1.0);
+    std::mt19937 thinkRng(config.seed + 1);
+    auto nextThinkTime = [&]() -> Clock::duration {
+        if (config.thinkTimeMs <= 0.0) return Clock::duration::zero();
+        return std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double, std::milli>(thinkTime(thinkRng)));
+    };
+
+    auto start = Clock::now();
+    auto deadline = start + std::chrono::seconds(config.durationSeconds);
+    using Entry = std::pair<Clock::time_point, size_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> schedule;
+    for (size_t i = 0; i < sessions.size(); ++i) {
+        schedule.push(Entry(start + nextThinkTime(), i));
+    }
+
+    while (!schedule.empty()) {
+        Entry next = schedule.top();
+        if (next.first >= deadline || Clock::now() >= deadline) break;
+        schedule.pop();
+
+        if (next.first > Clock::now()) {
+            std::this_thread::sleep_until(next.first);
+        }
+        driver.drive(*sessions[next.second], driver.pickFlow());
+        schedule.push(Entry(Clock::now() + nextThinkTime(), next.second));
+    }
+    double elapsedSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    // 关闭全部输入，会话读到输入结束后退出
+    for (auto& session : sessions) {
+        session->input.close();
+    }
+    scheduler.runReady();
+    size_t finished = scheduler.reapFinished();
+    std::cout.clear();
+
+    std::cout << "==========================================" << std::endl;
+    std::cout << "          协程会话浸泡测试" << std::endl;
+    std::cout << "==========================================" << std::endl;
+    std::cout << "会话: " << config.soakSessions << " (单线程)  时长: " << std::fixed << std::setprecision(1)
+        << elapsedSeconds << "s  商品数: " << config.catalogSize
+        << "  平均思考时间: " << config.thinkTimeMs << "ms" << std::endl;
+    std::cout << std::left << std::setw(10) << "流程"
+        << std::right << std::setw(10) << "次数"
+        << std::setw(14) << "吞吐(次/s)"
+        << std::setw(12) << "p50(us)"
+        << std::setw(12) << "p99(us)"
+        << std::setw(12) << "max(us)" << std::endl;
+
+    size_t totalFlows = 0;
+    for (int flow = 0; flow < FLOW_COUNT; ++flow) {
+        std::vector<long long>& samples = driver.samples[flow];
+        std::sort(samples.begin(), samples.end());
+        if (flow != FLOW_REGISTER) totalFlows += samples.size();
+        std::cout << std::left << std::setw(10) << SOAK_FLOW_NAMES[flow]
+            << std::right << std::setw(10) << samples.size()
+            << std::setw(14) << (flow == FLOW_REGISTER ? 0.0 : samples.size() / elapsedSeconds)
+            << std::setw(12) << percentile(samples, 0.50) / 1000.0
+            << std::setw(12) << percentile(samples, 0.99) / 1000.0
+            << std::setw(12) << (samples.empty() ? 0.0 : samples.back() / 1000.0) << std::endl;
+    }
+
+    std::cout << "------------------------------------------" << std::endl;
+    std::cout << "流程总数: " << totalFlows << "  总吞吐: " << std::setprecision(1)
+        << totalFlows / elapsedSeconds << " 次/s  输入行: " << driver.linesSent
+        << "  未回到菜单: " << driver.desyncs << std::endl;
+    std::cout << "建立会话的分配次数: " << sessionAllocations << " (每会话 " << std::setprecision(1)
+        << static_cast<double>(sessionAllocations) / config.soakSessions << ")"
+        << "  正常结束: " << finished << "  异常结束: " << scheduler.getFailedCount()
+        << "  未结束: " << scheduler.getActiveCount() << std::endl;
+    std::cout << "订单总数: " << db.getTotalOrderCount() << "  用户数: " << db.getTotalUserCount() << std::endl;
+    return 0;
+}
+
+// ==================== 批量导入基准 ====================
+
+/**
+ * @brief 生成导入数据：按行号混入无效手机号、文件内重名和与已有用户重名的行
+ */
+static std::vector<User> generateImportRows(const LoadConfig& config) {
+    std::vector<User> users;
+    users.reserve(config.importRows);
+    for (int i = 0; i < config.importRows; ++i) {
+        std::string username = "lg_import_" + std::to_string(i);
+        std::string phone = makePhone(i);
+        if (i % 50 == 7) phone = "1234";                                   // 手机号无效
+        if (i % 100 == 3 && i > 0) username = "lg_import_" + std::to_string(i - 1);  // 与上一行重名
+        if (i % 100 == 5) username = "lg_seller_" + std::to_string(i % config.sellerCount);  // 已存在
+        users.push_back(User(std::move(username), "import123", "customer", "", std::move(phone)));
+    }
+    return users;
+}
+
+static int runImportBenchmark(const LoadConfig& config) {
+    std::cout << "生成 " << config.importRows << " 行导入数据..." << std::endl;
+    const std::vector<User> rows = generateImportRows(config);
+
+    std::cout << std::left << std::setw(8) << "线程" << std::right << std::setw(12) << "耗时(ms)"
+        << std::setw(16) << "用户/秒" << std::setw(10) << "导入" << std::setw(10) << "拒绝"
+        << std::setw(10) << "加速比" << std::endl;
+
+    double baseline = 0.0;
+    for (int threads = 1; ; threads = std::min(threads * 2, config.threads)) {
+        // 每种线程数跑 3 次取最快，每次使用新的数据库
+        UserImportReport best;
+        for (int run = 0; run < 3; ++run) {
+            DatabaseManager db("", static_cast<size_t>(std::max(1, config.shards)));
+            for (int s = 0; s < config.sellerCount; ++s) {
+                db.addUser(User("lg_seller_" + std::to_string(s), "seller123", "customer",
+                    "", makePhone(900000000 + s)));
+            }
+            std::vector<User> users = rows;
+            UserImportReport report = db.importUsers(users, static_cast<unsigned>(threads));
+            if (run == 0 || report.elapsedMs < best.elapsedMs) best = std::move(report);
+        }
+        if (threads == 1) baseline = best.elapsedMs;
+
+        std::cout << std::left << std::setw(8) << best.threadsUsed << std::right << std::fixed << std::setprecision(1)
+            << std::setw(12) << best.elapsedMs
+            << std::setw(16) << std::setprecision(0) << best.getUsersPerSecond()
+            << std::setw(10) << best.imported
+            << std::setw(10) << best.rejected.size()
+            << std::setw(10) << std::setprecision(2) << baseline / best.elapsedMs << std::endl;
+
+        if (threads == config.threads) {
+            for (size_t i = 0; i < best.rejected.size() && i < 3; ++i) {
+                std::cout << "拒绝示例: 第 " << best.rejected[i].row + 1 << " 行 " << best.rejected[i].username
+                    << ": " << best.rejected[i].reason << std::endl;
+            }
+            break;
+        }
+    }
+    return 0;
+}
+
+// ==================== 存在性过滤器基准 ====================
+
+/**
+ * @brief 每个线程按给定用户名表循环查询用户编号，返回总查询速率
+ */
+static double measureLookups(DatabaseManager& db, const std::vector<std::string>& names, int threadCount,
+    size_t lookupsPerThread) {
+    std::atomic<long long> found{ 0 };
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t] {
+            long long hits = 0;
+            size_t offset = static_cast<size_t>(t) * 7919;
+            for (size_t i = 0; i < lookupsPerThread; ++i) {
+                if (db.findUserId(names[(offset + i) % names.size()]) >= 0) ++hits;
+            }
+            found += hits;
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return static_cast<double>(lookupsPerThread) * threadCount / elapsed;
+}
+
+static void printFilterStats(const char* label, const ExistenceFilter::Stats& stats) {
+    std::cout << label << ": 键 " << stats.keys << ", 阶段 " << stats.stages << ", 重建 " << stats.rebuilds
+        << ", 哈希 " << stats.hashCount << ", 内存 " << std::setprecision(1) << stats.memoryBytes / 1024.0 << " KB"
+        << ", 估算误判率 " << std::setprecision(3) << stats.estimatedRate * 100.0 << "%" << std::endl;
+}
+
+/**
+ * @brief 撞库式查询（随机不存在的用户名）和正常登录查询在过滤器开启、关闭时的吞吐对比
+ */
+static int runFilterBenchmark(const LoadConfig& config) {
+    double rate = config.filterRate > 0.0 ? config.filterRate : ExistenceFilter::DEFAULT_FALSE_POSITIVE_RATE;
+    DatabaseManager db("", static_cast<size_t>(std::max(1, config.shards)));
+    db.setExistenceFilterRate(rate);
+
+    std::cout << "准备数据: " << config.filterBenchUsers << " 个用户..." << std::endl;
+    std::vector<User> users;
+    users.reserve(config.filterBenchUsers);
+    for (int i = 0; i < config.filterBenchUsers; ++i) {
+        users.push_back(User("lg_user_" + std::to_string(i), "import123", "customer", "", makePhone(i)));
+    }
+    // 逐个注册，过滤器随用户数增长追加阶段并自动重建
+    for (auto& user : users) {
+        db.addUser(std::move(user));
+    }
+    std::cout << std::fixed;
+    printFilterStats("用户名过滤器", db.getUserFilterStats());
+
+    const size_t sampleCount = 1 << 20;
+    std::mt19937 rng(config.seed);
+    std::uniform_int_distribution<int> existing(0, config.filterBenchUsers - 1);
+    std::vector<std::string> missing;
+    std::vector<std::string> present;
+    missing.reserve(sampleCount);
+    present.reserve(sampleCount);
+    size_t falsePositives = 0;
+    for (size_t i = 0; i < sampleCount; ++i) {
+        missing.push_back("bot_" + std::to_string(rng()) + "_" + std::to_string(i));
+        present.push_back("lg_user_" + std::to_string(existing(rng)));
+        if (db.userMayExist(missing.back())) ++falsePositives;
+    }
+    std::cout << "实测误判率: " << std::setprecision(3) << 100.0 * falsePositives / sampleCount << "% (目标 "
+        << rate * 100.0 << "%)" << std::endl;
+
+    std::cout << std::left << std::setw(8) << "线程" << std::right << std::setw(18) << "不存在(关闭)/秒"
+        << std::setw(18) << "不存在(开启)/秒" << std::setw(10) << "提升"
+        << std::setw(18) << "存在(关闭)/秒" << std::setw(18) << "存在(开启)/秒" << std::endl;
+    const size_t lookupsPerThread = 2000000;
+    for (int threads = 1; ; threads = std::min(threads * 2, config.threads)) {
+        db.setExistenceFilterRate(0.0);
+        double missOff = measureLookups(db, missing, threads, lookupsPerThread);
+        double hitOff = measureLookups(db, present, threads, lookupsPerThread);
+        db.setExistenceFilterRate(rate);
+        double missOn = measureLookups(db, missing, threads, lookupsPerThread);
+        double hitOn = measureLookups(db, present, threads, lookupsPerThread);
+
+        std::cout << std::left << std::setw(8) << threads << std::right << std::setprecision(0)
+            << std::setw(18) << missOff << std::setw(18) << missOn
+            << std::setw(10) << std::setprecision(2) << missOn / missOff
+            << std::setw(18) << std::setprecision(0) << hitOff << std::setw(18) << hitOn << std::endl;
+        if (threads == config.threads) break;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    LoadConfig config;
+    if (!parseArguments(argc, argv, config)) {
+        printUsage();
+        return 1;
+    }
+
+    if (config.analyticsLines > 0) {
+        return runAnalyticsBenchmark(config);
+    }
+    if (config.fuzzyQueries > 0) {
+        return runFuzzySearchBenchmark(config);
+    }
+    if (config.commitBenchSeconds > 0) {
+        return runCommitBenchmark(config);
+    }
+    if (config.partitionBenchSeconds > 0) {
+        return runPartitionBenchmark(config);
+    }
+    if (config.soakSessions > 0) {
+        return runSessionSoak(config);
+    }
+    if (config.importRows > 0) {
+        return runImportBenchmark(config);
+    }
+    if (config.filterBenchUsers > 0) {
+        return runFilterBenchmark(config);
+    }
+
+    std::srand(config.seed);
+    DatabaseManager db(config.dataDirectory, static_cast<size_t>(std::max(1, config.shards)));
+    if (config.archiveAgeSeconds >= 0) {
+        db.setOrderArchiveAge(std::chrono::seconds(config.archiveAgeSeconds));
+    }
+    if (config.queryCacheMb >= 0) {
+        db.setQueryCacheCapacity(static_cast<size_t>(config.queryCacheMb) * 1024 * 1024);
+    }
+    if (config.filterRate >= 0.0) {
+        db.setExistenceFilterRate(config.filterRate);
+    }
+    db.setMemoryLimits(makeMemoryLimits(config));
+    db.setOrderJournalOptions(makeJournalOptions(config));
+
+    std::cout << "准备数据: " << config.catalogSize << " 个商品, " << config.users << " 个用户..." << std::endl;
+
+    // 业务层的提示信息在压测期间全部屏蔽
+    std::cout.setstate(std::ios_base::badbit);
+    seedCatalog(db, config);
+
+    std::vector<std::unique_ptr<LoadWorker>> workers;
+    int usersPerThread = config.users / config.threads;
+    int remainder = config.users % config.threads;
+    int firstUser = 0;
+    for (int t = 0; t < config.threads; ++t) {
+        int count = usersPerThread + (t < remainder ? 1 : 0);
+        if (count == 0) continue;
+        workers.push_back(std::make_unique<LoadWorker>(db, config, firstUser, count, config.seed + t * 7919));
+        firstUser += count;
+    }
+    std::unique_ptr<PartitionRuntime> runtime;
+    if (config.partitionRuntime) {
+        size_t partitionCount = static_cast<size_t>(config.partitions > 0 ? config.partitions : config.threads);
+        runtime = std::make_unique<PartitionRuntime>(db, partitionCount, workers.size());
+        runtime->start(config.pinPartitions);
+        for (auto& worker : workers) {
+            worker->usePartitionRuntime(*runtime);
+        }
+    }
+    for (auto& worker : workers) {
+        worker->prepare();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::seconds(config.durationSeconds);
+
+    std::vector<std::thread> threads;
+    for (auto& worker : workers) {
+        LoadWorker* w = worker.get();
+        threads.emplace_back([w, start, deadline] { w->run(start, deadline); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    double elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (runtime) runtime->stop();
+    std::cout.clear();
+
+    printReport(config, workers, elapsedSeconds, db);
+    if (runtime) {
+        PartitionStats stats = runtime->getStats();
+        std::cout << "分区运行时: " << runtime->getPartitionCount() << " 个分区, 下单 " << stats.orders
+            << ", 失败 " << stats.failedCheckouts << ", 跨分区 " << stats.crossPartitionCheckouts
+            << ", 分区间消息 " << stats.remoteMessages << std::endl;
+    }
+
+    if (!config.metricsJsonPath.empty()) {
+        std::ofstream file(config.metricsJsonPath);
+        file << OperationMetrics::instance().toJson() << std::endl;
+        std::cout << "引擎操作延迟已导出到 " << config.metricsJsonPath << std::endl;
+    }
+    return 0;
+}
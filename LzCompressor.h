@@ -0,0 +1,146 @@
+﻿#ifndef LZCOMPRESSOR_H
+#define LZCOMPRESSOR_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief 轻量 LZ77 压缩（LZ4 风格的字节格式），用于归档数据
+ *
+ * 每个序列由一个标记字节开始：高 4 位为字面量长度，低 4 位为匹配长度减 4，
+ * 取值 15 时后续字节继续累加（每个 255 表示继续）。字面量之后是 2 字节小端偏移。
+ * 最后一个序列只有字面量。
+ */
+class LzCompressor {
+public:
+    static std::string compress(std::string_view input) {
+        std::string output;
+        output.reserve(input.size() / 2 + 16);
+
+        const size_t size = input.size();
+        const char* data = input.data();
+        std::vector<int32_t> table(HASH_SIZE, -1);
+
+        size_t anchor = 0;
+        size_t pos = 0;
+        while (size >= MIN_MATCH && pos + MIN_MATCH <= size) {
+            uint32_t sequence = read32(data + pos);
+            uint32_t slot = hash(sequence);
+            int32_t candidate = table[slot];
+            table[slot] = static_cast<int32_t>(pos);
+
+            if (candidate < 0 || pos - candidate > MAX_OFFSET || read32(data + candidate) != sequence) {
+                ++pos;
+                continue;
+            }
+
+            size_t matchLength = MIN_MATCH;
+            while (pos + matchLength < size && data[candidate + matchLength] == data[pos + matchLength]) {
+                ++matchLength;
+            }
+
+            writeSequence(output, data + anchor, pos - anchor, matchLength, pos - candidate);
+            pos += matchLength;
+            anchor = pos;
+        }
+
+        // 剩余部分全部作为字面量
+        writeSequence(output, data + anchor, size - anchor, 0, 0);
+        return output;
+    }
+
+    /**
+     * @brief 解压
+     * @param input 压缩数据
+     * @param expectedSize 原始长度（用于预分配与校验）
+     * @return 数据损坏时返回空串
+     */
+    static std::string decompress(std::string_view input, size_t expectedSize) {
+        std::string output;
+        output.reserve(expectedSize);
+
+        size_t pos = 0;
+        while (pos < input.size()) {
+            uint8_t token = static_cast<uint8_t>(input[pos++]);
+
+            size_t literalLength = token >> 4;
+            if (literalLength == 15 && !readLength(input, pos, literalLength)) return std::string();
+            if (pos + literalLength > input.size()) return std::string();
+            output.append(input.data() + pos, literalLength);
+            pos += literalLength;
+
+            if (pos >= input.size()) break;  // 最后一个序列
+
+            if (pos + 2 > input.size()) return std::string();
+            size_t offset = static_cast<uint8_t>(input[pos]) | (static_cast<uint8_t>(input[pos + 1]) << 8);
+            pos += 2;
+
+            size_t matchLength = token & 0x0F;
+            if (matchLength == 15 && !readLength(input, pos, matchLength)) return std::string();
+            matchLength += MIN_MATCH;
+
+            if (offset == 0 || offset > output.size()) return std::string();
+            size_t from = output.size() - offset;
+            for (size_t i = 0; i < matchLength; ++i) {
+                output.push_back(output[from + i]);  // 允许重叠复制
+            }
+        }
+
+        if (output.size() != expectedSize) return std::string();
+        return output;
+    }
+
+private:
+    static constexpr size_t MIN_MATCH = 4;
+    static constexpr size_t MAX_OFFSET = 65535;
+    static constexpr int HASH_BITS = 14;
+    static constexpr size_t HASH_SIZE = size_t(1) << HASH_BITS;
+
+    static uint32_t read32(const char* p) {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    static uint32_t hash(uint32_t sequence) {
+        return (sequence * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    static void writeLength(std::string& output, size_t length) {
+        while (length >= 255) {
+            output.push_back(static_cast<char>(255));
+            length -= 255;
+        }
+        output.push_back(static_cast<char>(length));
+    }
+
+    static bool readLength(std::string_view input, size_t& pos, size_t& length) {
+        uint8_t byte;
+        do {
+            if (pos >= input.size()) return false;
+            byte = static_cast<uint8_t>(input[pos++]);
+            length += byte;
+        } while (byte == 255);
+        return true;
+    }
+
+    static void writeSequence(std::string& output, const char* literals, size_t literalLength,
+        size_t matchLength, size_t offset) {
+        size_t matchCode = matchLength >= MIN_MATCH ? matchLength - MIN_MATCH : 0;
+        uint8_t token = static_cast<uint8_t>(((literalLength < 15 ? literalLength : 15) << 4) |
+            (matchCode < 15 ? matchCode : 15));
+        output.push_back(static_cast<char>(token));
+        if (literalLength >= 15) writeLength(output, literalLength - 15);
+        output.append(literals, literalLength);
+
+        if (matchLength == 0) return;
+        output.push_back(static_cast<char>(offset & 0xFF));
+        output.push_back(static_cast<char>((offset >> 8) & 0xFF));
+        if (matchCode >= 15) writeLength(output, matchCode - 15);
+    }
+};
+
+#endif // LZCOMPRESSOR_H
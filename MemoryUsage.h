@@ -0,0 +1,127 @@
+﻿#ifndef MEMORYUSAGE_H
+#define MEMORYUSAGE_H
+
+#include <cstddef>
+#include <deque>
+#include <list>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 一张表或一个索引的内存占用（估算值）
+ */
+struct MemoryUsage {
+    size_t bytes = 0;
+    size_t items = 0;  ///< 记录数或索引条目数
+
+    MemoryUsage& operator+=(const MemoryUsage& other) {
+        bytes += other.bytes;
+        items += other.items;
+        return *this;
+    }
+};
+
+/**
+ * @brief 内存估算 - 按容器容量（含未使用的预留空间）和字符串的堆缓冲区计算
+ *
+ * 不经过分配器统计，查询时按当前结构计算，因此不改变任何容器的类型。
+ * 节点开销按 MSVC 标准库取值（哈希表每个桶两个指针、每个节点前后两个指针，红黑树节点三个指针加颜色），
+ * 不含 malloc 自身的块头和对齐填充，实际占用略高于估算值。
+ */
+struct MemoryAccounting {
+    static constexpr size_t POINTER = sizeof(void*);
+    static constexpr size_t HASH_NODE_OVERHEAD = 2 * POINTER;
+    static constexpr size_t HASH_BUCKET_BYTES = 2 * POINTER;
+    static constexpr size_t TREE_NODE_OVERHEAD = 4 * POINTER;
+    static constexpr size_t LIST_NODE_OVERHEAD = 2 * POINTER;
+
+    // 字符串超出短字符串缓冲区时才占用堆内存
+    static size_t ofString(const std::string& text) {
+        static const size_t inlineCapacity = std::string().capacity();
+        return text.capacity() > inlineCapacity ? text.capacity() + 1 : 0;
+    }
+
+    // 只计元素数组本身，元素内部的堆内存由调用方另加
+    template <typename T, typename Allocator>
+    static size_t ofVector(const std::vector<T, Allocator>& values) {
+        return values.capacity() * sizeof(T);
+    }
+
+    // 按 MSVC 的块大小（每块 16 字节，元素更大时每块一个元素）估算，另加块指针表
+    template <typename T>
+    static size_t ofDeque(const std::deque<T>& values) {
+        size_t perBlock = sizeof(T) < 16 ? 16 / sizeof(T) : 1;
+        size_t blocks = (values.size() + perBlock - 1) / perBlock;
+        return blocks * perBlock * sizeof(T) + (blocks + 8) * POINTER;
+    }
+
+    // 桶数组加节点，键和值内部的堆内存由调用方另加
+    template <typename HashTable>
+    static size_t ofHashTable(const HashTable& table) {
+        return table.bucket_count() * HASH_BUCKET_BYTES +
+            table.size() * (sizeof(typename HashTable::value_type) + HASH_NODE_OVERHEAD);
+    }
+
+    template <typename Tree>
+    static size_t ofTree(const Tree& tree) {
+        return tree.size() * (sizeof(typename Tree::value_type) + TREE_NODE_OVERHEAD);
+    }
+
+    template <typename T>
+    static size_t ofList(const std::list<T>& values) {
+        return values.size() * (sizeof(T) + LIST_NODE_OVERHEAD);
+    }
+};
+
+/**
+ * @brief 数据库各表和各索引的内存占用
+ */
+struct MemoryReport {
+    struct Entry {
+        const char* name;
+        bool isIndex;      ///< 索引、缓存等可由表重建的结构
+        MemoryUsage usage;
+    };
+
+    std::vector<Entry> entries;
+
+    size_t getTotalBytes() const {
+        size_t total = 0;
+        for (const auto& entry : entries) total += entry.usage.bytes;
+        return total;
+    }
+
+    size_t getIndexBytes() const {
+        size_t total = 0;
+        for (const auto& entry : entries) {
+            if (entry.isIndex) total += entry.usage.bytes;
+        }
+        return total;
+    }
+};
+
+/**
+ * @brief 内存软上限（字节），0 表示不限制
+ *
+ * 超过上限时先把最早下单的已结束订单提前归档，仍超过总上限时再淘汰查询缓存；
+ * 用户、商品、投诉和未结束的订单不会被移出内存，只能报告超限。
+ */
+struct MemoryLimits {
+    size_t hotOrderBytes = 0;  ///< 热订单对象（OrderStore::getLiveBytes 口径）
+    size_t totalBytes = 0;     ///< MemoryReport::getTotalBytes 口径
+};
+
+/**
+ * @brief 内存上限检查的累计结果
+ */
+struct MemoryPressureStats {
+    uint64_t checks = 0;            ///< 总上限检查次数（每次生成一份完整报告）
+    uint64_t overLimitEvents = 0;   ///< 检查时超过任一上限的次数
+    uint64_t ordersArchived = 0;    ///< 因内存压力提前归档的订单数
+    uint64_t cacheBytesTrimmed = 0; ///< 因内存压力淘汰的查询缓存字节数
+    size_t lastTotalBytes = 0;      ///< 最近一次完整报告的总字节数
+    bool overLimit = false;         ///< 最近一次处理后是否仍超过上限
+};
+
+#endif // MEMORYUSAGE_H
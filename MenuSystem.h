@@ -5,8 +5,12 @@
 #include <iostream>
 #include <string>
 #include <vector>
-#include <limits>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
 #include "ShopSystem.h"
+#include "InputSource.h"
+#include "CustomerSession.h"
 
 /**
  * @brief 菜单系统类 - 用户界面交互
@@ -14,9 +18,11 @@
 class MenuSystem {
 private:
     ShopSystem shopSystem;
+    ConsoleInputSource console;
+    CustomerSession customerFlows;  // 登录注册和用户购物流程，与会话压测共用同一套协程实现
 
 public:
-    MenuSystem() {}
+    MenuSystem() : customerFlows(shopSystem, console, std::cout, true) {}
 
     void run() {
         while (true) {
@@ -47,10 +53,10 @@ private:
         int choice = getIntInput("");
         switch (choice) {
         case 1:
-            showLoginMenu();
+            runFlow(customerFlows.showLoginMenu());
             break;
         case 2:
-            showRegisterMenu();
+            runFlow(customerFlows.showRegisterMenu());
             break;
         case 3:
             std::cout << "感谢使用商城管理系统，再见！" << std::endl;
@@ -61,61 +67,6 @@ private:
         }
     }
 
-    void showLoginMenu() {
-        clearScreen();
-        printHeader("用户登录");
-
-        int attempts = 0;
-        const int maxAttempts = 3;
-
-        while (attempts < maxAttempts) {
-            std::string username = getStringInput("用户名: ");
-            std::string password = getStringInput("密码: ");
-
-            if (shopSystem.login(username, password)) {
-                return;
-            }
-
-            attempts++;
-            if (attempts < maxAttempts) {
-                std::cout << "登录失败，还有 " << (maxAttempts - attempts) << " 次尝试机会" << std::endl;
-            }
-            else {
-                std::cout << "登录失败次数过多，返回主菜单" << std::endl;
-                pause();
-            }
-        }
-    }
-
-    void showRegisterMenu() {
-        clearScreen();
-        printHeader("用户注册");
-
-        std::string username = getStringInput("用户名: ");
-        std::string password = getStringInput("密码: ");
-        std::string confirmPassword = getStringInput("确认密码: ");
-
-        if (password != confirmPassword) {
-            std::cout << "两次输入的密码不一致！" << std::endl;
-            pause();
-            return;
-        }
-
-        std::string email = getStringInput("邮箱(可选): ");
-        std::string phone = getStringInput("手机号(必填): ");  // 改为必填
-
-        if (shopSystem.registerUser(username, password, "customer", email, phone)) {
-            std::cout << "注册成功！是否立即登录？(y/n): ";
-            std::string choice = getStringInput("");
-            if (choice == "y" || choice == "Y") {
-                if (shopSystem.login(username, password)) {
-                    std::cout << "自动登录成功！" << std::endl;
-                }
-            }
-        }
-        pause();
-    }
-
     // 客户菜单
     void showCustomerMenu() {
         clearScreen();
@@ -127,25 +78,26 @@ private:
         std::cout << "5. 我的订单" << std::endl;
         std::cout << "6. 我的商品管理" << std::endl;
         std::cout << "7. 投诉管理" << std::endl;  // 新增
-        std::cout << "8. 退出登录" << std::endl;
+        std::cout << "8. 热销排行" << std::endl;
+        std::cout << "9. 退出登录" << std::endl;
         std::cout << "请选择操作: ";
 
         int choice = getIntInput("");
         switch (choice) {
         case 1:
-            browseProducts();
+            runFlow(customerFlows.browseProducts());
             break;
         case 2:
-            searchProducts();
+            runFlow(customerFlows.searchProducts());
             break;
         case 3:
-            viewProductDetails();
+            runFlow(customerFlows.viewProductDetails());
             break;
         case 4:
-            showCartMenu();
+            runFlow(customerFlows.showCartMenu());
             break;
         case 5:
-            showOrderMenu();
+            runFlow(customerFlows.showOrderMenu());
             break;
         case 6:
             showMyProductManagementMenu();
@@ -154,6 +106,9 @@ private:
             showComplaintMenu();  // 新增
             break;
         case 8:
+            runFlow(customerFlows.showBestSellers());
+            break;
+        case 9:
             shopSystem.logout();
             pause();
             break;
@@ -243,6 +198,16 @@ private:
         clearScreen();
         printHeader("我的商品管理");
 
+        SellerStats stats = shopSystem.getMySellerStats();
+        auto myProducts = shopSystem.getMyProducts();
+        size_t activeCount = std::count_if(myProducts.begin(), myProducts.end(),
+            [](const Product& product) { return product.getIsActive(); });
+        std::cout << "商品: " << myProducts.size() << " (在售 " << activeCount << ")"
+            << "  已售: " << stats.unitsSold << " 件"
+            << "  销售额: Y" << std::fixed << std::setprecision(2) << stats.revenue << std::endl;
+        std::cout << "进行中订单: " << stats.openOrders << "  收到投诉: " << stats.complaintCount << std::endl;
+        std::cout << "------------------------------------------" << std::endl;
+
         std::cout << "1. 上架新商品" << std::endl;
         std::cout << "2. 查看我的商品" << std::endl;
         std::cout << "3. 下架商品" << std::endl;
@@ -278,7 +243,7 @@ private:
         std::string id = getStringInput("商品ID: ");
         std::string name = getStringInput("商品名称: ");
         std::string category = getStringInput("商品分类: ");
-        double price = getDoubleInput("价格: ");
+        Money price = getMoneyInput("价格: ");
         int stock = getIntInput("库存数量: ");
         std::string description = getStringInput("商品描述: ");
 
@@ -363,7 +328,8 @@ private:
         std::cout << "3. 订单管理" << std::endl;
         std::cout << "4. 投诉处理" << std::endl;  // 新增
         std::cout << "5. 数据统计" << std::endl;
-        std::cout << "6. 退出登录" << std::endl;
+        std::cout << "6. 性能指标" << std::endl;
+        std::cout << "7. 退出登录" << std::endl;
         std::cout << "请选择操作: ";
 
         int choice = getIntInput("");
@@ -384,6 +350,9 @@ private:
             showStatisticsMenu();
             break;
         case 6:
+            showMetricsMenu();
+            break;
+        case 7:
             shopSystem.logout();
             pause();
             break;
@@ -399,7 +368,8 @@ private:
         std::cout << "1. 查看所有投诉" << std::endl;
         std::cout << "2. 查看待处理投诉" << std::endl;
         std::cout << "3. 处理投诉" << std::endl;
-        std::cout << "4. 返回" << std::endl;
+        std::cout << "4. 领取下一条投诉" << std::endl;
+        std::cout << "5. 返回" << std::endl;
         std::cout << "请选择操作: ";
 
         int choice = getIntInput("");
@@ -414,6 +384,9 @@ private:
             processComplaint();
             break;
         case 4:
+            claimNextComplaint();
+            break;
+        case 5:
             return;
         default:
             std::cout << "无效选择！" << std::endl;
@@ -473,9 +446,13 @@ private:
         }
 
         std::string complaintId = getStringInput("\n请输入要处理的投诉ID: ");
+        bool wholeCluster = askProcessCluster(complaintId);
         std::string response = getStringInput("请输入回复内容: ");
 
-        if (shopSystem.processComplaint(complaintId, response)) {
+        if (wholeCluster) {
+            shopSystem.processComplaintCluster(complaintId, response);
+        }
+        else if (shopSystem.processComplaint(complaintId, response)) {
             std::cout << "投诉处理成功！" << std::endl;
         }
         else {
@@ -483,159 +460,42 @@ private:
         }
         pause();
     }
-    // 商品浏览功能
-    void browseProducts() {
-        clearScreen();
-        printHeader("浏览商品");
-
-        auto products = shopSystem.browseProducts();
-        if (products.empty()) {
-            std::cout << "暂无商品！" << std::endl;
-        }
-        else {
-            for (const auto& product : products) {
-                product.displayInfo();
-            }
-        }
-        pause();
-    }
-
-    void searchProducts() {
-        clearScreen();
-        printHeader("搜索商品");
 
-        std::string keyword = getStringInput("请输入搜索关键词: ");
-        auto products = shopSystem.searchProducts(keyword);
+    // 有相似的未处理投诉时列出，并询问是否用同一回复一并处理
+    bool askProcessCluster(const std::string& complaintId) {
+        auto similar = shopSystem.getSimilarComplaints(complaintId);
+        if (similar.empty()) return false;
 
-        if (products.empty()) {
-            std::cout << "未找到相关商品！" << std::endl;
-        }
-        else {
-            std::cout << "找到 " << products.size() << " 个相关商品:" << std::endl;
-            for (const auto& product : products) {
-                product.displayInfo();
-            }
+        std::cout << "\n发现 " << similar.size() << " 条相似投诉:" << std::endl;
+        for (const auto& complaint : similar) {
+            complaint.displayBriefInfo();
         }
-        pause();
+        std::cout << "是否用同一回复一并处理？(y/n): ";
+        std::string choice = getStringInput("");
+        return choice == "y" || choice == "Y";
     }
-
-    void viewProductDetails() {
+    // 按优先级领取一条投诉，回复内容为空时放回队列
+    void claimNextComplaint() {
         clearScreen();
-        printHeader("商品详情");
-
-        std::string productId = getStringInput("请输入商品ID: ");
-        auto product = shopSystem.getProduct(productId);
+        printHeader("领取投诉");
 
-        if (product) {
-            product->displayInfo();
-
-            std::cout << "\n1. 加入购物车" << std::endl;
-            std::cout << "2. 返回" << std::endl;
-            std::cout << "请选择操作: ";
-
-            int choice = getIntInput("");
-            if (choice == 1) {
-                int quantity = getIntInput("请输入数量: ");
-                shopSystem.addToCart(productId, quantity);
-            }
-        }
-        else {
-            std::cout << "商品不存在！" << std::endl;
-        }
-        pause();
-    }
-
-    // 购物车菜单
-    void showCartMenu() {
-        clearScreen();
-        printHeader("购物车管理");
-
-        shopSystem.displayCart();
-
-        if (!shopSystem.getCartItems().empty()) {
-            std::cout << "\n1. 继续购物" << std::endl;
-            std::cout << "2. 生成订单" << std::endl;
-            std::cout << "3. 清空购物车" << std::endl;
-            std::cout << "4. 返回" << std::endl;
-            std::cout << "请选择操作: ";
-
-            int choice = getIntInput("");
-            switch (choice) {
-            case 1:
-                // 继续购物，直接返回
-                break;
-            case 2:
-                createOrder();
-                break;
-            case 3:
-                // 清空购物车功能需要实现
-                std::cout << "清空购物车功能待实现" << std::endl;
-                pause();
-                break;
-            case 4:
-                return;
-            default:
-                std::cout << "无效选择！" << std::endl;
-                pause();
-            }
-        }
-        else {
+        Complaint complaint;
+        if (!shopSystem.claimNextComplaint(complaint)) {
             pause();
+            return;
         }
-    }
 
-    void createOrder() {
-        clearScreen();
-        printHeader("生成订单");
-
-        std::string address = getStringInput("请输入配送地址: ");
-        std::string payment = getStringInput("请输入支付方式: ");
-
-        Order order = shopSystem.createOrder(address, payment);
-        if (order.getOrderId() != "") {
-            std::cout << "\n订单详情:" << std::endl;
-            order.displayOrderDetails();
+        complaint.displayInfo();
+        bool wholeCluster = askProcessCluster(complaint.getComplaintId());
+        std::string response = getStringInput("请输入回复内容（直接回车放回队列）: ");
+        if (response.empty()) {
+            shopSystem.releaseComplaint(complaint.getComplaintId());
         }
-        pause();
-    }
-
-    // 订单菜单
-    void showOrderMenu() {
-        clearScreen();
-        printHeader("我的订单");
-
-        auto orders = shopSystem.getUserOrders();
-        if (orders.empty()) {
-            std::cout << "您还没有订单！" << std::endl;
+        else if (wholeCluster) {
+            shopSystem.processComplaintCluster(complaint.getComplaintId(), response);
         }
-        else {
-            for (const auto& order : orders) {
-                order.displayBriefInfo();
-            }
-
-            std::cout << "\n1. 查看订单详情" << std::endl;
-            std::cout << "2. 取消订单" << std::endl;
-            std::cout << "3. 返回" << std::endl;
-            std::cout << "请选择操作: ";
-
-            int choice = getIntInput("");
-            switch (choice) {
-            case 1: {
-                std::string orderId = getStringInput("请输入订单ID: ");
-                // 查看订单详情功能需要实现
-                std::cout << "查看订单详情功能待实现" << std::endl;
-                break;
-            }
-            case 2: {
-                std::string orderId = getStringInput("请输入要取消的订单ID: ");
-                shopSystem.cancelOrder(orderId);
-                break;
-            }
-            case 3:
-                return;
-            default:
-                std::cout << "无效选择！" << std::endl;
-            }
+        else if (shopSystem.processComplaint(complaint.getComplaintId(), response)) {
+            std::cout << "投诉处理成功！" << std::endl;
         }
         pause();
     }
@@ -734,7 +594,7 @@ private:
         std::string id = getStringInput("商品ID: ");
         std::string name = getStringInput("商品名称: ");
         std::string category = getStringInput("商品分类: ");
-        double price = getDoubleInput("价格: ");
+        Money price = getMoneyInput("价格: ");
         int stock = getIntInput("库存数量: ");
         std::string description = getStringInput("商品描述: ");
 
@@ -747,8 +607,34 @@ private:
         clearScreen();
         printHeader("用户管理");
 
-        // 这里需要显示所有用户
-        std::cout << "用户管理功能待实现" << std::endl;
+        std::cout << "1. 从文件批量导入用户" << std::endl;
+        std::cout << "2. 返回" << std::endl;
+        std::cout << "请选择操作: ";
+
+        int choice = getIntInput("");
+        if (choice != 1) return;
+
+        std::cout << "文件每行一个用户: 用户名|密码|类型(customer/admin)|邮箱|手机号" << std::endl;
+        std::string path = getStringInput("导入文件路径: ");
+        std::vector<User> users;
+        if (!UserImporter::readFile(path, users)) {
+            std::cout << "无法打开文件！" << std::endl;
+            pause();
+            return;
+        }
+
+        UserImportReport report = shopSystem.importUsers(users);
+        std::cout << "共 " << report.rows << " 行, 导入 " << report.imported << " 个用户, 拒绝 "
+            << report.rejected.size() << " 行, 耗时 " << std::fixed << std::setprecision(1) << report.elapsedMs
+            << " ms (" << report.threadsUsed << " 线程)" << std::endl;
+        const size_t shown = 20;
+        for (size_t i = 0; i < report.rejected.size() && i < shown; ++i) {
+            const auto& rejection = report.rejected[i];
+            std::cout << "  第 " << rejection.row + 1 << " 行 " << rejection.username << ": " << rejection.reason << std::endl;
+        }
+        if (report.rejected.size() > shown) {
+            std::cout << "  ... 其余 " << report.rejected.size() - shown << " 行未列出" << std::endl;
+        }
         pause();
     }
 
@@ -756,8 +642,22 @@ private:
         clearScreen();
         printHeader("订单管理");
 
-        // 这里需要显示所有订单
-        std::cout << "订单管理功能待实现" << std::endl;
+        shopSystem.displayOrderArchiveInfo();
+
+        std::cout << "\n1. 立即归档已结束的订单" << std::endl;
+        std::cout << "2. 返回" << std::endl;
+        std::cout << "请选择操作: ";
+
+        int choice = getIntInput("");
+        switch (choice) {
+        case 1:
+            std::cout << "已归档 " << shopSystem.archiveFinishedOrders() << " 个订单" << std::endl;
+            break;
+        case 2:
+            return;
+        default:
+            std::cout << "无效选择！" << std::endl;
+        }
         pause();
     }
 
@@ -765,16 +665,123 @@ private:
         clearScreen();
         printHeader("数据统计");
 
-        // 这里需要显示统计信息
-        std::cout << "数据统计功能待实现" << std::endl;
+        shopSystem.displayStatistics();
+
+        std::cout << "\n1. 销售分析" << std::endl;
+        std::cout << "2. 内存占用" << std::endl;
+        std::cout << "3. 返回" << std::endl;
+        std::cout << "请选择操作: ";
+
+        int choice = getIntInput("");
+        switch (choice) {
+        case 1:
+            showSalesReport();
+            break;
+        case 2:
+            shopSystem.displayMemoryUsage();
+            break;
+        case 3:
+            return;
+        default:
+            std::cout << "无效选择！" << std::endl;
+        }
         pause();
     }
 
+    void showSalesReport() {
+        SalesReport report = shopSystem.getSalesReport();
+        if (report.ordersScanned == 0) {
+            std::cout << "暂无已发货或已完成的订单！" << std::endl;
+            return;
+        }
+
+        std::cout << "\n统计订单 " << report.ordersScanned << " 个, 订单项 " << report.linesScanned
+            << " 行, 售出 " << report.totalUnits << " 件, 销售额 Y"
+            << std::fixed << std::setprecision(2) << report.totalRevenue << std::endl;
+        std::cout << "耗时 " << report.elapsedMs << " ms (" << report.threadsUsed << " 线程)" << std::endl;
+
+        printSalesGroups("按卖家", report.bySeller, 10);
+        printSalesGroups("按类别", report.byCategory, 10);
+        printSalesGroups("按商品", report.byProduct, 10);
+        printSalesGroups("按日期", report.byDay, 31, true);
+    }
+
+    // 分组较多时只显示前 limit 项，showLast 为 true 时显示最后 limit 项（如最近的日期）
+    void printSalesGroups(const std::string& title, const std::vector<SalesGroup>& groups, size_t limit,
+        bool showLast = false) {
+        std::cout << "\n--- " << title << " (共 " << groups.size() << " 组) ---" << std::endl;
+        size_t begin = 0;
+        size_t end = std::min(groups.size(), limit);
+        if (showLast && groups.size() > limit) {
+            begin = groups.size() - limit;
+            end = groups.size();
+        }
+        for (size_t i = begin; i < end; ++i) {
+            std::cout << std::left << std::setw(20) << groups[i].key << std::right
+                << " Y" << std::setw(14) << std::fixed << std::setprecision(2) << groups[i].revenue
+                << std::setw(10) << groups[i].units << " 件" << std::endl;
+        }
+    }
+
+    void showMetricsMenu() {
+        clearScreen();
+        printHeader("性能指标");
+
+        auto metrics = shopSystem.getOperationMetrics();
+        std::cout << std::left << std::setw(24) << "操作"
+            << std::right << std::setw(10) << "次数"
+            << std::setw(12) << "p50(us)" << std::setw(12) << "p90(us)"
+            << std::setw(12) << "p99(us)" << std::setw(12) << "max(us)" << std::endl;
+        for (const auto& stats : metrics) {
+            if (stats.count == 0) continue;
+            std::cout << std::left << std::setw(24) << stats.name
+                << std::right << std::setw(10) << stats.count
+                << std::fixed << std::setprecision(2)
+                << std::setw(12) << stats.p50Us << std::setw(12) << stats.p90Us
+                << std::setw(12) << stats.p99Us << std::setw(12) << stats.maxUs << std::endl;
+        }
+        std::cout << std::left << "单次记录开销: " << std::fixed << std::setprecision(1)
+            << OperationMetrics::measureRecordingOverhead() << " ns" << std::endl;
+
+        std::cout << "\n1. 导出为JSON" << std::endl;
+        std::cout << "2. 返回" << std::endl;
+        std::cout << "请选择操作: ";
+
+        int choice = getIntInput("");
+        if (choice == 1) {
+            std::string json = shopSystem.getOperationMetricsJson();
+            std::string path = getStringInput("导出文件名(默认 metrics.json): ");
+            if (path.empty()) path = "metrics.json";
+
+            std::ofstream file(path);
+            if (file) {
+                file << json << std::endl;
+                std::cout << json << std::endl;
+                std::cout << "已导出到 " << path << std::endl;
+            }
+            else {
+                std::cout << "无法写入文件 " << path << std::endl;
+            }
+            pause();
+        }
+    }
+
     // 辅助方法
+    // 控制台输入从不挂起，协程流程在此同步执行完；输入结束（EOF）时退出程序
+    void runFlow(SessionTask<> flow) {
+        flow.runToCompletion();
+        if (customerFlows.isDisconnected()) exit(0);
+    }
+
+    std::string readLine() {
+        std::string line;
+        if (!console.tryReadLine(line)) exit(0);
+        return line;
+    }
+
     void pause() {
         std::cout << "按回车键继续...";
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-        std::cin.get();
+        readLine();
     }
 
     void clearScreen() {
@@ -788,32 +795,25 @@ private:
     int getIntInput(const std::string& prompt) {
         int value;
         std::cout << prompt;
-        while (!(std::cin >> value)) {
-            std::cin.clear();
-            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        while (!InputSource::parseInt(readLine(), value)) {
             std::cout << "输入无效，请输入数字: ";
         }
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
         return value;
     }
 
-    double getDoubleInput(const std::string& prompt) {
-        double value;
+    // 按十进制解析到分，不经过浮点
+    Money getMoneyInput(const std::string& prompt) {
+        Money value;
         std::cout << prompt;
-        while (!(std::cin >> value)) {
-            std::cin.clear();
-            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        while (!Money::parse(readLine(), value)) {
             std::cout << "输入无效，请输入数字: ";
         }
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
         return value;
     }
 
     std::string getStringInput(const std::string& prompt) {
-        std::string value;
         std::cout << prompt;
-        std::getline(std::cin, value);
-        return value;
+        return readLine();
     }
 
     void printHeader(const std::string& title) {
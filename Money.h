@@ -0,0 +1,165 @@
+﻿#ifndef MONEY_H
+#define MONEY_H
+
+#include <cmath>
+#include <compare>
+#include <cstdint>
+#include <cstdlib>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief 金额 - 以 64 位整数"分"定点存储
+ *
+ * 加减和乘以数量都是整数运算，任意顺序、任意分组求和结果都相同，多线程分块汇总不产生舍入误差。
+ * 文本形式为 "-12.05" 这样固定两位小数的元，读取时也接受旧数据中的浮点写法（按四舍五入到分）。
+ */
+class Money {
+public:
+    constexpr Money() : cents(0) {}
+
+    static constexpr Money fromCents(int64_t cents) { return Money(cents); }
+
+    // 浮点元数四舍五入到分，只用于界面输入等边界
+    static Money fromYuan(double yuan) { return Money(std::llround(yuan * 100.0)); }
+
+    constexpr int64_t getCents() const { return cents; }
+    double toYuan() const { return static_cast<double>(cents) / 100.0; }
+
+    constexpr Money operator+(Money other) const { return Money(cents + other.cents); }
+    constexpr Money operator-(Money other) const { return Money(cents - other.cents); }
+    constexpr Money operator-() const { return Money(-cents); }
+    constexpr Money operator*(long long quantity) const { return Money(cents * quantity); }
+    friend constexpr Money operator*(long long quantity, Money money) { return money * quantity; }
+    Money& operator+=(Money other) { cents += other.cents; return *this; }
+    Money& operator-=(Money other) { cents -= other.cents; return *this; }
+
+    constexpr auto operator<=>(const Money&) const = default;
+
+    // ==================== 文本转换 ====================
+    std::string toString() const {
+        uint64_t magnitude = cents < 0 ? 0 - static_cast<uint64_t>(cents) : static_cast<uint64_t>(cents);
+        std::string text = std::to_string(magnitude / 100);
+        unsigned fraction = static_cast<unsigned>(magnitude % 100);
+        text.push_back('.');
+        text.push_back(static_cast<char>('0' + fraction / 10));
+        text.push_back(static_cast<char>('0' + fraction % 10));
+        if (cents < 0) text.insert(text.begin(), '-');
+        return text;
+    }
+
+    /**
+     * @brief 解析十进制元数，小数第三位起四舍五入；带指数的旧写法按浮点解析
+     *
+     * 除首尾空白外必须整串都是数字，"12abc"、"1.2.3" 这类输入返回 false；超出 int64 分的金额同样拒绝。
+     */
+    static bool parse(std::string_view text, Money& result) {
+        auto blank = [](char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; };
+        while (!text.empty() && blank(text.front())) text.remove_prefix(1);
+        while (!text.empty() && blank(text.back())) text.remove_suffix(1);
+        if (text.find_first_of("eE") != std::string_view::npos) {
+            std::string copy(text);
+            char* end = nullptr;
+            double value = std::strtod(copy.c_str(), &end);
+            if (end != copy.c_str() + copy.size() || !std::isfinite(value)) return false;
+            if (!(std::fabs(value) < static_cast<double>(MAX_WHOLE))) return false;
+            result = fromYuan(value);
+            return true;
+        }
+
+        bool negative = !text.empty() && text.front() == '-';
+        if (!text.empty() && (text.front() == '-' || text.front() == '+')) text.remove_prefix(1);
+
+        int64_t whole = 0;
+        size_t i = 0;
+        bool digits = false;
+        for (; i < text.size() && text[i] >= '0' && text[i] <= '9'; ++i) {
+            int digit = text[i] - '0';
+            if (whole > (MAX_WHOLE - digit) / 10) return false;
+            whole = whole * 10 + digit;
+            digits = true;
+        }
+        int64_t fraction = 0;
+        if (i < text.size() && text[i] == '.') {
+            ++i;
+            int scale = 0;
+            for (; i < text.size() && text[i] >= '0' && text[i] <= '9'; ++i, ++scale) {
+                digits = true;
+                if (scale < 2) fraction = fraction * 10 + (text[i] - '0');
+                else if (scale == 2 && text[i] >= '5') ++fraction;  // 第三位小数四舍五入
+            }
+            if (scale == 1) fraction *= 10;
+        }
+        if (!digits || i != text.size()) return false;
+
+        int64_t value = whole * 100 + fraction;
+        result = Money(negative ? -value : value);
+        return true;
+    }
+
+    // 与 std::stod 一致，无法解析时抛出 std::invalid_argument
+    static Money fromString(std::string_view text) {
+        Money result;
+        if (!parse(text, result)) throw std::invalid_argument("Money::fromString");
+        return result;
+    }
+
+    // 输出固定两位小数，遵守 setw 设置的宽度
+    friend std::ostream& operator<<(std::ostream& os, Money money) {
+        return os << money.toString();
+    }
+
+    // ==================== 批量求和 ====================
+    /**
+     * @brief 对连续存放的金额（分）求和，x86 上使用 SSE2/AVX2 整数加法，每次处理 4 或 8 个
+     *
+     * 整数加法满足结合律，向量化的分组顺序不影响结果，与逐个相加完全一致。
+     */
+    static Money sum(std::span<const int64_t> values) {
+        const int64_t* data = values.data();
+        size_t count = values.size();
+        size_t i = 0;
+        int64_t total = 0;
+        #if defined(__AVX2__)
+        __m256i first = _mm256_setzero_si256();
+        __m256i second = _mm256_setzero_si256();
+        for (; i + 8 <= count; i += 8) {
+            first = _mm256_add_epi64(first, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)));
+            second = _mm256_add_epi64(second, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 4)));
+        }
+        alignas(32) int64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), _mm256_add_epi64(first, second));
+        total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        #elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        __m128i first = _mm_setzero_si128();
+        __m128i second = _mm_setzero_si128();
+        for (; i + 4 <= count; i += 4) {
+            first = _mm_add_epi64(first, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+            second = _mm_add_epi64(second, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 2)));
+        }
+        alignas(16) int64_t lanes[2];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), _mm_add_epi64(first, second));
+        total = lanes[0] + lanes[1];
+        #endif
+        for (; i < count; ++i) {
+            total += data[i];
+        }
+        return Money(total);
+    }
+
+private:
+    // 整数元部分的上限，加上两位小数及四舍五入进位后仍不超出 int64 分
+    static constexpr int64_t MAX_WHOLE = (INT64_MAX - 100) / 100;
+
+    int64_t cents;
+
+    explicit constexpr Money(int64_t cents) : cents(cents) {}
+};
+
+#endif // MONEY_H
@@ -0,0 +1,399 @@
+﻿#ifndef OPERATIONMETRICS_H
+#define OPERATIONMETRICS_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define SHOP_METRICS_USE_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define SHOP_METRICS_USE_TSC 1
+#endif
+
+/**
+ * @brief ShopSystem 对外操作的编号，用于延迟统计
+ */
+enum class ShopOperation : int {
+    RegisterUser,
+    Login,
+    Logout,
+    Authenticate,
+    ResumeSession,
+    AddProduct,
+    DeactivateMyProduct,
+    ActivateMyProduct,
+    GetMyProducts,
+    GetSellerStats,
+    ActivateProduct,
+    DeactivateProduct,
+    BrowseProducts,
+    SearchProducts,
+    FuzzySearchProducts,
+    RankedSearchProducts,
+    GetProduct,
+    GetAllProductsForAdmin,
+    GetActiveProducts,
+    GetInactiveProducts,
+    GetBestSellers,
+    AddComplaint,
+    GetMyComplaints,
+    GetAllComplaints,
+    GetPendingComplaints,
+    ProcessComplaint,
+    ClaimComplaint,
+    ReleaseComplaint,
+    GetSimilarComplaints,
+    ProcessComplaintCluster,
+    AddToCart,
+    UpdateCartQuantity,
+    RemoveFromCart,
+    ClearCart,
+    GetCartTotal,
+    DisplayCart,
+    CreateOrder,
+    GetUserOrders,
+    GetOrderDetails,
+    GetArchivedOrders,
+    CancelOrder,
+    ArchiveOrders,
+    DisplayStatistics,
+    ComputeSalesReport,
+    ImportUsers,
+    DisplayMemoryUsage,
+    GetBestSellerWindowDays,
+    DisplayOrderArchiveInfo,
+    HasCartItems,
+    Count
+};
+
+inline const char* getOperationName(ShopOperation operation) {
+    static const char* const names[] = {
+        "registerUser", "login", "logout", "authenticate", "resumeSession",
+        "addProduct", "deactivateMyProduct", "activateMyProduct", "getMyProducts", "getSellerStats",
+        "activateProduct", "deactivateProduct", "browseProducts", "searchProducts", "fuzzySearchProducts",
+        "rankedSearchProducts",
+        "getProduct", "getAllProductsForAdmin", "getActiveProducts", "getInactiveProducts",
+        "getBestSellers",
+        "addComplaint", "getMyComplaints", "getAllComplaints", "getPendingComplaints",
+        "processComplaint", "claimComplaint", "releaseComplaint",
+        "getSimilarComplaints", "processComplaintCluster", "addToCart", "updateCartQuantity", "removeFromCart", "clearCart",
+        "getCartTotal", "displayCart", "createOrder",
+        "getUserOrders", "getOrderDetails", "getArchivedOrders", "cancelOrder",
+        "archiveOrders", "displayStatistics", "computeSalesReport", "importUsers", "displayMemoryUsage",
+        "getBestSellerWindowDays", "displayOrderArchiveInfo", "hasCartItems"
+    };
+    static_assert(sizeof(names) / sizeof(names[0]) == static_cast<size_t>(ShopOperation::Count),
+        "操作名称表与 ShopOperation 不一致");
+    return names[static_cast<int>(operation)];
+}
+
+/**
+ * @brief 计时时钟 - x86 上直接读 TSC，读取统计时再换算为纳秒
+ */
+class MetricsClock {
+public:
+    static uint64_t now() {
+#ifdef SHOP_METRICS_USE_TSC
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    /**
+     * @brief 每个时钟周期对应的纳秒数，用进程启动以来的 TSC 与 steady_clock 增量校准
+     */
+    static double nanosPerTick() {
+#ifdef SHOP_METRICS_USE_TSC
+        const Anchor& start = anchor();
+        auto elapsed = std::chrono::steady_clock::now() - start.time;
+        if (elapsed < std::chrono::milliseconds(20)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20) - elapsed);
+        }
+        uint64_t ticks = __rdtsc();
+        double nanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start.time).count();
+        return ticks > start.ticks ? nanos / static_cast<double>(ticks - start.ticks) : 1.0;
+#else
+        return 1.0;
+#endif
+    }
+
+    // 建立校准基准点，首次使用统计时调用
+    static void initialize() { anchor(); }
+
+private:
+    struct Anchor {
+        uint64_t ticks;
+        std::chrono::steady_clock::time_point time;
+    };
+
+    static const Anchor& anchor() {
+        static const Anchor instance{ now(), std::chrono::steady_clock::now() };
+        return instance;
+    }
+};
+
+/**
+ * @brief 单个操作的延迟汇总（微秒）
+ */
+struct OperationStats {
+    const char* name = "";
+    uint64_t count = 0;
+    double meanUs = 0.0;
+    double p50Us = 0.0;
+    double p90Us = 0.0;
+    double p99Us = 0.0;
+    double maxUs = 0.0;
+};
+
+/**
+ * @brief 操作延迟统计 - 每线程一份 HDR 风格对数分桶直方图，读取时汇总
+ *
+ * 分桶方式：小于 32 的值各占一桶，之后每个 2 的幂区间再均分 16 个子桶，
+ * 相对误差不超过 1/16。记录路径只写本线程的数据，无锁、无共享写。
+ */
+class OperationMetrics {
+public:
+    static constexpr int SUB_BUCKET_BITS = 4;
+    static constexpr uint64_t SUB_BUCKET_COUNT = 1ull << SUB_BUCKET_BITS;
+    static constexpr int MAX_VALUE_BITS = 44;
+    static constexpr size_t BUCKET_COUNT =
+        (MAX_VALUE_BITS - SUB_BUCKET_BITS) * SUB_BUCKET_COUNT + 2 * SUB_BUCKET_COUNT;
+    static constexpr size_t OPERATION_COUNT = static_cast<size_t>(ShopOperation::Count);
+
+    static OperationMetrics& instance() {
+        static OperationMetrics metrics;
+        return metrics;
+    }
+
+    /**
+     * @brief 记录一次操作耗时（时钟周期数），只写调用线程自己的直方图
+     */
+    void record(ShopOperation operation, uint64_t ticks) {
+        recordInto(localHistograms(), operation, ticks);
+    }
+
+    /**
+     * @brief 汇总所有线程的直方图并计算分位数
+     */
+    std::vector<OperationStats> snapshot() const {
+        double nanosPerTick = MetricsClock::nanosPerTick();
+        std::vector<OperationStats> result;
+        std::vector<uint64_t> merged(BUCKET_COUNT);
+
+        // 持锁汇总，避免线程退出时其计数同时出现在存活块和退出线程累计里
+        std::lock_guard<std::mutex> guard(registryMutex);
+        for (size_t op = 0; op < OPERATION_COUNT; ++op) {
+            std::fill(merged.begin(), merged.end(), 0);
+            uint64_t count = 0;
+            uint64_t totalTicks = 0;
+            uint64_t maxTicks = 0;
+
+            auto accumulate = [&](const ThreadHistograms& thread) {
+                for (size_t b = 0; b < BUCKET_COUNT; ++b) {
+                    uint64_t n = thread.buckets[op][b].load(std::memory_order_relaxed);
+                    merged[b] += n;
+                    count += n;
+                }
+                totalTicks += thread.totalTicks[op].load(std::memory_order_relaxed);
+                uint64_t threadMax = thread.maxTicks[op].load(std::memory_order_relaxed);
+                if (threadMax > maxTicks) maxTicks = threadMax;
+            };
+            accumulate(*retired);
+            for (const auto& thread : registry) accumulate(*thread);
+
+            OperationStats stats;
+            stats.name = getOperationName(static_cast<ShopOperation>(op));
+            stats.count = count;
+            if (count > 0) {
+                double toMicros = nanosPerTick / 1000.0;
+                stats.meanUs = static_cast<double>(totalTicks) / count * toMicros;
+                stats.p50Us = percentileTicks(merged, count, maxTicks, 0.50) * toMicros;
+                stats.p90Us = percentileTicks(merged, count, maxTicks, 0.90) * toMicros;
+                stats.p99Us = percentileTicks(merged, count, maxTicks, 0.99) * toMicros;
+                stats.maxUs = maxTicks * toMicros;
+            }
+            result.push_back(stats);
+        }
+        return result;
+    }
+
+    /**
+     * @brief 以 JSON 格式导出有记录的操作
+     */
+    std::string toJson() const {
+        std::ostringstream oss;
+        oss << std::fixed << std::setprecision(3);
+        oss << "{\n  \"unit\": \"us\",\n  \"operations\": [";
+        bool first = true;
+        for (const auto& stats : snapshot()) {
+            if (stats.count == 0) continue;
+            oss << (first ? "\n" : ",\n");
+            first = false;
+            oss << "    {\"name\": \"" << stats.name << "\", \"count\": " << stats.count
+                << ", \"mean\": " << stats.meanUs << ", \"p50\": " << stats.p50Us
+                << ", \"p90\": " << stats.p90Us << ", \"p99\": " << stats.p99Us
+                << ", \"max\": " << stats.maxUs << "}";
+        }
+        oss << (first ? "]\n}" : "\n  ]\n}");
+        return oss.str();
+    }
+
+    /**
+     * @brief 测量单次记录的开销（两次读时钟 + 写直方图），单位纳秒
+     * @param iterations 测量次数
+     */
+    static double measureRecordingOverhead(int iterations = 1000000) {
+        auto scratch = std::make_unique<ThreadHistograms>();
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            uint64_t start = MetricsClock::now();
+            recordInto(*scratch, ShopOperation::GetProduct, MetricsClock::now() - start);
+        }
+        auto elapsed = std::chrono::steady_clock::now() - begin;
+        return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    }
+
+    static size_t bucketIndex(uint64_t value) {
+        if (value < 2 * SUB_BUCKET_COUNT) return static_cast<size_t>(value);
+        int shift = static_cast<int>(std::bit_width(value)) - 1 - SUB_BUCKET_BITS;
+        size_t index = static_cast<size_t>(shift) * SUB_BUCKET_COUNT + static_cast<size_t>(value >> shift);
+        return index < BUCKET_COUNT ? index : BUCKET_COUNT - 1;
+    }
+
+    // 桶内可能出现的最大值
+    static uint64_t bucketUpperBound(size_t index) {
+        if (index < 2 * SUB_BUCKET_COUNT) return index;
+        uint64_t shift = index / SUB_BUCKET_COUNT - 1;
+        uint64_t mantissa = index - shift * SUB_BUCKET_COUNT;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+private:
+    struct ThreadHistograms {
+        std::array<std::array<std::atomic<uint64_t>, BUCKET_COUNT>, OPERATION_COUNT> buckets{};
+        std::array<std::atomic<uint64_t>, OPERATION_COUNT> totalTicks{};
+        std::array<std::atomic<uint64_t>, OPERATION_COUNT> maxTicks{};
+    };
+
+    /**
+     * @brief 线程私有的直方图持有者，线程退出时把计数并入退出线程累计并注销
+     */
+    class ThreadSlot {
+    public:
+        ThreadSlot() : histograms(instance().attachThread()) {}
+        ~ThreadSlot() { instance().detachThread(histograms); }
+        ThreadSlot(const ThreadSlot&) = delete;
+        ThreadSlot& operator=(const ThreadSlot&) = delete;
+
+        ThreadHistograms& get() const { return *histograms; }
+
+    private:
+        std::shared_ptr<ThreadHistograms> histograms;
+    };
+
+    mutable std::mutex registryMutex;
+    std::vector<std::shared_ptr<ThreadHistograms>> registry;  // 仅存活线程
+    std::unique_ptr<ThreadHistograms> retired;                // 已退出线程的累计，受 registryMutex 保护
+
+    OperationMetrics() : retired(std::make_unique<ThreadHistograms>()) { MetricsClock::initialize(); }
+    OperationMetrics(const OperationMetrics&) = delete;
+    OperationMetrics& operator=(const OperationMetrics&) = delete;
+
+    std::shared_ptr<ThreadHistograms> attachThread() {
+        auto histograms = std::make_shared<ThreadHistograms>();
+        std::lock_guard<std::mutex> guard(registryMutex);
+        registry.push_back(histograms);
+        return histograms;
+    }
+
+    void detachThread(const std::shared_ptr<ThreadHistograms>& histograms) {
+        std::lock_guard<std::mutex> guard(registryMutex);
+        for (size_t op = 0; op < OPERATION_COUNT; ++op) {
+            for (size_t b = 0; b < BUCKET_COUNT; ++b) {
+                uint64_t n = histograms->buckets[op][b].load(std::memory_order_relaxed);
+                if (n == 0) continue;
+                auto& bucket = retired->buckets[op][b];
+                bucket.store(bucket.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+            }
+            auto& total = retired->totalTicks[op];
+            total.store(total.load(std::memory_order_relaxed)
+                + histograms->totalTicks[op].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            uint64_t threadMax = histograms->maxTicks[op].load(std::memory_order_relaxed);
+            if (threadMax > retired->maxTicks[op].load(std::memory_order_relaxed)) {
+                retired->maxTicks[op].store(threadMax, std::memory_order_relaxed);
+            }
+        }
+        std::erase(registry, histograms);
+    }
+
+    static ThreadHistograms& localHistograms() {
+        thread_local ThreadSlot local;
+        return local.get();
+    }
+
+    // 单写者：各计数只由所属线程写入，读端并发读取，relaxed 即可
+    static void recordInto(ThreadHistograms& histograms, ShopOperation operation, uint64_t ticks) {
+        size_t op = static_cast<size_t>(operation);
+        auto& bucket = histograms.buckets[op][bucketIndex(ticks)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        auto& total = histograms.totalTicks[op];
+        total.store(total.load(std::memory_order_relaxed) + ticks, std::memory_order_relaxed);
+        auto& maximum = histograms.maxTicks[op];
+        if (ticks > maximum.load(std::memory_order_relaxed)) {
+            maximum.store(ticks, std::memory_order_relaxed);
+        }
+    }
+
+    static double percentileTicks(const std::vector<uint64_t>& buckets, uint64_t count,
+        uint64_t maxTicks, double p) {
+        uint64_t target = static_cast<uint64_t>(p * count + 0.5);
+        if (target == 0) target = 1;
+        uint64_t seen = 0;
+        for (size_t b = 0; b < buckets.size(); ++b) {
+            seen += buckets[b];
+            if (seen >= target) {
+                uint64_t upper = bucketUpperBound(b);
+                return static_cast<double>(upper < maxTicks ? upper : maxTicks);
+            }
+        }
+        return static_cast<double>(maxTicks);
+    }
+};
+
+/**
+ * @brief 作用域计时器：构造时开始计时，析构时记录到对应操作的直方图
+ */
+class ScopedOperationTimer {
+private:
+    ShopOperation operation;
+    uint64_t start;
+
+public:
+    explicit ScopedOperationTimer(ShopOperation operation)
+        : operation(operation), start(MetricsClock::now()) {
+    }
+
+    ~ScopedOperationTimer() {
+        OperationMetrics::instance().record(operation, MetricsClock::now() - start);
+    }
+
+    ScopedOperationTimer(const ScopedOperationTimer&) = delete;
+    ScopedOperationTimer& operator=(const ScopedOperationTimer&) = delete;
+};
+
+#endif // OPERATIONMETRICS_H
@@ -8,7 +8,12 @@
 #include <sstream>
 #include <iomanip>
 #include <cstdlib>
+#include <atomic>
+#include <chrono>
+#include <string_view>
+#include <utility>
 #include "Product.h"
+#include "TextRecord.h"
 
 /**
  * @brief 订单项类
@@ -18,61 +23,85 @@ private:
     std::string productId;
     std::string productName;
     int quantity;
-    double price;
+    Money price;
     std::string sellerUsername;  // 新增：卖家用户名
     std::string sellerPhone;     // 新增：卖家手机号
 
 public:
-    OrderItem() : quantity(0), price(0.0) {}
+    OrderItem() : quantity(0) {}
 
-    OrderItem(const std::string& productId, const std::string& productName,
-        int quantity, double price, const std::string& sellerUsername = "",
-        const std::string& sellerPhone = "")
-        : productId(productId), productName(productName), quantity(quantity), price(price),
-        sellerUsername(sellerUsername), sellerPhone(sellerPhone) {
+    OrderItem(std::string productId, std::string productName,
+        int quantity, Money price, std::string sellerUsername = "",
+        std::string sellerPhone = "")
+        : productId(std::move(productId)), productName(std::move(productName)), quantity(quantity), price(price),
+        sellerUsername(std::move(sellerUsername)), sellerPhone(std::move(sellerPhone)) {
     }
 
-    // Getter方法
-    std::string getProductId() const { return productId; }
-    std::string getProductName() const { return productName; }
+    // Getter方法（返回常量引用）
+    const std::string& getProductId() const { return productId; }
+    const std::string& getProductName() const { return productName; }
     int getQuantity() const { return quantity; }
-    double getPrice() const { return price; }
-    double getTotalPrice() const { return price * quantity; }
-    std::string getSellerUsername() const { return sellerUsername; }  // 新增
-    std::string getSellerPhone() const { return sellerPhone; }        // 新增
+    Money getPrice() const { return price; }
+    Money getTotalPrice() const { return price * quantity; }
+    const std::string& getSellerUsername() const { return sellerUsername; }  // 新增
+    const std::string& getSellerPhone() const { return sellerPhone; }        // 新增
 
     void setQuantity(int newQuantity) { quantity = newQuantity; }
 
     void displayInfo() const {
         std::cout << productName << " x " << quantity
-            << " @ Y" << std::fixed << std::setprecision(2) << price
+            << " @ Y" << price
             << " = Y" << getTotalPrice() << std::endl;
         std::cout << "   卖家: " << sellerUsername << " 电话: " << sellerPhone << std::endl;  // 新增
     }
 
-    std::string toString() const {
-        std::ostringstream oss;
-        oss << productId << "|" << productName << "|" << quantity << "|"
-            << price << "|" << sellerUsername << "|" << sellerPhone;
-        return oss.str();
+    size_t getHeapBytes() const {
+        return MemoryAccounting::ofString(productId) + MemoryAccounting::ofString(productName) +
+            MemoryAccounting::ofString(sellerUsername) + MemoryAccounting::ofString(sellerPhone);
     }
 
-    static OrderItem fromString(const std::string& data) {
-        std::istringstream iss(data);
-        std::string token;
-        std::vector<std::string> tokens;
+    // 字符串字段经 TextRecord 转义，记录内不含未转义的 '|'、';' 和换行
+    std::string toString() const {
+        std::string text;
+        TextRecord::appendField(text, productId);
+        text += '|';
+        TextRecord::appendField(text, productName);
+        text += '|';
+        text += std::to_string(quantity);
+        text += '|';
+        text += price.toString();
+        text += '|';
+        TextRecord::appendField(text, sellerUsername);
+        text += '|';
+        TextRecord::appendField(text, sellerPhone);
+        return text;
+    }
 
-        while (std::getline(iss, token, '|')) {
-            tokens.push_back(token);
+    /**
+     * @brief 解析 toString() 的结果（缺少卖家字段的旧记录同样接受）
+     * @return 字段数不对、商品ID为空、数量不是正整数或单价无法解析时返回 false，result 不变
+     */
+    static bool tryParse(std::string_view data, OrderItem& result) {
+        std::vector<std::string_view> fields = TextRecord::split(data, '|');
+        if (fields.size() < 4 || fields.size() > 6 || fields[0].empty()) return false;
+
+        int itemQuantity = 0;
+        Money itemPrice;
+        if (!TextRecord::parseInt(fields[2], itemQuantity) || itemQuantity <= 0 ||
+            !Money::parse(fields[3], itemPrice)) {
+            return false;
         }
+        fields.resize(6);
+        result = OrderItem(TextRecord::unescape(fields[0]), TextRecord::unescape(fields[1]), itemQuantity, itemPrice,
+            TextRecord::unescape(fields[4]), TextRecord::unescape(fields[5]));
+        return true;
+    }
 
-        if (tokens.size() >= 4) {
-            std::string sellerUser = tokens.size() > 4 ? tokens[4] : "";
-            std::string sellerPhone = tokens.size() > 5 ? tokens[5] : "";
-            return OrderItem(tokens[0], tokens[1], std::stoi(tokens[2]),
-                std::stod(tokens[3]), sellerUser, sellerPhone);
-        }
-        return OrderItem();
+    // 无法解析时返回空的订单项
+    static OrderItem fromString(const std::string& data) {
+        OrderItem item;
+        tryParse(data, item);
+        return item;
     }
 };
 
@@ -84,7 +113,7 @@ private:
     std::string orderId;
     std::string username;
     std::vector<OrderItem> items;
-    double totalAmount;
+    Money totalAmount;
     std::string orderTime;
     std::string status;
     std::string shippingAddress;
@@ -92,31 +121,32 @@ private:
     std::string buyerPhone;  // 新增：买家手机号
 
 public:
-    Order() : totalAmount(0.0), status("pending") {}
-
-    Order(const std::string& username, const std::vector<OrderItem>& items,
-        const std::string& address, const std::string& payment,
-        const std::string& buyerPhone = "")
-        : username(username), items(items), shippingAddress(address),
-        paymentMethod(payment), buyerPhone(buyerPhone), status("pending") {
+    Order() : status("pending") {}
+
+    // 订单项按值传入，调用方可把购物车直接移动进来
+    Order(std::string username, std::vector<OrderItem> items,
+        std::string address, std::string payment,
+        std::string buyerPhone = "")
+        : username(std::move(username)), items(std::move(items)), status("pending"),
+        shippingAddress(std::move(address)), paymentMethod(std::move(payment)), buyerPhone(std::move(buyerPhone)) {
         generateOrderId();
         setOrderTime();
         calculateTotalAmount();
     }
 
-    // Getter方法
-    std::string getOrderId() const { return orderId; }
-    std::string getUsername() const { return username; }
-    std::vector<OrderItem> getItems() const { return items; }
-    double getTotalAmount() const { return totalAmount; }
-    std::string getOrderTime() const { return orderTime; }
-    std::string getStatus() const { return status; }
-    std::string getShippingAddress() const { return shippingAddress; }
-    std::string getPaymentMethod() const { return paymentMethod; }
-    std::string getBuyerPhone() const { return buyerPhone; }  // 新增
+    // Getter方法（返回常量引用）
+    const std::string& getOrderId() const { return orderId; }
+    const std::string& getUsername() const { return username; }
+    const std::vector<OrderItem>& getItems() const { return items; }
+    Money getTotalAmount() const { return totalAmount; }
+    const std::string& getOrderTime() const { return orderTime; }
+    const std::string& getStatus() const { return status; }
+    const std::string& getShippingAddress() const { return shippingAddress; }
+    const std::string& getPaymentMethod() const { return paymentMethod; }
+    const std::string& getBuyerPhone() const { return buyerPhone; }  // 新增
 
     // 状态管理
-    void setStatus(const std::string& newStatus) { status = newStatus; }
+    void setStatus(std::string newStatus) { status = std::move(newStatus); }
 
     void pay() {
         if (status == "pending") {
@@ -146,6 +176,56 @@ public:
         return status == "pending" || status == "paid";
     }
 
+    // 已完成或已取消的订单不会再变化，可以归档
+    bool isFinished() const {
+        return status == "completed" || status == "cancelled";
+    }
+
+    /**
+     * @brief 下单时间（本地时间）转为时间戳
+     * @return 时间格式无法解析时返回 -1
+     */
+    std::time_t getOrderTimestamp() const {
+        std::tm localTime = {};
+        std::istringstream iss(orderTime);
+        iss >> std::get_time(&localTime, "%Y-%m-%d %H:%M:%S");
+        if (iss.fail()) return -1;
+        localTime.tm_isdst = -1;
+        return std::mktime(&localTime);
+    }
+
+    /**
+     * @brief 下单日期（本地日期）距 1970-01-01 的天数，只解析日期部分，不分配内存
+     * @return 时间格式无法解析时返回 -1
+     */
+    long long getOrderDay() const {
+        return toDayNumber(orderTime);
+    }
+
+    /**
+     * @brief "YYYY-MM-DD..." 格式的日期转为距 1970-01-01 的天数
+     */
+    static long long toDayNumber(std::string_view text) {
+        if (text.size() < 10 || text[4] != '-' || text[7] != '-') return -1;
+        auto digits = [&](size_t begin, size_t count) {
+            int value = 0;
+            for (size_t i = begin; i < begin + count; ++i) {
+                if (text[i] < '0' || text[i] > '9') return -1;
+                value = value * 10 + (text[i] - '0');
+            }
+            return value;
+        };
+        int year = digits(0, 4);
+        int month = digits(5, 2);
+        int day = digits(8, 2);
+        if (year < 0 || month < 0 || day < 0) return -1;
+
+        std::chrono::year_month_day date{ std::chrono::year(year),
+            std::chrono::month(static_cast<unsigned>(month)), std::chrono::day(static_cast<unsigned>(day)) };
+        if (!date.ok()) return -1;
+        return std::chrono::sys_days(date).time_since_epoch().count();
+    }
+
     void displayOrderDetails() const {
         std::cout << "订单ID: " << orderId << std::endl;
         std::cout << "买家: " << username << std::endl;
@@ -161,13 +241,12 @@ public:
             item.displayInfo();
         }
 
-        std::cout << "总金额: Y" << std::fixed << std::setprecision(2) << totalAmount << std::endl;
+        std::cout << "总金额: Y" << totalAmount << std::endl;
         std::cout << "------------------------" << std::endl;
     }
 
     void displayBriefInfo() const {
-        std::cout << orderId << " | " << getStatusText() << " | Y"
-            << std::fixed << std::setprecision(2) << totalAmount
+        std::cout << orderId << " | " << getStatusText() << " | Y" << totalAmount
             << " | " << orderTime << std::endl;
     }
 
@@ -180,66 +259,117 @@ public:
         return "未知状态";
     }
 
+    // 订单项数组和各字符串占用的堆内存（不含对象本身）
+    size_t getHeapBytes() const {
+        size_t bytes = MemoryAccounting::ofVector(items) + MemoryAccounting::ofString(orderId) +
+            MemoryAccounting::ofString(username) + MemoryAccounting::ofString(orderTime) +
+            MemoryAccounting::ofString(status) + MemoryAccounting::ofString(shippingAddress) +
+            MemoryAccounting::ofString(paymentMethod) + MemoryAccounting::ofString(buyerPhone);
+        for (const auto& item : items) {
+            bytes += item.getHeapBytes();
+        }
+        return bytes;
+    }
+
+    // 字符串字段经 TextRecord 转义；订单项之间以 ';' 分隔，订单项内部的 '|' 不影响前 8 个字段的拆分
     std::string toString() const {
-        std::ostringstream oss;
-        oss << orderId << "|" << username << "|" << totalAmount << "|"
-            << orderTime << "|" << status << "|" << shippingAddress << "|"
-            << paymentMethod << "|" << buyerPhone << "|";  // 新增买家手机号
+        std::string text;
+        for (const std::string* field : { &orderId, &username }) {
+            TextRecord::appendField(text, *field);
+            text += '|';
+        }
+        text += totalAmount.toString();
+        text += '|';
+        for (const std::string* field : { &orderTime, &status, &shippingAddress, &paymentMethod, &buyerPhone }) {
+            TextRecord::appendField(text, *field);
+            text += '|';
+        }
 
         for (size_t i = 0; i < items.size(); ++i) {
-            if (i > 0) oss << ";";
-            oss << items[i].toString();
+            if (i > 0) text += ';';
+            text += items[i].toString();
         }
+        return text;
+    }
 
-        return oss.str();
+    /**
+     * @brief 解析 toString() 的结果（缺少买家手机号或订单项的旧记录同样接受）
+     * @return 字段数不足、订单ID为空、金额无法解析或任一订单项无效时返回 false，result 不变
+     */
+    static bool tryParse(std::string_view data, Order& result) {
+        // 前 8 个字段以 '|' 分隔，其余部分是订单项列表（订单项内部同样使用 '|'）
+        std::vector<std::string_view> fields = TextRecord::split(data, '|', 9);
+        Order order;
+        if (fields.size() < 7 || fields[0].empty() || !Money::parse(fields[2], order.totalAmount)) return false;
+
+        fields.resize(9);
+        order.orderId = TextRecord::unescape(fields[0]);
+        order.username = TextRecord::unescape(fields[1]);
+        order.orderTime = TextRecord::unescape(fields[3]);
+        order.status = TextRecord::unescape(fields[4]);
+        order.shippingAddress = TextRecord::unescape(fields[5]);
+        order.paymentMethod = TextRecord::unescape(fields[6]);
+        order.buyerPhone = TextRecord::unescape(fields[7]);
+
+        if (!fields[8].empty()) {
+            for (std::string_view itemText : TextRecord::split(fields[8], ';')) {
+                if (!OrderItem::tryParse(itemText, order.items.emplace_back())) return false;
+            }
+        }
+        result = std::move(order);
+        return true;
     }
 
+    // 无法解析时返回空订单（订单ID为空）
     static Order fromString(const std::string& data) {
-        std::istringstream iss(data);
-        std::string token;
-        std::vector<std::string> tokens;
-
-        while (std::getline(iss, token, '|')) {
-            tokens.push_back(token);
-        }
+        Order order;
+        tryParse(data, order);
+        return order;
+    }
 
-        if (tokens.size() >= 7) {
-            Order order;
-            order.orderId = tokens[0];
-            order.username = tokens[1];
-            order.totalAmount = std::stod(tokens[2]);
-            order.orderTime = tokens[3];
-            order.status = tokens[4];
-            order.shippingAddress = tokens[5];
-            order.paymentMethod = tokens[6];
-            order.buyerPhone = tokens.size() > 7 ? tokens[7] : "";  // 新增
-
-            if (tokens.size() > 8 && !tokens[8].empty()) {
-                std::istringstream itemsStream(tokens[8]);
-                std::string itemToken;
-                while (std::getline(itemsStream, itemToken, ';')) {
-                    order.items.push_back(OrderItem::fromString(itemToken));
-                }
-            }
-            return order;
+    /**
+     * @brief 登记已存在的订单ID（启动时从日志和归档恢复），之后生成的序号都大于它的序号
+     *
+     * 订单ID为 "ORD" + 10 位秒数 + 序号，秒数定宽，序号不同的ID一定不同，
+     * 重启后同一秒内下单也不会与恢复出的订单重复。
+     */
+    static void reserveOrderId(std::string_view id) {
+        if (id.size() <= ID_SEQUENCE_OFFSET || id.substr(0, 3) != "ORD") return;
+        std::string_view digits = id.substr(ID_SEQUENCE_OFFSET);
+        if (digits.size() > 18) return;
+        unsigned long long value = 0;
+        for (char c : digits) {
+            if (c < '0' || c > '9') return;
+            value = value * 10 + static_cast<unsigned long long>(c - '0');
         }
-        return Order();
+        auto& counter = sequenceCounter();
+        unsigned long long current = counter.load();
+        while (current < value && !counter.compare_exchange_weak(current, value)) {}
     }
 
 private:
+    static constexpr size_t ID_SEQUENCE_OFFSET = 3 + 10;  // "ORD" + 10 位秒数
+
+    // 进程内递增序号，保证同一秒内并发下单的订单ID不重复
+    static std::atomic<unsigned long long>& sequenceCounter() {
+        static std::atomic<unsigned long long> sequence{ 0 };
+        return sequence;
+    }
+
     void generateOrderId() {
         std::ostringstream oss;
-        oss << "ORD" << std::time(nullptr) << std::rand() % 1000;
+        oss << "ORD" << std::setw(10) << std::setfill('0') << std::time(nullptr) << ++sequenceCounter();
         orderId = oss.str();
     }
 
     void setOrderTime() {
         std::time_t now = std::time(nullptr);
         std::tm localTime;
+        // 分区运行时等场景会在多个线程中同时创建订单，使用可重入版本
         #ifdef _WIN32
         localtime_s(&localTime, &now);
         #else
-        localTime = *std::localtime(&now);
+        localtime_r(&now, &localTime);
         #endif
         std::ostringstream oss;
         oss << std::put_time(&localTime, "%Y-%m-%d %H:%M:%S");
@@ -247,7 +377,7 @@ private:
     }
 
     void calculateTotalAmount() {
-        totalAmount = 0.0;
+        totalAmount = Money();
         for (const auto& item : items) {
             totalAmount += item.getTotalPrice();
         }
@@ -0,0 +1,389 @@
+﻿#ifndef ORDERARCHIVE_H
+#define ORDERARCHIVE_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "Order.h"
+#include "LzCompressor.h"
+#include "StringHash.h"
+#include "MemoryUsage.h"
+#include "DurableFile.h"
+
+/**
+ * @brief 订单归档（冷数据层）- 已结束的订单压缩后写入只追加的段
+ *
+ * 每个段保存一批订单（每行一个 Order::toString()），整体 LZ 压缩。
+ * 段格式：4 字节魔数 "OSG2" + 原始长度 + 压缩长度 + 订单数 + 压缩数据的 CRC-32 + 前 20 字节的 CRC-32
+ * （各 4 字节）+ 压缩数据。魔数不是 "OSG2" 的段头按损坏处理。
+ * 打开时只截掉文件末尾不完整的段（写段时中断）；完整但校验或解压失败的段跳过并报告，不改动文件；
+ * 段头本身损坏时无法定位后续的段，拒绝打开。
+ * 每段写入后立即同步到磁盘（新建文件时同时同步目录），调用方之后才能把这些订单从订单日志中去掉。
+ * 内存中只保留 订单ID -> 段号、用户名 -> 段号列表 两个索引和汇总值，
+ * 查询时按需解压对应的段，最近用过的几个段缓存在内存中。
+ */
+class OrderArchive {
+public:
+    static constexpr size_t ORDERS_PER_SEGMENT = 1024;
+
+    OrderArchive() : archivedOrderCount(0), rawBytes(0), compressedBytes(0) {}
+
+    OrderArchive(const OrderArchive&) = delete;
+    OrderArchive& operator=(const OrderArchive&) = delete;
+
+    /**
+     * @brief 打开归档文件并重建内存索引
+     * @param path 归档文件路径，为空表示段只保存在内存中
+     */
+    void open(const std::string& path) {
+        filePath = path;
+        segments.clear();
+        orderLocation.clear();
+        userSegments.clear();
+        cache.clear();
+        archivedOrderCount = 0;
+        archivedSales = Money();
+        rawBytes = 0;
+        compressedBytes = 0;
+        if (filePath.empty()) return;
+
+        std::error_code error;
+        uint64_t fileSize = std::filesystem::exists(filePath, error) ? std::filesystem::file_size(filePath, error) : 0;
+        std::ifstream in(filePath, std::ios::binary);
+        uint64_t offset = 0;
+        while (offset < fileSize) {
+            Segment segment;
+            segment.fileOffset = offset;
+            HeaderStatus status = readHeader(in, fileSize - offset, segment);
+            if (status == HeaderStatus::Torn) {
+                // 进程在写段时中断会留下不完整的尾部，截掉以便继续追加
+                std::filesystem::resize_file(filePath, offset, error);
+                break;
+            }
+            if (status == HeaderStatus::Corrupt) {
+                throw std::runtime_error("订单归档 " + filePath + " 在偏移 " + std::to_string(offset) +
+                    " 处的段头损坏，无法定位后续的段；请修复或移走该文件后再启动");
+            }
+
+            std::string payload(segment.compressedSize, '\0');
+            in.read(payload.data(), payload.size());
+            offset += HEADER_SIZE + segment.compressedSize;
+
+            std::string raw;
+            if (crc32(payload) == segment.checksum) {
+                raw = LzCompressor::decompress(payload, segment.rawSize);
+            }
+            if (raw.size() != segment.rawSize) {
+                std::cerr << "订单归档在偏移 " << segment.fileOffset << " 处的段（" << segment.orderCount
+                    << " 个订单）校验或解压失败，已跳过，文件保持不变" << std::endl;
+                continue;
+            }
+
+            uint32_t segmentId = static_cast<uint32_t>(segments.size());
+            segments.push_back(std::move(segment));
+            size_t skipped = 0;
+            std::vector<Order> orders = parseOrders(raw, &skipped);
+            if (skipped > 0) {
+                std::cerr << "订单归档第 " << segmentId << " 段有 " << skipped << " 条无效记录，已跳过" << std::endl;
+            }
+            indexSegment(segmentId, orders.data(), orders.size());
+        }
+    }
+
+    /**
+     * @brief 归档一批订单，按 ORDERS_PER_SEGMENT 切分成段追加写入并同步
+     * @return 已持久化的订单数：orders 的前这么多个已归档，其余的因写入失败未归档，调用方应继续保留
+     */
+    size_t append(const std::vector<Order>& orders) {
+        for (size_t begin = 0; begin < orders.size(); begin += ORDERS_PER_SEGMENT) {
+            size_t end = std::min(orders.size(), begin + ORDERS_PER_SEGMENT);
+            if (!writeSegment(orders.data() + begin, end - begin)) return begin;
+        }
+        return orders.size();
+    }
+
+    bool contains(std::string_view orderId) const {
+        return orderLocation.find(orderId) != orderLocation.end();
+    }
+
+    /**
+     * @brief 按订单ID查找归档订单，只解压其所在的段
+     */
+    bool findOrder(std::string_view orderId, Order& result) {
+        auto it = orderLocation.find(orderId);
+        if (it == orderLocation.end()) return false;
+
+        const std::vector<Order>* orders = loadSegment(it->second);
+        if (!orders) return false;
+        for (const auto& order : *orders) {
+            if (order.getOrderId() == orderId) {
+                result = order;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief 获取某用户的全部归档订单，只解压包含该用户订单的段
+     */
+    std::vector<Order> getOrdersByUser(std::string_view username) {
+        std::vector<Order> result;
+        auto it = userSegments.find(username);
+        if (it == userSegments.end()) return result;
+
+        for (uint32_t segmentId : it->second) {
+            const std::vector<Order>* orders = loadSegment(segmentId);
+            if (!orders) continue;
+            for (const auto& order : *orders) {
+                if (order.getUsername() == username) {
+                    result.push_back(order);
+                }
+            }
+        }
+        return result;
+    }
+
+    /**
+     * @brief 解压全部段（用于全量分析），不经过段缓存
+     */
+    std::vector<std::vector<Order>> loadAllSegments() const {
+        std::vector<std::vector<Order>> result;
+        result.reserve(segments.size());
+        for (uint32_t segmentId = 0; segmentId < segments.size(); ++segmentId) {
+            std::string raw = readSegment(segmentId);
+            if (raw.size() == segments[segmentId].rawSize) {
+                result.push_back(parseOrders(raw));
+            }
+        }
+        return result;
+    }
+
+    // 汇总值在归档时累加，统计时无需解压
+    size_t getOrderCount() const { return archivedOrderCount; }
+    Money getSales() const { return archivedSales; }
+    size_t getSegmentCount() const { return segments.size(); }
+
+    // 内存中的段表（纯内存模式下含压缩数据）、两个索引和段缓存
+    MemoryUsage getMemoryUsage() const {
+        MemoryUsage usage{ MemoryAccounting::ofVector(segments) + MemoryAccounting::ofHashTable(orderLocation) +
+            MemoryAccounting::ofHashTable(userSegments) + MemoryAccounting::ofList(cache), archivedOrderCount };
+        for (const auto& segment : segments) {
+            usage.bytes += MemoryAccounting::ofString(segment.payload);
+        }
+        for (const auto& [orderId, segmentId] : orderLocation) {
+            usage.bytes += MemoryAccounting::ofString(orderId);
+        }
+        for (const auto& [username, owned] : userSegments) {
+            usage.bytes += MemoryAccounting::ofString(username) + MemoryAccounting::ofVector(owned);
+        }
+        for (const auto& [segmentId, orders] : cache) {
+            usage.bytes += MemoryAccounting::ofVector(orders);
+            for (const Order& order : orders) {
+                usage.bytes += order.getHeapBytes();
+            }
+        }
+        return usage;
+    }
+    uint64_t getRawBytes() const { return rawBytes; }
+    uint64_t getCompressedBytes() const { return compressedBytes; }
+
+private:
+    struct Segment {
+        uint64_t fileOffset = 0;
+        uint32_t rawSize = 0;
+        uint32_t compressedSize = 0;
+        uint32_t orderCount = 0;
+        uint32_t checksum = 0;     ///< 压缩数据的 CRC-32
+        std::string payload;  ///< 仅纯内存模式下保存压缩数据
+    };
+
+    enum class HeaderStatus {
+        Ok,
+        Torn,     ///< 段头或压缩数据在文件末尾不完整
+        Corrupt   ///< 段头损坏，后续的段无法定位
+    };
+
+    static constexpr char MAGIC[4] = { 'O', 'S', 'G', '2' };
+    static constexpr size_t HEADER_SIZE = 24;
+    // LZ 序列的匹配长度按字节累加，每个压缩字节最多展开约 255 字节，原始长度超过此倍数的段头不可信
+    static constexpr uint64_t MAX_EXPANSION = 256;
+    static constexpr size_t CACHED_SEGMENTS = 4;
+
+    std::string filePath;
+    std::vector<Segment> segments;
+    StringMap<uint32_t> orderLocation;              ///< 订单ID -> 段号
+    StringMap<std::vector<uint32_t>> userSegments;  ///< 用户名 -> 段号（升序、去重）
+    std::list<std::pair<uint32_t, std::vector<Order>>> cache;  ///< 最近使用在前
+
+    size_t archivedOrderCount;
+    Money archivedSales;
+    uint64_t rawBytes;
+    uint64_t compressedBytes;
+
+    /**
+     * @brief 读取并检查段头，remaining 为从段头起到文件末尾的字节数
+     *
+     * 只有段头或压缩数据超出文件末尾才算不完整；段头有校验和，通过校验后长度字段可信。
+     */
+    static HeaderStatus readHeader(std::istream& in, uint64_t remaining, Segment& segment) {
+        char header[HEADER_SIZE];
+        if (remaining < 4) return HeaderStatus::Torn;
+        if (!in.read(header, 4)) return HeaderStatus::Torn;
+        if (std::memcmp(header, MAGIC, 4) != 0) return HeaderStatus::Corrupt;
+        if (remaining < HEADER_SIZE) return HeaderStatus::Torn;
+        if (!in.read(header + 4, HEADER_SIZE - 4)) return HeaderStatus::Torn;
+
+        std::memcpy(&segment.rawSize, header + 4, 4);
+        std::memcpy(&segment.compressedSize, header + 8, 4);
+        std::memcpy(&segment.orderCount, header + 12, 4);
+        uint32_t headerChecksum;
+        std::memcpy(&segment.checksum, header + 16, 4);
+        std::memcpy(&headerChecksum, header + 20, 4);
+        if (crc32(std::string_view(header, 20)) != headerChecksum) return HeaderStatus::Corrupt;
+        if (segment.compressedSize > remaining - HEADER_SIZE) return HeaderStatus::Torn;
+        if (segment.rawSize > segment.compressedSize * MAX_EXPANSION + 64) return HeaderStatus::Corrupt;
+        return HeaderStatus::Ok;
+    }
+
+    // CRC-32（IEEE 802.3 多项式，按字节查表）
+    static uint32_t crc32(std::string_view data) {
+        static const std::array<uint32_t, 256> table = [] {
+            std::array<uint32_t, 256> entries{};
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t value = i;
+                for (int bit = 0; bit < 8; ++bit) value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+                entries[i] = value;
+            }
+            return entries;
+        }();
+        uint32_t crc = 0xFFFFFFFFu;
+        for (unsigned char c : data) crc = table[(crc ^ c) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    // 每行一个订单，无法解析的行跳过并计入 skipped（启动时的全量加载据此报告，按需解压时不再重复报告）
+    static std::vector<Order> parseOrders(const std::string& raw, size_t* skipped = nullptr) {
+        std::vector<Order> orders;
+        size_t begin = 0;
+        while (begin < raw.size()) {
+            size_t end = raw.find('\n', begin);
+            if (end == std::string::npos) end = raw.size();
+            if (end > begin) {
+                if (!Order::tryParse(std::string_view(raw).substr(begin, end - begin), orders.emplace_back())) {
+                    orders.pop_back();
+                    if (skipped) ++*skipped;
+                }
+            }
+            begin = end + 1;
+        }
+        return orders;
+    }
+
+    void indexSegment(uint32_t segmentId, const Order* orders, size_t count) {
+        const Segment& segment = segments[segmentId];
+        rawBytes += segment.rawSize;
+        compressedBytes += segment.compressedSize;
+
+        for (size_t i = 0; i < count; ++i) {
+            const Order& order = orders[i];
+            orderLocation[order.getOrderId()] = segmentId;
+            auto& owned = userSegments[order.getUsername()];
+            if (owned.empty() || owned.back() != segmentId) {
+                owned.push_back(segmentId);
+            }
+            ++archivedOrderCount;
+            // 与 DatabaseManager::getTotalSales 口径一致：已完成订单计入销售额
+            if (order.getStatus() == "completed") {
+                archivedSales += order.getTotalAmount();
+            }
+        }
+    }
+
+    // 写入并同步一个段，失败时截掉写了一半的部分（之后的段才能接着追加），不建立索引
+    bool writeSegment(const Order* orders, size_t count) {
+        std::string raw;
+        for (size_t i = 0; i < count; ++i) {
+            raw += orders[i].toString();
+            raw += '\n';
+        }
+
+        Segment segment;
+        std::string payload = LzCompressor::compress(raw);
+        segment.rawSize = static_cast<uint32_t>(raw.size());
+        segment.compressedSize = static_cast<uint32_t>(payload.size());
+        segment.orderCount = static_cast<uint32_t>(count);
+        segment.checksum = crc32(payload);
+
+        if (filePath.empty()) {
+            segment.payload = std::move(payload);
+        }
+        else {
+            std::error_code error;
+            segment.fileOffset = std::filesystem::exists(filePath, error) ? std::filesystem::file_size(filePath, error) : 0;
+
+            std::string record(HEADER_SIZE, '\0');
+            std::memcpy(record.data(), MAGIC, 4);
+            std::memcpy(record.data() + 4, &segment.rawSize, 4);
+            std::memcpy(record.data() + 8, &segment.compressedSize, 4);
+            std::memcpy(record.data() + 12, &segment.orderCount, 4);
+            std::memcpy(record.data() + 16, &segment.checksum, 4);
+            uint32_t headerChecksum = crc32(std::string_view(record.data(), 20));
+            std::memcpy(record.data() + 20, &headerChecksum, 4);
+            record += payload;
+
+            if (!DurableFile::append(filePath, record)) {
+                std::filesystem::resize_file(filePath, segment.fileOffset, error);
+                return false;
+            }
+        }
+
+        uint32_t segmentId = static_cast<uint32_t>(segments.size());
+        segments.push_back(std::move(segment));
+        indexSegment(segmentId, orders, count);
+        return true;
+    }
+
+    // 读取并解压一个段，失败时返回空串
+    std::string readSegment(uint32_t segmentId) const {
+        const Segment& segment = segments[segmentId];
+        if (filePath.empty()) {
+            return LzCompressor::decompress(segment.payload, segment.rawSize);
+        }
+
+        std::ifstream in(filePath, std::ios::binary);
+        in.seekg(static_cast<std::streamoff>(segment.fileOffset + HEADER_SIZE));
+        std::string payload(segment.compressedSize, '\0');
+        if (!in.read(payload.data(), payload.size())) return std::string();
+        if (crc32(payload) != segment.checksum) return std::string();
+        return LzCompressor::decompress(payload, segment.rawSize);
+    }
+
+    const std::vector<Order>* loadSegment(uint32_t segmentId) {
+        for (auto it = cache.begin(); it != cache.end(); ++it) {
+            if (it->first == segmentId) {
+                cache.splice(cache.begin(), cache, it);
+                return &cache.front().second;
+            }
+        }
+
+        std::string raw = readSegment(segmentId);
+        if (raw.size() != segments[segmentId].rawSize) return nullptr;
+
+        cache.emplace_front(segmentId, parseOrders(raw));
+        if (cache.size() > CACHED_SEGMENTS) cache.pop_back();
+        return &cache.front().second;
+    }
+};
+
+#endif // ORDERARCHIVE_H
@@ -0,0 +1,334 @@
+﻿#ifndef ORDERSTORE_H
+#define ORDERSTORE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+#include "Order.h"
+#include "StringHash.h"
+#include "MemoryUsage.h"
+
+/**
+ * @brief 热订单表 - 按下单用户名哈希分片，每个分片独立加锁并维护订单ID和用户索引
+ *
+ * 同一用户的订单都在一个分片中，查看"我的订单"和订单详情只锁一个分片，不需要引擎锁；
+ * 按订单ID查找时不知道用户，依次探查各分片的索引（每个分片一次哈希查找）。
+ * 写入都在分片锁内进行：单条写入经 add / update，事务经 lockShards 一次按分片号顺序锁住涉及的分片，
+ * 在这些分片内查找、追加、修改。全表访问（forEach / forEachShard）不加分片锁，调用方须排除并发写入
+ * （DatabaseManager 持有订单写锁的独占模式）。
+ * 每个分片另存一列与订单对齐的销售额（分），统计总销售额时连续求和，不必逐个访问订单对象。
+ * 订单对象占用的字节数随写入增量维护（getLiveBytes），内存上限检查不必遍历全表。
+ */
+class OrderStore {
+public:
+    static constexpr size_t DEFAULT_SHARD_COUNT = 16;
+
+    explicit OrderStore(size_t shardCount = DEFAULT_SHARD_COUNT)
+        : shardCount(shardCount == 0 ? 1 : shardCount), shards(std::make_unique<Shard[]>(this->shardCount)),
+        orderCount(0), liveBytes(0) {
+    }
+
+    OrderStore(const OrderStore&) = delete;
+    OrderStore& operator=(const OrderStore&) = delete;
+
+    // ==================== 写入（加分片锁） ====================
+    void add(Order order) {
+        Shard& shard = shardFor(order.getUsername());
+        std::lock_guard<std::mutex> guard(shard.mutex);
+        addLocked(shard, std::move(order));
+    }
+
+    /**
+     * @brief 在分片锁内修改订单（不能改订单ID和下单用户），并同步销售额列
+     * @param modifier bool(Order&)，返回 false 表示不修改（调用方须保证此时订单未被改动）
+     * @return 订单不存在或 modifier 返回 false 时返回 false
+     */
+    template <typename Modifier>
+    bool update(std::string_view orderId, Modifier&& modifier) {
+        for (size_t i = 0; i < shardCount; ++i) {
+            Shard& shard = shards[i];
+            std::lock_guard<std::mutex> guard(shard.mutex);
+            auto it = shard.byId.find(orderId);
+            if (it != shard.byId.end()) return modifyLocked(shard, it->second, modifier);
+        }
+        return false;
+    }
+
+    // 下单用户所在的分片号，事务据此在加锁前确定要锁的分片
+    size_t shardOfUser(std::string_view username) const { return shardIndexFor(username); }
+
+    /**
+     * @brief 一组已加锁的分片（按分片号升序加锁，不会互相等待），期间只能访问这些分片中的订单
+     */
+    class ShardLocks {
+    public:
+        // 订单不存在或不在已加锁的分片中时返回 nullptr；指针在本组锁释放或下一次 add 之前有效
+        const Order* find(std::string_view orderId) const {
+            for (size_t shard : held) {
+                auto it = store.shards[shard].byId.find(orderId);
+                if (it != store.shards[shard].byId.end()) return &store.shards[shard].orders[it->second];
+            }
+            return nullptr;
+        }
+
+        // 下单用户的分片须已加锁
+        void add(Order order) {
+            Shard& shard = store.shardFor(order.getUsername());
+            store.addLocked(shard, std::move(order));
+        }
+
+        template <typename Modifier>
+        bool update(std::string_view orderId, Modifier&& modifier) {
+            for (size_t shard : held) {
+                auto it = store.shards[shard].byId.find(orderId);
+                if (it != store.shards[shard].byId.end()) return store.modifyLocked(store.shards[shard], it->second, modifier);
+            }
+            return false;
+        }
+
+    private:
+        friend class OrderStore;
+
+        ShardLocks(OrderStore& store, std::vector<size_t> shardIds) : store(store), held(std::move(shardIds)) {
+            std::sort(held.begin(), held.end());
+            held.erase(std::unique(held.begin(), held.end()), held.end());
+            locks.reserve(held.size());
+            for (size_t shard : held) locks.emplace_back(store.shards[shard].mutex);
+        }
+
+        OrderStore& store;
+        std::vector<size_t> held;  ///< 已加锁的分片号，升序
+        std::vector<std::unique_lock<std::mutex>> locks;
+    };
+
+    ShardLocks lockShards(std::vector<size_t> shardIds) {
+        return ShardLocks(*this, std::move(shardIds));
+    }
+
+    /**
+     * @brief 按订单ID查找所在的分片号（只在查找时持该分片的锁）
+     */
+    bool findShard(std::string_view orderId, size_t& shardId) const {
+        for (size_t i = 0; i < shardCount; ++i) {
+            std::lock_guard<std::mutex> guard(shards[i].mutex);
+            if (shards[i].byId.find(orderId) != shards[i].byId.end()) {
+                shardId = i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief 移出满足条件的订单，各分片内剩余订单保持原有顺序
+     */
+    template <typename Predicate>
+    std::vector<Order> extractIf(Predicate&& matches) {
+        std::vector<Order> extracted;
+        for (size_t i = 0; i < shardCount; ++i) {
+            Shard& shard = shards[i];
+            std::lock_guard<std::mutex> guard(shard.mutex);
+            auto first = std::stable_partition(shard.orders.begin(), shard.orders.end(),
+                [&](const Order& order) { return !matches(order); });
+            if (first == shard.orders.end()) continue;
+
+            size_t moved = static_cast<size_t>(shard.orders.end() - first);
+            for (auto it = first; it != shard.orders.end(); ++it) {
+                liveBytes.fetch_sub(bytesOf(*it), std::memory_order_relaxed);
+            }
+            extracted.insert(extracted.end(), std::make_move_iterator(first), std::make_move_iterator(shard.orders.end()));
+            shard.orders.erase(first, shard.orders.end());
+            orderCount.fetch_sub(moved, std::memory_order_relaxed);
+            rebuildIndex(shard);
+        }
+        return extracted;
+    }
+
+    // ==================== 读取（只持分片锁，返回副本） ====================
+    bool copy(std::string_view orderId, Order& result) const {
+        for (size_t i = 0; i < shardCount; ++i) {
+            const Shard& shard = shards[i];
+            std::lock_guard<std::mutex> guard(shard.mutex);
+            auto it = shard.byId.find(orderId);
+            if (it != shard.byId.end()) {
+                result = shard.orders[it->second];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<Order> getByUser(std::string_view username) const {
+        std::vector<Order> result;
+        const Shard& shard = shardFor(username);
+        std::lock_guard<std::mutex> guard(shard.mutex);
+        auto it = shard.byUser.find(username);
+        if (it == shard.byUser.end()) return result;
+        result.reserve(it->second.size());
+        for (uint32_t position : it->second) {
+            result.push_back(shard.orders[position]);
+        }
+        return result;
+    }
+
+    /**
+     * @brief 汇集全部热订单（按分片顺序，各分片内按下单顺序）
+     */
+    std::vector<Order> getAll() const {
+        std::vector<Order> result;
+        result.reserve(size());
+        for (size_t i = 0; i < shardCount; ++i) {
+            std::lock_guard<std::mutex> guard(shards[i].mutex);
+            result.insert(result.end(), shards[i].orders.begin(), shards[i].orders.end());
+        }
+        return result;
+    }
+
+    // ==================== 全表访问（调用方排除并发写入，不加分片锁） ====================
+    template <typename Visitor>
+    void forEach(Visitor&& visitor) const {
+        for (size_t i = 0; i < shardCount; ++i) {
+            for (const Order& order : shards[i].orders) {
+                visitor(order);
+            }
+        }
+    }
+
+    // visitor(const std::vector<Order>&)，用于把各分片作为独立数据源并行扫描
+    template <typename Visitor>
+    void forEachShard(Visitor&& visitor) const {
+        for (size_t i = 0; i < shardCount; ++i) {
+            visitor(shards[i].orders);
+        }
+    }
+
+    /**
+     * @brief 已发货和已完成订单的金额合计，逐个分片加锁
+     */
+    Money sumSales() const {
+        Money total;
+        for (size_t i = 0; i < shardCount; ++i) {
+            std::lock_guard<std::mutex> guard(shards[i].mutex);
+            total += Money::sum(shards[i].salesCents);
+        }
+        return total;
+    }
+
+    size_t size() const { return orderCount.load(std::memory_order_relaxed); }
+    size_t getShardCount() const { return shardCount; }
+
+    // ==================== 内存统计 ====================
+    /**
+     * @brief 全部热订单对象的字节数（对象本身、堆上的字符串和订单项、销售额列），增量维护，不加锁
+     */
+    size_t getLiveBytes() const { return liveBytes.load(std::memory_order_relaxed); }
+
+    // 与 getLiveBytes 同一口径的单个订单字节数
+    static size_t bytesOf(const Order& order) {
+        return sizeof(Order) + order.getHeapBytes() + sizeof(int64_t);
+    }
+
+    // 订单表（按容量计，含预留空间）和两个索引，逐个分片加锁统计
+    MemoryUsage getMemoryUsage() const {
+        MemoryUsage usage;
+        for (size_t i = 0; i < shardCount; ++i) {
+            const Shard& shard = shards[i];
+            std::lock_guard<std::mutex> guard(shard.mutex);
+            usage.bytes += MemoryAccounting::ofVector(shard.orders) + MemoryAccounting::ofVector(shard.salesCents);
+            usage.items += shard.orders.size();
+            for (const Order& order : shard.orders) {
+                usage.bytes += order.getHeapBytes();
+            }
+        }
+        return usage;
+    }
+
+    MemoryUsage getIndexMemoryUsage() const {
+        MemoryUsage usage;
+        for (size_t i = 0; i < shardCount; ++i) {
+            const Shard& shard = shards[i];
+            std::lock_guard<std::mutex> guard(shard.mutex);
+            usage.bytes += MemoryAccounting::ofHashTable(shard.byId) + MemoryAccounting::ofHashTable(shard.byUser);
+            usage.items += shard.byId.size();
+            for (const auto& [orderId, position] : shard.byId) {
+                usage.bytes += MemoryAccounting::ofString(orderId);
+            }
+            for (const auto& [username, positions] : shard.byUser) {
+                usage.bytes += MemoryAccounting::ofString(username) + MemoryAccounting::ofVector(positions);
+            }
+        }
+        return usage;
+    }
+
+private:
+    struct alignas(64) Shard {
+        mutable std::mutex mutex;
+        std::vector<Order> orders;
+        StringMap<uint32_t> byId;                   ///< 订单ID -> orders 中的位置
+        StringMap<std::vector<uint32_t>> byUser;    ///< 用户名 -> 该用户订单的位置（下单顺序）
+        std::vector<int64_t> salesCents;            ///< 与 orders 对齐的销售额列（分），不计入销售额的订单为 0
+    };
+
+    size_t shardCount;
+    std::unique_ptr<Shard[]> shards;
+    std::atomic<size_t> orderCount;
+    std::atomic<size_t> liveBytes;
+
+    size_t shardIndexFor(std::string_view username) const {
+        uint64_t mixed = static_cast<uint64_t>(StringHash{}(username)) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>((mixed >> 32) % shardCount);
+    }
+
+    Shard& shardFor(std::string_view username) { return shards[shardIndexFor(username)]; }
+    const Shard& shardFor(std::string_view username) const { return shards[shardIndexFor(username)]; }
+
+    // 以下两个方法的调用方持有 shard 的锁
+    void addLocked(Shard& shard, Order order) {
+        uint32_t position = static_cast<uint32_t>(shard.orders.size());
+        shard.byId.emplace(order.getOrderId(), position);
+        shard.byUser[order.getUsername()].push_back(position);
+        shard.salesCents.push_back(salesOf(order));
+        liveBytes.fetch_add(bytesOf(order), std::memory_order_relaxed);
+        shard.orders.push_back(std::move(order));
+        orderCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    template <typename Modifier>
+    bool modifyLocked(Shard& shard, size_t position, Modifier&& modifier) {
+        Order& order = shard.orders[position];
+        size_t before = bytesOf(order);
+        if (!modifier(order)) return false;
+        shard.salesCents[position] = salesOf(order);
+        liveBytes.fetch_add(bytesOf(order) - before, std::memory_order_relaxed);  // 无符号回绕即为减去
+        return true;
+    }
+
+    // 换成新容器而不是 clear，移出大量订单后桶数组和预留空间随之释放
+    static void rebuildIndex(Shard& shard) {
+        if (shard.orders.capacity() > 2 * shard.orders.size() + 64) shard.orders.shrink_to_fit();
+        shard.byId = StringMap<uint32_t>();
+        shard.byId.reserve(shard.orders.size());
+        shard.byUser = StringMap<std::vector<uint32_t>>();
+        shard.salesCents = std::vector<int64_t>();
+        shard.salesCents.reserve(shard.orders.size());
+        for (size_t position = 0; position < shard.orders.size(); ++position) {
+            const Order& order = shard.orders[position];
+            shard.byId.emplace(order.getOrderId(), static_cast<uint32_t>(position));
+            shard.byUser[order.getUsername()].push_back(static_cast<uint32_t>(position));
+            shard.salesCents.push_back(salesOf(order));
+        }
+    }
+
+    // 与 DatabaseManager::getTotalSales 口径一致：只计已发货和已完成的订单
+    static int64_t salesOf(const Order& order) {
+        const std::string& status = order.getStatus();
+        return status == "completed" || status == "shipped" ? order.getTotalAmount().getCents() : 0;
+    }
+};
+
+#endif // ORDERSTORE_H
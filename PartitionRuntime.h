@@ -0,0 +1,638 @@
+﻿#ifndef PARTITIONRUNTIME_H
+#define PARTITIONRUNTIME_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "DatabaseManager.h"
+#include "Order.h"
+#include "SpscQueue.h"
+#include "StringHash.h"
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/**
+ * @brief 下单请求中的一行
+ */
+struct CheckoutLine {
+    std::string productId;
+    int quantity = 0;
+};
+
+/**
+ * @brief 分区运行时的统计信息（各分区累加）
+ */
+struct PartitionStats {
+    uint64_t messages = 0;        ///< 经队列收到的消息数
+    uint64_t remoteMessages = 0;  ///< 其中来自其他分区的消息
+    uint64_t orders = 0;          ///< 成功的下单数
+    uint64_t failedCheckouts = 0;
+    uint64_t crossPartitionCheckouts = 0;  ///< 需要其他分区参与的下单数
+};
+
+/**
+ * @brief 分区运行时 - 每个分区一个线程（可绑核），分区间只通过消息通信
+ *
+ * 商品按商品ID哈希、用户按用户名哈希分配到分区：一个商品的库存只由所属分区扣减和归还，
+ * 一个用户的下单和取消只由所属分区提交，运行时内同一商品的库存写入不会在多个线程之间争锁。
+ * 每对（客户端, 分区）和（分区, 分区）之间各有一条单生产者单消费者的无锁队列。
+ *
+ * 数据就是 DatabaseManager 中的商品表和订单表，运行时不保存副本：库存经数据库事务扣减和归还，
+ * 订单经数据库事务写入热订单表和订单日志，与加锁模式的下单、取消互相可见，重启后由订单日志恢复。
+ *
+ * 下单由用户所在的分区（主分区）协调：按商品所属分区分组后发出预留请求，各分区以一个事务检查并扣减
+ * 本分区的库存后回复；全部成功则主分区以事务追加订单并回复客户端，任一失败则向已扣减的分区发出归还请求（补偿）。
+ * 预留期间其他下单可能看到已扣减的库存，但不会超卖。取消订单时主分区以事务改状态后异步归还库存。
+ *
+ * 客户端对象属于单个线程，每次只有一个未完成的请求，发出后等待结果；下单、取消成功后用 waitDurable
+ * 等待订单日志落盘。分区线程提交事务时可能取引擎锁归档订单，因此持有引擎锁时不得调用客户端。
+ * ShopSystem::setPartitionClient 把会话的下单、取消和库存查询切换到运行时。
+ */
+class PartitionRuntime {
+private:
+    struct Completion {
+        std::atomic<bool> done{ false };
+        bool ok = false;
+        int value = 0;
+        uint64_t journalSequence = 0;  ///< 下单、取消写入的订单日志序号
+        std::string error;
+        Order order;
+
+        // 由分区线程调用，写完结果后唤醒客户端
+        void complete(bool success, std::string message = std::string()) {
+            ok = success;
+            error = std::move(message);
+            done.store(true, std::memory_order_release);
+            done.notify_one();
+        }
+    };
+
+    struct Message {
+        enum class Type : uint8_t {
+            Checkout,      ///< 客户端 -> 主分区
+            Cancel,        ///< 客户端 -> 主分区
+            StockQuery,    ///< 客户端 -> 商品所属分区
+            Reserve,       ///< 主分区 -> 商品所属分区：检查并扣减库存
+            ReserveReply,  ///< 商品所属分区 -> 主分区：ok 表示已扣减，items 带回名称、单价和卖家
+            Release        ///< 主分区 -> 商品所属分区：归还库存
+        };
+
+        Type type = Type::Checkout;
+        bool ok = false;
+        uint32_t from = 0;      ///< 发送方分区（分区间消息）
+        uint64_t request = 0;   ///< 主分区上的下单请求编号
+        Completion* completion = nullptr;
+        std::string key;        ///< 用户名或商品ID
+        std::string text;       ///< 订单ID或失败原因
+        std::string address;
+        std::string payment;
+        std::string phone;
+        std::vector<OrderItem> items;
+    };
+
+public:
+    /**
+     * @brief 客户端句柄，由 connect 创建，只能在一个线程中使用
+     */
+    class Client {
+    public:
+        /**
+         * @brief 下单，库存不足或商品不存在、已下架时整单失败且不扣减任何库存
+         * @param phone 买家手机号
+         */
+        bool checkout(const std::string& username, const std::vector<CheckoutLine>& lines,
+            std::string address, std::string payment, std::string phone, Order& result, std::string& error) {
+            Message message;
+            message.type = Message::Type::Checkout;
+            message.key = username;
+            message.address = std::move(address);
+            message.payment = std::move(payment);
+            message.phone = std::move(phone);
+            message.items.reserve(lines.size());
+            for (const CheckoutLine& line : lines) {
+                message.items.emplace_back(line.productId, "", line.quantity, Money(), "", "");
+            }
+            if (!call(runtime.partitionOfUser(username), std::move(message))) {
+                error = std::move(completion.error);
+                return false;
+            }
+            result = std::move(completion.order);
+            return true;
+        }
+
+        // 只能取消 username 自己的订单；库存在返回后由商品所属分区异步归还
+        bool cancelOrder(const std::string& username, const std::string& orderId, std::string& error) {
+            Message message;
+            message.type = Message::Type::Cancel;
+            message.key = username;
+            message.text = orderId;
+            if (!call(runtime.partitionOfUser(username), std::move(message))) {
+                error = std::move(completion.error);
+                return false;
+            }
+            return true;
+        }
+
+        // 商品不存在时返回 -1
+        int getStock(const std::string& productId) {
+            Message message;
+            message.type = Message::Type::StockQuery;
+            message.key = productId;
+            call(runtime.partitionOfProduct(productId), std::move(message));
+            return completion.value;
+        }
+
+        /**
+         * @brief 等待上一次成功的下单或取消写入的订单日志落盘
+         * @return 日志写入或同步失败时返回 false；未写日志时返回 true
+         */
+        bool waitDurable() {
+            return runtime.db.waitOrderJournal(completion.journalSequence);
+        }
+
+    private:
+        friend class PartitionRuntime;
+        Client(PartitionRuntime& runtime, size_t slot) : runtime(runtime), slot(slot) {}
+
+        PartitionRuntime& runtime;
+        size_t slot;
+        Completion completion;
+
+        bool call(size_t partition, Message&& message) {
+            completion.done.store(false, std::memory_order_relaxed);
+            completion.journalSequence = 0;
+            message.completion = &completion;
+            runtime.clientSent[slot].count.fetch_add(1, std::memory_order_relaxed);
+            runtime.push(runtime.clientQueue(slot, partition), std::move(message), partition);
+            completion.done.wait(false, std::memory_order_acquire);
+            return completion.ok;
+        }
+    };
+
+    /**
+     * @param db 运行时读写的数据库，生命周期须长于本对象
+     * @param partitionCount 分区数（即工作线程数）
+     * @param maxClients 最多可连接的客户端数
+     */
+    PartitionRuntime(DatabaseManager& db, size_t partitionCount, size_t maxClients)
+        : db(db), partitionCount(partitionCount == 0 ? 1 : partitionCount), maxClients(maxClients),
+        partitions(std::make_unique<Partition[]>(this->partitionCount)),
+        clientSent(std::make_unique<Counter[]>(maxClients)), connectedClients(0), stopping(false) {
+        clientQueues.reserve(maxClients * this->partitionCount);
+        for (size_t i = 0; i < maxClients * this->partitionCount; ++i) {
+            clientQueues.push_back(std::make_unique<SpscQueue<Message>>(CLIENT_QUEUE_CAPACITY));
+        }
+        peerQueues.reserve(this->partitionCount * this->partitionCount);
+        for (size_t i = 0; i < this->partitionCount * this->partitionCount; ++i) {
+            peerQueues.push_back(std::make_unique<SpscQueue<Message>>(PEER_QUEUE_CAPACITY));
+        }
+        for (size_t i = 0; i < this->partitionCount; ++i) {
+            partitions[i].index = i;
+            partitions[i].outbox.resize(this->partitionCount);
+        }
+    }
+
+    PartitionRuntime(const PartitionRuntime&) = delete;
+    PartitionRuntime& operator=(const PartitionRuntime&) = delete;
+
+    ~PartitionRuntime() {
+        stop();
+    }
+
+    /**
+     * @brief 启动分区线程
+     * @param pinThreads 是否把第 i 个分区线程绑定到第 i 个核心（超出核心数时取模）
+     */
+    void start(bool pinThreads = false) {
+        unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+        for (size_t i = 0; i < partitionCount; ++i) {
+            Partition& partition = partitions[i];
+            partition.thread = std::thread([this, &partition] { run(partition); });
+            if (pinThreads) pinToCore(partition.thread, i % cores);
+        }
+    }
+
+    /**
+     * @brief 等待所有在途消息处理完后停止分区线程；调用前客户端须已停止发送请求
+     */
+    void stop() {
+        if (stopping.load() || !partitions[0].thread.joinable()) return;
+        while (!quiescent()) {
+            std::this_thread::yield();
+        }
+        stopping.store(true);
+        for (size_t i = 0; i < partitionCount; ++i) {
+            wake(partitions[i]);
+        }
+        for (size_t i = 0; i < partitionCount; ++i) {
+            partitions[i].thread.join();
+        }
+    }
+
+    /**
+     * @brief 创建客户端，客户端数达到上限时返回空指针
+     */
+    std::unique_ptr<Client> connect() {
+        size_t slot = connectedClients.fetch_add(1);
+        if (slot >= maxClients) return nullptr;
+        return std::unique_ptr<Client>(new Client(*this, slot));
+    }
+
+    size_t partitionOfProduct(std::string_view productId) const { return hashToPartition(productId); }
+    size_t partitionOfUser(std::string_view username) const { return hashToPartition(username); }
+    size_t getPartitionCount() const { return partitionCount; }
+
+    // 各分区的计数器按分区线程写入，运行中读取为近似值
+    PartitionStats getStats() const {
+        PartitionStats stats;
+        for (size_t i = 0; i < partitionCount; ++i) {
+            const Partition& partition = partitions[i];
+            stats.messages += partition.handled.load(std::memory_order_relaxed);
+            stats.remoteMessages += partition.remoteMessages.load(std::memory_order_relaxed);
+            stats.orders += partition.orderCount.load(std::memory_order_relaxed);
+            stats.failedCheckouts += partition.failedCheckouts.load(std::memory_order_relaxed);
+            stats.crossPartitionCheckouts += partition.crossCheckouts.load(std::memory_order_relaxed);
+        }
+        return stats;
+    }
+
+private:
+    static constexpr size_t CLIENT_QUEUE_CAPACITY = 4;  ///< 客户端同时只有一个请求
+    static constexpr size_t PEER_QUEUE_CAPACITY = 128;  ///< 满时暂存到发送方的待发队列
+    static constexpr int IDLE_SPINS = 256;               ///< 连续空转多少轮后休眠等待
+
+    // 主分区上等待预留结果的下单
+    struct PendingCheckout {
+        Completion* completion = nullptr;
+        std::string username;
+        std::string address;
+        std::string payment;
+        std::string phone;
+        std::vector<OrderItem> items;  ///< 已预留成功的行（带名称和单价）
+        std::vector<std::pair<size_t, std::vector<OrderItem>>> reserved;  ///< (分区, 该分区扣减的行)
+        size_t waiting = 0;
+        std::string error;
+    };
+
+    struct alignas(64) Counter {
+        std::atomic<uint64_t> count{ 0 };
+    };
+
+    struct alignas(64) Partition {
+        size_t index = 0;
+        std::unordered_map<uint64_t, PendingCheckout> pending;
+        uint64_t nextRequest = 0;
+        std::vector<std::deque<Message>> outbox;  ///< 发往各分区、因队列满暂存的消息
+        size_t outboxSize = 0;
+
+        std::atomic<bool> sleeping{ false };
+        std::atomic<uint32_t> doorbell{ 0 };
+        std::atomic<uint64_t> sent{ 0 };      ///< 发往其他分区的消息数（用于停止时判断是否还有在途消息）
+        std::atomic<uint64_t> handled{ 0 };   ///< 从队列收到并处理的消息数
+        std::atomic<uint64_t> remoteMessages{ 0 };
+        std::atomic<uint64_t> orderCount{ 0 };
+        std::atomic<uint64_t> failedCheckouts{ 0 };
+        std::atomic<uint64_t> crossCheckouts{ 0 };
+        std::thread thread;
+    };
+
+    DatabaseManager& db;
+    size_t partitionCount;
+    size_t maxClients;
+    std::unique_ptr<Partition[]> partitions;
+    std::vector<std::unique_ptr<SpscQueue<Message>>> clientQueues;  ///< [客户端][分区]
+    std::vector<std::unique_ptr<SpscQueue<Message>>> peerQueues;  ///< [发送分区][接收分区]
+    std::unique_ptr<Counter[]> clientSent;
+    std::atomic<size_t> connectedClients;
+    std::atomic<bool> stopping;
+
+    size_t hashToPartition(std::string_view key) const {
+        uint64_t mixed = static_cast<uint64_t>(StringHash{}(key)) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>((mixed >> 32) % partitionCount);
+    }
+
+    SpscQueue<Message>& clientQueue(size_t slot, size_t partition) {
+        return *clientQueues[slot * partitionCount + partition];
+    }
+
+    SpscQueue<Message>& peerQueue(size_t from, size_t to) {
+        return *peerQueues[from * partitionCount + to];
+    }
+
+    // ==================== 消息收发 ====================
+    // 客户端发送：客户端队列只有一个在途请求，不会长时间满
+    void push(SpscQueue<Message>& queue, Message&& message, size_t partition) {
+        while (!queue.tryPush(std::move(message))) {
+            std::this_thread::yield();
+        }
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (partitions[partition].sleeping.load()) wake(partitions[partition]);
+    }
+
+    static void wake(Partition& partition) {
+        partition.doorbell.fetch_add(1);
+        partition.doorbell.notify_one();
+    }
+
+    // 分区间发送：目标是自己时直接处理；队列满时放入待发队列，避免两个分区互相等待
+    void send(Partition& self, size_t to, Message&& message) {
+        if (to == self.index) {
+            handle(self, std::move(message));
+            return;
+        }
+        message.from = static_cast<uint32_t>(self.index);
+        self.sent.fetch_add(1, std::memory_order_relaxed);
+        if (!self.outbox[to].empty() || !peerQueue(self.index, to).tryPush(std::move(message))) {
+            self.outbox[to].push_back(std::move(message));
+            ++self.outboxSize;
+            return;
+        }
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (partitions[to].sleeping.load()) wake(partitions[to]);
+    }
+
+    void flushOutbox(Partition& self) {
+        for (size_t to = 0; to < partitionCount && self.outboxSize > 0; ++to) {
+            std::deque<Message>& pendingMessages = self.outbox[to];
+            bool pushed = false;
+            while (!pendingMessages.empty() && peerQueue(self.index, to).tryPush(std::move(pendingMessages.front()))) {
+                pendingMessages.pop_front();
+                --self.outboxSize;
+                pushed = true;
+            }
+            if (pushed) {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (partitions[to].sleeping.load()) wake(partitions[to]);
+            }
+        }
+    }
+
+    // 一轮从每条入队列各取一批消息，返回处理的条数
+    size_t poll(Partition& self) {
+        static constexpr int BATCH = 32;
+        size_t processed = 0;
+        Message message;
+        for (size_t slot = 0; slot < maxClients; ++slot) {
+            SpscQueue<Message>& queue = clientQueue(slot, self.index);
+            for (int i = 0; i < BATCH && queue.tryPop(message); ++i) {
+                handle(self, std::move(message));
+                ++processed;
+            }
+        }
+        for (size_t from = 0; from < partitionCount; ++from) {
+            if (from == self.index) continue;
+            SpscQueue<Message>& queue = peerQueue(from, self.index);
+            for (int i = 0; i < BATCH && queue.tryPop(message); ++i) {
+                self.remoteMessages.fetch_add(1, std::memory_order_relaxed);
+                handle(self, std::move(message));
+                ++processed;
+            }
+        }
+        // 只统计经队列收到的消息，与发送方的计数对应（发给自己的消息直接处理，两边都不计）
+        if (processed > 0) self.handled.fetch_add(processed, std::memory_order_relaxed);
+        return processed;
+    }
+
+    void run(Partition& self) {
+        int idle = 0;
+        while (true) {
+            size_t processed = poll(self);
+            if (self.outboxSize > 0) flushOutbox(self);
+            if (processed > 0 || self.outboxSize > 0) {
+                idle = 0;
+                continue;
+            }
+            if (stopping.load()) break;
+            if (++idle < IDLE_SPINS) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            // 休眠前登记并再检查一次，发送方入队后看到 sleeping 即会按门铃
+            uint32_t ring = self.doorbell.load();
+            self.sleeping.store(true);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (poll(self) == 0 && !stopping.load()) {
+                self.doorbell.wait(ring);
+            }
+            self.sleeping.store(false);
+            idle = 0;
+        }
+    }
+
+    // 所有客户端和分区发出的消息都已处理（先读已处理数再读已发送数，两者相等说明此刻没有在途消息）
+    bool quiescent() const {
+        uint64_t handled = 0;
+        for (size_t i = 0; i < partitionCount; ++i) {
+            handled += partitions[i].handled.load();
+        }
+        uint64_t sent = 0;
+        for (size_t i = 0; i < partitionCount; ++i) {
+            sent += partitions[i].sent.load();
+        }
+        for (size_t slot = 0; slot < maxClients; ++slot) {
+            sent += clientSent[slot].count.load();
+        }
+        return handled == sent;
+    }
+
+    static void pinToCore(std::thread& thread, size_t core) {
+        #ifdef _WIN32
+        SetThreadAffinityMask(thread.native_handle(), DWORD_PTR(1) << (core % (8 * sizeof(DWORD_PTR))));
+        #elif defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(core, &set);
+        pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+        #else
+        (void)thread;
+        (void)core;
+        #endif
+    }
+
+    // ==================== 消息处理（只在所属分区线程中执行） ====================
+    void handle(Partition& self, Message&& message) {
+        switch (message.type) {
+        case Message::Type::Checkout: startCheckout(self, std::move(message)); break;
+        case Message::Type::Cancel: cancelOrder(self, message); break;
+        case Message::Type::StockQuery: {
+            std::optional<Product> product = db.getProduct(message.key);
+            message.completion->value = product ? product->getStock() : -1;
+            message.completion->complete(product.has_value());
+            break;
+        }
+        case Message::Type::Reserve: reserve(self, std::move(message)); break;
+        case Message::Type::ReserveReply: onReserveReply(self, std::move(message)); break;
+        case Message::Type::Release: release(self, message); break;
+        }
+    }
+
+    void startCheckout(Partition& self, Message&& message) {
+        Completion* completion = message.completion;
+        if (message.items.empty()) {
+            self.failedCheckouts.fetch_add(1, std::memory_order_relaxed);
+            completion->complete(false, "购物车为空");
+            return;
+        }
+
+        // 按商品所属分区分组
+        std::vector<std::vector<OrderItem>> groups(partitionCount);
+        for (OrderItem& item : message.items) {
+            groups[partitionOfProduct(item.getProductId())].push_back(std::move(item));
+        }
+
+        uint64_t request = ++self.nextRequest;
+        PendingCheckout& pending = self.pending[request];
+        pending.completion = completion;
+        pending.username = std::move(message.key);
+        pending.address = std::move(message.address);
+        pending.payment = std::move(message.payment);
+        pending.phone = std::move(message.phone);
+        for (const auto& group : groups) {
+            if (!group.empty()) ++pending.waiting;
+        }
+        if (pending.waiting > 1 || groups[self.index].empty()) {
+            self.crossCheckouts.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        for (size_t owner = 0; owner < partitionCount; ++owner) {
+            if (groups[owner].empty()) continue;
+            Message reserveMessage;
+            reserveMessage.type = Message::Type::Reserve;
+            reserveMessage.request = request;
+            reserveMessage.from = static_cast<uint32_t>(self.index);
+            reserveMessage.items = std::move(groups[owner]);
+            send(self, owner, std::move(reserveMessage));
+        }
+    }
+
+    // 以一个事务检查并扣减本分区商品的库存，任一行失败则整组不扣减
+    void reserve(Partition& self, Message&& message) {
+        auto transaction = db.beginTransaction();
+        for (OrderItem& item : message.items) {
+            std::optional<Product> product = db.getProduct(item.getProductId());
+            if (!product || !product->getIsActive()) {
+                message.text = "商品 " + item.getProductId() + " 不存在或已下架";
+                break;
+            }
+            if (item.getQuantity() <= 0) {
+                message.text = "商品 " + item.getProductId() + " 库存不足";
+                break;
+            }
+            transaction.reduceStock(item.getProductId(), item.getQuantity());
+            item = OrderItem(product->getId(), product->getName(), item.getQuantity(), product->getPrice(),
+                product->getSellerUsername(), product->getSellerPhone());
+        }
+        message.ok = message.text.empty() && transaction.commit();
+        if (!message.ok && message.text.empty()) {
+            message.text = transaction.getError();
+        }
+
+        size_t home = message.from;
+        message.type = Message::Type::ReserveReply;
+        message.from = static_cast<uint32_t>(self.index);
+        send(self, home, std::move(message));
+    }
+
+    void onReserveReply(Partition& self, Message&& message) {
+        auto it = self.pending.find(message.request);
+        if (it == self.pending.end()) return;
+        PendingCheckout& pending = it->second;
+
+        if (message.ok) {
+            pending.items.insert(pending.items.end(), message.items.begin(), message.items.end());
+            pending.reserved.emplace_back(message.from, std::move(message.items));
+        }
+        else if (pending.error.empty()) {
+            pending.error = std::move(message.text);
+        }
+        if (--pending.waiting > 0) return;
+
+        Completion* completion = pending.completion;
+        if (pending.error.empty()) {
+            // 库存已全部预留，事务只追加订单（畅销榜、卖家汇总和订单日志随之更新）
+            Order order(std::move(pending.username), std::move(pending.items),
+                std::move(pending.address), std::move(pending.payment), std::move(pending.phone));
+            auto transaction = db.beginTransaction();
+            transaction.addOrder(order);
+            if (transaction.commit()) {
+                self.pending.erase(it);
+                completion->journalSequence = transaction.getJournalSequence();
+                completion->order = std::move(order);
+                self.orderCount.fetch_add(1, std::memory_order_relaxed);
+                completion->complete(true);
+                return;
+            }
+            pending.error = transaction.getError();
+        }
+
+        // 补偿：归还已扣减的库存
+        for (auto& [owner, items] : pending.reserved) {
+            Message releaseMessage;
+            releaseMessage.type = Message::Type::Release;
+            releaseMessage.items = std::move(items);
+            send(self, owner, std::move(releaseMessage));
+        }
+        std::string error = std::move(pending.error);
+        self.pending.erase(it);
+        self.failedCheckouts.fetch_add(1, std::memory_order_relaxed);
+        completion->complete(false, std::move(error));
+    }
+
+    void cancelOrder(Partition& self, const Message& message) {
+        Order order;
+        if (!db.copyOrder(message.text, order) || order.getUsername() != message.key) {
+            message.completion->complete(false, "订单不存在");
+            return;
+        }
+        // 状态是否还能取消由事务在分片锁内判断，同一订单只会被取消一次
+        auto transaction = db.beginTransaction();
+        transaction.cancelOrder(message.text);
+        if (!transaction.commit()) {
+            message.completion->complete(false, "订单无法取消");
+            return;
+        }
+        message.completion->journalSequence = transaction.getJournalSequence();
+
+        std::vector<std::vector<OrderItem>> groups(partitionCount);
+        for (const OrderItem& item : order.getItems()) {
+            groups[partitionOfProduct(item.getProductId())].push_back(item);
+        }
+        for (size_t owner = 0; owner < partitionCount; ++owner) {
+            if (groups[owner].empty()) continue;
+            Message releaseMessage;
+            releaseMessage.type = Message::Type::Release;
+            releaseMessage.items = std::move(groups[owner]);
+            send(self, owner, std::move(releaseMessage));
+        }
+        message.completion->complete(true);
+    }
+
+    // 逐行归还，已删除的商品不再归还
+    void release(Partition&, const Message& message) {
+        for (const OrderItem& item : message.items) {
+            db.increaseStock(item.getProductId(), item.getQuantity());
+        }
+    }
+};
+
+#endif // PARTITIONRUNTIME_H
@@ -6,6 +6,30 @@
 #include <sstream>
 #include <vector>
 #include <iomanip>
+#include <utility>
+#include "Money.h"
+#include "MemoryUsage.h"
+
+class ProductView;
+
+/**
+ * @brief 显示商品详情；Product 和紧凑记录的视图 ProductView 共用这一种格式
+ */
+template <typename ProductLike>
+void printProductInfo(const ProductLike& product) {
+    std::cout << "商品ID: " << product.getId() << std::endl;
+    std::cout << "商品名称: " << product.getName() << std::endl;
+    std::cout << "分类: " << product.getCategory() << std::endl;
+    std::cout << "价格: Y" << product.getPrice() << std::endl;
+    std::cout << "库存: " << product.getStock() << std::endl;
+    std::cout << "状态: " << (product.getIsActive() ? "上架" : "下架") << std::endl;
+    std::cout << "卖家: " << product.getSellerUsername() << std::endl;
+    std::cout << "卖家手机: " << product.getSellerPhone() << std::endl;
+    if (!product.getDescription().empty()) {
+        std::cout << "描述: " << product.getDescription() << std::endl;
+    }
+    std::cout << "------------------------" << std::endl;
+}
 
 /**
  * @brief 商品类 - 管理商品信息
@@ -15,65 +39,57 @@ private:
     std::string id;
     std::string name;
     std::string category;
-    double price;
+    Money price;
     int stock;
     std::string description;
     bool isActive;
     std::string sellerUsername;  // 新增：卖家用户名
     std::string sellerPhone;     // 新增：卖家手机号
 
+    friend class ProductView;    // 由紧凑记录还原时直接写入各字段
+
 public:
-    Product() : price(0.0), stock(0), isActive(true) {}
-
-    Product(const std::string& id, const std::string& name, const std::string& category,
-        double price, int stock, const std::string& description = "",
-        bool isActive = true, const std::string& sellerUsername = "",
-        const std::string& sellerPhone = "")
-        : id(id), name(name), category(category), price(price), stock(stock),
-        description(description), isActive(isActive), sellerUsername(sellerUsername),
-        sellerPhone(sellerPhone) {
+    Product() : stock(0), isActive(true) {}
+
+    // 字符串参数按值传入再移动
+    Product(std::string id, std::string name, std::string category,
+        Money price, int stock, std::string description = "",
+        bool isActive = true, std::string sellerUsername = "",
+        std::string sellerPhone = "")
+        : id(std::move(id)), name(std::move(name)), category(std::move(category)), price(price), stock(stock),
+        description(std::move(description)), isActive(isActive), sellerUsername(std::move(sellerUsername)),
+        sellerPhone(std::move(sellerPhone)) {
     }
 
-    // Getter方法
-    std::string getId() const { return id; }
-    std::string getName() const { return name; }
-    std::string getCategory() const { return category; }
-    double getPrice() const { return price; }
+    // Getter方法（返回常量引用）
+    const std::string& getId() const { return id; }
+    const std::string& getName() const { return name; }
+    const std::string& getCategory() const { return category; }
+    Money getPrice() const { return price; }
     int getStock() const { return stock; }
-    std::string getDescription() const { return description; }
+    const std::string& getDescription() const { return description; }
     bool getIsActive() const { return isActive; }
-    std::string getSellerUsername() const { return sellerUsername; }  // 新增
-    std::string getSellerPhone() const { return sellerPhone; }        // 新增
+    const std::string& getSellerUsername() const { return sellerUsername; }  // 新增
+    const std::string& getSellerPhone() const { return sellerPhone; }        // 新增
 
     // Setter方法
-    void setName(const std::string& newName) { name = newName; }
-    void setCategory(const std::string& newCategory) { category = newCategory; }
-    void setPrice(double newPrice) { price = newPrice; }
+    void setName(std::string newName) { name = std::move(newName); }
+    void setCategory(std::string newCategory) { category = std::move(newCategory); }
+    void setPrice(Money newPrice) { price = newPrice; }
     void setStock(int newStock) { stock = newStock; }
-    void setDescription(const std::string& newDescription) { description = newDescription; }
+    void setDescription(std::string newDescription) { description = std::move(newDescription); }
     void setIsActive(bool active) { isActive = active; }
-    void setSellerUsername(const std::string& username) { sellerUsername = username; }  // 新增
-    void setSellerPhone(const std::string& phone) { sellerPhone = phone; }              // 新增
+    void setSellerUsername(std::string username) { sellerUsername = std::move(username); }  // 新增
+    void setSellerPhone(std::string phone) { sellerPhone = std::move(phone); }              // 新增
 
     // 业务方法
     void displayInfo() const {
-        std::cout << "商品ID: " << id << std::endl;
-        std::cout << "商品名称: " << name << std::endl;
-        std::cout << "分类: " << category << std::endl;
-        std::cout << "价格: Y" << std::fixed << std::setprecision(2) << price << std::endl;
-        std::cout << "库存: " << stock << std::endl;
-        std::cout << "状态: " << (isActive ? "上架" : "下架") << std::endl;
-        std::cout << "卖家: " << sellerUsername << std::endl;        // 新增
-        std::cout << "卖家手机: " << sellerPhone << std::endl;       // 新增
-        if (!description.empty()) {
-            std::cout << "描述: " << description << std::endl;
-        }
-        std::cout << "------------------------" << std::endl;
+        printProductInfo(*this);
     }
 
     // 简略显示，用于列表
     void displayBriefInfo() const {
-        std::cout << id << " | " << name << " | Y" << std::fixed << std::setprecision(2) << price
+        std::cout << id << " | " << name << " | Y" << price
             << " | 库存:" << stock << " | " << (isActive ? "上架" : "下架")
             << " | 卖家:" << sellerUsername << std::endl;
     }
@@ -83,7 +99,7 @@ public:
         std::cout << "商品ID: " << id << std::endl;
         std::cout << "商品名称: " << name << std::endl;
         std::cout << "分类: " << category << std::endl;
-        std::cout << "价格: Y" << std::fixed << std::setprecision(2) << price << std::endl;
+        std::cout << "价格: Y" << price << std::endl;
         std::cout << "库存: " << stock << std::endl;
         std::cout << "卖家: " << sellerUsername << std::endl;
         if (!description.empty()) {
@@ -127,6 +143,13 @@ public:
         return stock >= quantity;
     }
 
+    // 字符串占用的堆内存（不含对象本身）
+    size_t getHeapBytes() const {
+        return MemoryAccounting::ofString(id) + MemoryAccounting::ofString(name) + MemoryAccounting::ofString(category) +
+            MemoryAccounting::ofString(description) + MemoryAccounting::ofString(sellerUsername) +
+            MemoryAccounting::ofString(sellerPhone);
+    }
+
     // 序列化方法
     std::string toString() const {
         std::ostringstream oss;
@@ -147,22 +170,14 @@ public:
 
         if (tokens.size() >= 6) {
             bool active = true;
-            std::string sellerUser = "";
-            std::string sellerPhone = "";
-
             if (tokens.size() > 6) {
                 active = (tokens[6] == "1" || tokens[6] == "true");
             }
-            if (tokens.size() > 7) {
-                sellerUser = tokens[7];
-            }
-            if (tokens.size() > 8) {
-                sellerPhone = tokens[8];
-            }
+            tokens.resize(9);  // 缺失的卖家字段补为空串
 
-            return Product(tokens[0], tokens[1], tokens[2],
-                std::stod(tokens[3]), std::stoi(tokens[4]),
-                tokens.size() > 5 ? tokens[5] : "", active, sellerUser, sellerPhone);
+            return Product(std::move(tokens[0]), std::move(tokens[1]), std::move(tokens[2]),
+                Money::fromString(tokens[3]), std::stoi(tokens[4]),
+                std::move(tokens[5]), active, std::move(tokens[7]), std::move(tokens[8]));
         }
         return Product();
     }
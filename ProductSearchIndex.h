@@ -0,0 +1,335 @@
+﻿#ifndef PRODUCTSEARCHINDEX_H
+#define PRODUCTSEARCHINDEX_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Product.h"
+#include "Utf8Text.h"
+#include "MemoryUsage.h"
+
+/**
+ * @brief 相关度搜索的一页结果
+ */
+struct SearchPage {
+    std::vector<Product> products;  ///< 本页商品，按相关度降序
+    std::vector<double> scores;     ///< 与 products 一一对应的得分
+    size_t totalHits = 0;           ///< 命中的商品总数
+    size_t page = 0;                ///< 页码，从 0 开始
+    size_t pageSize = 0;
+
+    size_t getPageCount() const {
+        return pageSize == 0 ? 0 : (totalHits + pageSize - 1) / pageSize;
+    }
+};
+
+/**
+ * @brief 单条命中
+ */
+struct SearchHit {
+    size_t position;  ///< 商品位置
+    double score;
+};
+
+/**
+ * @brief 商品相关度搜索索引 - 名称和描述的倒排 + BM25 打分 + 堆选前 K
+ *
+ * 分词：连续的 ASCII 字母数字为一个词（转小写）；中文等其他字符按连续片段切成相邻二字词，
+ * 文档同时登记单字，查询只在片段仅一个字时使用单字，避免"手机"同时命中所有含"机"的商品。
+ * 打分为简化的 BM25F：名称和描述各自按长度归一化词频，名称乘以 NAME_BOOST 后合并，
+ * 再做 BM25 饱和并乘以 IDF，各查询词得分相加（任一词命中即为结果）。
+ * 外部信号（库存、销量等）由调用方以有上界的加分提供：文本得分按堆依次取出，
+ * 只有文本得分加上加分上界仍可能进入前 K 的商品才计算加分，最终只返回请求的一页。
+ */
+class ProductSearchIndex {
+public:
+    static constexpr double K1 = 1.2;
+    static constexpr double B = 0.75;
+    static constexpr double NAME_BOOST = 3.0;
+
+    /**
+     * @brief 登记一个商品；位置已登记时须先用旧文本 remove
+     */
+    void add(size_t position, std::string_view name, std::string_view description) {
+        if (position >= documents.size()) documents.resize(position + 1);
+        Document& document = documents[position];
+        if (document.present) return;
+
+        std::vector<TermCount> nameTerms = countTerms(name, true);
+        std::vector<TermCount> descriptionTerms = countTerms(description, true);
+        document = Document{ true, termTotal(nameTerms), termTotal(descriptionTerms) };
+        ++documentCount;
+        nameLengthSum += document.nameLength;
+        descriptionLengthSum += document.descriptionLength;
+
+        // 两个有序列表归并，同一个词只登记一条倒排
+        size_t i = 0, j = 0;
+        while (i < nameTerms.size() || j < descriptionTerms.size()) {
+            Posting posting{ static_cast<uint32_t>(position), 0, 0 };
+            uint64_t term;
+            if (j == descriptionTerms.size() || (i < nameTerms.size() && nameTerms[i].term < descriptionTerms[j].term)) {
+                term = nameTerms[i].term;
+                posting.nameCount = nameTerms[i++].count;
+            }
+            else if (i == nameTerms.size() || descriptionTerms[j].term < nameTerms[i].term) {
+                term = descriptionTerms[j].term;
+                posting.descriptionCount = descriptionTerms[j++].count;
+            }
+            else {
+                term = nameTerms[i].term;
+                posting.nameCount = nameTerms[i++].count;
+                posting.descriptionCount = descriptionTerms[j++].count;
+            }
+            insertPosting(postings[term], posting);
+        }
+    }
+
+    /**
+     * @brief 移除一个商品，name 和 description 须为登记时的文本
+     */
+    void remove(size_t position, std::string_view name, std::string_view description) {
+        if (position >= documents.size() || !documents[position].present) return;
+
+        std::vector<TermCount> terms = countTerms(name, true);
+        std::vector<TermCount> descriptionTerms = countTerms(description, true);
+        terms.insert(terms.end(), descriptionTerms.begin(), descriptionTerms.end());
+        for (const TermCount& entry : terms) {
+            auto it = postings.find(entry.term);
+            if (it == postings.end()) continue;
+            std::vector<Posting>& list = it->second;
+            auto posting = std::lower_bound(list.begin(), list.end(), position,
+                [](const Posting& p, size_t value) { return p.position < value; });
+            if (posting != list.end() && posting->position == position) list.erase(posting);
+            if (list.empty()) postings.erase(it);
+        }
+
+        Document& document = documents[position];
+        nameLengthSum -= document.nameLength;
+        descriptionLengthSum -= document.descriptionLength;
+        --documentCount;
+        document = Document();
+    }
+
+    void clear() {
+        documents.clear();
+        postings.clear();
+        documentCount = 0;
+        nameLengthSum = 0;
+        descriptionLengthSum = 0;
+    }
+
+    /**
+     * @brief 搜索并返回按得分降序的第 [offset, offset + limit) 条
+     * @param accept 位置过滤（如只要上架商品）
+     * @param bonus 外部信号加分，取值须在 [0, maxBonus] 内
+     * @param totalHits 输出命中总数（accept 通过且至少命中一个查询词）
+     */
+    template <typename Accept, typename Bonus>
+    std::vector<SearchHit> search(std::string_view query, size_t offset, size_t limit,
+        Accept&& accept, Bonus&& bonus, double maxBonus, size_t& totalHits) {
+        totalHits = 0;
+        std::vector<SearchHit> page;
+        std::vector<TermCount> terms = countTerms(query, false);
+        if (terms.empty() || limit == 0 || documentCount == 0) return page;
+
+        // 逐词累加文本得分（term-at-a-time）
+        if (accumulators.size() < documents.size()) accumulators.resize(documents.size(), 0.0);
+        std::vector<uint32_t> touched;
+        double averageName = std::max(1.0, static_cast<double>(nameLengthSum) / documentCount);
+        double averageDescription = std::max(1.0, static_cast<double>(descriptionLengthSum) / documentCount);
+
+        for (const TermCount& entry : terms) {
+            auto it = postings.find(entry.term);
+            if (it == postings.end()) continue;
+            const std::vector<Posting>& list = it->second;
+            double documentFrequency = static_cast<double>(list.size());
+            double idf = std::log(1.0 + (documentCount - documentFrequency + 0.5) / (documentFrequency + 0.5));
+
+            for (const Posting& posting : list) {
+                const Document& document = documents[posting.position];
+                double frequency =
+                    NAME_BOOST * posting.nameCount / (1.0 - B + B * document.nameLength / averageName) +
+                    posting.descriptionCount / (1.0 - B + B * document.descriptionLength / averageDescription);
+                double& score = accumulators[posting.position];
+                if (score == 0.0) touched.push_back(posting.position);
+                score += entry.count * idf * frequency * (K1 + 1.0) / (frequency + K1);
+            }
+        }
+
+        // 所有命中按文本得分建堆（O(n)），按需逐个弹出
+        std::vector<SearchHit> candidates;
+        candidates.reserve(touched.size());
+        for (uint32_t position : touched) {
+            if (accept(position)) candidates.push_back(SearchHit{ position, accumulators[position] });
+            accumulators[position] = 0.0;
+        }
+        totalHits = candidates.size();
+        if (offset >= totalHits) return page;
+
+        auto lower = [](const SearchHit& a, const SearchHit& b) {
+            return a.score != b.score ? a.score < b.score : a.position > b.position;
+        };
+        std::make_heap(candidates.begin(), candidates.end(), lower);
+
+        // 最终得分的前 K 名用小顶堆维护；剩余最高的文本得分加上加分上界都进不了前 K 时停止
+        size_t wanted = offset + limit;
+        std::vector<SearchHit> best;
+        best.reserve(wanted + 1);
+        auto higher = [&](const SearchHit& a, const SearchHit& b) { return lower(b, a); };
+        while (!candidates.empty()) {
+            const SearchHit& top = candidates.front();
+            if (best.size() == wanted && top.score + maxBonus < best.front().score) break;
+
+            SearchHit hit{ top.position, top.score + bonus(top.position) };
+            std::pop_heap(candidates.begin(), candidates.end(), lower);
+            candidates.pop_back();
+
+            if (best.size() < wanted) {
+                best.push_back(hit);
+                std::push_heap(best.begin(), best.end(), higher);
+            }
+            else if (lower(best.front(), hit)) {
+                std::pop_heap(best.begin(), best.end(), higher);
+                best.back() = hit;
+                std::push_heap(best.begin(), best.end(), higher);
+            }
+        }
+
+        std::sort(best.begin(), best.end(), higher);
+        if (offset < best.size()) {
+            page.assign(best.begin() + offset, best.begin() + std::min(best.size(), wanted));
+        }
+        return page;
+    }
+
+    size_t getDocumentCount() const { return documentCount; }
+    size_t getTermCount() const { return postings.size(); }
+
+    MemoryUsage getMemoryUsage() const {
+        MemoryUsage usage{ MemoryAccounting::ofVector(documents) + MemoryAccounting::ofVector(accumulators) +
+            MemoryAccounting::ofHashTable(postings), postings.size() };
+        for (const auto& [term, list] : postings) {
+            usage.bytes += MemoryAccounting::ofVector(list);
+        }
+        return usage;
+    }
+
+private:
+    struct Posting {
+        uint32_t position;
+        uint16_t nameCount;         ///< 词在名称中出现的次数
+        uint16_t descriptionCount;  ///< 词在描述中出现的次数
+    };
+
+    struct Document {
+        bool present = false;
+        uint32_t nameLength = 0;         ///< 名称的词数
+        uint32_t descriptionLength = 0;  ///< 描述的词数
+    };
+
+    struct TermCount {
+        uint64_t term;
+        uint16_t count;
+    };
+
+    std::vector<Document> documents;  ///< 按商品位置索引
+    std::unordered_map<uint64_t, std::vector<Posting>> postings;  ///< 词 -> 倒排（按位置升序）
+    size_t documentCount = 0;
+    uint64_t nameLengthSum = 0;
+    uint64_t descriptionLengthSum = 0;
+    std::vector<double> accumulators;  ///< 查询时的得分累加器，用完清零
+
+    static void insertPosting(std::vector<Posting>& list, const Posting& posting) {
+        if (list.empty() || list.back().position < posting.position) {
+            list.push_back(posting);
+            return;
+        }
+        auto it = std::lower_bound(list.begin(), list.end(), posting.position,
+            [](const Posting& p, uint32_t value) { return p.position < value; });
+        list.insert(it, posting);
+    }
+
+    static uint32_t termTotal(const std::vector<TermCount>& terms) {
+        uint32_t total = 0;
+        for (const TermCount& entry : terms) total += entry.count;
+        return total;
+    }
+
+    /**
+     * @brief 分词并按词合并计数，结果按词排序
+     * @param indexing true 表示为文档分词（额外登记单字），false 表示为查询分词
+     */
+    static std::vector<TermCount> countTerms(std::string_view text, bool indexing) {
+        std::vector<uint64_t> terms;
+        uint64_t word = 0;
+        bool inWord = false;
+        uint32_t previous = 0;  ///< 当前中文片段的上一个字，0 表示不在片段中
+        size_t runLength = 0;
+
+        auto endWord = [&] {
+            if (inWord) terms.push_back(word >> 2);
+            inWord = false;
+            word = 0;
+        };
+        auto endRun = [&] {
+            if (runLength == 1 && !indexing) terms.push_back(singleTerm(previous));
+            previous = 0;
+            runLength = 0;
+        };
+
+        size_t i = 0;
+        while (i < text.size()) {
+            uint32_t codePoint = Utf8Text::decode(text, i);
+            if (Utf8Text::isSeparator(codePoint)) {
+                endWord();
+                endRun();
+            }
+            else if (codePoint < 0x80) {
+                endRun();
+                word = mix(word ^ Utf8Text::toLowerAscii(codePoint));
+                inWord = true;
+            }
+            else {
+                endWord();
+                if (indexing) terms.push_back(singleTerm(codePoint));
+                if (previous != 0) terms.push_back(pairTerm(previous, codePoint));
+                previous = codePoint;
+                ++runLength;
+            }
+        }
+        endWord();
+        endRun();
+
+        std::sort(terms.begin(), terms.end());
+        std::vector<TermCount> counts;
+        for (uint64_t term : terms) {
+            if (!counts.empty() && counts.back().term == term) {
+                if (counts.back().count < UINT16_MAX) ++counts.back().count;
+            }
+            else {
+                counts.push_back(TermCount{ term, 1 });
+            }
+        }
+        return counts;
+    }
+
+    static uint64_t mix(uint64_t value) {
+        value = (value ^ (value >> 33)) * 0xFF51AFD7ED558CCDull;
+        return value ^ (value >> 29);
+    }
+
+    // ASCII 词的哈希右移两位，单字和二字词用最高两位标记，三类词互不冲突
+    static uint64_t singleTerm(uint32_t codePoint) {
+        return (uint64_t(1) << 62) | codePoint;
+    }
+
+    static uint64_t pairTerm(uint32_t first, uint32_t second) {
+        return (uint64_t(2) << 62) | (static_cast<uint64_t>(first) << 21) | second;
+    }
+};
+
+#endif // PRODUCTSEARCHINDEX_H
@@ -0,0 +1,445 @@
+﻿#ifndef PRODUCTSTORE_H
+#define PRODUCTSTORE_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string_view>
+#include <vector>
+#include "CompactProduct.h"
+#include "ExistenceFilter.h"
+#include "MemoryUsage.h"
+#include "Product.h"
+#include "StringHash.h"
+
+/**
+ * @brief 商品表 - 紧凑记录按位置每 CHUNK_SIZE 个分为一块，块与目录快照按写时复制共享
+ *
+ * 每块存放 CompactProduct 定长记录和块自己的字符串池（编号、名称、描述），分类和卖家字段放在整表共用的
+ * 去重池里。读取经回调中的 ProductView 或还原出的 Product；修改经 setActive、reduceStock、assign 等方法
+ * 写入记录，不对外给出可修改的记录。
+ *
+ * share 把当前各块和去重池交给目录快照并冻结：之后第一次修改某块时先复制一份，快照仍读原来的块；
+ * 去重池遇到新取值时同样先复制再追加，已发出的偏移在副本中仍然有效。未修改的块在商品表和各版本快照间
+ * 只存一份，发布一次快照的开销为 O(总块数)。
+ *
+ * 加锁：结构锁（读写锁）保护块列表、去重池和商品ID索引，增删商品、整条替换和 share 持独占锁；
+ * 其余读写持共享锁，再按块加块锁（块号取模分到 LOCK_STRIPES 把锁上）。只改库存和上下架的写入
+ * 因此可以与其他块上的写入并行，不需要 DatabaseManager 的引擎锁。
+ * 商品的位置只在增删商品时变化，持有引擎锁的调用方取得的位置在本次操作内有效。
+ */
+class ProductStore {
+public:
+    static constexpr size_t CHUNK_SIZE = 128;
+    static constexpr size_t LOCK_STRIPES = 64;
+    // 共用去重池超过该大小且大于每个商品 16 字节时丢弃旧取值、整体重建，避免已不再使用的卖家字段一直累积
+    static constexpr size_t SHARED_POOL_REBUILD_BYTES = 64 * 1024;
+
+    struct Chunk {
+        std::vector<CompactProduct> records;
+        StringPool strings;
+    };
+
+    ProductStore() : shared(std::make_shared<InternedStringPool>()) {}
+
+    ProductStore(const ProductStore&) = delete;
+    ProductStore& operator=(const ProductStore&) = delete;
+
+    // ==================== 读取（共享锁 + 块锁） ====================
+    size_t size() const {
+        std::shared_lock<std::shared_mutex> structure(structureMutex);
+        return count;
+    }
+
+    bool find(std::string_view productId, size_t& position) const {
+        if (!filter.mayContain(productId)) return false;
+        std::shared_lock<std::shared_mutex> structure(structureMutex);
+        return findLocked(productId, position);
+    }
+
+    std::optional<Product> get(std::string_view productId) const {
+        std::optional<Product> result;
+        read(productId, [&](size_t, const ProductView& product) { result = product.toProduct(); });
+        return result;
+    }
+
+    Product get(size_t position) const {
+        Product result;
+        read(position, [&](const ProductView& product) { product.copyTo(result); });
+        return result;
+    }
+
+    /**
+     * @brief 在锁内读取一个商品，reader(position, ProductView)；视图不能带出回调
+     * @return 商品不存在时返回 false，不调用 reader
+     */
+    template <typename Reader>
+    bool read(std::string_view productId, Reader&& reader) const {
+        if (!filter.mayContain(productId)) return false;
+        std::shared_lock<std::shared_mutex> structure(structureMutex);
+        size_t position;
+        if (!findLocked(productId, position)) return false;
+        std::lock_guard<std::mutex> chunk(stripeOf(position / CHUNK_SIZE));
+        reader(position, viewLocked(position));
+        return true;
+    }
+
+    template <typename Reader>
+    void read(size_t position, Reader&& reader) const {
+        std::shared_lock<std::shared_mutex> structure(structureMutex);
+        std::lock_guard<std::mutex> chunk(stripeOf(position / CHUNK_SIZE));
+        reader(viewLocked(position));
+    }
+
+    /**
+     * @brief 按位置顺序访问每个商品，visitor(position, ProductView)；逐块加锁，回调中不能再访问商品表
+     */
+    template <typename Visitor>
+    void forEach(Visitor&& visitor) const {
+        std::shared_lock<std::shared_mutex> structure(structureMutex);
+        size_t position = 0;
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            std::lock_guard<std::mutex> chunk(stripeOf(i));
+            for (const CompactProduct& record : chunks[i]->records) {
+                visitor(position++, ProductView(record, chunks[i]->strings, *shared));
+            }
+        }
+    }
+
+    // ==================== 单条写入 ====================
+    // 追加到表尾，位置为追加前的 size()；ID 已存在时返回 false
+    bool add(const Product& product) {
+        std::unique_lock<std::shared_mutex> structure(structureMutex);
+        size_t position;
+        if (findLocked(product.getId(), position)) return false;
+
+        if (count % CHUNK_SIZE == 0) {
+            chunks.push_back(std::make_shared<Chunk>());
+            chunks.back()->records.reserve(CHUNK_SIZE);
+            frozen.push_back(false);
+        }
+        Chunk& chunk = writableChunk(count / CHUNK_SIZE);
+        chunk.records.push_back(encode(product, chunk.strings));
+        index.emplace(product.getId(), count);
+        filter.add(product.getId());
+        if (filter.needsRebuild()) rebuildFilter(-1.0);
+        if (++count % CHUNK_SIZE == 0) chunk.strings.shrinkToFit();
+        return true;
+    }
+
+    // 整条替换（ID 不变）；块内字符串池中被替换下来的旧值在废弃部分超过一半时随整块重新编码回收
+    void assign(size_t position, const Product& product) {
+        std::unique_lock<std::shared_mutex> structure(structureMutex);
+        Chunk& chunk = writableChunk(position / CHUNK_SIZE);
+        chunk.records[position % CHUNK_SIZE] = encode(product, chunk.strings);
+        if (chunk.strings.size() > 2 * liveTextBytes(chunk) + 1024) {
+            chunks[position / CHUNK_SIZE] = recode(chunk);
+        }
+    }
+
+    void setActive(size_t position, bool active) {
+        std::shared_lock<std::shared_mutex> structure(structureMutex);
+        std::lock_guard<std::mutex> chunk(stripeOf(position / CHUNK_SIZE));
+        writableRecord(position).isActive = active;
+    }
+
+    bool reduceStock(std::string_view productId, int quantity) {
+        return modifyStock(productId, [&](int32_t& stock) {
+            if (stock < quantity) return false;
+            stock -= quantity;
+            return true;
+        });
+    }
+
+    bool increaseStock(std::string_view productId, int quantity) {
+        return modifyStock(productId, [&](int32_t& stock) {
+            stock += quantity;
+            return true;
+        });
+    }
+
+    // 删除后其后的商品整体前移一位，受影响的块全部重新编码，ID 索引重建
+    bool erase(std::string_view productId) {
+        std::unique_lock<std::shared_mutex> structure(structureMutex);
+        size_t position;
+        if (!findLocked(productId, position)) return false;
+
+        std::vector<Product> moved;
+        moved.reserve(count - position);
+        size_t keptChunks = position / CHUNK_SIZE;
+        for (size_t i = keptChunks * CHUNK_SIZE; i < count; ++i) {
+            if (i != position) viewLocked(i).copyTo(moved.emplace_back());
+        }
+        chunks.resize(keptChunks);
+        frozen.resize(keptChunks);
+        count = keptChunks * CHUNK_SIZE;
+        for (const Product& product : moved) {
+            if (count % CHUNK_SIZE == 0) {
+                chunks.push_back(std::make_shared<Chunk>());
+                chunks.back()->records.reserve(CHUNK_SIZE);
+                frozen.push_back(false);
+            }
+            Chunk& chunk = *chunks.back();
+            chunk.records.push_back(encode(product, chunk.strings));
+            ++count;
+        }
+
+        index.clear();
+        index.reserve(count);
+        for (size_t i = 0; i < count; ++i) index.emplace(viewLocked(i).getId(), i);
+        rebuildFilter(-1.0);  // 清掉已删除的ID
+        return true;
+    }
+
+    // ==================== 事务 ====================
+    /**
+     * @brief 持有共享锁和一组商品所在块的锁（按锁号顺序加锁，不会互相等待），期间读写这些商品不再加锁
+     *
+     * 只能读写加锁时给出的商品；加锁时不存在的商品之后也查不到。
+     */
+    class Batch {
+    public:
+        bool find(std::string_view productId, size_t& position) const {
+            return store.findLocked(productId, position) &&
+                std::binary_search(stripes.begin(), stripes.end(), (position / CHUNK_SIZE) % LOCK_STRIPES);
+        }
+
+        ProductView operator[](size_t position) const { return store.viewLocked(position); }
+
+        bool reduceStock(size_t position, int quantity) {
+            CompactProduct& record = store.writableRecord(position);
+            if (record.stock < quantity) return false;
+            record.stock -= quantity;
+            return true;
+        }
+
+        void increaseStock(size_t position, int quantity) {
+            store.writableRecord(position).stock += quantity;
+        }
+
+    private:
+        friend class ProductStore;
+
+        Batch(ProductStore& store, std::vector<size_t> stripes)
+            : store(store), structure(store.structureMutex), stripes(std::move(stripes)) {
+            locks.reserve(this->stripes.size());
+            for (size_t stripe : this->stripes) locks.emplace_back(store.stripes[stripe].mutex);
+        }
+
+        ProductStore& store;
+        std::shared_lock<std::shared_mutex> structure;
+        std::vector<size_t> stripes;  ///< 已加锁的锁号，升序
+        std::vector<std::unique_lock<std::mutex>> locks;
+    };
+
+    // 不存在的商品忽略；productIds 为空时只持共享锁
+    Batch lock(const std::vector<std::string_view>& productIds) {
+        std::vector<size_t> stripeIds;
+        {
+            std::shared_lock<std::shared_mutex> structure(structureMutex);
+            for (std::string_view productId : productIds) {
+                size_t position;
+                if (findLocked(productId, position)) stripeIds.push_back((position / CHUNK_SIZE) % LOCK_STRIPES);
+            }
+        }
+        std::sort(stripeIds.begin(), stripeIds.end());
+        stripeIds.erase(std::unique(stripeIds.begin(), stripeIds.end()), stripeIds.end());
+        // 两次加锁之间位置只会因增删商品（独占锁）变化，Batch::find 会发现不在已加锁块中的商品
+        return Batch(*this, std::move(stripeIds));
+    }
+
+    // ==================== 快照 ====================
+    /**
+     * @brief 把当前各块和去重池交给目录快照，之后的修改先复制所在的块
+     *
+     * 持独占锁，进行中的事务提交完才交出，快照中不会有事务的中间状态。
+     * 去重池超出重建阈值时先按现有商品重新编码全部块，丢弃不再使用的取值。
+     */
+    void share(std::vector<std::shared_ptr<const Chunk>>& sharedChunks, size_t& sharedCount,
+        std::shared_ptr<const InternedStringPool>& sharedPool) {
+        std::unique_lock<std::shared_mutex> structure(structureMutex);
+        if (shared->size() > std::max({ SHARED_POOL_REBUILD_BYTES, count * 16, 2 * sharedSizeAtRebuild })) {
+            rebuildSharedPool();
+        }
+        sharedChunks.assign(chunks.begin(), chunks.end());
+        sharedCount = count;
+        sharedPool = shared;
+        frozen.assign(chunks.size(), true);
+        sharedFrozen = true;
+    }
+
+    // ==================== 过滤器与统计 ====================
+    // 商品ID存在性过滤器的目标误判率，立即按现有商品重建；rate 为负数时沿用当前值
+    void setFilterRate(double falsePositiveRate) {
+        std::unique_lock<std::shared_mutex> structure(structureMutex);
+        rebuildFilter(falsePositiveRate);
+    }
+
+    ExistenceFilter::Stats getFilterStats() const { return filter.getStats(); }
+
+    static MemoryUsage chunkUsage(const Chunk& chunk) {
+        return MemoryUsage{ sizeof(Chunk) + MemoryAccounting::ofVector(chunk.records) + chunk.strings.getMemoryBytes(),
+            chunk.records.size() };
+    }
+
+    // 快照中的块是否仍与商品表共用（内存统计时不重复计入）
+    bool holds(size_t chunk, const Chunk* candidate) const {
+        std::shared_lock<std::shared_mutex> structure(structureMutex);
+        if (chunk >= chunks.size()) return false;
+        std::lock_guard<std::mutex> guard(stripeOf(chunk));
+        return chunks[chunk].get() == candidate;
+    }
+
+    bool holds(const InternedStringPool* candidate) const {
+        std::shared_lock<std::shared_mutex> structure(structureMutex);
+        return shared.get() == candidate;
+    }
+
+    MemoryUsage getMemoryUsage() const {
+        std::shared_lock<std::shared_mutex> structure(structureMutex);
+        MemoryUsage usage{ MemoryAccounting::ofVector(chunks) + frozen.capacity() + shared->getMemoryBytes(), 0 };
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            std::lock_guard<std::mutex> chunk(stripeOf(i));
+            usage += chunkUsage(*chunks[i]);
+        }
+        return usage;
+    }
+
+    MemoryUsage getIndexMemoryUsage() const {
+        std::shared_lock<std::shared_mutex> structure(structureMutex);
+        MemoryUsage usage{ MemoryAccounting::ofHashTable(index), index.size() };
+        for (const auto& [productId, position] : index) usage.bytes += MemoryAccounting::ofString(productId);
+        return usage;
+    }
+
+private:
+    struct alignas(64) Stripe {
+        std::mutex mutex;
+    };
+
+    mutable std::shared_mutex structureMutex;
+    mutable std::array<Stripe, LOCK_STRIPES> stripes;
+    std::vector<std::shared_ptr<Chunk>> chunks;
+    std::vector<uint8_t> frozen;              ///< 块已交给快照，修改前须先复制（按块加锁修改，不用 vector<bool>）
+    std::shared_ptr<InternedStringPool> shared;
+    bool sharedFrozen = false;                ///< 去重池已交给快照，追加新取值前须先复制
+    size_t sharedSizeAtRebuild = 0;
+    size_t count = 0;
+    StringMap<size_t> index;                  ///< 商品ID -> 位置
+    ExistenceFilter filter;                   ///< 全部商品ID，查不存在的ID时不取锁、不访问 index
+
+    std::mutex& stripeOf(size_t chunk) const { return stripes[chunk % LOCK_STRIPES].mutex; }
+
+    bool findLocked(std::string_view productId, size_t& position) const {
+        auto it = index.find(productId);
+        if (it == index.end()) return false;
+        position = it->second;
+        return true;
+    }
+
+    ProductView viewLocked(size_t position) const {
+        const Chunk& chunk = *chunks[position / CHUNK_SIZE];
+        return ProductView(chunk.records[position % CHUNK_SIZE], chunk.strings, *shared);
+    }
+
+    template <typename Modifier>
+    bool modifyStock(std::string_view productId, Modifier&& modifier) {
+        if (!filter.mayContain(productId)) return false;
+        std::shared_lock<std::shared_mutex> structure(structureMutex);
+        size_t position;
+        if (!findLocked(productId, position)) return false;
+        std::lock_guard<std::mutex> chunk(stripeOf(position / CHUNK_SIZE));
+        int32_t stock = viewLocked(position).getStock();
+        if (!modifier(stock)) return false;
+        writableRecord(position).stock = stock;
+        return true;
+    }
+
+    // 调用方持有独占锁，或持有共享锁和该块的块锁
+    Chunk& writableChunk(size_t chunk) {
+        if (frozen[chunk]) {
+            chunks[chunk] = std::make_shared<Chunk>(*chunks[chunk]);
+            frozen[chunk] = false;
+        }
+        return *chunks[chunk];
+    }
+
+    CompactProduct& writableRecord(size_t position) {
+        return writableChunk(position / CHUNK_SIZE).records[position % CHUNK_SIZE];
+    }
+
+    // 以下调用方持有独占锁
+    uint32_t intern(std::string_view text) {
+        uint32_t offset;
+        if (shared->find(text, offset)) return offset;
+        if (sharedFrozen) {
+            shared = std::make_shared<InternedStringPool>(*shared);
+            sharedFrozen = false;
+        }
+        return shared->intern(text);
+    }
+
+    template <typename Source>
+    CompactProduct encode(const Source& product, StringPool& strings) {
+        return CompactProduct::encode(product, strings, [this](std::string_view text) { return intern(text); });
+    }
+
+    void rebuildFilter(double rate) {
+        filter.rebuild(count, [&](auto&& add) {
+            for (const auto& [productId, position] : index) add(productId);
+        }, rate);
+    }
+
+    static size_t liveTextBytes(const Chunk& chunk) {
+        size_t bytes = 1;
+        for (const CompactProduct& record : chunk.records) {
+            size_t description = chunk.strings.view(record.description).size();
+            bytes += chunk.strings.view(record.id).size() + description + 2;
+            // 名称共用描述尾部时不另占空间
+            if (record.name < record.description || record.name > record.description + description) {
+                bytes += chunk.strings.view(record.name).size() + 1;
+            }
+        }
+        return bytes;
+    }
+
+    // 按记录重新写入块字符串池，丢弃被替换下来的旧值；去重池偏移不变
+    std::shared_ptr<Chunk> recode(const Chunk& from) const {
+        auto chunk = std::make_shared<Chunk>();
+        chunk->records.reserve(CHUNK_SIZE);
+        chunk->strings.reserve(liveTextBytes(from) + from.records.size() * 16);
+        for (const CompactProduct& record : from.records) {
+            CompactProduct copy = record;
+            copy.id = chunk->strings.append(from.strings.view(record.id));
+            copy.description = chunk->strings.append(from.strings.view(record.description));
+            copy.name = chunk->strings.appendSuffixOf(copy.description, from.strings.view(record.name));
+            chunk->records.push_back(copy);
+        }
+        chunk->strings.shrinkToFit();
+        return chunk;
+    }
+
+    // 用新的去重池重新编码全部块；快照继续持有旧的块和旧池
+    void rebuildSharedPool() {
+        auto previous = std::move(shared);
+        shared = std::make_shared<InternedStringPool>();
+        sharedFrozen = false;
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            auto chunk = std::make_shared<Chunk>();
+            chunk->records.reserve(CHUNK_SIZE);
+            for (const CompactProduct& record : chunks[i]->records) {
+                chunk->records.push_back(encode(ProductView(record, chunks[i]->strings, *previous), chunk->strings));
+            }
+            chunk->strings.shrinkToFit();
+            chunks[i] = std::move(chunk);
+            frozen[i] = false;
+        }
+        sharedSizeAtRebuild = shared->size();
+    }
+};
+
+#endif // PRODUCTSTORE_H
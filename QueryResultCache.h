@@ -0,0 +1,220 @@
+﻿#ifndef QUERYRESULTCACHE_H
+#define QUERYRESULTCACHE_H
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "StringHash.h"
+
+/**
+ * @brief 查询缓存的统计信息
+ */
+struct QueryCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;         ///< 包括因过期而丢弃的条目
+    uint64_t invalidations = 0;  ///< 因版本号变化或整体清空而丢弃的条目数
+    uint64_t evictions = 0;      ///< 因超出容量而淘汰的条目数
+    size_t entryCount = 0;
+    size_t memoryBytes = 0;      ///< 缓存条目占用的内存（估算）
+    size_t capacityBytes = 0;
+
+    double getHitRate() const {
+        uint64_t total = hits + misses;
+        return total == 0 ? 0.0 : static_cast<double>(hits) / total;
+    }
+};
+
+/**
+ * @brief 商品查询结果缓存 - 按内存上限做 LRU 淘汰，按版本号精确失效
+ *
+ * 缓存的是结果集合（商品在商品表中的位置），命中时由调用方按位置从目录快照读取商品，
+ * 因此库存、价格等不影响结果集合的修改无需使缓存失效，返回的永远是最新的商品数据。
+ * 版本号由 QueryStamps 维护并随目录快照发布：条目记录写入时所用快照的版本号，
+ * 查找时与读者快照的版本号不一致即不命中，条目比读者的快照旧时顺便丢弃。
+ * 读者不持有引擎锁，缓存自带互斥锁，临界区内只做哈希查找和链表调整。
+ */
+class QueryResultCache {
+public:
+    enum class Kind : char {
+        ActiveProducts = 'A',  ///< 全部上架商品，参数为空
+        Search = 'S',          ///< 关键词搜索，参数为关键词
+        Category = 'C'         ///< 类别浏览，参数为类别名
+    };
+
+    static constexpr size_t DEFAULT_CAPACITY_BYTES = 16 * 1024 * 1024;
+
+    explicit QueryResultCache(size_t capacityBytes = DEFAULT_CAPACITY_BYTES) {
+        stats.capacityBytes = capacityBytes;
+    }
+
+    using Positions = std::shared_ptr<const std::vector<uint32_t>>;
+
+    /**
+     * @brief 查找与读者快照版本号一致的结果，命中的条目移到 LRU 表头
+     * @param stamp 读者快照中该查询的版本号
+     * @return 未命中时返回空指针
+     */
+    Positions find(Kind kind, std::string_view argument, uint64_t stamp) {
+        std::lock_guard<std::mutex> guard(mutex);
+        lookupKey.assign(1, static_cast<char>(kind));
+        lookupKey.append(argument);
+        auto it = entries.find(lookupKey);
+        if (it == entries.end()) {
+            ++stats.misses;
+            return nullptr;
+        }
+
+        auto node = it->second;
+        if (node->stamp != stamp) {
+            ++stats.misses;
+            if (node->stamp < stamp) {
+                ++stats.invalidations;
+                erase(it);
+            }
+            return nullptr;
+        }
+        ++stats.hits;
+        lru.splice(lru.begin(), lru, node);
+        return node->positions;
+    }
+
+    /**
+     * @brief 写入查询结果；不覆盖更新的条目，单条超过容量一半的结果不缓存
+     * @return 共享的结果，未缓存时同样返回，调用方与缓存共用同一份位置表
+     */
+    Positions store(Kind kind, std::string_view argument, uint64_t stamp, std::vector<uint32_t> positions) {
+        std::string key = makeKey(kind, argument);
+        size_t bytes = entryBytes(key, positions);
+        auto shared = std::make_shared<const std::vector<uint32_t>>(std::move(positions));
+
+        std::lock_guard<std::mutex> guard(mutex);
+        if (bytes > stats.capacityBytes / 2) return shared;
+        auto existing = entries.find(key);
+        if (existing != entries.end()) {
+            if (existing->second->stamp > stamp) return shared;
+            erase(existing);
+        }
+
+        lru.push_front(Node{ key, stamp, shared, bytes });
+        entries.emplace(std::move(key), lru.begin());
+        stats.memoryBytes += bytes;
+        ++stats.entryCount;
+        evictOverflow();
+        return shared;
+    }
+
+    // 调整容量，0 表示禁用缓存
+    void setCapacity(size_t capacityBytes) {
+        std::lock_guard<std::mutex> guard(mutex);
+        stats.capacityBytes = capacityBytes;
+        evictOverflow();
+    }
+
+    /**
+     * @brief 按 LRU 淘汰条目直到占用不超过 targetBytes，容量不变（内存压力时使用）
+     * @return 释放的字节数
+     */
+    size_t trim(size_t targetBytes) {
+        std::lock_guard<std::mutex> guard(mutex);
+        size_t before = stats.memoryBytes;
+        while (stats.memoryBytes > targetBytes && !lru.empty()) {
+            ++stats.evictions;
+            erase(entries.find(lru.back().key));
+        }
+        return before - stats.memoryBytes;
+    }
+
+    QueryCacheStats getStats() const {
+        std::lock_guard<std::mutex> guard(mutex);
+        return stats;
+    }
+
+private:
+    struct Node {
+        std::string key;
+        uint64_t stamp;
+        Positions positions;
+        size_t bytes;
+    };
+
+    using NodeList = std::list<Node>;
+
+    // 每个条目除结果外的固定开销：链表节点、哈希表节点、结果的控制块和两份键
+    static constexpr size_t ENTRY_OVERHEAD = sizeof(Node) + 2 * sizeof(void*) +
+        sizeof(std::string) + sizeof(NodeList::iterator) + 2 * sizeof(void*) +
+        sizeof(std::vector<uint32_t>) + 2 * sizeof(void*);
+
+    mutable std::mutex mutex;
+    NodeList lru;  ///< 表头为最近使用
+    StringMap<NodeList::iterator> entries;
+    QueryCacheStats stats;
+    std::string lookupKey;  ///< 查找时复用的键缓冲区，命中时不分配内存
+
+    static std::string makeKey(Kind kind, std::string_view argument) {
+        std::string key;
+        key.reserve(argument.size() + 1);
+        key.push_back(static_cast<char>(kind));
+        key.append(argument);
+        return key;
+    }
+
+    static size_t entryBytes(const std::string& key, const std::vector<uint32_t>& positions) {
+        return ENTRY_OVERHEAD + 2 * key.capacity() + positions.capacity() * sizeof(uint32_t);
+    }
+
+    void evictOverflow() {
+        while (stats.memoryBytes > stats.capacityBytes) {
+            ++stats.evictions;
+            erase(entries.find(lru.back().key));
+        }
+    }
+
+    void erase(StringMap<NodeList::iterator>::iterator it) {
+        stats.memoryBytes -= it->second->bytes;
+        --stats.entryCount;
+        lru.erase(it->second);
+        entries.erase(it);
+    }
+};
+
+/**
+ * @brief 查询结果集合的版本号，由写入方在引擎锁内维护，随目录快照一起发布
+ *
+ * 目录版本覆盖"全部上架商品"和关键词搜索，类别版本只覆盖该类别的浏览页。
+ * 商品的上下架、名称描述或类别变化时递增其新旧类别和目录版本；
+ * 删除商品会使之后所有商品的位置前移，此时递增全部版本号。
+ */
+class QueryStamps {
+public:
+    uint64_t get(QueryResultCache::Kind kind, std::string_view argument) const {
+        if (kind != QueryResultCache::Kind::Category) return catalogVersion;
+        auto it = categoryVersions.find(argument);
+        return it == categoryVersions.end() ? baseVersion : it->second;
+    }
+
+    void bumpCategory(std::string_view category) {
+        auto it = categoryVersions.find(category);
+        if (it == categoryVersions.end()) it = categoryVersions.emplace(std::string(category), 0).first;
+        it->second = ++clock;
+        catalogVersion = ++clock;
+    }
+
+    void bumpAll() {
+        categoryVersions.clear();
+        baseVersion = ++clock;
+        catalogVersion = ++clock;
+    }
+
+private:
+    StringMap<uint64_t> categoryVersions;
+    uint64_t baseVersion = 0;  ///< 未单独递增过的类别的版本号
+    uint64_t catalogVersion = 0;
+    uint64_t clock = 0;
+};
+
+#endif // QUERYRESULTCACHE_H
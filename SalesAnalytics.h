@@ -0,0 +1,234 @@
+﻿#ifndef SALESANALYTICS_H
+#define SALESANALYTICS_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "Order.h"
+
+/**
+ * @brief 一个分组的销售汇总
+ */
+struct SalesGroup {
+    std::string key;
+    Money revenue;
+    long long units = 0;   ///< 售出件数
+    long long lines = 0;   ///< 订单项行数
+};
+
+/**
+ * @brief 销售分析结果 - 按卖家、类别、商品、日期分组
+ *
+ * 卖家、类别、商品按销售额降序排列，日期按时间升序排列。
+ */
+struct SalesReport {
+    std::vector<SalesGroup> bySeller;
+    std::vector<SalesGroup> byCategory;
+    std::vector<SalesGroup> byProduct;
+    std::vector<SalesGroup> byDay;
+    Money totalRevenue;
+    long long totalUnits = 0;
+    size_t ordersScanned = 0;
+    size_t linesScanned = 0;
+    unsigned threadsUsed = 1;
+    double elapsedMs = 0.0;
+};
+
+/**
+ * @brief 并行销售分析 - 线程局部哈希聚合，按分区并行合并
+ *
+ * 扫描阶段：订单按固定大小的块分发给各线程，每个线程把订单项聚合到自己的哈希表中，
+ * 每个维度的哈希表按键的哈希值分成 P 个分区（P 为线程数）。
+ * 合并阶段：线程 p 只合并所有线程的第 p 个分区，各分区键集不相交，无需加锁。
+ * 分组键是指向订单数据的 string_view，扫描期间不分配字符串，调用方须保证订单数据在计算期间不变。
+ * 统计口径与 DatabaseManager::getTotalSales 一致：只计已发货和已完成的订单。
+ */
+class SalesAnalytics {
+public:
+    /// 商品ID -> 类别，订单项本身不记录类别
+    using CategoryLookup = std::unordered_map<std::string_view, std::string_view>;
+
+    /**
+     * @brief 计算分组汇总
+     * @param sources 订单数据，可来自多个容器（如热订单和各归档段）
+     * @param categories 商品类别查询表
+     * @param threadCount 线程数，0 表示使用硬件线程数
+     */
+    static SalesReport compute(const std::vector<std::span<const Order>>& sources,
+        const CategoryLookup& categories, unsigned threadCount = 0) {
+        auto start = std::chrono::steady_clock::now();
+        if (threadCount == 0) {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        std::vector<Chunk> chunks;
+        for (const auto& source : sources) {
+            for (size_t begin = 0; begin < source.size(); begin += CHUNK_ORDERS) {
+                chunks.push_back(Chunk{ source.subspan(begin, std::min(CHUNK_ORDERS, source.size() - begin)) });
+            }
+        }
+        threadCount = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(threadCount, chunks.size())));
+
+        std::vector<LocalState> locals(threadCount);
+        for (auto& local : locals) {
+            for (auto& partitions : local.tables) {
+                partitions.resize(threadCount);
+            }
+        }
+
+        // 扫描阶段
+        std::atomic<size_t> nextChunk{ 0 };
+        runParallel(threadCount, [&](unsigned worker) {
+            LocalState& local = locals[worker];
+            size_t index;
+            while ((index = nextChunk.fetch_add(1, std::memory_order_relaxed)) < chunks.size()) {
+                scanChunk(chunks[index], categories, local, threadCount);
+            }
+        });
+
+        // 合并阶段：每个线程负责一个分区
+        std::vector<std::array<std::vector<SalesGroup>, DIMENSION_COUNT>> merged(threadCount);
+        runParallel(threadCount, [&](unsigned partition) {
+            for (size_t dimension = 0; dimension < DIMENSION_COUNT; ++dimension) {
+                Table table;
+                for (const auto& local : locals) {
+                    for (const auto& entry : local.tables[dimension][partition]) {
+                        Totals& totals = table[entry.first];
+                        totals.revenue += entry.second.revenue;
+                        totals.units += entry.second.units;
+                        totals.lines += entry.second.lines;
+                    }
+                }
+                auto& groups = merged[partition][dimension];
+                groups.reserve(table.size());
+                for (const auto& entry : table) {
+                    groups.push_back(SalesGroup{ std::string(entry.first), entry.second.revenue,
+                        entry.second.units, entry.second.lines });
+                }
+            }
+        });
+
+        SalesReport report;
+        std::vector<SalesGroup>* outputs[DIMENSION_COUNT] = {
+            &report.bySeller, &report.byCategory, &report.byProduct, &report.byDay
+        };
+        for (size_t dimension = 0; dimension < DIMENSION_COUNT; ++dimension) {
+            for (auto& partition : merged) {
+                auto& groups = partition[dimension];
+                outputs[dimension]->insert(outputs[dimension]->end(),
+                    std::make_move_iterator(groups.begin()), std::make_move_iterator(groups.end()));
+            }
+        }
+        for (const auto& local : locals) {
+            report.totalRevenue += local.revenue;
+            report.totalUnits += local.units;
+            report.ordersScanned += local.orders;
+            report.linesScanned += local.lines;
+        }
+
+        auto byRevenue = [](const SalesGroup& a, const SalesGroup& b) {
+            return a.revenue != b.revenue ? a.revenue > b.revenue : a.key < b.key;
+        };
+        std::sort(report.bySeller.begin(), report.bySeller.end(), byRevenue);
+        std::sort(report.byCategory.begin(), report.byCategory.end(), byRevenue);
+        std::sort(report.byProduct.begin(), report.byProduct.end(), byRevenue);
+        std::sort(report.byDay.begin(), report.byDay.end(),
+            [](const SalesGroup& a, const SalesGroup& b) { return a.key < b.key; });
+
+        report.threadsUsed = threadCount;
+        report.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return report;
+    }
+
+private:
+    enum Dimension { SELLER, CATEGORY, PRODUCT, DAY, DIMENSION_COUNT };
+
+    static constexpr size_t CHUNK_ORDERS = 4096;
+
+    struct Totals {
+        Money revenue;
+        long long units = 0;
+        long long lines = 0;
+    };
+
+    using Table = std::unordered_map<std::string_view, Totals>;
+
+    struct Chunk {
+        std::span<const Order> orders;
+    };
+
+    // 按缓存行对齐，避免各线程的计数器伪共享
+    struct alignas(64) LocalState {
+        std::array<std::vector<Table>, DIMENSION_COUNT> tables;  ///< [维度][分区]
+        Money revenue;
+        long long units = 0;
+        size_t orders = 0;
+        size_t lines = 0;
+    };
+
+    static void scanChunk(const Chunk& chunk, const CategoryLookup& categories, LocalState& local, unsigned partitions) {
+        static constexpr std::string_view UNKNOWN_CATEGORY = "未分类";
+        std::hash<std::string_view> hasher;
+
+        auto accumulate = [&](Dimension dimension, std::string_view key, Money revenue, long long units, long long lines) {
+            Totals& totals = local.tables[dimension][hasher(key) % partitions][key];
+            totals.revenue += revenue;
+            totals.units += units;
+            totals.lines += lines;
+        };
+
+        for (const Order& order : chunk.orders) {
+            const std::string& status = order.getStatus();
+            if (status != "completed" && status != "shipped") continue;
+
+            // 下单时间格式为 "YYYY-MM-DD HH:MM:SS"，取前 10 个字符作为日期
+            std::string_view day = std::string_view(order.getOrderTime()).substr(0, 10);
+            Money orderRevenue;
+            long long orderUnits = 0;
+
+            for (const OrderItem& item : order.getItems()) {
+                Money revenue = item.getTotalPrice();
+                int units = item.getQuantity();
+                const std::string& productId = item.getProductId();
+
+                auto category = categories.find(productId);
+                accumulate(SELLER, item.getSellerUsername(), revenue, units, 1);
+                accumulate(CATEGORY, category == categories.end() ? UNKNOWN_CATEGORY : category->second, revenue, units, 1);
+                accumulate(PRODUCT, productId, revenue, units, 1);
+                orderRevenue += revenue;
+                orderUnits += units;
+            }
+
+            // 同一订单的订单项日期相同，按订单累加一次
+            long long lines = static_cast<long long>(order.getItems().size());
+            accumulate(DAY, day, orderRevenue, orderUnits, lines);
+            local.revenue += orderRevenue;
+            local.units += orderUnits;
+            local.lines += lines;
+            ++local.orders;
+        }
+    }
+
+    template <typename Task>
+    static void runParallel(unsigned threadCount, Task&& task) {
+        std::vector<std::thread> threads;
+        threads.reserve(threadCount - 1);
+        for (unsigned i = 1; i < threadCount; ++i) {
+            threads.emplace_back([&task, i] { task(i); });
+        }
+        task(0);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+};
+
+#endif // SALESANALYTICS_H
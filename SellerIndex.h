@@ -0,0 +1,114 @@
+﻿#ifndef SELLERINDEX_H
+#define SELLERINDEX_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Order.h"
+#include "StringHash.h"
+#include "MemoryUsage.h"
+
+/**
+ * @brief 卖家看板汇总
+ */
+struct SellerStats {
+    long long unitsSold = 0;    ///< 未取消订单中售出的件数
+    Money revenue;              ///< 未取消订单的销售额
+    int openOrders = 0;         ///< 含有该卖家商品、尚未完成或取消的订单数
+    int complaintCount = 0;     ///< 针对该卖家商品的投诉数
+};
+
+/**
+ * @brief 卖家索引 - 卖家 -> 商品位置列表，以及按订单增量维护的卖家汇总
+ *
+ * 商品位置指 DatabaseManager::products 中的下标，商品表重排时须调用 clearProducts 后重新登记。
+ * 订单的贡献通过 applyOrder(order, +1/-1) 加上或撤销，状态变化时先撤销旧订单再加上新订单，
+ * 保证汇总与订单表一致。
+ */
+class SellerIndex {
+public:
+    void addProduct(std::string_view sellerUsername, size_t position) {
+        entryFor(sellerUsername).productPositions.push_back(position);
+    }
+
+    void clearProducts() {
+        for (auto& entry : sellers) {
+            entry.second.productPositions.clear();
+        }
+    }
+
+    // 未登记的卖家返回空列表
+    const std::vector<size_t>& getProductPositions(std::string_view sellerUsername) const {
+        static const std::vector<size_t> empty;
+        auto it = sellers.find(sellerUsername);
+        return it == sellers.end() ? empty : it->second.productPositions;
+    }
+
+    SellerStats getStats(std::string_view sellerUsername) const {
+        auto it = sellers.find(sellerUsername);
+        return it == sellers.end() ? SellerStats() : it->second.stats;
+    }
+
+    /**
+     * @brief 加上（sign = +1）或撤销（sign = -1）一个订单对各卖家汇总的贡献
+     */
+    void applyOrder(const Order& order, int sign) {
+        bool cancelled = order.getStatus() == "cancelled";
+        bool open = !cancelled && !order.isFinished();
+
+        const std::vector<OrderItem>& items = order.getItems();
+        for (size_t i = 0; i < items.size(); ++i) {
+            const OrderItem& item = items[i];
+            SellerStats& stats = entryFor(item.getSellerUsername()).stats;
+            if (!cancelled) {
+                stats.unitsSold += static_cast<long long>(sign) * item.getQuantity();
+                stats.revenue += sign * item.getTotalPrice();
+            }
+
+            // 同一订单中同一卖家只计一次进行中订单
+            if (open && isFirstItemOfSeller(items, i)) {
+                stats.openOrders += sign;
+            }
+        }
+    }
+
+    void addComplaint(std::string_view sellerUsername, int delta = 1) {
+        entryFor(sellerUsername).stats.complaintCount += delta;
+    }
+
+    size_t getSellerCount() const { return sellers.size(); }
+
+    MemoryUsage getMemoryUsage() const {
+        MemoryUsage usage{ MemoryAccounting::ofHashTable(sellers), sellers.size() };
+        for (const auto& [seller, entry] : sellers) {
+            usage.bytes += MemoryAccounting::ofString(seller) + MemoryAccounting::ofVector(entry.productPositions);
+        }
+        return usage;
+    }
+
+private:
+    struct Entry {
+        std::vector<size_t> productPositions;
+        SellerStats stats;
+    };
+
+    StringMap<Entry> sellers;
+
+    Entry& entryFor(std::string_view sellerUsername) {
+        auto it = sellers.find(sellerUsername);
+        if (it == sellers.end()) {
+            it = sellers.emplace(std::string(sellerUsername), Entry()).first;
+        }
+        return it->second;
+    }
+
+    // 订单项通常只有几行，线性查找即可
+    static bool isFirstItemOfSeller(const std::vector<OrderItem>& items, size_t index) {
+        for (size_t j = 0; j < index; ++j) {
+            if (items[j].getSellerUsername() == items[index].getSellerUsername()) return false;
+        }
+        return true;
+    }
+};
+
+#endif // SELLERINDEX_H
@@ -0,0 +1,251 @@
+﻿#ifndef SESSIONMANAGER_H
+#define SESSIONMANAGER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "MemoryUsage.h"
+
+/**
+ * @brief 用户角色，会话表中只保存角色而不保存用户对象
+ */
+enum class UserRole : uint8_t {
+    Customer,
+    Admin
+};
+
+/**
+ * @brief 不透明的 128 位会话令牌，对外以 32 位十六进制字符串表示
+ */
+struct SessionToken {
+    uint64_t high = 0;
+    uint64_t low = 0;
+
+    bool isValid() const { return high != 0 || low != 0; }
+
+    bool operator==(const SessionToken& other) const {
+        return high == other.high && low == other.low;
+    }
+
+    std::string toString() const {
+        static const char digits[] = "0123456789abcdef";
+        std::string text(32, '0');
+        for (int i = 0; i < 16; ++i) {
+            text[15 - i] = digits[(high >> (i * 4)) & 0xF];
+            text[31 - i] = digits[(low >> (i * 4)) & 0xF];
+        }
+        return text;
+    }
+
+    /**
+     * @brief 解析十六进制令牌，不分配内存
+     * @return 格式错误时返回无效令牌
+     */
+    static SessionToken parse(std::string_view text) {
+        SessionToken token;
+        if (text.size() != 32) return token;
+
+        uint64_t parts[2] = { 0, 0 };
+        for (size_t i = 0; i < 32; ++i) {
+            char c = text[i];
+            uint64_t digit;
+            if (c >= '0' && c <= '9') digit = c - '0';
+            else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+            else return SessionToken();
+            parts[i / 16] = (parts[i / 16] << 4) | digit;
+        }
+        token.high = parts[0];
+        token.low = parts[1];
+        return token;
+    }
+};
+
+struct SessionTokenHash {
+    size_t operator()(const SessionToken& token) const {
+        // 令牌本身是随机数，直接混合即可
+        return static_cast<size_t>(token.low ^ (token.high * 0x9E3779B97F4A7C15ull));
+    }
+};
+
+/**
+ * @brief 令牌解析结果
+ */
+struct SessionInfo {
+    uint32_t userId = 0;
+    UserRole role = UserRole::Customer;
+};
+
+/**
+ * @brief 会话表 - 按令牌哈希分片的并发哈希表，带过期时间
+ *
+ * 每个分片独立加锁。过期采用惰性淘汰：解析时发现过期即删除；
+ * 另外每个分片按签发顺序维护一个过期队列，签发新令牌时顺带清理队首已过期的会话，
+ * 均摊 O(1)，无需后台线程。
+ */
+class SessionManager {
+public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr size_t SHARD_COUNT = 64;
+
+    explicit SessionManager(std::chrono::seconds timeToLive = std::chrono::hours(2))
+        : timeToLive(timeToLive), liveCount(0) {
+    }
+
+    SessionManager(const SessionManager&) = delete;
+    SessionManager& operator=(const SessionManager&) = delete;
+
+    void setTimeToLive(std::chrono::seconds ttl) { timeToLive = ttl; }
+    std::chrono::seconds getTimeToLive() const { return timeToLive; }
+
+    /**
+     * @brief 签发新令牌
+     * @param userId 用户编号
+     * @param role 用户角色
+     */
+    SessionToken issue(uint32_t userId, UserRole role) {
+        SessionToken token = generateToken();
+        Clock::time_point now = Clock::now();
+        Shard& shard = shardFor(token);
+
+        std::lock_guard<std::mutex> guard(shard.mutex);
+        evictExpired(shard, now, EVICTIONS_PER_ISSUE);
+        shard.sessions.emplace(token, Entry{ userId, role, now + timeToLive });
+        shard.expiryQueue.push_back(Pending{ token, now + timeToLive });
+        liveCount.fetch_add(1, std::memory_order_relaxed);
+        return token;
+    }
+
+    /**
+     * @brief 将令牌解析为用户编号和角色，O(1)，不复制任何字符串
+     * @return 令牌不存在或已过期时返回 false
+     */
+    bool resolve(const SessionToken& token, SessionInfo& info) {
+        if (!token.isValid()) return false;
+        Shard& shard = shardFor(token);
+
+        std::lock_guard<std::mutex> guard(shard.mutex);
+        auto it = shard.sessions.find(token);
+        if (it == shard.sessions.end()) return false;
+
+        if (it->second.expiresAt <= Clock::now()) {
+            shard.sessions.erase(it);
+            liveCount.fetch_sub(1, std::memory_order_relaxed);
+            return false;
+        }
+        info.userId = it->second.userId;
+        info.role = it->second.role;
+        return true;
+    }
+
+    bool resolve(std::string_view text, SessionInfo& info) {
+        return resolve(SessionToken::parse(text), info);
+    }
+
+    /**
+     * @brief 注销令牌
+     */
+    bool revoke(const SessionToken& token) {
+        if (!token.isValid()) return false;
+        Shard& shard = shardFor(token);
+
+        std::lock_guard<std::mutex> guard(shard.mutex);
+        if (shard.sessions.erase(token) > 0) {
+            liveCount.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief 清理所有分片中已过期的会话
+     * @return 清理的会话数
+     */
+    size_t purgeExpired() {
+        size_t removed = 0;
+        Clock::time_point now = Clock::now();
+        for (Shard& shard : shards) {
+            std::lock_guard<std::mutex> guard(shard.mutex);
+            removed += evictExpired(shard, now, SIZE_MAX);
+        }
+        return removed;
+    }
+
+    // 当前存活（未注销、未被清理）的会话数
+    size_t getLiveSessionCount() const { return liveCount.load(std::memory_order_relaxed); }
+
+    // 逐个分片加锁统计，已过期但尚未清理的会话也计入
+    MemoryUsage getMemoryUsage() {
+        MemoryUsage usage;
+        for (auto& shard : shards) {
+            std::lock_guard<std::mutex> guard(shard.mutex);
+            usage.bytes += MemoryAccounting::ofHashTable(shard.sessions) + MemoryAccounting::ofDeque(shard.expiryQueue);
+            usage.items += shard.sessions.size();
+        }
+        return usage;
+    }
+
+private:
+    struct Entry {
+        uint32_t userId;
+        UserRole role;
+        Clock::time_point expiresAt;
+    };
+
+    struct Pending {
+        SessionToken token;
+        Clock::time_point expiresAt;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<SessionToken, Entry, SessionTokenHash> sessions;
+        std::deque<Pending> expiryQueue;  // 按签发顺序，即按过期时间有序
+    };
+
+    static constexpr size_t EVICTIONS_PER_ISSUE = 4;
+
+    std::chrono::seconds timeToLive;
+    std::atomic<size_t> liveCount;
+    std::array<Shard, SHARD_COUNT> shards;
+
+    Shard& shardFor(const SessionToken& token) {
+        return shards[(token.high >> 58) % SHARD_COUNT];
+    }
+
+    // 调用方须持有分片锁
+    size_t evictExpired(Shard& shard, Clock::time_point now, size_t limit) {
+        size_t removed = 0;
+        while (limit > 0 && !shard.expiryQueue.empty() && shard.expiryQueue.front().expiresAt <= now) {
+            const Pending& pending = shard.expiryQueue.front();
+            auto it = shard.sessions.find(pending.token);
+            if (it != shard.sessions.end() && it->second.expiresAt <= now) {
+                shard.sessions.erase(it);
+                liveCount.fetch_sub(1, std::memory_order_relaxed);
+                ++removed;
+            }
+            shard.expiryQueue.pop_front();
+            --limit;
+        }
+        return removed;
+    }
+
+    static SessionToken generateToken() {
+        thread_local std::random_device device;
+        SessionToken token;
+        do {
+            token.high = (static_cast<uint64_t>(device()) << 32) | device();
+            token.low = (static_cast<uint64_t>(device()) << 32) | device();
+        } while (!token.isValid());
+        return token;
+    }
+};
+
+#endif // SESSIONMANAGER_H
@@ -0,0 +1,206 @@
+﻿#ifndef SESSIONTASK_H
+#define SESSIONTASK_H
+
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+template <typename T = void>
+class SessionTask;
+
+/**
+ * @brief 会话协程的公共部分：惰性启动，结束时对称转移回等待它的协程
+ */
+struct SessionPromiseBase {
+    std::coroutine_handle<> continuation;  ///< co_await 本任务的协程，为空表示顶层会话
+    std::exception_ptr exception;
+
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            std::coroutine_handle<> next = handle.promise().continuation;
+            return next ? next : std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() { exception = std::current_exception(); }
+};
+
+template <typename T>
+struct SessionPromise : SessionPromiseBase {
+    std::optional<T> value;
+
+    SessionTask<T> get_return_object();
+    void return_value(T result) { value = std::move(result); }
+};
+
+template <>
+struct SessionPromise<void> : SessionPromiseBase {
+    SessionTask<void> get_return_object();
+    void return_void() {}
+};
+
+/**
+ * @brief 会话协程任务 - 菜单流程的协程版本使用的返回类型
+ *
+ * 创建后不立即执行；被 co_await 时开始运行，结束后直接恢复等待方（对称转移，嵌套再深也不增加栈深度）。
+ * 顶层会话交给 SessionScheduler 管理；输入源从不挂起时（如控制台）也可以用 runToCompletion 同步执行。
+ */
+template <typename T>
+class SessionTask {
+public:
+    using promise_type = SessionPromise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    explicit SessionTask(Handle handle) : handle(handle) {}
+
+    SessionTask(SessionTask&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+
+    SessionTask& operator=(SessionTask&& other) noexcept {
+        if (this != &other) {
+            if (handle) handle.destroy();
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+
+    SessionTask(const SessionTask&) = delete;
+    SessionTask& operator=(const SessionTask&) = delete;
+
+    ~SessionTask() {
+        if (handle) handle.destroy();
+    }
+
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            Handle handle;
+
+            bool await_ready() const noexcept { return !handle || handle.done(); }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> waiting) noexcept {
+                handle.promise().continuation = waiting;
+                return handle;
+            }
+
+            T await_resume() {
+                if (handle.promise().exception) std::rethrow_exception(handle.promise().exception);
+                if constexpr (!std::is_void_v<T>) return std::move(*handle.promise().value);
+            }
+        };
+        return Awaiter{ handle };
+    }
+
+    /**
+     * @brief 在当前线程执行到结束，只适用于从不挂起的输入源；协程中途挂起视为用法错误
+     */
+    void runToCompletion() {
+        if (!handle || handle.done()) return;
+        handle.resume();
+        if (handle.promise().exception) std::rethrow_exception(handle.promise().exception);
+    }
+
+    bool isDone() const { return !handle || handle.done(); }
+
+    // 交出协程帧的所有权（调度器接管顶层会话时使用）
+    Handle release() { return std::exchange(handle, nullptr); }
+
+private:
+    Handle handle;
+};
+
+template <typename T>
+SessionTask<T> SessionPromise<T>::get_return_object() {
+    return SessionTask<T>(std::coroutine_handle<SessionPromise<T>>::from_promise(*this));
+}
+
+inline SessionTask<void> SessionPromise<void>::get_return_object() {
+    return SessionTask<void>(std::coroutine_handle<SessionPromise<void>>::from_promise(*this));
+}
+
+/**
+ * @brief 单线程会话调度器 - 在一个线程上复用大量挂起的会话协程
+ *
+ * 会话等待输入时挂起，只占用协程帧，不占线程；输入源收到新行后把挂起点交给 schedule，
+ * 由 runReady 依次恢复。调度器不是线程安全的，所有会话、输入源和调度器须在同一线程使用。
+ */
+class SessionScheduler {
+public:
+    SessionScheduler() = default;
+
+    SessionScheduler(const SessionScheduler&) = delete;
+    SessionScheduler& operator=(const SessionScheduler&) = delete;
+
+    ~SessionScheduler() {
+        for (auto root : roots) root.destroy();
+    }
+
+    /**
+     * @brief 接管一个顶层会话，下一次 runReady 时开始执行
+     */
+    void spawn(SessionTask<void> task) {
+        auto handle = task.release();
+        if (!handle) return;
+        roots.push_back(handle);
+        ready.push_back(handle);
+    }
+
+    void schedule(std::coroutine_handle<> handle) {
+        ready.push_back(handle);
+    }
+
+    /**
+     * @brief 恢复所有就绪的协程（包括执行期间新就绪的），直到全部再次挂起或结束
+     * @return 恢复次数
+     */
+    size_t runReady() {
+        size_t resumed = 0;
+        while (!ready.empty()) {
+            std::coroutine_handle<> handle = ready.front();
+            ready.pop_front();
+            handle.resume();
+            ++resumed;
+        }
+        return resumed;
+    }
+
+    /**
+     * @brief 销毁已结束的顶层会话
+     * @return 本次回收的会话数
+     */
+    size_t reapFinished() {
+        size_t reaped = 0;
+        for (size_t i = 0; i < roots.size();) {
+            if (!roots[i].done()) {
+                ++i;
+                continue;
+            }
+            if (roots[i].promise().exception) ++failedSessions;
+            roots[i].destroy();
+            roots[i] = roots.back();
+            roots.pop_back();
+            ++reaped;
+        }
+        return reaped;
+    }
+
+    size_t getActiveCount() const { return roots.size(); }
+    size_t getFailedCount() const { return failedSessions; }  ///< 以异常结束的会话数
+
+private:
+    std::vector<SessionTask<void>::Handle> roots;  ///< 调度器拥有的顶层会话
+    std::deque<std::coroutine_handle<>> ready;
+    size_t failedSessions = 0;
+};
+
+#endif // SESSIONTASK_H
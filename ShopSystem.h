@@ -6,79 +6,79 @@
 #include <string>
 #include <algorithm>
 #include <iomanip>
+#include <memory>
+#include <optional>
 #include "DatabaseManager.h"
+#include "PartitionRuntime.h"
 #include "User.h"
 #include "Product.h"
 #include "Order.h"
 #include "Complaint.h"
+#include "OperationMetrics.h"
 /**
  * @brief 商城系统核心类
  */
 class ShopSystem {
 private:
-    DatabaseManager db;
+    std::unique_ptr<DatabaseManager> ownedDb;  // 独立运行时自带的数据库
+    DatabaseManager& db;
     User currentUser;
     bool isLoggedIn;
-    std::vector<OrderItem> tempCart;
+    SessionToken sessionToken;
+    PartitionRuntime::Client* partitionClient;  // 非空时下单、取消和库存查询经分区运行时
 
 public:
-    ShopSystem() : isLoggedIn(false) {}
+    ShopSystem() : ownedDb(std::make_unique<DatabaseManager>()), db(*ownedDb), isLoggedIn(false),
+        partitionClient(nullptr) {}
 
-    // ==================== 用户认证 ====================
-    bool registerUser(const std::string& username, const std::string& password,
-        const std::string& userType = "customer",
-        const std::string& email = "", const std::string& phone = "") {
-        if (username.empty() || password.empty()) {
-            std::cout << "用户名和密码不能为空！" << std::endl;
-            return false;
-        }
-
-        if (username.length() < 3) {
-            std::cout << "用户名长度不能少于3个字符！" << std::endl;
-            return false;
-        }
-
-        if (password.length() < 6) {
-            std::cout << "密码长度不能少于6个字符！" << std::endl;
-            return false;
-        }
+    /**
+     * @brief 共享数据库构造：多个会话（如压测中的模拟用户）共用同一个 DatabaseManager
+     * @param sharedDb 共享的数据库，生命周期须长于本对象
+     */
+    explicit ShopSystem(DatabaseManager& sharedDb) : db(sharedDb), isLoggedIn(false), partitionClient(nullptr) {}
 
-        // 新增：手机号验证
-        if (phone.empty()) {
-            std::cout << "手机号不能为空！" << std::endl;
-            return false;
-        }
+    ShopSystem(const ShopSystem&) = delete;
+    ShopSystem& operator=(const ShopSystem&) = delete;
 
-        User tempUser("", "", "", "", phone);
-        if (!tempUser.isValidPhone()) {
-            std::cout << "手机号格式不正确！请输入11位有效手机号" << std::endl;
-            return false;
-        }
+    /**
+     * @brief 把本会话的下单、取消和库存查询切换到分区运行时，传空指针恢复加锁模式
+     * @param client 运行时须以本会话的数据库构造；客户端只能在一个线程中使用，同一线程的多个会话可以共用
+     */
+    void setPartitionClient(PartitionRuntime::Client* client) { partitionClient = client; }
 
-        if (db.userExists(username)) {
-            std::cout << "用户名已存在！" << std::endl;
+    // ==================== 用户认证 ====================
+    // 注册、登录和恢复会话只访问分片的用户表，不取引擎锁
+    bool registerUser(std::string username, std::string password,
+        std::string userType = "customer",
+        std::string email = "", std::string phone = "") {
+        ScopedOperationTimer timer(ShopOperation::RegisterUser);
+        if (const char* error = User::validateRegistration(username, password, phone)) {
+            std::cout << error << std::endl;
             return false;
         }
 
-        User newUser(username, password, userType, email, phone);
-        bool success = db.addUser(newUser);
-        if (success) {
-            std::cout << "注册成功！" << std::endl;
-        }
+        // 查重与插入在同一把分片锁内完成，并发注册同名用户时只有一个成功
+        bool success = db.addUser(User(std::move(username), std::move(password), std::move(userType),
+            std::move(email), std::move(phone)));
+        std::cout << (success ? "注册成功！" : "用户名已存在！") << std::endl;
         return success;
     }
 
     bool login(const std::string& username, const std::string& password) {
+        ScopedOperationTimer timer(ShopOperation::Login);
         if (username.empty() || password.empty()) {
             std::cout << "用户名和密码不能为空！" << std::endl;
             return false;
         }
 
-        User* user = db.getUser(username);
-        if (user && user->getPassword() == password) {
-            currentUser = *user;
+        int userId = db.findUserId(username);
+        User user;
+        if (userId >= 0 && db.copyUserById(static_cast<uint32_t>(userId), user) && user.getPassword() == password) {
+            currentUser = std::move(user);
             isLoggedIn = true;
-            tempCart.clear();
+            db.getSessions().revoke(sessionToken);
+            sessionToken = db.getSessions().issue(static_cast<uint32_t>(userId),
+                currentUser.isAdmin() ? UserRole::Admin : UserRole::Customer);
             std::cout << "登录成功！欢迎 " << username << std::endl;
             return true;
         }
@@ -89,14 +89,57 @@ public:
     }
 
     void logout() {
+        ScopedOperationTimer timer(ShopOperation::Logout);
+        db.getSessions().revoke(sessionToken);
+        sessionToken = SessionToken();
         currentUser = User();
         isLoggedIn = false;
-        tempCart.clear();
         std::cout << "已退出登录！" << std::endl;
     }
 
+    /**
+     * @brief 校验令牌，供无状态前端对每个请求鉴权，不访问用户表、不加引擎锁
+     * @param token 登录时签发的令牌（十六进制字符串）
+     * @param info 输出用户编号与角色
+     */
+    bool authenticate(std::string_view token, SessionInfo& info) {
+        ScopedOperationTimer timer(ShopOperation::Authenticate);
+        return db.getSessions().resolve(token, info);
+    }
+
+    /**
+     * @brief 用令牌恢复登录状态，使本对象可代表该用户处理一次请求
+     */
+    bool resumeSession(std::string_view token) {
+        ScopedOperationTimer timer(ShopOperation::ResumeSession);
+        SessionInfo info;
+        SessionToken parsed = SessionToken::parse(token);
+        if (!db.getSessions().resolve(parsed, info)) {
+            return false;
+        }
+
+        User user;
+        if (!db.copyUserById(info.userId, user)) return false;
+
+        currentUser = std::move(user);
+        isLoggedIn = true;
+        sessionToken = parsed;
+        return true;
+    }
+
+    /**
+     * @brief 批量导入用户（管理员），校验规则与注册相同，只访问分片的用户表，不取引擎锁
+     */
+    UserImportReport importUsers(std::vector<User>& users, unsigned threadCount = 0) {
+        ScopedOperationTimer timer(ShopOperation::ImportUsers);
+        if (!checkAdminPermission()) return UserImportReport();
+        return db.importUsers(users, threadCount);
+    }
+
+    const SessionToken& getSessionToken() const { return sessionToken; }
+
     bool isUserLoggedIn() const { return isLoggedIn; }
-    User getCurrentUser() const { return currentUser; }
+    const User& getCurrentUser() const { return currentUser; }
 
     std::string getLoginStatus() const {
         if (!isLoggedIn) return "未登录";
@@ -106,9 +149,11 @@ public:
 
     // ==================== 商品管理 ====================
     // 用户上架商品
-    bool addProduct(const std::string& id, const std::string& name,
-        const std::string& category, double price, int stock,
-        const std::string& description = "") {
+    bool addProduct(std::string id, std::string name,
+        std::string category, Money price, int stock,
+        std::string description = "") {
+        ScopedOperationTimer timer(ShopOperation::AddProduct);
+        auto guard = db.lock();
         if (!isLoggedIn) {
             std::cout << "请先登录！" << std::endl;
             return false;
@@ -119,7 +164,7 @@ public:
             return false;
         }
 
-        if (price <= 0) {
+        if (price <= Money()) {
             std::cout << "价格必须大于0！" << std::endl;
             return false;
         }
@@ -130,10 +175,8 @@ public:
         }
 
         // 创建商品，包含卖家信息
-        Product product(id, name, category, price, stock, description,
-            true, currentUser.getUsername(), currentUser.getPhone());
-
-        bool success = db.addProduct(product);
+        bool success = db.addProduct(Product(std::move(id), std::move(name), std::move(category),
+            price, stock, std::move(description), true, currentUser.getUsername(), currentUser.getPhone()));
         if (success) {
             std::cout << "商品上架成功！" << std::endl;
         }
@@ -145,12 +188,14 @@ public:
 
     // 用户下架自己的商品
     bool deactivateMyProduct(const std::string& productId) {
+        ScopedOperationTimer timer(ShopOperation::DeactivateMyProduct);
+        auto guard = db.lock();
         if (!isLoggedIn) {
             std::cout << "请先登录！" << std::endl;
             return false;
         }
 
-        Product* product = db.getProduct(productId);
+        auto product = db.getProduct(productId);
         if (!product) {
             std::cout << "商品不存在！" << std::endl;
             return false;
@@ -162,8 +207,7 @@ public:
             return false;
         }
 
-        product->deactivate();
-        bool success = db.updateProduct(*product);
+        bool success = db.deactivateProduct(productId);
         if (success) {
             std::cout << "商品下架成功！" << std::endl;
         }
@@ -172,12 +216,14 @@ public:
 
     // 用户重新上架自己的商品
     bool activateMyProduct(const std::string& productId) {
+        ScopedOperationTimer timer(ShopOperation::ActivateMyProduct);
+        auto guard = db.lock();
         if (!isLoggedIn) {
             std::cout << "请先登录！" << std::endl;
             return false;
         }
 
-        Product* product = db.getProduct(productId);
+        auto product = db.getProduct(productId);
         if (!product) {
             std::cout << "商品不存在！" << std::endl;
             return false;
@@ -189,8 +235,7 @@ public:
             return false;
         }
 
-        product->activate();
-        bool success = db.updateProduct(*product);
+        bool success = db.activateProduct(productId);
         if (success) {
             std::cout << "商品上架成功！" << std::endl;
         }
@@ -198,22 +243,28 @@ public:
     }
 
     // 获取用户自己的商品
+    /**
+     * @brief 卖家看板：售出件数、销售额、进行中订单数、投诉数，O(1)
+     */
+    SellerStats getMySellerStats() {
+        ScopedOperationTimer timer(ShopOperation::GetSellerStats);
+        auto guard = db.lock();
+        if (!isLoggedIn) return SellerStats();
+        return db.getSellerStats(currentUser.getUsername());
+    }
+
     std::vector<Product> getMyProducts() {
+        ScopedOperationTimer timer(ShopOperation::GetMyProducts);
+        auto guard = db.lock();
         if (!isLoggedIn) return std::vector<Product>();
 
-        std::vector<Product> allProducts = db.getAllProducts();
-        std::vector<Product> myProducts;
-
-        for (const auto& product : allProducts) {
-            if (product.getSellerUsername() == currentUser.getUsername()) {
-                myProducts.push_back(product);
-            }
-        }
-        return myProducts;
+        return db.getProductsBySeller(currentUser.getUsername());
     }
 
     // 管理员商品状态管理
     bool activateProduct(const std::string& productId) {
+        ScopedOperationTimer timer(ShopOperation::ActivateProduct);
+        auto guard = db.lock();
         if (!checkAdminPermission()) return false;
 
         bool success = db.activateProduct(productId);
@@ -227,6 +278,8 @@ public:
     }
 
     bool deactivateProduct(const std::string& productId) {
+        ScopedOperationTimer timer(ShopOperation::DeactivateProduct);
+        auto guard = db.lock();
         if (!checkAdminPermission()) return false;
 
         bool success = db.deactivateProduct(productId);
@@ -239,44 +292,81 @@ public:
         return success;
     }
 
-    std::vector<Product> browseProducts() {
-        return db.getActiveProducts();
+    /**
+     * @brief 浏览上架商品；浏览和关键词搜索读目录快照，不取引擎锁，不阻塞也不被写操作阻塞
+     *
+     * 结果经 ProductView 读取、不复制商品，持有期间占用快照读槽，显示完即应释放
+     */
+    ProductListing browseProducts() {
+        ScopedOperationTimer timer(ShopOperation::BrowseProducts);
+        return db.listActiveProducts();
     }
 
     std::vector<Product> searchProducts(const std::string& keyword) {
+        ScopedOperationTimer timer(ShopOperation::SearchProducts);
         return db.searchProducts(keyword);
     }
 
-    Product* getProduct(const std::string& productId) {
+    /**
+     * @brief 按相关度排序的分页搜索
+     * @param page 页码，从 0 开始
+     */
+    SearchPage searchProductsRanked(const std::string& keyword, size_t page = 0, size_t pageSize = 10) {
+        ScopedOperationTimer timer(ShopOperation::RankedSearchProducts);
+        auto guard = db.lock();
+        return db.searchProductsRanked(keyword, page, pageSize);
+    }
+
+    /**
+     * @brief 容错搜索，关键词有错别字时也能找到商品
+     * @param maxDistance 允许的编辑距离，负数表示按关键词长度自动选择
+     */
+    std::vector<Product> fuzzySearchProducts(const std::string& keyword, int maxDistance = -1) {
+        ScopedOperationTimer timer(ShopOperation::FuzzySearchProducts);
+        auto guard = db.lock();
+        return db.fuzzySearchProducts(keyword, maxDistance);
+    }
+
+    // 返回商品的副本，不存在时为空
+    std::optional<Product> getProduct(const std::string& productId) {
+        ScopedOperationTimer timer(ShopOperation::GetProduct);
+        auto guard = db.lock();
         return db.getProduct(productId);
     }
 
     // 获取所有商品（管理员用，包括下架的）
     std::vector<Product> getAllProductsForAdmin() {
+        ScopedOperationTimer timer(ShopOperation::GetAllProductsForAdmin);
+        auto guard = db.lock();
         if (!checkAdminPermission()) return std::vector<Product>();
         return db.getAllProducts();
     }
 
     // 获取上架商品（客户用）
     std::vector<Product> getActiveProducts() {
+        ScopedOperationTimer timer(ShopOperation::GetActiveProducts);
         return db.getActiveProducts();
     }
 
     // 获取下架商品
     std::vector<Product> getInactiveProducts() {
+        ScopedOperationTimer timer(ShopOperation::GetInactiveProducts);
+        auto guard = db.lock();
         if (!checkAdminPermission()) return std::vector<Product>();
         return db.getInactiveProducts();
     }
     // 在 ShopSystem.h 的 public 部分添加投诉相关方法：
 // ==================== 投诉管理 ====================
-    bool addComplaint(const std::string& productId, const std::string& complaintType,
-        const std::string& title, const std::string& content) {
+    bool addComplaint(const std::string& productId, std::string complaintType,
+        std::string title, std::string content) {
+        ScopedOperationTimer timer(ShopOperation::AddComplaint);
+        auto guard = db.lock();
         if (!isLoggedIn) {
             std::cout << "请先登录！" << std::endl;
             return false;
         }
 
-        Product* product = db.getProduct(productId);
+        auto product = db.getProduct(productId);
         if (!product) {
             std::cout << "商品不存在！" << std::endl;
             return false;
@@ -284,16 +374,19 @@ public:
 
         // 创建投诉
         Complaint complaint(productId, product->getName(), currentUser.getUsername(),
-            complaintType, title, content);
+            std::move(complaintType), std::move(title), std::move(content));
+        std::string complaintId = complaint.getComplaintId();
 
-        bool success = db.addComplaint(complaint);
+        bool success = db.addComplaint(std::move(complaint));
         if (success) {
-            std::cout << "投诉提交成功！投诉ID: " << complaint.getComplaintId() << std::endl;
+            std::cout << "投诉提交成功！投诉ID: " << complaintId << std::endl;
         }
         return success;
     }
 
     std::vector<Complaint> getMyComplaints() {
+        ScopedOperationTimer timer(ShopOperation::GetMyComplaints);
+        auto guard = db.lock();
         if (!isLoggedIn) {
             std::cout << "请先登录！" << std::endl;
             return std::vector<Complaint>();
@@ -302,16 +395,22 @@ public:
     }
 
     std::vector<Complaint> getAllComplaints() {
+        ScopedOperationTimer timer(ShopOperation::GetAllComplaints);
+        auto guard = db.lock();
         if (!checkAdminPermission()) return std::vector<Complaint>();
         return db.getAllComplaints();
     }
 
     std::vector<Complaint> getPendingComplaints() {
+        ScopedOperationTimer timer(ShopOperation::GetPendingComplaints);
+        auto guard = db.lock();
         if (!checkAdminPermission()) return std::vector<Complaint>();
         return db.getPendingComplaints();
     }
 
-    bool processComplaint(const std::string& complaintId, const std::string& response) {
+    bool processComplaint(const std::string& complaintId, std::string response) {
+        ScopedOperationTimer timer(ShopOperation::ProcessComplaint);
+        auto guard = db.lock();
         if (!checkAdminPermission()) return false;
 
         Complaint* complaint = db.getComplaint(complaintId);
@@ -320,21 +419,129 @@ public:
             return false;
         }
 
-        complaint->processComplaint(response, currentUser.getUsername());
+        if (complaint->isProcessed()) {
+            std::cout << "该投诉已处理！" << std::endl;
+            return false;
+        }
+
+        // 其他管理员领取中（租约未过期）的投诉不能处理
+        if (db.isComplaintClaimed(complaintId) && complaint->getAdminUser() != currentUser.getUsername()) {
+            std::cout << "该投诉已被管理员 " << complaint->getAdminUser() << " 领取！" << std::endl;
+            return false;
+        }
+
+        complaint->processComplaint(std::move(response), currentUser.getUsername());
         bool success = db.updateComplaint(*complaint);
         if (success) {
             std::cout << "投诉处理成功！" << std::endl;
         }
         return success;
     }
+    /**
+     * @brief 领取优先级最高的待处理投诉，领取期间其他管理员不能处理
+     * @param result 领取到的投诉
+     * @return 没有待处理投诉时返回 false
+     */
+    bool claimNextComplaint(Complaint& result) {
+        ScopedOperationTimer timer(ShopOperation::ClaimComplaint);
+        auto guard = db.lock();
+        if (!checkAdminPermission()) return false;
+
+        Complaint* complaint = db.claimNextComplaint(currentUser.getUsername());
+        if (!complaint) {
+            std::cout << "暂无待处理投诉！" << std::endl;
+            return false;
+        }
+        result = *complaint;
+        return true;
+    }
+
+    // 放弃已领取的投诉，放回队列
+    bool releaseComplaint(const std::string& complaintId) {
+        ScopedOperationTimer timer(ShopOperation::ReleaseComplaint);
+        auto guard = db.lock();
+        if (!checkAdminPermission()) return false;
+
+        if (!db.releaseComplaint(complaintId, currentUser.getUsername())) {
+            std::cout << "只能归还自己领取的投诉！" << std::endl;
+            return false;
+        }
+        std::cout << "投诉已放回待处理队列" << std::endl;
+        return true;
+    }
+
+    /**
+     * @brief 与该投诉内容相近、尚未处理的其他投诉（同一商品）
+     */
+    std::vector<Complaint> getSimilarComplaints(const std::string& complaintId) {
+        ScopedOperationTimer timer(ShopOperation::GetSimilarComplaints);
+        auto guard = db.lock();
+        if (!checkAdminPermission()) return std::vector<Complaint>();
+
+        std::vector<Complaint> result;
+        for (const Complaint* complaint : db.getOpenComplaintCluster(complaintId)) {
+            if (complaint->getComplaintId() != complaintId) {
+                result.push_back(*complaint);
+            }
+        }
+        return result;
+    }
+
+    /**
+     * @brief 用同一回复处理该投诉及其所有相似的未处理投诉
+     *
+     * 被其他管理员领取中（租约未过期）的投诉跳过，留给领取人处理。
+     * @return 处理的投诉条数，投诉不存在或无权限时返回 0
+     */
+    int processComplaintCluster(const std::string& complaintId, const std::string& response) {
+        ScopedOperationTimer timer(ShopOperation::ProcessComplaintCluster);
+        auto guard = db.lock();
+        if (!checkAdminPermission()) return 0;
+
+        std::vector<Complaint*> cluster = db.getOpenComplaintCluster(complaintId);
+        if (cluster.empty()) {
+            std::cout << "投诉不存在或已处理！" << std::endl;
+            return 0;
+        }
+
+        // 整组在同一事务中处理，要么全部回复，要么都不变
+        auto transaction = db.beginTransaction();
+        int processed = 0;
+        int skipped = 0;
+        for (const Complaint* complaint : cluster) {
+            if (db.isComplaintClaimed(complaint->getComplaintId()) &&
+                complaint->getAdminUser() != currentUser.getUsername()) {
+                ++skipped;
+                continue;
+            }
+            Complaint answered = *complaint;
+            answered.processComplaint(response, currentUser.getUsername());
+            transaction.updateComplaint(std::move(answered));
+            ++processed;
+        }
+        if (!transaction.commit()) {
+            std::cout << "处理失败：" << transaction.getError() << std::endl;
+            return 0;
+        }
+
+        std::cout << "已处理 " << processed << " 条投诉";
+        if (skipped > 0) {
+            std::cout << "，" << skipped << " 条已被其他管理员领取，未处理";
+        }
+        std::cout << std::endl;
+        return processed;
+    }
+
     // ==================== 购物车操作 ====================
+    // 加购和改数量只读商品副本、写自带锁的购物车表，不取引擎锁（运行时模式下的库存查询不能在引擎锁内进行）
     bool addToCart(const std::string& productId, int quantity) {
+        ScopedOperationTimer timer(ShopOperation::AddToCart);
         if (!isLoggedIn) {
             std::cout << "请先登录！" << std::endl;
             return false;
         }
 
-        Product* product = db.getProduct(productId);
+        auto product = db.getProduct(productId);
         if (!product) {
             std::cout << "商品不存在！" << std::endl;
             return false;
@@ -357,97 +564,159 @@ public:
             return false;
         }
 
-        if (!product->hasEnoughStock(quantity)) {
-            std::cout << "库存不足！当前库存: " << product->getStock() << std::endl;
+        int stock = currentStock(*product);
+        if (stock < quantity) {
+            std::cout << "库存不足！当前库存: " << stock << std::endl;
             return false;
         }
 
-        // 检查是否已在购物车中
-        for (auto& item : tempCart) {
-            if (item.getProductId() == productId) {
-                item.setQuantity(item.getQuantity() + quantity);
-                std::cout << "已更新购物车中的商品数量" << std::endl;
-                return true;
+        // 检查是否已在购物车中（哈希查找）
+        bool existing = db.getCarts().contains(currentUser.getUsername(), productId);
+
+        // 添加到购物车，包含卖家信息；已存在时累加数量
+        db.getCarts().addItem(currentUser.getUsername(), OrderItem(productId, product->getName(), quantity,
+            product->getPrice(), product->getSellerUsername(), product->getSellerPhone()));
+        std::cout << (existing ? "已更新购物车中的商品数量" : "商品已添加到购物车") << std::endl;
+        return true;
+    }
+
+    bool updateCartQuantity(const std::string& productId, int quantity) {
+        ScopedOperationTimer timer(ShopOperation::UpdateCartQuantity);
+        if (!isLoggedIn) {
+            std::cout << "请先登录！" << std::endl;
+            return false;
+        }
+
+        if (quantity < 0) {
+            std::cout << "数量不能为负数！" << std::endl;
+            return false;
+        }
+
+        auto product = db.getProduct(productId);
+        if (quantity > 0 && product) {
+            int stock = currentStock(*product);
+            if (stock < quantity) {
+                std::cout << "库存不足！当前库存: " << stock << std::endl;
+                return false;
             }
         }
 
-        // 添加到购物车，包含卖家信息
-        tempCart.push_back(OrderItem(productId, product->getName(), quantity,
-            product->getPrice(), product->getSellerUsername(),
-            product->getSellerPhone()));
-        std::cout << "商品已添加到购物车" << std::endl;
+        if (!db.getCarts().setQuantity(currentUser.getUsername(), productId, quantity)) {
+            std::cout << "购物车中没有该商品！" << std::endl;
+            return false;
+        }
+        std::cout << (quantity == 0 ? "已从购物车移除" : "已更新购物车中的商品数量") << std::endl;
         return true;
     }
 
-    std::vector<OrderItem> getCartItems() const {
-        return tempCart;
-    }
+    bool removeFromCart(const std::string& productId) {
+        ScopedOperationTimer timer(ShopOperation::RemoveFromCart);
+        auto guard = db.lock();
+        if (!isLoggedIn) {
+            std::cout << "请先登录！" << std::endl;
+            return false;
+        }
 
-    double getCartTotal() const {
-        double total = 0.0;
-        for (const auto& item : tempCart) {
-            total += item.getTotalPrice();
+        if (!db.getCarts().removeItem(currentUser.getUsername(), productId)) {
+            std::cout << "购物车中没有该商品！" << std::endl;
+            return false;
         }
-        return total;
+        std::cout << "已从购物车移除" << std::endl;
+        return true;
+    }
+
+    void clearCart() {
+        ScopedOperationTimer timer(ShopOperation::ClearCart);
+        auto guard = db.lock();
+        if (!isLoggedIn) return;
+        db.getCarts().clear(currentUser.getUsername());
+        std::cout << "购物车已清空" << std::endl;
+    }
+
+    // 购物车表自带锁，读取副本（同一用户的其他会话可能同时修改）
+    bool hasCartItems() const {
+        ScopedOperationTimer timer(ShopOperation::HasCartItems);
+        Cart cart;
+        return myCart(cart) && !cart.empty();
+    }
+
+    // 合计金额随购物车修改增量维护，这里 O(1) 读取
+    Money getCartTotal() const {
+        ScopedOperationTimer timer(ShopOperation::GetCartTotal);
+        Cart cart;
+        return myCart(cart) ? cart.getTotal() : Money();
     }
 
     void displayCart() const {
-        if (tempCart.empty()) {
+        ScopedOperationTimer timer(ShopOperation::DisplayCart);
+        Cart cart;
+        if (!myCart(cart) || cart.empty()) {
             std::cout << "购物车为空" << std::endl;
             return;
         }
 
         std::cout << "=== 购物车 ===" << std::endl;
-        for (const auto& item : tempCart) {
+        for (const auto& item : cart.getItems()) {
             item.displayInfo();
         }
-        std::cout << "总计: Y" << std::fixed << std::setprecision(2) << getCartTotal() << std::endl;
+        std::cout << "总计: Y" << cart.getTotal() << std::endl;
     }
 
     // ==================== 订单管理 ====================
-    Order createOrder(const std::string& address, const std::string& payment) {
+    // 下单和取消不取引擎锁：事务只锁涉及的商品块和订单分片，不同用户的下单可以并行；
+    // 设置了分区运行时客户端时改由运行时的分区线程提交同样的事务
+    Order createOrder(std::string address, std::string payment) {
+        ScopedOperationTimer timer(ShopOperation::CreateOrder);
         if (!isLoggedIn) {
             std::cout << "请先登录！" << std::endl;
             return Order();
         }
 
-        if (tempCart.empty()) {
+        // 先检查库存，不足时购物车保持不变；之后仍可能被其他会话抢先买走，由事务判断
+        Cart cart;
+        if (!myCart(cart) || cart.empty()) {
             std::cout << "购物车为空！" << std::endl;
             return Order();
         }
-
-        // 检查库存
-        for (const auto& item : tempCart) {
-            Product* product = db.getProduct(item.getProductId());
-            if (!product || !product->hasEnoughStock(item.getQuantity())) {
+        for (const auto& item : cart.getItems()) {
+            auto product = db.getProduct(item.getProductId());
+            if (!product || currentStock(*product) < item.getQuantity()) {
                 std::cout << "商品 " << item.getProductName() << " 库存不足！" << std::endl;
                 return Order();
             }
         }
 
-        // 创建订单，包含买家手机号
-        Order order(currentUser.getUsername(), tempCart, address, payment, currentUser.getPhone());
-
-        // 减少库存
-        for (const auto& item : tempCart) {
-            Product* product = db.getProduct(item.getProductId());
-            if (product) {
-                product->reduceStock(item.getQuantity());
-                db.updateProduct(*product);
+        // 创建订单，包含买家手机号；购物车内容直接移入订单
+        std::vector<OrderItem> items = db.getCarts().takeItems(currentUser.getUsername());
+        if (items.empty()) {
+            std::cout << "购物车为空！" << std::endl;
+            return Order();
+        }
+        Order order;
+        std::string error;
+        bool durable = true;
+        if (!placeOrder(items, std::move(address), std::move(payment), order, error, durable)) {
+            // 失败时商品放回购物车
+            for (auto& item : items) {
+                db.getCarts().addItem(currentUser.getUsername(), std::move(item));
             }
+            std::cout << "下单失败：" << error << std::endl;
+            return Order();
         }
 
-        // 保存订单
-        if (db.addOrder(order)) {
-            tempCart.clear();
-            std::cout << "订单创建成功！订单ID: " << order.getOrderId() << std::endl;
+        // 事务已在内存中生效（库存已扣、订单可见），落盘失败也照实返回订单，只提示未能持久化
+        if (!durable) {
+            std::cout << "订单已创建但未能写入磁盘，服务重启后可能丢失，请联系管理员。订单ID: "
+                << order.getOrderId() << std::endl;
             return order;
         }
-
-        return Order();
+        std::cout << "订单创建成功！订单ID: " << order.getOrderId() << std::endl;
+        return order;
     }
 
+    // 订单表按用户分片，查看自己的订单只锁所在分片
     std::vector<Order> getUserOrders() {
+        ScopedOperationTimer timer(ShopOperation::GetUserOrders);
         if (!isLoggedIn) {
             std::cout << "请先登录！" << std::endl;
             return std::vector<Order>();
@@ -455,62 +724,289 @@ public:
         return db.getOrdersByUser(currentUser.getUsername());
     }
 
-    bool cancelOrder(const std::string& orderId) {
+    /**
+     * @brief 查看订单详情，热数据中找不到时再查归档
+     * @param orderId 订单ID
+     * @param result 找到的订单
+     * @return 订单不存在或无权查看时返回 false
+     */
+    bool getOrderDetails(const std::string& orderId, Order& result) {
+        ScopedOperationTimer timer(ShopOperation::GetOrderDetails);
         if (!isLoggedIn) {
             std::cout << "请先登录！" << std::endl;
             return false;
         }
 
-        Order* order = db.getOrder(orderId);
-        if (!order) {
+        // 热订单只需分片锁；归档的段缓存由引擎锁保护
+        Order order;
+        bool found = db.copyOrder(orderId, order);
+        if (!found) {
+            auto guard = db.lock();
+            found = db.findArchivedOrder(orderId, order);
+        }
+        if (!found) {
             std::cout << "订单不存在！" << std::endl;
             return false;
         }
 
-        if (order->getUsername() != currentUser.getUsername()) {
-            std::cout << "无权操作此订单！" << std::endl;
+        if (order.getUsername() != currentUser.getUsername() && !currentUser.isAdmin()) {
+            std::cout << "无权查看此订单！" << std::endl;
             return false;
         }
+        result = std::move(order);
+        return true;
+    }
 
-        if (order->canCancel()) {
-            order->cancel();
+    // 已归档的历史订单，按需从归档段中解压
+    std::vector<Order> getArchivedOrders() {
+        ScopedOperationTimer timer(ShopOperation::GetArchivedOrders);
+        auto guard = db.lock();
+        if (!isLoggedIn) {
+            std::cout << "请先登录！" << std::endl;
+            return std::vector<Order>();
+        }
+        return db.getArchivedOrdersByUser(currentUser.getUsername());
+    }
 
-            // 恢复库存
-            for (const auto& item : order->getItems()) {
-                Product* product = db.getProduct(item.getProductId());
-                if (product) {
-                    product->increaseStock(item.getQuantity());
-                    db.updateProduct(*product);
-                }
-            }
+    bool cancelOrder(const std::string& orderId) {
+        ScopedOperationTimer timer(ShopOperation::CancelOrder);
+        if (!isLoggedIn) {
+            std::cout << "请先登录！" << std::endl;
+            return false;
+        }
 
-            bool success = db.updateOrder(*order);
-            if (success) {
-                std::cout << "订单取消成功！" << std::endl;
-            }
-            return success;
+        // 订单的用户和商品不会变化，读副本即可；状态是否还能取消由事务在分片锁内判断
+        Order order;
+        if (!db.copyOrder(orderId, order)) {
+            std::cout << "订单不存在！" << std::endl;
+            return false;
         }
-        else {
+
+        if (order.getUsername() != currentUser.getUsername()) {
+            std::cout << "无权操作此订单！" << std::endl;
+            return false;
+        }
+
+        bool durable = true;
+        if (!cancelPlacedOrder(order, durable)) {
             std::cout << "订单无法取消！" << std::endl;
             return false;
         }
+
+        // 取消已在内存中生效，落盘失败时仍返回 true，只提示未能持久化
+        if (!durable) {
+            std::cout << "订单已取消但未能写入磁盘，服务重启后可能恢复为未取消状态，请联系管理员" << std::endl;
+            return true;
+        }
+        std::cout << "订单取消成功！" << std::endl;
+        return true;
+    }
+
+    // ==================== 畅销榜 ====================
+    /**
+     * @brief 畅销榜前 limit 名（只列出上架中的商品）
+     * @param category 商品类别，为空表示全部
+     * @param recentOnly true 表示只统计最近几天（窗口榜）
+     */
+    std::vector<BestSeller> getBestSellers(size_t limit, const std::string& category = "", bool recentOnly = false) {
+        ScopedOperationTimer timer(ShopOperation::GetBestSellers);
+        std::vector<BestSeller> result;
+        db.forEachBestSeller(category, recentOnly, [&](const std::string& productId, long long units) {
+            if (result.size() >= limit) return false;
+            auto product = db.getProduct(productId);
+            if (product && product->getIsActive()) {
+                result.push_back(BestSeller{ std::move(*product), units });
+            }
+            return true;
+        });
+        return result;
+    }
+
+    int getBestSellerWindowDays() const {
+        ScopedOperationTimer timer(ShopOperation::GetBestSellerWindowDays);
+        return db.getBestSellerWindowDays();
+    }
+
+    // ==================== 订单归档 ====================
+    /**
+     * @brief 立即归档超过期限的已结束订单（平时由下单操作定期触发）
+     * @return 归档的订单数
+     */
+    size_t archiveFinishedOrders() {
+        ScopedOperationTimer timer(ShopOperation::ArchiveOrders);
+        auto guard = db.lock();
+        if (!checkAdminPermission()) return 0;
+        return db.archiveFinishedOrders();
+    }
+
+    void displayOrderArchiveInfo() const {
+        ScopedOperationTimer timer(ShopOperation::DisplayOrderArchiveInfo);
+        auto guard = db.lock();
+        if (!checkAdminPermission()) return;
+
+        const OrderArchive& archive = db.getOrderArchive();
+        std::cout << "活跃订单: " << db.getActiveOrderCount() << std::endl;
+        std::cout << "已归档订单: " << archive.getOrderCount() << std::endl;
+        std::cout << "归档段数: " << archive.getSegmentCount() << std::endl;
+        std::cout << "归档期限: " << db.getOrderArchiveAge().count() / 86400 << " 天" << std::endl;
+        if (archive.getRawBytes() > 0) {
+            std::cout << "压缩率: " << std::fixed << std::setprecision(1)
+                << 100.0 * archive.getCompressedBytes() / archive.getRawBytes() << "% ("
+                << archive.getCompressedBytes() << " / " << archive.getRawBytes() << " 字节)" << std::endl;
+        }
     }
 
     // ==================== 管理员统计功能 ====================
     void displayStatistics() const {
+        ScopedOperationTimer timer(ShopOperation::DisplayStatistics);
+        auto guard = db.lock();
         if (!checkAdminPermission()) return;
 
         std::cout << "=== 系统统计 ===" << std::endl;
         std::cout << "用户总数: " << db.getTotalUserCount() << std::endl;
         std::cout << "商品总数: " << db.getTotalProductCount() << std::endl;
         std::cout << "上架商品: " << db.getActiveProductCount() << std::endl;
-        std::cout << "订单总数: " << db.getTotalOrderCount() << std::endl;
+        std::cout << "订单总数: " << db.getTotalOrderCount()
+            << " (已归档 " << db.getOrderArchive().getOrderCount() << ")" << std::endl;
+        std::cout << "购物车数: " << db.getCartCount() << std::endl;
         std::cout << "投诉总数: " << db.getTotalComplaintCount() << std::endl;  // 新增
         std::cout << "待处理投诉: " << db.getPendingComplaintCount() << std::endl;  // 新增
+        std::cout << "处理中投诉: " << db.getClaimedComplaintCount() << std::endl;
         std::cout << "总销售额: Y" << std::fixed << std::setprecision(2) << db.getTotalSales() << std::endl;
+
+        QueryCacheStats cache = db.getQueryCacheStats();
+        std::cout << "查询缓存: 命中率 " << std::setprecision(1) << 100.0 * cache.getHitRate() << "% ("
+            << cache.hits << " / " << cache.hits + cache.misses << "), 条目 " << cache.entryCount
+            << ", 内存 " << cache.memoryBytes / 1024 << " / " << cache.capacityBytes / 1024 << " KB" << std::endl;
+        std::cout << "热订单内存: " << db.getHotOrderBytes() / 1024 << " KB" << std::endl;
+    }
+
+    /**
+     * @brief 显示各表和各索引的内存占用（管理员），数据量大时耗时较长
+     */
+    void displayMemoryUsage() {
+        ScopedOperationTimer timer(ShopOperation::DisplayMemoryUsage);
+        auto guard = db.lock();
+        if (!checkAdminPermission()) return;
+
+        MemoryReport report = db.getMemoryReport();
+        std::cout << "=== 内存占用（估算） ===" << std::endl;
+        std::cout << std::left << std::setw(16) << "名称" << std::right << std::setw(12) << "条目"
+            << std::setw(14) << "内存(KB)" << std::endl;
+        for (const auto& entry : report.entries) {
+            std::cout << std::left << std::setw(16) << entry.name << std::right << std::setw(12) << entry.usage.items
+                << std::setw(14) << std::fixed << std::setprecision(1) << entry.usage.bytes / 1024.0
+                << (entry.isIndex ? "  (索引)" : "") << std::endl;
+        }
+        std::cout << "合计: " << report.getTotalBytes() / 1024 << " KB, 其中索引 " << report.getIndexBytes() / 1024
+            << " KB" << std::endl;
+
+        const MemoryLimits& limits = db.getMemoryLimits();
+        const MemoryPressureStats& pressure = db.getMemoryPressureStats();
+        std::cout << "软上限: 热订单 " << (limits.hotOrderBytes ? std::to_string(limits.hotOrderBytes / 1024) + " KB" : "不限")
+            << ", 总计 " << (limits.totalBytes ? std::to_string(limits.totalBytes / 1024) + " KB" : "不限") << std::endl;
+        std::cout << "超限次数: " << pressure.overLimitEvents << ", 提前归档订单 " << pressure.ordersArchived
+            << ", 淘汰查询缓存 " << pressure.cacheBytesTrimmed / 1024 << " KB"
+            << (pressure.overLimit ? " (仍超过上限)" : "") << std::endl;
+    }
+
+    /**
+     * @brief 销售分析：按卖家、类别、商品、日期分组汇总
+     * @param threadCount 并行线程数，0 表示使用硬件线程数
+     */
+    SalesReport getSalesReport(unsigned threadCount = 0) const {
+        ScopedOperationTimer timer(ShopOperation::ComputeSalesReport);
+        auto guard = db.lock();
+        if (!checkAdminPermission()) return SalesReport();
+        return db.computeSalesReport(threadCount);
+    }
+
+    // ==================== 性能指标 ====================
+    std::vector<OperationStats> getOperationMetrics() const {
+        if (!checkAdminPermission()) return std::vector<OperationStats>();
+        return OperationMetrics::instance().snapshot();
+    }
+
+    std::string getOperationMetricsJson() const {
+        if (!checkAdminPermission()) return "";
+        return OperationMetrics::instance().toJson();
     }
 
 private:
+    bool myCart(Cart& result) const {
+        return isLoggedIn && db.getCarts().copyCart(currentUser.getUsername(), result);
+    }
+
+    // 商品的当前库存；运行时模式下向商品所属分区查询
+    int currentStock(const Product& product) {
+        return partitionClient ? partitionClient->getStock(product.getId()) : product.getStock();
+    }
+
+    /**
+     * @brief 扣减库存并保存订单，任一步失败全部撤销
+     * @param items 订单项，成功时可能已移入订单，失败时原样保留
+     * @param durable 输出订单日志是否已落盘（提交失败时不变）
+     */
+    bool placeOrder(std::vector<OrderItem>& items, std::string address, std::string payment,
+        Order& result, std::string& error, bool& durable) {
+        if (partitionClient) {
+            // 运行时：各商品所属分区预留库存，主分区以事务追加订单；名称和单价取下单时的商品资料
+            std::vector<CheckoutLine> lines;
+            lines.reserve(items.size());
+            for (const auto& item : items) {
+                lines.push_back(CheckoutLine{ item.getProductId(), item.getQuantity() });
+            }
+            if (!partitionClient->checkout(currentUser.getUsername(), lines, std::move(address), std::move(payment),
+                currentUser.getPhone(), result, error)) {
+                return false;
+            }
+            durable = partitionClient->waitDurable();
+            return true;
+        }
+
+        Order order(currentUser.getUsername(), std::move(items), std::move(address), std::move(payment),
+            currentUser.getPhone());
+        auto transaction = db.beginTransaction();
+        for (const auto& item : order.getItems()) {
+            transaction.reduceStock(item.getProductId(), item.getQuantity());
+        }
+        transaction.addOrder(order);
+        if (!transaction.commit()) {
+            items = order.getItems();
+            error = transaction.getError();
+            return false;
+        }
+        durable = transaction.waitDurable();
+        result = std::move(order);
+        return true;
+    }
+
+    /**
+     * @brief 取消订单（畅销榜随之更新）并恢复库存；已删除的商品不再恢复库存
+     * @param durable 输出订单日志是否已落盘（取消失败时不变）
+     */
+    bool cancelPlacedOrder(const Order& order, bool& durable) {
+        if (partitionClient) {
+            // 运行时：主分区以事务改状态，库存由商品所属分区随后归还
+            std::string error;
+            if (!partitionClient->cancelOrder(currentUser.getUsername(), order.getOrderId(), error)) return false;
+            durable = partitionClient->waitDurable();
+            return true;
+        }
+
+        // 取消和恢复库存在同一事务中
+        auto transaction = db.beginTransaction();
+        transaction.cancelOrder(order.getOrderId());
+        for (const auto& item : order.getItems()) {
+            if (db.productExists(item.getProductId())) {
+                transaction.increaseStock(item.getProductId(), item.getQuantity());
+            }
+        }
+        if (!transaction.commit()) return false;
+        durable = transaction.waitDurable();
+        return true;
+    }
+
     bool checkAdminPermission() const {
         if (!isLoggedIn) {
             std::cout << "请先登录！" << std::endl;
@@ -0,0 +1,119 @@
+﻿#ifndef SNAPSHOTCELL_H
+#define SNAPSHOTCELL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 按纪元回收的快照单元（RCU 风格）- 读者无锁读取不可变快照，写入方原子发布新版本
+ *
+ * 读者在 SLOT_COUNT 个读槽中占用一个，登记当前全局纪元后读取快照指针，读完释放读槽；
+ * 读取过程中只有对本线程读槽的一次 CAS 和一次写，不修改任何共享计数，读者之间互不争用。
+ * 写入方用新快照替换指针，旧快照连同发布时的纪元号放入待回收列表，纪元加一；
+ * 所有正在读的读者登记的纪元都大于某个旧快照的纪元号时，该快照已不可能被读到，可以释放。
+ * publish 须由调用方串行化（如在引擎锁内调用）。
+ */
+template <typename T>
+class SnapshotCell {
+private:
+    static constexpr size_t SLOT_COUNT = 128;
+    static constexpr uint64_t IDLE = UINT64_MAX;
+
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> epoch{ IDLE };
+    };
+
+public:
+    /**
+     * @brief 读者持有的快照，析构时释放读槽；持有期间快照不会被回收
+     */
+    class ReadGuard {
+    public:
+        ReadGuard(ReadGuard&& other) noexcept
+            : slot(std::exchange(other.slot, nullptr)), snapshot(other.snapshot) {
+        }
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+        ReadGuard& operator=(ReadGuard&&) = delete;
+
+        ~ReadGuard() {
+            if (slot) slot->epoch.store(IDLE, std::memory_order_release);
+        }
+
+        const T& operator*() const { return *snapshot; }
+        const T* operator->() const { return snapshot; }
+
+    private:
+        friend class SnapshotCell;
+        ReadGuard(ReaderSlot* slot, const T* snapshot) : slot(slot), snapshot(snapshot) {}
+
+        ReaderSlot* slot;
+        const T* snapshot;
+    };
+
+    explicit SnapshotCell(std::unique_ptr<T> initial)
+        : slots(std::make_unique<ReaderSlot[]>(SLOT_COUNT)), current(initial.release()) {
+    }
+
+    SnapshotCell(const SnapshotCell&) = delete;
+    SnapshotCell& operator=(const SnapshotCell&) = delete;
+
+    // 析构时不应再有读者
+    ~SnapshotCell() {
+        delete current.load();
+    }
+
+    /**
+     * @brief 获取当前快照；读槽从线程ID散列的位置开始找，通常一次即占到本线程常用的槽
+     */
+    ReadGuard read() const {
+        size_t start = std::hash<std::thread::id>{}(std::this_thread::get_id());
+        while (true) {
+            for (size_t i = 0; i < SLOT_COUNT; ++i) {
+                ReaderSlot& slot = slots[(start + i) % SLOT_COUNT];
+                uint64_t expected = IDLE;
+                // 先登记纪元再读指针（均为顺序一致），写入方扫描读槽时要么看到本次登记，
+                // 要么本次读到的已是新快照
+                if (slot.epoch.compare_exchange_strong(expected, epoch.load())) {
+                    return ReadGuard(&slot, current.load());
+                }
+            }
+            std::this_thread::yield();  // 读者数超过读槽数时等待
+        }
+    }
+
+    /**
+     * @brief 发布新快照，并回收已无读者的旧快照
+     */
+    void publish(std::unique_ptr<T> next) {
+        T* previous = current.exchange(next.release());
+        retired.emplace_back(epoch.fetch_add(1), std::unique_ptr<T>(previous));
+        reclaim();
+    }
+
+    // 尚未回收的旧快照数
+    size_t getRetiredCount() const { return retired.size(); }
+
+private:
+    std::unique_ptr<ReaderSlot[]> slots;
+    std::atomic<T*> current;
+    std::atomic<uint64_t> epoch{ 0 };
+    std::vector<std::pair<uint64_t, std::unique_ptr<T>>> retired;  ///< (发布新版本时的纪元, 旧快照)
+
+    void reclaim() {
+        uint64_t oldestReader = IDLE;
+        for (size_t i = 0; i < SLOT_COUNT; ++i) {
+            oldestReader = std::min(oldestReader, slots[i].epoch.load());
+        }
+        // 纪元号小于所有读者登记纪元的旧快照可以释放
+        std::erase_if(retired, [&](const auto& entry) { return entry.first < oldestReader; });
+    }
+};
+
+#endif // SNAPSHOTCELL_H
@@ -0,0 +1,70 @@
+﻿#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+/**
+ * @brief 单生产者单消费者的有界无锁队列（环形缓冲区）
+ *
+ * 生产者只写 tail、消费者只写 head，两者位于不同缓存行；双方各自缓存对方的位置，
+ * 只有缓存值显示队列满（或空）时才读取对方的原子变量，正常情况下入队出队不产生缓存行争用。
+ * 容量向上取整为 2 的幂。
+ */
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity = 1024) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        mask = size - 1;
+        slots = std::make_unique<T[]>(size);
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // 仅生产者调用；队列满时返回 false，value 保持不变
+    bool tryPush(T&& value) {
+        size_t tail = producer.position.load(std::memory_order_relaxed);
+        if (tail - producer.cachedOther > mask) {
+            producer.cachedOther = consumer.position.load(std::memory_order_acquire);
+            if (tail - producer.cachedOther > mask) return false;
+        }
+        slots[tail & mask] = std::move(value);
+        producer.position.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 仅消费者调用；队列空时返回 false
+    bool tryPop(T& value) {
+        size_t head = consumer.position.load(std::memory_order_relaxed);
+        if (head == consumer.cachedOther) {
+            consumer.cachedOther = producer.position.load(std::memory_order_acquire);
+            if (head == consumer.cachedOther) return false;
+        }
+        value = std::move(slots[head & mask]);
+        consumer.position.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 近似值，任一方均可调用
+    bool empty() const {
+        return consumer.position.load(std::memory_order_acquire) == producer.position.load(std::memory_order_acquire);
+    }
+
+private:
+    struct alignas(64) Side {
+        std::atomic<size_t> position{ 0 };
+        size_t cachedOther = 0;  ///< 上次读到的对方位置
+    };
+
+    Side producer;  ///< tail 与缓存的 head
+    Side consumer;  ///< head 与缓存的 tail
+    size_t mask;
+    std::unique_ptr<T[]> slots;
+};
+
+#endif // SPSCQUEUE_H
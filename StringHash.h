@@ -0,0 +1,26 @@
+﻿#ifndef STRINGHASH_H
+#define STRINGHASH_H
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+/**
+ * @brief 透明字符串哈希 - 允许用 string_view 直接查找以 std::string 为键的哈希表
+ */
+struct StringHash {
+    using is_transparent = void;
+
+    size_t operator()(std::string_view text) const {
+        return std::hash<std::string_view>{}(text);
+    }
+};
+
+template <typename Value>
+using StringMap = std::unordered_map<std::string, Value, StringHash, std::equal_to<>>;
+
+using StringSet = std::unordered_set<std::string, StringHash, std::equal_to<>>;
+
+#endif // STRINGHASH_H
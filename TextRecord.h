@@ -0,0 +1,85 @@
+﻿#ifndef TEXTRECORD_H
+#define TEXTRECORD_H
+
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief 持久化文本记录的字段编码 - 购物车日志、订单日志和订单归档都按 '|'、';' 分隔字段
+ *
+ * 字段内容中的分隔符、反斜杠和换行写成转义序列，序列本身不含分隔符（'|' 写作 "\p"，';' 写作 "\s"），
+ * 各层拆分时直接查找分隔符即可，取出最内层的字段后再还原。
+ * 不认识的转义序列按原样保留，不含反斜杠的旧记录读出的结果与转义前相同。
+ */
+struct TextRecord {
+    static void appendField(std::string& out, std::string_view field) {
+        for (char c : field) {
+            switch (c) {
+            case '\\': out += "\\\\"; break;
+            case '|': out += "\\p"; break;
+            case ';': out += "\\s"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            default: out.push_back(c); break;
+            }
+        }
+    }
+
+    static std::string escape(std::string_view field) {
+        std::string out;
+        out.reserve(field.size());
+        appendField(out, field);
+        return out;
+    }
+
+    static std::string unescape(std::string_view field) {
+        if (field.find('\\') == std::string_view::npos) return std::string(field);
+        std::string out;
+        out.reserve(field.size());
+        for (size_t i = 0; i < field.size(); ++i) {
+            if (field[i] != '\\' || i + 1 == field.size()) {
+                out.push_back(field[i]);
+                continue;
+            }
+            switch (field[i + 1]) {
+            case '\\': out.push_back('\\'); break;
+            case 'p': out.push_back('|'); break;
+            case 's': out.push_back(';'); break;
+            case 'n': out.push_back('\n'); break;
+            case 'r': out.push_back('\r'); break;
+            default: out.append(field.substr(i, 2)); break;
+            }
+            ++i;
+        }
+        return out;
+    }
+
+    /**
+     * @brief 按分隔符拆分，最多拆出 maxFields 个字段，最后一个字段保留其余全部内容
+     *
+     * 空串拆出一个空字段；返回的视图指向 text，字段仍是转义形式。
+     */
+    static std::vector<std::string_view> split(std::string_view text, char separator, size_t maxFields = SIZE_MAX) {
+        std::vector<std::string_view> fields;
+        size_t begin = 0;
+        while (fields.size() + 1 < maxFields) {
+            size_t end = text.find(separator, begin);
+            if (end == std::string_view::npos) break;
+            fields.push_back(text.substr(begin, end - begin));
+            begin = end + 1;
+        }
+        fields.push_back(text.substr(begin));
+        return fields;
+    }
+
+    // 整个字段须是十进制整数（可带负号），不接受前后空白和多余字符
+    static bool parseInt(std::string_view text, int& value) {
+        auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+        return result.ec == std::errc() && result.ptr == text.data() + text.size();
+    }
+};
+
+#endif // TEXTRECORD_H
@@ -5,6 +5,9 @@
 #include <string>
 #include <sstream>
 #include <vector>
+#include <utility>
+#include <string_view>
+#include "MemoryUsage.h"
 
 /**
  * @brief 用户类 - 管理商城系统的用户信息
@@ -20,23 +23,25 @@ private:
 public:
     User() : userType("customer") {}
 
-    User(const std::string& username, const std::string& password,
-        const std::string& userType = "customer", const std::string& email = "",
-        const std::string& phone = "")
-        : username(username), password(password), userType(userType), email(email), phone(phone) {
+    // 参数按值传入再移动，调用方传临时对象时不产生拷贝
+    User(std::string username, std::string password,
+        std::string userType = "customer", std::string email = "",
+        std::string phone = "")
+        : username(std::move(username)), password(std::move(password)), userType(std::move(userType)),
+        email(std::move(email)), phone(std::move(phone)) {
     }
 
-    // Getter方法
-    std::string getUsername() const { return username; }
-    std::string getPassword() const { return password; }
-    std::string getUserType() const { return userType; }
-    std::string getEmail() const { return email; }
-    std::string getPhone() const { return phone; }
+    // Getter方法（返回常量引用，比较和输出时不复制字符串）
+    const std::string& getUsername() const { return username; }
+    const std::string& getPassword() const { return password; }
+    const std::string& getUserType() const { return userType; }
+    const std::string& getEmail() const { return email; }
+    const std::string& getPhone() const { return phone; }
 
     // Setter方法
-    void setPassword(const std::string& newPassword) { password = newPassword; }
-    void setEmail(const std::string& newEmail) { email = newEmail; }
-    void setPhone(const std::string& newPhone) { phone = newPhone; }
+    void setPassword(std::string newPassword) { password = std::move(newPassword); }
+    void setEmail(std::string newEmail) { email = std::move(newEmail); }
+    void setPhone(std::string newPhone) { phone = std::move(newPhone); }
 
     // 业务方法
     bool isAdmin() const {
@@ -55,15 +60,40 @@ public:
 
     // 验证手机号格式
     bool isValidPhone() const {
+        return isValidPhoneNumber(phone);
+    }
+
+    /**
+     * @brief 注册信息校验（单个注册与批量导入共用）
+     * @return 不合法时返回提示信息，合法时返回 nullptr
+     */
+    static const char* validateRegistration(std::string_view username, std::string_view password,
+        std::string_view phone) {
+        if (username.empty() || password.empty()) return "用户名和密码不能为空！";
+        if (username.length() < 3) return "用户名长度不能少于3个字符！";
+        if (password.length() < 6) return "密码长度不能少于6个字符！";
+        if (phone.empty()) return "手机号不能为空！";
+        if (!isValidPhoneNumber(phone)) return "手机号格式不正确！请输入11位有效手机号";
+        return nullptr;
+    }
+
+    // 无需构造 User 即可校验手机号
+    static bool isValidPhoneNumber(std::string_view phone) {
         // 简单的手机号验证：11位数字，以1开头
         if (phone.length() != 11) return false;
         if (phone[0] != '1') return false;
         for (char c : phone) {
-            if (!isdigit(c)) return false;
+            if (!isdigit(static_cast<unsigned char>(c))) return false;
         }
         return true;
     }
 
+    // 字符串占用的堆内存（不含对象本身）
+    size_t getHeapBytes() const {
+        return MemoryAccounting::ofString(username) + MemoryAccounting::ofString(password) +
+            MemoryAccounting::ofString(userType) + MemoryAccounting::ofString(email) + MemoryAccounting::ofString(phone);
+    }
+
     // 序列化方法
     std::string toString() const {
         std::ostringstream oss;
@@ -81,9 +111,9 @@ public:
         }
 
         if (tokens.size() >= 3) {
-            return User(tokens[0], tokens[1], tokens[2],
-                tokens.size() > 3 ? tokens[3] : "",
-                tokens.size() > 4 ? tokens[4] : "");
+            tokens.resize(5);
+            return User(std::move(tokens[0]), std::move(tokens[1]), std::move(tokens[2]),
+                std::move(tokens[3]), std::move(tokens[4]));
         }
         return User();
     }
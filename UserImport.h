@@ -0,0 +1,155 @@
+﻿#ifndef USERIMPORT_H
+#define USERIMPORT_H
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "User.h"
+#include "UserStore.h"
+
+/**
+ * @brief 被拒绝的导入行
+ */
+struct UserImportRejection {
+    size_t row = 0;          ///< 行号（从 0 开始）
+    std::string username;
+    const char* reason = "";
+};
+
+/**
+ * @brief 批量导入结果
+ */
+struct UserImportReport {
+    size_t rows = 0;
+    size_t imported = 0;
+    std::vector<UserImportRejection> rejected;  ///< 按行号升序
+    unsigned threadsUsed = 1;
+    double elapsedMs = 0.0;
+
+    double getUsersPerSecond() const {
+        return elapsedMs <= 0.0 ? 0.0 : imported / (elapsedMs / 1000.0);
+    }
+};
+
+/**
+ * @brief 批量导入用户 - 并行校验、按分片分桶、每个分片一次加锁插入
+ *
+ * 校验阶段：各线程处理连续的一段行，按注册规则校验，合法的行按用户名哈希放进本线程的分片桶。
+ * 插入阶段：线程 p 负责第 p, p+T, ... 个分片，按行号顺序拼接各线程的桶后整批插入，
+ * 一次哈希查找同时判断"已存在"和"批次内重名"（先出现的行优先）。
+ * 各分片键集不相交，插入阶段线程之间不争用同一把锁。
+ */
+class UserImporter {
+public:
+    /**
+     * @brief 导入一批用户
+     * @param users 导入的记录，导入成功的记录被移走
+     * @param threadCount 线程数，0 表示使用硬件线程数
+     */
+    static UserImportReport run(UserStore& store, std::vector<User>& users, unsigned threadCount = 0) {
+        auto start = std::chrono::steady_clock::now();
+        if (threadCount == 0) {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+        size_t rowCount = users.size();
+        threadCount = static_cast<unsigned>(std::max<size_t>(1,
+            std::min<size_t>(threadCount, (rowCount + MIN_ROWS_PER_THREAD - 1) / MIN_ROWS_PER_THREAD)));
+        size_t shardCount = store.getShardCount();
+
+        // 校验并分桶
+        std::vector<const char*> invalid(rowCount, nullptr);
+        std::vector<std::vector<std::vector<uint32_t>>> buckets(threadCount);  ///< [线程][分片]
+        size_t perThread = (rowCount + threadCount - 1) / threadCount;
+        runParallel(threadCount, [&](unsigned worker) {
+            auto& local = buckets[worker];
+            local.resize(shardCount);
+            size_t begin = std::min(rowCount, worker * perThread);
+            size_t end = std::min(rowCount, begin + perThread);
+            for (auto& bucket : local) {
+                bucket.reserve((end - begin) / shardCount + 16);
+            }
+            for (size_t row = begin; row < end; ++row) {
+                const User& user = users[row];
+                invalid[row] = validate(user);
+                if (!invalid[row]) {
+                    local[store.shardOf(user.getUsername())].push_back(static_cast<uint32_t>(row));
+                }
+            }
+        });
+
+        // 按分片插入
+        std::vector<UserStore::InsertResult> results(rowCount, UserStore::InsertResult::Inserted);
+        runParallel(threadCount, [&](unsigned worker) {
+            std::vector<uint32_t> rows;
+            for (size_t shard = worker; shard < shardCount; shard += threadCount) {
+                rows.clear();
+                for (const auto& local : buckets) {
+                    rows.insert(rows.end(), local[shard].begin(), local[shard].end());
+                }
+                if (!rows.empty()) store.insertBatch(shard, rows, users, results);
+            }
+        });
+        store.rebuildFilterIfNeeded();
+
+        UserImportReport report;
+        report.rows = rowCount;
+        for (size_t row = 0; row < rowCount; ++row) {
+            const char* reason = invalid[row];
+            if (!reason && results[row] == UserStore::InsertResult::Exists) reason = "用户名已存在！";
+            if (!reason && results[row] == UserStore::InsertResult::Duplicate) reason = "与导入文件中前面的行用户名重复！";
+            if (reason) {
+                report.rejected.push_back(UserImportRejection{ row, users[row].getUsername(), reason });
+            }
+        }
+        report.imported = rowCount - report.rejected.size();
+        report.threadsUsed = threadCount;
+        report.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return report;
+    }
+
+    /**
+     * @brief 读取导入文件，每行一个 User::toString() 格式的记录（用户名|密码|类型|邮箱|手机号）
+     *
+     * 空行跳过；字段不足的行读成空用户，导入时按校验失败报告，行号与文件中的非空行对应。
+     */
+    static bool readFile(const std::string& path, std::vector<User>& users) {
+        std::ifstream in(path);
+        if (!in) return false;
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty()) continue;
+            users.push_back(User::fromString(line));
+        }
+        return true;
+    }
+
+private:
+    static constexpr size_t MIN_ROWS_PER_THREAD = 16384;  // 行数少时不值得开线程
+
+    static const char* validate(const User& user) {
+        if (const char* error = User::validateRegistration(user.getUsername(), user.getPassword(), user.getPhone())) {
+            return error;
+        }
+        if (user.getUserType() != "customer" && user.getUserType() != "admin") return "用户类型无效！";
+        return nullptr;
+    }
+
+    template <typename Task>
+    static void runParallel(unsigned threadCount, Task&& task) {
+        std::vector<std::thread> threads;
+        threads.reserve(threadCount - 1);
+        for (unsigned i = 1; i < threadCount; ++i) {
+            threads.emplace_back([&task, i] { task(i); });
+        }
+        task(0);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+};
+
+#endif // USERIMPORT_H
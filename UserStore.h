@@ -0,0 +1,266 @@
+﻿#ifndef USERSTORE_H
+#define USERSTORE_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <vector>
+#include "User.h"
+#include "StringHash.h"
+#include "ExistenceFilter.h"
+#include "MemoryUsage.h"
+
+/**
+ * @brief 用户表 - 按用户名哈希分片，每个分片独立加锁并维护用户名索引
+ *
+ * 注册、登录和按编号恢复会话只锁一个分片，不需要引擎锁；列出全部用户时依次访问各分片。
+ * 分片内用 deque 存放用户，追加时已有用户的地址不变，持有引擎锁的调用方可以直接使用返回的指针。
+ * 用户编号 = 分片内位置 x 分片数 + 分片号，用户不会被删除，编号保持稳定。
+ * 按用户名查询前先查存在性过滤器，一定不存在的用户名（随机名撞库、注册前查重）不取分片锁。
+ */
+class UserStore {
+public:
+    static constexpr size_t DEFAULT_SHARD_COUNT = 16;
+
+    explicit UserStore(size_t shardCount = DEFAULT_SHARD_COUNT)
+        : shardCount(shardCount == 0 ? 1 : shardCount), shards(std::make_unique<Shard[]>(this->shardCount)),
+        userCount(0) {
+    }
+
+    UserStore(const UserStore&) = delete;
+    UserStore& operator=(const UserStore&) = delete;
+
+    /**
+     * @brief 添加用户，用户名已存在时返回 false（检查与插入在同一把分片锁内）
+     */
+    bool add(User user) {
+        {
+            Shard& shard = shardFor(user.getUsername());
+            std::lock_guard<std::mutex> guard(shard.mutex);
+            if (!shard.index.try_emplace(user.getUsername(), static_cast<uint32_t>(shard.users.size())).second) {
+                return false;
+            }
+            // 过滤器在分片锁内更新，重建时持有全部分片锁即可排除并发插入
+            nameFilter.add(user.getUsername());
+            shard.users.push_back(std::move(user));
+            userCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        rebuildFilterIfNeeded();
+        return true;
+    }
+
+    /**
+     * @brief 按用户名查找用户编号
+     * @return 不存在时返回 -1
+     */
+    int findId(std::string_view username) const {
+        if (!nameFilter.mayContain(username)) return -1;
+        size_t shardIndex = shardIndexFor(username);
+        const Shard& shard = shards[shardIndex];
+        std::lock_guard<std::mutex> guard(shard.mutex);
+        auto it = shard.index.find(username);
+        if (it == shard.index.end()) return -1;
+        return static_cast<int>(it->second * shardCount + shardIndex);
+    }
+
+    /**
+     * @brief 复制一份用户信息（不需要引擎锁）
+     */
+    bool copy(std::string_view username, User& result) const {
+        if (!nameFilter.mayContain(username)) return false;
+        const Shard& shard = shardFor(username);
+        std::lock_guard<std::mutex> guard(shard.mutex);
+        auto it = shard.index.find(username);
+        if (it == shard.index.end()) return false;
+        result = shard.users[it->second];
+        return true;
+    }
+
+    bool copyById(uint32_t userId, User& result) const {
+        const Shard& shard = shards[userId % shardCount];
+        std::lock_guard<std::mutex> guard(shard.mutex);
+        size_t position = userId / shardCount;
+        if (position >= shard.users.size()) return false;
+        result = shard.users[position];
+        return true;
+    }
+
+    // 以下两个方法返回指向表内的指针，调用方须持有引擎锁，并且只读或经 update 修改
+    User* find(std::string_view username) {
+        if (!nameFilter.mayContain(username)) return nullptr;
+        Shard& shard = shardFor(username);
+        std::lock_guard<std::mutex> guard(shard.mutex);
+        auto it = shard.index.find(username);
+        return it == shard.index.end() ? nullptr : &shard.users[it->second];
+    }
+
+    User* findById(uint32_t userId) {
+        Shard& shard = shards[userId % shardCount];
+        std::lock_guard<std::mutex> guard(shard.mutex);
+        size_t position = userId / shardCount;
+        return position < shard.users.size() ? &shard.users[position] : nullptr;
+    }
+
+    bool update(const User& user) {
+        Shard& shard = shardFor(user.getUsername());
+        std::lock_guard<std::mutex> guard(shard.mutex);
+        auto it = shard.index.find(user.getUsername());
+        if (it == shard.index.end()) return false;
+        shard.users[it->second] = user;
+        return true;
+    }
+
+    /**
+     * @brief 汇集全部用户（按分片顺序，各分片内按注册顺序）
+     */
+    std::vector<User> getAll() const {
+        std::vector<User> result;
+        result.reserve(size());
+        for (size_t i = 0; i < shardCount; ++i) {
+            std::lock_guard<std::mutex> guard(shards[i].mutex);
+            result.insert(result.end(), shards[i].users.begin(), shards[i].users.end());
+        }
+        return result;
+    }
+
+    // ==================== 批量插入 ====================
+    enum class InsertResult : uint8_t {
+        Inserted,
+        Exists,      ///< 导入前已存在
+        Duplicate    ///< 与同一批中更早的行重名
+    };
+
+    // 用户名所属的分片，批量导入据此把记录分桶
+    size_t shardOf(std::string_view username) const { return shardIndexFor(username); }
+
+    /**
+     * @brief 在一把分片锁内按行号顺序插入同一分片的一批用户，同名时先出现的行优先
+     * @param rows 属于该分片的行号（升序），插入成功的 users[row] 被移走
+     * @param results 按行号记录结果，不同分片写入不同的元素，可并行调用
+     */
+    void insertBatch(size_t shardIndex, std::span<const uint32_t> rows, std::vector<User>& users,
+        std::vector<InsertResult>& results) {
+        Shard& shard = shards[shardIndex];
+        std::lock_guard<std::mutex> guard(shard.mutex);
+        uint32_t existing = static_cast<uint32_t>(shard.users.size());
+        shard.index.reserve(shard.index.size() + rows.size());
+
+        size_t inserted = 0;
+        for (uint32_t row : rows) {
+            auto found = shard.index.try_emplace(users[row].getUsername(), static_cast<uint32_t>(shard.users.size()));
+            if (!found.second) {
+                results[row] = found.first->second < existing ? InsertResult::Exists : InsertResult::Duplicate;
+                continue;
+            }
+            nameFilter.add(shard.users.emplace_back(std::move(users[row])).getUsername());
+            results[row] = InsertResult::Inserted;
+            ++inserted;
+        }
+        userCount.fetch_add(inserted, std::memory_order_relaxed);
+    }
+
+    // 批量插入全部完成后调用，插入期间过滤器追加的阶段在这里合并
+    void rebuildFilterIfNeeded() {
+        if (!nameFilter.needsRebuild()) return;
+        // 已有线程在重建时直接返回，由它完成
+        std::unique_lock<std::mutex> rebuilding(filterRebuildMutex, std::try_to_lock);
+        if (rebuilding.owns_lock()) rebuildFilter(-1.0);
+    }
+
+    // ==================== 存在性过滤器 ====================
+    // 返回 false 表示用户名一定不存在（不取锁）
+    bool mayContain(std::string_view username) const { return nameFilter.mayContain(username); }
+
+    /**
+     * @brief 修改过滤器的目标误判率并立即重建，0 表示禁用过滤器
+     */
+    void setFilterFalsePositiveRate(double rate) {
+        std::lock_guard<std::mutex> rebuilding(filterRebuildMutex);
+        rebuildFilter(rate);
+    }
+
+    ExistenceFilter::Stats getFilterStats() const { return nameFilter.getStats(); }
+
+    // ==================== 内存统计（逐个分片加锁） ====================
+    MemoryUsage getMemoryUsage() const {
+        MemoryUsage usage;
+        for (size_t i = 0; i < shardCount; ++i) {
+            std::lock_guard<std::mutex> guard(shards[i].mutex);
+            usage.bytes += MemoryAccounting::ofDeque(shards[i].users);
+            usage.items += shards[i].users.size();
+            for (const User& user : shards[i].users) {
+                usage.bytes += user.getHeapBytes();
+            }
+        }
+        return usage;
+    }
+
+    // 用户名索引（不含存在性过滤器，见 getFilterStats）
+    MemoryUsage getIndexMemoryUsage() const {
+        MemoryUsage usage;
+        for (size_t i = 0; i < shardCount; ++i) {
+            std::lock_guard<std::mutex> guard(shards[i].mutex);
+            usage.bytes += MemoryAccounting::ofHashTable(shards[i].index);
+            usage.items += shards[i].index.size();
+            for (const auto& [username, position] : shards[i].index) {
+                usage.bytes += MemoryAccounting::ofString(username);
+            }
+        }
+        return usage;
+    }
+
+    size_t size() const { return userCount.load(std::memory_order_relaxed); }
+    size_t getShardCount() const { return shardCount; }
+
+private:
+    struct alignas(64) Shard {
+        mutable std::mutex mutex;
+        std::deque<User> users;
+        StringMap<uint32_t> index;  ///< 用户名 -> users 中的位置
+    };
+
+    size_t shardCount;
+    std::unique_ptr<Shard[]> shards;
+    std::atomic<size_t> userCount;
+    ExistenceFilter nameFilter;          ///< 全部用户名，无锁判断"一定不存在"
+    std::mutex filterRebuildMutex;       ///< 串行化过滤器重建
+
+    // 散列值再混合一次取高位，避免分片号与分片内哈希表的桶号相关
+    size_t shardIndexFor(std::string_view username) const {
+        uint64_t mixed = static_cast<uint64_t>(StringHash{}(username)) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>((mixed >> 32) % shardCount);
+    }
+
+    Shard& shardFor(std::string_view username) { return shards[shardIndexFor(username)]; }
+
+    /**
+     * @brief 按当前全部用户名重建过滤器
+     *
+     * 按分片号顺序取得全部分片锁（其他路径最多持有一把分片锁，不会死锁），期间注册暂停，
+     * 登录等查询继续读旧版本。重建容量为用户数的两倍，用户数翻几番才会再次触发。
+     * 调用方须持有 filterRebuildMutex。
+     */
+    void rebuildFilter(double rate) {
+        std::vector<std::unique_lock<std::mutex>> guards;
+        guards.reserve(shardCount);
+        for (size_t i = 0; i < shardCount; ++i) {
+            guards.emplace_back(shards[i].mutex);
+        }
+        if (rate >= 0.0 || nameFilter.needsRebuild()) {
+            size_t total = 0;
+            for (size_t i = 0; i < shardCount; ++i) total += shards[i].users.size();
+            nameFilter.rebuild(total, [&](auto&& add) {
+                for (size_t i = 0; i < shardCount; ++i) {
+                    for (const auto& user : shards[i].users) add(user.getUsername());
+                }
+            }, rate);
+        }
+    }
+    const Shard& shardFor(std::string_view username) const { return shards[shardIndexFor(username)]; }
+};
+
+#endif // USERSTORE_H
@@ -0,0 +1,73 @@
+﻿#ifndef UTF8TEXT_H
+#define UTF8TEXT_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief UTF-8 文本工具 - 解码为 Unicode 码点并做匹配用的归一化
+ *
+ * 归一化规则：忽略空白和 ASCII 标点、全角空格和常用中文标点，ASCII 字母转小写。
+ * 相似投诉聚类、模糊搜索和相关度搜索共用这套字符规则；归一化后"iPhone 15"与"iphone15"相同。
+ */
+class Utf8Text {
+public:
+    /**
+     * @brief 解码并归一化，结果追加到 output 末尾；非法字节按单字节处理
+     */
+    static void appendNormalized(std::string_view text, std::vector<uint32_t>& output) {
+        size_t i = 0;
+        while (i < text.size()) {
+            uint32_t codePoint = decode(text, i);
+            if (isSeparator(codePoint)) continue;
+            output.push_back(toLowerAscii(codePoint));
+        }
+    }
+
+    /**
+     * @brief 解码 text[index] 开始的一个码点，index 前进到下一个码点
+     */
+    static uint32_t decode(std::string_view text, size_t& index) {
+        unsigned char lead = static_cast<unsigned char>(text[index]);
+        if (lead >= 0xF0 && index + 3 < text.size()) {
+            uint32_t codePoint = ((lead & 0x07u) << 18) | ((text[index + 1] & 0x3Fu) << 12) |
+                ((text[index + 2] & 0x3Fu) << 6) | (text[index + 3] & 0x3Fu);
+            index += 4;
+            return codePoint;
+        }
+        if (lead >= 0xE0 && index + 2 < text.size()) {
+            uint32_t codePoint = ((lead & 0x0Fu) << 12) | ((text[index + 1] & 0x3Fu) << 6) | (text[index + 2] & 0x3Fu);
+            index += 3;
+            return codePoint;
+        }
+        if (lead >= 0xC0 && index + 1 < text.size()) {
+            uint32_t codePoint = ((lead & 0x1Fu) << 6) | (text[index + 1] & 0x3Fu);
+            index += 2;
+            return codePoint;
+        }
+        index += 1;
+        return lead;
+    }
+
+    // 空白、ASCII 标点和常用中文标点，归一化时忽略，分词时作为词的边界
+    static bool isSeparator(uint32_t c) {
+        return c < 0x80 ? !isAsciiWordChar(c) : isCjkPunctuation(c);
+    }
+
+    static uint32_t toLowerAscii(uint32_t c) {
+        return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+    }
+
+    static bool isAsciiWordChar(uint32_t c) {
+        return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+    }
+
+private:
+    // 全角空格、顿号句号、全角标点
+    static bool isCjkPunctuation(uint32_t c) {
+        return (c >= 0x3000 && c <= 0x3002) || (c >= 0xFF01 && c <= 0xFF0F) || c == 0xFF1F;
+    }
+};
+
+#endif // UTF8TEXT_H